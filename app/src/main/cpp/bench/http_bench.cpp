@@ -0,0 +1,121 @@
+// Loopback throughput and latency benchmark for HttpClient's socket
+// transport. Every request runs twice against the same in-process server.
+// The first pass uses pooled keep-alive connections. The second is the
+// baseline transport's behaviour: the server answers "Connection: close",
+// so each request resolves, connects and tears its socket down again.
+//
+//   http_bench [--requests N] [--concurrency N] [--body-bytes N]
+//
+// Latency is HttpTiming::total, so time spent queued for a connection slot
+// is included.
+
+#include "http_client.h"
+#include "test_support.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+struct Options {
+    size_t requests = 2000;
+    size_t concurrency = 1;
+    size_t bodyBytes = 1024;
+};
+
+Options options;
+
+double percentileMs(std::vector<double>& latencies, double percentile) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    size_t index = std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * percentile));
+    std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+}
+
+// Issues options.requests GETs, options.concurrency at a time, and prints
+// one row of the table
+void runPass(const char* name, const std::string& fullResponse) {
+    LoopbackServer server(serveForever(fullResponse));
+    if (!server.isListening()) {
+        fprintf(stderr, "%s: could not listen on loopback\n", name);
+        exit(1);
+    }
+
+    HttpClient& client = HttpClient::getInstance();
+    client.closeIdleConnections();
+    ConnectionPoolStats before = client.getConnectionPoolStats();
+    std::string url = server.url("/bench");
+
+    std::vector<double> latencies;
+    latencies.reserve(options.requests);
+    size_t failures = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t issued = 0; issued < options.requests;) {
+        std::vector<std::future<HttpResponse>> batch;
+        for (size_t i = 0; i < options.concurrency && issued < options.requests; ++i, ++issued) {
+            batch.push_back(client.getAsync(url));
+        }
+        for (auto& future : batch) {
+            HttpResponse response = future.get();
+            if (response.statusCode != 200 || response.body.size() != options.bodyBytes) {
+                ++failures;
+                continue;
+            }
+            latencies.push_back(std::chrono::duration<double, std::milli>(response.timing.total).count());
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ConnectionPoolStats after = client.getConnectionPoolStats();
+
+    printf("%-12s %10.0f %10.3f %10.3f %10.3f %12zu %10zu\n", name, options.requests / seconds,
+           percentileMs(latencies, 0.50), percentileMs(latencies, 0.99), percentileMs(latencies, 1.0),
+           after.connectionsOpened - before.connectionsOpened, failures);
+    fflush(stdout);
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--requests") == 0 && hasValue) {
+            options.requests = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--concurrency") == 0 && hasValue) {
+            options.concurrency = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--body-bytes") == 0 && hasValue) {
+            options.bodyBytes = strtoull(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--requests N] [--concurrency N] [--body-bytes N]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        return 2;
+    }
+    HttpClient& client = HttpClient::getInstance();
+    client.setCacheEnabled(false);
+    client.setHostConcurrency(options.concurrency, options.concurrency);
+
+    std::string body(options.bodyBytes, 'x');
+    printf("%zu requests, %zu in flight, %zu byte bodies\n\n", options.requests, options.concurrency,
+           options.bodyBytes);
+    printf("%-12s %10s %10s %10s %10s %12s %10s\n", "transport", "req/s", "p50 ms", "p99 ms", "max ms",
+           "connections", "failures");
+    runPass("keep-alive", response(200, body));
+    runPass("per-request", response(200, body, "Connection: close\r\n"));
+    return 0;
+}
@@ -0,0 +1,210 @@
+// Micro-benchmark for the HTTP path's parsing: the request URL, the status
+// line and the response header block. HttpParser runs next to the regex and
+// istringstream code that performRequest used before it, reproduced here as
+// the baseline.
+//
+//   http_parser_bench [--min-time MS]
+//
+// Rates are for the best run. Allocations are per parse, counted by the
+// operator new below.
+
+#include "http_parser.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <regex>
+#include <sstream>
+#include <string>
+
+using namespace localify;
+
+namespace {
+
+std::atomic<size_t> allocationCount(0);
+
+} // namespace
+
+void* operator new(size_t size) {
+    void* pointer = malloc(size > 0 ? size : 1);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+namespace {
+
+const std::string URL =
+    "https://staging.localify.org:443/v1/search?q=the%20fillmore&artists=true&events=true&venues=true";
+const std::string STATUS_LINE = "HTTP/1.1 200 OK";
+// As the API answers a search, without the status line
+const std::string HEADER_BLOCK =
+    "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Content-Length: 48213\r\n"
+    "Connection: keep-alive\r\n"
+    "Keep-Alive: timeout=30, max=100\r\n"
+    "Cache-Control: private, max-age=60\r\n"
+    "ETag: \"5f2b-1a9c3e7d\"\r\n"
+    "Vary: Accept-Encoding, Authorization\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n"
+    "X-Request-Id: 4b1d6f0e-8c2a-4e55-9f3b-2d7a1c9e6b40\r\n"
+    "Server: nginx";
+
+double minTimeMs = 200;
+
+// Keeps results observable so no run is optimized away
+volatile size_t sink;
+
+template<typename Run>
+void measure(const char* parser, const char* operation, Run run) {
+    run();
+
+    size_t allocationsBefore = allocationCount.load();
+    run();
+    size_t allocations = allocationCount.load() - allocationsBefore;
+
+    // Best of several batches, each large enough to time reliably
+    const int BATCH = 1000;
+    double best = 1e30;
+    double total = 0;
+    for (int batches = 0; total * 1000 < minTimeMs || batches < 3; ++batches) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BATCH; ++i) {
+            run();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, elapsed / BATCH);
+        total += elapsed;
+    }
+    printf("%-12s %-14s %14.0f %12.3f %12zu\n", parser, operation, 1 / best, best * 1e6, allocations);
+    fflush(stdout);
+}
+
+// The pre-HttpParser code, as it stood in HttpClient::performRequest and
+// HttpClient::parseHeaders
+namespace baseline {
+
+bool parseUrl(const std::string& url, std::string& host, int& port, std::string& path) {
+    std::regex urlRegex(R"(^https?://([^:/]+)(?::(\d+))?(/.*)?$)");
+    std::smatch matches;
+    if (!std::regex_match(url, matches, urlRegex)) {
+        return false;
+    }
+    host = matches[1].str();
+    port = matches[2].matched ? std::stoi(matches[2].str()) : (url.find("https://") == 0 ? 443 : 80);
+    path = matches[3].matched ? matches[3].str() : "/";
+    return true;
+}
+
+int parseStatusLine(const std::string& statusLine) {
+    std::regex statusRegex(R"(HTTP/\d\.\d (\d+) .*)");
+    std::smatch statusMatches;
+    return std::regex_match(statusLine, statusMatches, statusRegex) ? std::stoi(statusMatches[1].str()) : 0;
+}
+
+std::map<std::string, std::string> parseHeaders(const std::string& headerString) {
+    std::map<std::string, std::string> headers;
+    std::istringstream stream(headerString);
+    std::string line;
+    std::getline(stream, line);
+    while (std::getline(stream, line) && !line.empty() && line != "\r") {
+        size_t colonPos = line.find(':');
+        if (colonPos != std::string::npos) {
+            std::string key = line.substr(0, colonPos);
+            std::string value = line.substr(colonPos + 1);
+            key.erase(0, key.find_first_not_of(" \t\r\n"));
+            key.erase(key.find_last_not_of(" \t\r\n") + 1);
+            value.erase(0, value.find_first_not_of(" \t\r\n"));
+            value.erase(value.find_last_not_of(" \t\r\n") + 1);
+            headers[key] = value;
+        }
+    }
+    return headers;
+}
+
+} // namespace baseline
+
+void benchBaseline() {
+    const std::string headerSection = STATUS_LINE + "\r\n" + HEADER_BLOCK;
+    auto url = [&]() {
+        std::string host, path;
+        int port = 0;
+        sink = baseline::parseUrl(URL, host, port, path) + host.size() + port;
+    };
+    auto status = [&]() { sink = baseline::parseStatusLine(STATUS_LINE); };
+    auto headers = [&]() { sink = baseline::parseHeaders(headerSection).size(); };
+    measure("regex", "URL", url);
+    measure("regex", "status line", status);
+    measure("regex", "headers", headers);
+    measure("regex", "request", [&]() {
+        url();
+        status();
+        headers();
+    });
+}
+
+void benchHttpParser() {
+    auto url = [&]() {
+        ParsedUrl parsed;
+        sink = HttpParser::parseUrl(URL, parsed) + parsed.host.size() + parsed.port;
+    };
+    auto status = [&]() {
+        int statusCode = 0;
+        int minorVersion = 0;
+        sink = HttpParser::parseStatusLine(STATUS_LINE, statusCode, minorVersion) + statusCode;
+    };
+    // A fresh header list per response, reserved as HttpResponseParser does
+    auto headers = [&]() {
+        HttpHeaders parsed;
+        parsed.reserve(16, HEADER_BLOCK.size());
+        HttpParser::parseHeaderLines(HEADER_BLOCK, parsed);
+        sink = parsed.size() + parsed.get("content-length").size();
+    };
+    measure("HttpParser", "URL", url);
+    measure("HttpParser", "status line", status);
+    measure("HttpParser", "headers", headers);
+    HttpHeaders reused;
+    measure("HttpParser", "headers reused", [&]() {
+        reused.clear();
+        HttpParser::parseHeaderLines(HEADER_BLOCK, reused);
+        sink = reused.size();
+    });
+    measure("HttpParser", "request", [&]() {
+        url();
+        status();
+        headers();
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minTimeMs = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--min-time MS]\n", argv[0]);
+            return 2;
+        }
+    }
+    printf("%-12s %-14s %14s %12s %12s\n", "parser", "operation", "parses/s", "us/parse", "allocations");
+    benchBaseline();
+    benchHttpParser();
+    return 0;
+}
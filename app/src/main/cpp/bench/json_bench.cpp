@@ -0,0 +1,584 @@
+// Throughput, allocation and memory benchmark for the JSON layer. Runs every
+// JSONParser parse* and serialize* entry point, plus the arena, lazy,
+// streaming and parallel modes, over the shared corpus (json_corpus.h).
+// Summary sections follow the table: the heap 10k events hold with and
+// without string interning, owning models against arena views, thread
+// scaling on a 5 MB event feed, and the token tape against the regex parser
+// it replaced.
+//
+//   json_bench [--max-bytes N] [--filter TEXT] [--min-time MS]
+//
+// --filter selects payloads by name and sections by title ("interning",
+// "arena", "thread scaling", "regex baseline").
+//
+// MB/s is for the best run. Allocations and peak heap are for one run, with
+// the string pool and arenas already warm. Peak RSS is for the whole process
+// so far, so it only ever grows down the table.
+
+#include "json_corpus.h"
+#include "json_parser.h"
+#include "json_regex_baseline.h"
+#include "model_schema.h"
+#include "model_views.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <sys/resource.h>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+using namespace localify;
+using namespace localify::bench;
+
+namespace {
+
+std::atomic<size_t> allocationCount(0);
+std::atomic<size_t> liveBytes(0);
+std::atomic<size_t> peakLiveBytes(0);
+
+size_t usableSize(void* pointer) {
+#ifdef __APPLE__
+    return malloc_size(pointer);
+#else
+    return malloc_usable_size(pointer);
+#endif
+}
+
+} // namespace
+
+// Every operator new in the process is counted, including those on
+// WorkerPool threads
+void* operator new(size_t size) {
+    void* pointer = malloc(size > 0 ? size : 1);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size_t bytes = usableSize(pointer);
+    size_t live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer != nullptr) {
+        liveBytes.fetch_sub(usableSize(pointer), std::memory_order_relaxed);
+        free(pointer);
+    }
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+namespace {
+
+struct Options {
+    size_t maxBytes = 10 * 1024 * 1024;
+    double minTimeMs = 200;
+    const char* filter = nullptr;
+};
+
+struct Measurement {
+    double megabytesPerSecond;
+    size_t allocations;
+    size_t peakHeapBytes;
+};
+
+Options options;
+
+// Keeps results observable so no run is optimized away
+volatile size_t sink;
+
+double peakRssMegabytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+template<typename Run>
+Measurement measure(size_t bytes, Run run) {
+    run();  // warm caches, the string pool and any arena
+
+    size_t allocationsBefore = allocationCount.load();
+    size_t liveBefore = liveBytes.load();
+    peakLiveBytes.store(liveBefore);
+    auto start = std::chrono::steady_clock::now();
+    run();
+    double best = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Measurement result;
+    result.allocations = allocationCount.load() - allocationsBefore;
+    result.peakHeapBytes = peakLiveBytes.load() - liveBefore;
+
+    double total = best;
+    int runs = 1;
+    while (total * 1000 < options.minTimeMs || runs < 3) {
+        start = std::chrono::steady_clock::now();
+        run();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, elapsed);
+        total += elapsed;
+        ++runs;
+    }
+    result.megabytesPerSecond = bytes / best / (1024.0 * 1024.0);
+    return result;
+}
+
+void report(const Payload& payload, const std::string& operation, const Measurement& result) {
+    printf("%-24s %-28s %10.1f %12zu %12.1f %10.1f\n", payload.name.c_str(), operation.c_str(),
+           result.megabytesPerSecond, result.allocations, result.peakHeapBytes / 1024.0, peakRssMegabytes());
+    fflush(stdout);
+}
+
+// Decoding into the owning models, then encoding them again
+template<typename Parse>
+void benchModels(const Payload& payload, const char* operation, Parse parse) {
+    report(payload, operation, measure(payload.body.size(), [&]() {
+        auto value = parse(payload.body);
+        sink = sizeof(value);
+    }));
+    auto value = parse(payload.body);
+    std::string encoded = toJSON(value);
+    report(payload, "toJSON", measure(encoded.size(), [&]() {
+        sink = toJSON(value).size();
+    }));
+}
+
+// Decoding into an arena that is reset between runs, as a screen would
+template<typename Parse>
+void benchArena(const Payload& payload, const char* operation, Parse parse) {
+    Arena arena;
+    report(payload, operation, measure(payload.body.size(), [&]() {
+        arena.reset();
+        auto view = parse(payload.body, arena);
+        sink = sizeof(view);
+    }));
+}
+
+// Decoding with the parallel threshold at its default and the pool at each
+// thread count in turn; a count of 1 is the serial baseline
+template<typename Parse>
+void benchParallel(const Payload& payload, Parse parse) {
+    if (payload.body.size() < JSONParser::getParallelDecodeThreshold()) {
+        return;
+    }
+    WorkerPool& pool = WorkerPool::getInstance();
+    size_t original = pool.getThreadCount();
+    for (size_t threads : {1, 2, 4, 8}) {
+        pool.setThreadCount(threads);
+        report(payload, "parallel x" + std::to_string(threads), measure(payload.body.size(), [&]() {
+            sink = parse(payload.body).size();
+        }));
+    }
+    pool.setThreadCount(original);
+}
+
+// Splitting the array as it would arrive from the network, 16 KB at a time
+void benchStream(const Payload& payload) {
+    const size_t PIECE = 16 * 1024;
+    report(payload, "JSONArrayStream", measure(payload.body.size(), [&]() {
+        size_t elements = 0;
+        JSONArrayStream stream([&elements](std::string element) {
+            elements += element.size() > 0;
+        });
+        for (size_t at = 0; at < payload.body.size(); at += PIECE) {
+            if (!stream.feed(payload.body.data() + at, std::min(PIECE, payload.body.size() - at))) {
+                break;
+            }
+        }
+        sink = elements;
+    }));
+}
+
+void benchPayload(const Payload& payload) {
+    switch (payload.kind) {
+        case PayloadKind::AUTH:
+            benchModels(payload, "parseAuthResponse", JSONParser::parseAuthResponse);
+            break;
+        case PayloadKind::USER: {
+            benchModels(payload, "parseUserDetails", JSONParser::parseUserDetails);
+            UserDetails user = JSONParser::parseUserDetails(payload.body);
+            report(payload, "serializeUserDetails", measure(payload.body.size(), [&]() {
+                sink = JSONParser::serializeUserDetails(user).size();
+            }));
+            break;
+        }
+        case PayloadKind::ARTIST:
+            benchModels(payload, "parseArtistResponse", JSONParser::parseArtistResponse);
+            break;
+        case PayloadKind::EVENT:
+            benchModels(payload, "parseEventResponse", JSONParser::parseEventResponse);
+            break;
+        case PayloadKind::VENUE:
+            benchModels(payload, "parseVenueResponse", JSONParser::parseVenueResponse);
+            break;
+        case PayloadKind::CITY:
+            benchModels(payload, "parseCityResponse", JSONParser::parseCityResponse);
+            break;
+        case PayloadKind::USER_CITY: {
+            benchModels(payload, "parseUserCity", JSONParser::parseUserCity);
+            UserCity userCity = JSONParser::parseUserCity(payload.body);
+            report(payload, "serializeUserCity", measure(payload.body.size(), [&]() {
+                sink = JSONParser::serializeUserCity(userCity).size();
+            }));
+            break;
+        }
+        case PayloadKind::ERROR:
+            benchModels(payload, "parseErrorResponse", JSONParser::parseErrorResponse);
+            break;
+        case PayloadKind::SEARCH: {
+            benchModels(payload, "parseSearchResponse", [](const std::string& json) {
+                return JSONParser::parseSearchResponse(json);
+            });
+            benchArena(payload, "parseSearchResponse arena", [](std::string_view json, Arena& arena) {
+                return JSONParser::parseSearchResponse(json, arena);
+            });
+            report(payload, "parseSearchResponseLazy", measure(payload.body.size(), [&]() {
+                sink = JSONParser::parseSearchResponseLazy(payload.body).use_count();
+            }));
+            report(payload, "parseSearchResponseLazy tab", measure(payload.body.size(), [&]() {
+                sink = JSONParser::parseSearchResponseLazy(payload.body)->events().size();
+            }));
+            break;
+        }
+        case PayloadKind::ARTISTS: {
+            auto parse = [](const std::string& json) { return JSONParser::parseArtistArray(json); };
+            benchModels(payload, "parseArtistArray", parse);
+            benchArena(payload, "parseArtistArray arena", [](std::string_view json, Arena& arena) {
+                return JSONParser::parseArtistArray(json, arena);
+            });
+            benchParallel(payload, parse);
+            benchStream(payload);
+            break;
+        }
+        case PayloadKind::EVENTS: {
+            auto parse = [](const std::string& json) { return JSONParser::parseEventArray(json); };
+            benchModels(payload, "parseEventArray", parse);
+            benchArena(payload, "parseEventArray arena", [](std::string_view json, Arena& arena) {
+                return JSONParser::parseEventArray(json, arena);
+            });
+            benchParallel(payload, parse);
+            benchStream(payload);
+            break;
+        }
+        case PayloadKind::VENUES: {
+            auto parse = [](const std::string& json) { return JSONParser::parseVenueArray(json); };
+            benchModels(payload, "parseVenueArray", parse);
+            benchArena(payload, "parseVenueArray arena", [](std::string_view json, Arena& arena) {
+                return JSONParser::parseVenueArray(json, arena);
+            });
+            benchParallel(payload, parse);
+            benchStream(payload);
+            break;
+        }
+        case PayloadKind::CITIES: {
+            auto parse = [](const std::string& json) { return JSONParser::parseCityArray(json); };
+            benchModels(payload, "parseCityArray", parse);
+            benchArena(payload, "parseCityArray arena", [](std::string_view json, Arena& arena) {
+                return JSONParser::parseCityArray(json, arena);
+            });
+            benchParallel(payload, parse);
+            benchStream(payload);
+            break;
+        }
+        case PayloadKind::USER_CITIES:
+            benchModels(payload, "parseUserCityArray", JSONParser::parseUserCityArray);
+            benchParallel(payload, JSONParser::parseUserCityArray);
+            break;
+        case PayloadKind::STRINGS: {
+            benchModels(payload, "parseStringArray", JSONParser::parseStringArray);
+            std::vector<std::string> strings = JSONParser::parseStringArray(payload.body);
+            report(payload, "serializeStringArray", measure(payload.body.size(), [&]() {
+                sink = JSONParser::serializeStringArray(strings).size();
+            }));
+            break;
+        }
+    }
+}
+
+bool sectionSelected(const char* title) {
+    if (options.filter != nullptr && strstr(title, options.filter) == nullptr) {
+        return false;
+    }
+    printf("\n%s\n", title);
+    return true;
+}
+
+const Payload* findPayload(const std::vector<Payload>& corpus, const char* name) {
+    for (const Payload& payload : corpus) {
+        if (payload.name == name) {
+            return &payload;
+        }
+    }
+    return nullptr;
+}
+
+// The event model as it was before interning, every value its own string
+struct PlainArtist {
+    std::string id;
+    std::string name;
+    std::optional<std::string> imageUrl;
+    std::optional<std::string> spotifyId;
+    std::vector<std::string> genres;
+    int popularity;
+    bool isFavorite;
+};
+
+struct PlainEvent {
+    std::string id;
+    std::string name;
+    std::string description;
+    std::string startDate;
+    std::string endDate;
+    std::optional<std::string> imageUrl;
+    std::string venueId;
+    std::string venueName;
+    std::vector<PlainArtist> artists;
+    bool isFavorite;
+    double latitude;
+    double longitude;
+};
+
+std::optional<std::string> plain(const std::optional<InternedString>& value) {
+    return value ? std::optional<std::string>(value->str()) : std::nullopt;
+}
+
+PlainEvent plain(const EventResponse& event) {
+    PlainEvent out{event.id, event.name, event.description, event.startDate, event.endDate, event.imageUrl,
+                   event.venueId.str(), event.venueName.str(), {}, event.isFavorite, event.latitude, event.longitude};
+    out.artists.reserve(event.artists.size());
+    for (const ArtistResponse& artist : event.artists) {
+        std::vector<std::string> genres(artist.genres.begin(), artist.genres.end());
+        out.artists.push_back({artist.id.str(), artist.name.str(), plain(artist.imageUrl), plain(artist.spotifyId),
+                               std::move(genres), artist.popularity, artist.isFavorite});
+    }
+    return out;
+}
+
+// Heap that 10k decoded events keep alive, interned and as plain strings.
+// The interned figure is what freeing the events releases plus what the
+// pool holds for them; the parser's reusable scratch is left out of both.
+// Runs before anything else is parsed, so everything pooled is theirs.
+void reportInterningMemory() {
+    const size_t EVENTS = 10000;
+    std::string body = eventFeed(EVENTS);
+    std::vector<EventResponse> events = JSONParser::parseEventArray(body);
+    events.shrink_to_fit();
+
+    size_t before = liveBytes.load();
+    std::vector<PlainEvent> plainEvents;
+    plainEvents.reserve(events.size());
+    for (const EventResponse& event : events) {
+        plainEvents.push_back(plain(event));
+    }
+    size_t separate = liveBytes.load() - before;
+    plainEvents = std::vector<PlainEvent>();
+
+    // Pooled text stays with the pool until its shard is swept
+    StringPoolStats pool = StringPool::getInstance().getStats();
+    before = liveBytes.load();
+    size_t count = events.size();
+    events = std::vector<EventResponse>();
+    size_t interned = before - liveBytes.load() + pool.bytes + pool.entries * sizeof(string_pool_detail::Entry);
+
+    printf("%-28s %12s %12s\n", "10k events", "heap KB", "bytes/event");
+    printf("%-28s %12.1f %12.1f\n", "plain strings", separate / 1024.0, double(separate) / count);
+    printf("%-28s %12.1f %12.1f\n", "interned", interned / 1024.0, double(interned) / count);
+    printf("saved %.1f KB (%.1f%%); pool holds %zu strings, %zu of %zu lookups were hits\n",
+           (double(separate) - double(interned)) / 1024.0, 100.0 * (1.0 - double(interned) / separate),
+           pool.entries, pool.hits, pool.lookups);
+    fflush(stdout);
+}
+
+// Time to free a decoded result: destroying the owning models, or resetting
+// the arena the views live in. Best of several.
+template<typename Prepare, typename Release>
+double releaseMicroseconds(Prepare prepare, Release release) {
+    double best = 1e30;
+    for (int i = 0; i < 5; ++i) {
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        release();
+        best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+template<typename ParseOwning, typename ParseArena>
+void compareArena(const Payload& payload, ParseOwning parseOwning, ParseArena parseArena) {
+    using Owning = decltype(parseOwning(payload.body));
+    std::unique_ptr<Owning> owned;
+    Measurement owning = measure(payload.body.size(), [&]() {
+        auto value = parseOwning(payload.body);
+        sink = sizeof(value);
+    });
+    double owningFree = releaseMicroseconds(
+        [&]() { owned.reset(new Owning(parseOwning(payload.body))); },
+        [&]() { owned.reset(); });
+
+    Arena arena;
+    Measurement arenaRun = measure(payload.body.size(), [&]() {
+        arena.reset();
+        auto view = parseArena(payload.body, arena);
+        sink = sizeof(view);
+    });
+    double arenaFree = releaseMicroseconds(
+        [&]() {
+            auto view = parseArena(payload.body, arena);
+            sink = sizeof(view);
+        },
+        [&]() { arena.reset(); });
+
+    printf("%-16s %10.1f %12zu %10.1f %10.1f %12zu %10.1f\n", payload.name.c_str(), owning.megabytesPerSecond,
+           owning.allocations, owningFree, arenaRun.megabytesPerSecond, arenaRun.allocations, arenaFree);
+    fflush(stdout);
+}
+
+void reportArena(const std::vector<Payload>& corpus) {
+    printf("%-16s %10s %12s %10s %10s %12s %10s\n", "payload", "owning MB/s", "allocations", "free us",
+           "arena MB/s", "allocations", "reset us");
+    for (const Payload& payload : corpus) {
+        if (payload.name.compare(0, 7, "events-") == 0) {
+            compareArena(payload, [](const std::string& json) { return JSONParser::parseEventArray(json); },
+                         [](std::string_view json, Arena& arena) { return JSONParser::parseEventArray(json, arena); });
+        } else if (payload.name.compare(0, 7, "search-") == 0) {
+            compareArena(payload, [](const std::string& json) { return JSONParser::parseSearchResponse(json); },
+                         [](std::string_view json, Arena& arena) { return JSONParser::parseSearchResponse(json, arena); });
+        }
+    }
+}
+
+// parseEventArray on one 5 MB feed at each pool size; speedup is against
+// one thread, which decodes serially
+void reportThreadScaling() {
+    std::string body = eventArray(std::min<size_t>(5 * 1024 * 1024, options.maxBytes));
+    WorkerPool& pool = WorkerPool::getInstance();
+    size_t original = pool.getThreadCount();
+    printf("%.1f MB event feed, %u hardware threads\n", body.size() / (1024.0 * 1024.0),
+           std::thread::hardware_concurrency());
+    printf("%-16s %10s %10s\n", "threads", "MB/s", "speedup");
+    double serial = 0;
+    for (size_t threads : {1, 2, 4, 8}) {
+        pool.setThreadCount(threads);
+        Measurement result = measure(body.size(), [&]() {
+            sink = JSONParser::parseEventArray(body).size();
+        });
+        if (threads == 1) {
+            serial = result.megabytesPerSecond;
+        }
+        printf("%-16zu %10.1f %9.2fx\n", threads, result.megabytesPerSecond, result.megabytesPerSecond / serial);
+        fflush(stdout);
+    }
+    pool.setThreadCount(original);
+}
+
+// The tape against the per-field regexes on event and search payloads.
+// Larger payloads are left out: the regex parser needs minutes for them,
+// and its lazy ".*?" array match recurses once per byte in std::regex.
+void reportRegexBaseline(const std::vector<Payload>& corpus) {
+    printf("%-16s %10s %12s %10s %12s %10s\n", "payload", "tape MB/s", "allocations", "regex MB/s",
+           "allocations", "speedup");
+    auto compare = [](const Payload& payload, auto parseTape, auto parseRegex) {
+        Measurement tape = measure(payload.body.size(), [&]() {
+            auto value = parseTape(payload.body);
+            sink = sizeof(value);
+        });
+        Measurement regex = measure(payload.body.size(), [&]() {
+            auto value = parseRegex(payload.body);
+            sink = sizeof(value);
+        });
+        printf("%-16s %10.1f %12zu %10.2f %12zu %9.0fx\n", payload.name.c_str(), tape.megabytesPerSecond,
+               tape.allocations, regex.megabytesPerSecond, regex.allocations,
+               tape.megabytesPerSecond / regex.megabytesPerSecond);
+        fflush(stdout);
+    };
+    if (const Payload* payload = findPayload(corpus, "event")) {
+        compare(*payload, JSONParser::parseEventResponse, regex_baseline::parseEventResponse);
+    }
+    for (const char* name : {"events-1kb", "events-64kb"}) {
+        if (const Payload* payload = findPayload(corpus, name)) {
+            compare(*payload, [](const std::string& json) { return JSONParser::parseEventArray(json); },
+                    regex_baseline::parseEventArray);
+        }
+    }
+    for (const char* name : {"search-1kb", "search-64kb"}) {
+        if (const Payload* payload = findPayload(corpus, name)) {
+            compare(*payload, [](const std::string& json) { return JSONParser::parseSearchResponse(json); },
+                    regex_baseline::parseSearchResponse);
+        }
+    }
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--max-bytes") == 0 && hasValue) {
+            options.maxBytes = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            options.minTimeMs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            options.filter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--max-bytes N] [--filter TEXT] [--min-time MS]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        return 2;
+    }
+    printf("structural indexer: %s, worker threads: %zu\n", JSONStructuralIndexer::implementation(),
+           WorkerPool::getInstance().getThreadCount());
+    // First, while the string pool is still empty
+    if (sectionSelected("interning")) {
+        reportInterningMemory();
+    }
+
+    std::vector<Payload> corpus = buildCorpus(options.maxBytes);
+    bool headerPrinted = false;
+    for (const Payload& payload : corpus) {
+        if (options.filter != nullptr && payload.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        if (!headerPrinted) {
+            printf("\n%-24s %-28s %10s %12s %12s %10s\n", "payload", "operation", "MB/s", "allocations",
+                   "peak heap KB", "peak RSS MB");
+            headerPrinted = true;
+        }
+        benchPayload(payload);
+    }
+
+    if (sectionSelected("arena")) {
+        reportArena(corpus);
+    }
+    if (sectionSelected("thread scaling")) {
+        reportThreadScaling();
+    }
+    if (sectionSelected("regex baseline")) {
+        reportRegexBaseline(corpus);
+    }
+    return 0;
+}
@@ -0,0 +1,323 @@
+#include "json_corpus.h"
+#include <cstdint>
+#include <cstdio>
+
+namespace localify {
+namespace bench {
+
+namespace {
+
+const size_t KB = 1024;
+const size_t MB = 1024 * 1024;
+
+// xorshift64*: fixed seed, same corpus everywhere
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+    bool chance(size_t percent) { return below(100) < percent; }
+
+private:
+    uint64_t state;
+};
+
+const char* const GENRES[] = {
+    "indie rock", "alternative", "hip hop", "electronic", "pop", "singer-songwriter", "jazz",
+    "folk", "r&b", "techno", "house", "punk", "metal", "soul", "country", "k-pop", "música mexicana"};
+const char* const CITIES[][3] = {
+    {"Brooklyn", "NY", "US"}, {"Los Angeles", "CA", "US"}, {"San Francisco", "CA", "US"},
+    {"Chicago", "IL", "US"}, {"Austin", "TX", "US"}, {"Montréal", "QC", "CA"},
+    {"Zürich", "ZH", "CH"}, {"São Paulo", "SP", "BR"}, {"Berlin", "BE", "DE"}};
+// Names carry the non-ASCII text and escapes real catalogues do
+const char* const WORDS[] = {
+    "The", "Night", "Velvet", "Hounds", "Café", "Tacocat", "Sigur", "Rós", "Björk", "\\\"Live\\\"",
+    "Ünderground", "Beyoncé", "Motörhead", "\\u00e9t\\u00e9", "🎸", "Orchestra", "DJ", "& Friends",
+    "Kollektiv", "Blue"};
+
+template<size_t N>
+const char* pick(Random& random, const char* const (&values)[N]) {
+    return values[random.below(N)];
+}
+
+std::string words(Random& random, size_t count) {
+    std::string out;
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            out += ' ';
+        }
+        out += pick(random, WORDS);
+    }
+    return out;
+}
+
+std::string uuid(Random& random, const char* prefix) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%s-%08x-%04x-4%03x-8%03x-%012llx", prefix,
+             static_cast<unsigned>(random.next()), static_cast<unsigned>(random.below(0x10000)),
+             static_cast<unsigned>(random.below(0x1000)), static_cast<unsigned>(random.below(0x1000)),
+             static_cast<unsigned long long>(random.next() & 0xFFFFFFFFFFFFULL));
+    return buffer;
+}
+
+std::string quoted(const std::string& text) {
+    return "\"" + text + "\"";
+}
+
+std::string imageUrl(Random& random) {
+    if (random.chance(20)) {
+        return "null";
+    }
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "\"https://i.scdn.co/image/ab6761610000e5eb%016llx\"",
+             static_cast<unsigned long long>(random.next()));
+    return buffer;
+}
+
+std::string coordinate(Random& random, int whole) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%d.%06d", whole, static_cast<int>(random.below(1000000)));
+    return buffer;
+}
+
+const char* flag(Random& random) {
+    return random.chance(10) ? "true" : "false";
+}
+
+// Artists are drawn from a fixed roster, as a real feed repeats them
+std::string artist(uint64_t id) {
+    Random random(id * 7919 + 1);
+    std::string out = "{\"id\":" + quoted(uuid(random, "artist"));
+    out += ",\"name\":" + quoted(words(random, 1 + random.below(3)));
+    out += ",\"imageUrl\":" + imageUrl(random);
+    out += ",\"spotifyId\":";
+    out += random.chance(30) ? "null" : quoted(uuid(random, "sp").substr(3, 22));
+    out += ",\"genres\":[";
+    size_t genres = random.below(4);
+    for (size_t i = 0; i < genres; ++i) {
+        out += (i > 0 ? ",\"" : "\"") + std::string(pick(random, GENRES)) + "\"";
+    }
+    out += "],\"popularity\":" + std::to_string(random.below(101));
+    out += ",\"isFavorite\":" + std::string(flag(random)) + "}";
+    return out;
+}
+
+std::string venue(Random& random) {
+    const char* const* city = CITIES[random.below(sizeof(CITIES) / sizeof(CITIES[0]))];
+    std::string out = "{\"id\":" + quoted(uuid(random, "venue"));
+    out += ",\"name\":" + quoted(words(random, 2) + " Hall");
+    out += ",\"address\":" + quoted(std::to_string(1 + random.below(999)) + " Main St, Suite " + std::to_string(random.below(50)));
+    out += ",\"city\":" + quoted(city[0]) + ",\"state\":" + quoted(city[1]) + ",\"country\":" + quoted(city[2]);
+    out += ",\"latitude\":" + coordinate(random, 40) + ",\"longitude\":" + coordinate(random, -73);
+    out += ",\"imageUrl\":" + imageUrl(random) + ",\"isFavorite\":" + flag(random) + "}";
+    return out;
+}
+
+std::string event(Random& random) {
+    std::string out = "{\"id\":" + quoted(uuid(random, "event"));
+    out += ",\"name\":" + quoted(words(random, 3));
+    out += ",\"description\":" + quoted(words(random, 8 + random.below(24)) + "\\nDoors at 8pm.\\tAll ages.");
+    char dates[96];
+    int day = 1 + static_cast<int>(random.below(28));
+    snprintf(dates, sizeof(dates), ",\"startDate\":\"2025-06-%02dT20:00:00Z\",\"endDate\":\"2025-06-%02dT23:30:00Z\"", day, day);
+    out += dates;
+    out += ",\"imageUrl\":" + imageUrl(random);
+    out += ",\"venueId\":" + quoted("venue-" + std::to_string(random.below(300)));
+    out += ",\"venueName\":" + quoted(std::string(CITIES[random.below(9)][0]) + " Music Hall");
+    out += ",\"artists\":[";
+    size_t artists = 1 + random.below(3);
+    for (size_t i = 0; i < artists; ++i) {
+        out += (i > 0 ? "," : "") + artist(random.below(2000));
+    }
+    out += "],\"isFavorite\":" + std::string(flag(random));
+    out += ",\"latitude\":" + coordinate(random, 40) + ",\"longitude\":" + coordinate(random, -73) + "}";
+    return out;
+}
+
+std::string city(Random& random) {
+    const char* const* city = CITIES[random.below(sizeof(CITIES) / sizeof(CITIES[0]))];
+    return "{\"id\":" + quoted(uuid(random, "city")) + ",\"name\":" + quoted(city[0]) +
+           ",\"state\":" + quoted(city[1]) + ",\"country\":" + quoted(city[2]) +
+           ",\"latitude\":" + coordinate(random, 37) + ",\"longitude\":" + coordinate(random, -122) + "}";
+}
+
+std::string userCity(Random& random) {
+    return "{\"id\":" + quoted(uuid(random, "uc")) + ",\"cityId\":" + quoted(uuid(random, "city")) +
+           ",\"cityName\":" + quoted(CITIES[random.below(9)][0]) + ",\"radius\":" +
+           std::to_string(5 + random.below(100)) + ".5,\"selected\":" + flag(random) + "}";
+}
+
+std::string user(Random& random) {
+    return "{\"id\":" + quoted(uuid(random, "user")) + ",\"name\":" + quoted(words(random, 2)) +
+           ",\"email\":\"listener@example.com\",\"appleId\":null,\"spotifyId\":\"31abcxyz\"" +
+           ",\"accountCreationDate\":1717171717000,\"profileImage\":" + imageUrl(random) +
+           ",\"spotifyProfileImage\":null,\"playlistLocalSongsPerSeed\":3,\"anonymousUser\":false" +
+           ",\"emailConnected\":true,\"appleConnected\":false,\"spotifyConnected\":true,\"emailVerified\":true" +
+           ",\"emailOptIn\":false,\"isAdmin\":false,\"isTeamMember\":false,\"playlistUseSeedSongs\":true" +
+           ",\"playlistGeneration\":false}";
+}
+
+// A top-level array of generated elements, about targetBytes long
+template<typename Generate>
+std::string array(size_t targetBytes, Generate generate) {
+    std::string out = "[";
+    while (out.size() < targetBytes) {
+        if (out.size() > 1) {
+            out += ',';
+        }
+        out += generate();
+    }
+    out += ']';
+    return out;
+}
+
+std::string search(Random& random, size_t targetBytes) {
+    size_t share = targetBytes / 4;
+    return "{\"artists\":" + array(share, [&]() { return artist(random.below(2000)); }) +
+           ",\"events\":" + array(share, [&]() { return event(random); }) +
+           ",\"venues\":" + array(share, [&]() { return venue(random); }) +
+           ",\"cities\":" + array(share, [&]() { return city(random); }) + "}";
+}
+
+std::string sizeLabel(size_t bytes) {
+    return bytes >= MB ? std::to_string(bytes / MB) + "mb" : std::to_string(bytes / KB) + "kb";
+}
+
+// Escape-dense text of about length bytes: every kind of escape, surrogate
+// pairs and raw multi-byte UTF-8
+std::string escapeHeavy(size_t length) {
+    static const char PATTERN[] = "tab\\tquote\\\"slash\\/back\\\\\\u00e9\\ud83c\\udfb8 naïve 日本 \\n";
+    std::string out;
+    out.reserve(length + sizeof(PATTERN));
+    while (out.size() < length) {
+        out += PATTERN;
+    }
+    return out;
+}
+
+} // namespace
+
+const char* kindName(PayloadKind kind) {
+    switch (kind) {
+        case PayloadKind::AUTH: return "auth";
+        case PayloadKind::USER: return "user";
+        case PayloadKind::ARTIST: return "artist";
+        case PayloadKind::EVENT: return "event";
+        case PayloadKind::VENUE: return "venue";
+        case PayloadKind::CITY: return "city";
+        case PayloadKind::USER_CITY: return "user city";
+        case PayloadKind::ERROR: return "error";
+        case PayloadKind::SEARCH: return "search";
+        case PayloadKind::ARTISTS: return "artist array";
+        case PayloadKind::EVENTS: return "event array";
+        case PayloadKind::VENUES: return "venue array";
+        case PayloadKind::CITIES: return "city array";
+        case PayloadKind::USER_CITIES: return "user city array";
+        case PayloadKind::STRINGS: return "string array";
+    }
+    return "unknown";
+}
+
+std::vector<Payload> buildCorpus(size_t maxBytes) {
+    Random random(0x10CA11F7);
+    std::vector<Payload> corpus;
+
+    // Single objects, as the account and detail endpoints return them
+    corpus.push_back({"auth", PayloadKind::AUTH,
+                      "{\"token\":\"eyJhbGciOiJIUzI1NiJ9." + uuid(random, "t") + "\",\"refreshToken\":\"" +
+                      uuid(random, "r") + "\",\"expiresIn\":3600}"});
+    corpus.push_back({"user", PayloadKind::USER, user(random)});
+    corpus.push_back({"artist", PayloadKind::ARTIST, artist(7)});
+    corpus.push_back({"event", PayloadKind::EVENT, event(random)});
+    corpus.push_back({"venue", PayloadKind::VENUE, venue(random)});
+    corpus.push_back({"city", PayloadKind::CITY, city(random)});
+    corpus.push_back({"user-city", PayloadKind::USER_CITY, userCity(random)});
+    corpus.push_back({"error", PayloadKind::ERROR,
+                      "{\"status\":404,\"error\":\"Not Found\",\"message\":\"No event \\\"x\\\"\",\"path\":\"/v1/events/x\","
+                      "\"timestamp\":\"2025-06-01T12:00:00Z\",\"requestId\":\"" + uuid(random, "req") + "\"}"});
+
+    // Lists at each size up to maxBytes
+    for (size_t size : {KB, 64 * KB, MB, 10 * MB}) {
+        if (size > maxBytes) {
+            break;
+        }
+        std::string label = sizeLabel(size);
+        corpus.push_back({"events-" + label, PayloadKind::EVENTS, array(size, [&]() { return event(random); })});
+        corpus.push_back({"artists-" + label, PayloadKind::ARTISTS, array(size, [&]() { return artist(random.below(2000)); })});
+        corpus.push_back({"venues-" + label, PayloadKind::VENUES, array(size, [&]() { return venue(random); })});
+        corpus.push_back({"cities-" + label, PayloadKind::CITIES, array(size, [&]() { return city(random); })});
+        if (size <= MB) {
+            corpus.push_back({"search-" + label, PayloadKind::SEARCH, search(random, size)});
+            corpus.push_back({"user-cities-" + label, PayloadKind::USER_CITIES, array(size, [&]() { return userCity(random); })});
+            corpus.push_back({"strings-" + label, PayloadKind::STRINGS,
+                              array(size, [&]() { return quoted(pick(random, GENRES)); })});
+        }
+    }
+
+    // Worst cases. Deep nesting in a member nobody reads: the tape must
+    // skip it without recursing.
+    size_t depth = maxBytes >= MB ? 100000 : 1000;
+    std::string nested(depth, '[');
+    nested += std::string(depth, ']');
+    corpus.push_back({"deep-nesting-member", PayloadKind::EVENTS,
+                      "[{\"id\":\"e1\",\"extra\":" + nested + ",\"name\":\"after\"}," + event(random) + "]"});
+    std::string objects;
+    for (size_t i = 0; i < depth; ++i) {
+        objects += "{\"a\":";
+    }
+    objects += "1" + std::string(depth, '}');
+    corpus.push_back({"deep-nesting-objects", PayloadKind::SEARCH, objects});
+
+    // One huge escape-dense string, and long plain ones throughout
+    size_t longLength = maxBytes >= 4 * MB ? 4 * MB : maxBytes / 4;
+    corpus.push_back({"long-escaped-string", PayloadKind::EVENT,
+                      "{\"id\":\"e\",\"name\":\"long\",\"description\":\"" + escapeHeavy(longLength) + "\",\"venueName\":\"v\"}"});
+    corpus.push_back({"long-plain-strings", PayloadKind::EVENTS, array(std::min(maxBytes, 2 * MB), [&]() {
+        return "{\"id\":\"" + uuid(random, "e") + "\",\"description\":\"" + std::string(64 * KB, 'x') + "\"}";
+    })});
+
+    // Escaped member names take the slow key path
+    corpus.push_back({"escaped-keys", PayloadKind::ARTISTS, array(std::min(maxBytes, 64 * KB), [&]() {
+        return std::string("{\"\\u0069d\":\"a\",\"n\\u0061me\":\"") + pick(random, WORDS) +
+               "\",\"\\u0067enres\":[\"pop\"],\"popularity\":1}";
+    })});
+
+    // Numbers at and past the edges, and values of the wrong type
+    corpus.push_back({"extreme-numbers", PayloadKind::CITIES,
+                      "[{\"id\":1,\"name\":null,\"latitude\":1.7976931348623157e308,\"longitude\":-0.0},"
+                      "{\"id\":\"c\",\"latitude\":1e999,\"longitude\":4.9e-324},"
+                      "{\"id\":\"d\",\"latitude\":\"40.7\",\"longitude\":[1]},"
+                      "{\"id\":\"e\",\"latitude\":123456789012345678901234567890,\"longitude\":-1E-7}]"});
+    corpus.push_back({"wrong-types", PayloadKind::EVENTS,
+                      "[{\"id\":5,\"name\":{\"x\":1},\"artists\":{\"id\":\"a\"},\"isFavorite\":\"yes\","
+                      "\"latitude\":true},null,3,\"text\",[],{}]"});
+
+    // Bodies cut short, as a dropped connection leaves them
+    corpus.push_back({"truncated-events", PayloadKind::EVENTS,
+                      array(4 * KB, [&]() { return event(random); }).substr(0, 2700)});
+    corpus.push_back({"truncated-search", PayloadKind::SEARCH, search(random, 4 * KB).substr(0, 2500)});
+    return corpus;
+}
+
+std::string eventArray(size_t targetBytes) {
+    Random random(0xFEED5);
+    return array(targetBytes, [&]() { return event(random); });
+}
+
+std::string eventFeed(size_t count) {
+    Random random(0xFEED5);
+    std::string out = "[";
+    for (size_t i = 0; i < count; ++i) {
+        out += (i > 0 ? "," : "") + event(random);
+    }
+    return out + "]";
+}
+
+} // namespace bench
+} // namespace localify
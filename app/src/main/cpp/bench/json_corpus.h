@@ -0,0 +1,52 @@
+#ifndef LOCALIFY_JSON_CORPUS_H
+#define LOCALIFY_JSON_CORPUS_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace localify {
+namespace bench {
+
+// Which JSONParser entry point a payload is shaped for
+enum class PayloadKind {
+    AUTH,
+    USER,
+    ARTIST,
+    EVENT,
+    VENUE,
+    CITY,
+    USER_CITY,
+    ERROR,
+    SEARCH,
+    ARTISTS,
+    EVENTS,
+    VENUES,
+    CITIES,
+    USER_CITIES,
+    STRINGS
+};
+
+struct Payload {
+    std::string name;       // e.g. "events-1mb", unique within a corpus
+    PayloadKind kind;
+    std::string body;
+};
+
+const char* kindName(PayloadKind kind);
+
+// API-shaped responses from about 1 KB up to maxBytes, plus synthetic worst
+// cases: deep nesting, long and escape-heavy strings, escaped keys, extreme
+// numbers, truncated bodies. Deterministic, so runs are comparable and the
+// benchmark and fuzzer see the same inputs.
+std::vector<Payload> buildCorpus(size_t maxBytes);
+
+// Event lists shaped like the corpus's, for runs that need a set size: one
+// of about targetBytes, and one of exactly count events
+std::string eventArray(size_t targetBytes);
+std::string eventFeed(size_t count);
+
+} // namespace bench
+} // namespace localify
+
+#endif // LOCALIFY_JSON_CORPUS_H
@@ -0,0 +1,270 @@
+// Fuzz target for the JSON layer. Every input goes through every JSONParser
+// entry point, and the results are checked against each other:
+//
+//   - encoding a decoded value, decoding that and encoding again gives the
+//     same text (the serializers and parsers agree on every model)
+//   - arena views encode the same as the owning models
+//   - lazy search results encode the same as eager ones
+//   - parallel array decoding gives the same models as serial
+//   - JSONArrayStream, fed in arbitrary pieces, splits a valid array into
+//     as many elements as the tape finds, each of them valid JSON
+//
+// Built with LOCALIFY_LIBFUZZER this is a plain libFuzzer target. Otherwise
+// main() replays the corpus (json_corpus.h) and deterministic mutations of
+// it, which is what ctest runs:
+//
+//   json_fuzz [--iterations N] [--seed N] [--write-corpus DIR]
+
+#include "json_corpus.h"
+#include "json_parser.h"
+#include "model_schema.h"
+#include "model_views.h"
+#include "worker_pool.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace localify;
+
+namespace {
+
+void check(bool condition, const char* invariant, const std::string& detail = std::string()) {
+    if (!condition) {
+        fprintf(stderr, "json_fuzz: %s\n%s\n", invariant, detail.substr(0, 2048).c_str());
+        abort();
+    }
+}
+
+template<typename Parse>
+void checkRoundTrip(const std::string& input, const char* name, Parse parse) {
+    std::string encoded = toJSON(parse(input));
+    std::string again = toJSON(parse(encoded));
+    check(encoded == again, name, encoded + "\n--- re-encoded as ---\n" + again);
+}
+
+template<typename Parse, typename ParseInArena>
+void checkArena(const std::string& input, const char* name, Parse parse, ParseInArena parseInArena) {
+    Arena arena;
+    std::string models = toJSON(parse(input));
+    std::string views = toJSON(parseInArena(input, arena));
+    check(models == views, name, models + "\n--- arena views ---\n" + views);
+}
+
+template<typename Parse>
+void checkParallel(const std::string& input, const char* name, Parse parse) {
+    // Enough threads for tasks to interleave even on a single-core machine
+    WorkerPool& pool = WorkerPool::getInstance();
+    if (pool.getThreadCount() < 4) {
+        pool.setThreadCount(4);
+    }
+    size_t threshold = JSONParser::getParallelDecodeThreshold();
+    JSONParser::setParallelDecodeThreshold(0);
+    std::string serial = toJSON(parse(input));
+    JSONParser::setParallelDecodeThreshold(1);
+    std::string parallel = toJSON(parse(input));
+    JSONParser::setParallelDecodeThreshold(threshold);
+    check(serial == parallel, name);
+}
+
+void checkStream(const std::string& input, const uint8_t* data, size_t size) {
+    // Piece boundaries come from the input bytes so each input splits the
+    // same way every time
+    std::vector<std::string> elements;
+    JSONArrayStream stream([&elements](std::string element) {
+        elements.push_back(std::move(element));
+    });
+    size_t at = 0;
+    for (size_t step = 0; at < input.size(); ++step) {
+        size_t piece = 1 + data[(step * 7) % size] % 64;
+        piece = std::min(piece, input.size() - at);
+        stream.feed(input.data() + at, piece);
+        at += piece;
+    }
+
+    JSONTape tape;
+    if (!tape.parse(input) || !tape.root().isArray() || !stream.isComplete()) {
+        return;
+    }
+    check(elements.size() == tape.root().size(), "JSONArrayStream element count matches the tape");
+    for (const std::string& element : elements) {
+        JSONTape elementTape;
+        check(elementTape.parse(element), "JSONArrayStream elements are valid JSON", element);
+    }
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string input(reinterpret_cast<const char*>(data), size);
+
+    checkRoundTrip(input, "AuthResponse round trip", JSONParser::parseAuthResponse);
+    checkRoundTrip(input, "UserDetails round trip", JSONParser::parseUserDetails);
+    checkRoundTrip(input, "ArtistResponse round trip", JSONParser::parseArtistResponse);
+    checkRoundTrip(input, "EventResponse round trip", JSONParser::parseEventResponse);
+    checkRoundTrip(input, "VenueResponse round trip", JSONParser::parseVenueResponse);
+    checkRoundTrip(input, "CityResponse round trip", JSONParser::parseCityResponse);
+    checkRoundTrip(input, "UserCity round trip", JSONParser::parseUserCity);
+    checkRoundTrip(input, "ErrorResponse round trip", JSONParser::parseErrorResponse);
+    checkRoundTrip(input, "SearchResponse round trip", [](const std::string& json) {
+        return JSONParser::parseSearchResponse(json);
+    });
+    checkRoundTrip(input, "UserCity array round trip", JSONParser::parseUserCityArray);
+    checkRoundTrip(input, "string array round trip", JSONParser::parseStringArray);
+    check(JSONParser::serializeUserDetails(JSONParser::parseUserDetails(input)) ==
+          toJSON(JSONParser::parseUserDetails(input)), "serializeUserDetails matches toJSON");
+    check(JSONParser::serializeUserCity(JSONParser::parseUserCity(input)) ==
+          toJSON(JSONParser::parseUserCity(input)), "serializeUserCity matches toJSON");
+    check(JSONParser::serializeStringArray(JSONParser::parseStringArray(input)) ==
+          toJSON(JSONParser::parseStringArray(input)), "serializeStringArray matches toJSON");
+
+    auto artists = [](const std::string& json) { return JSONParser::parseArtistArray(json); };
+    auto events = [](const std::string& json) { return JSONParser::parseEventArray(json); };
+    auto venues = [](const std::string& json) { return JSONParser::parseVenueArray(json); };
+    auto cities = [](const std::string& json) { return JSONParser::parseCityArray(json); };
+    checkRoundTrip(input, "artist array round trip", artists);
+    checkRoundTrip(input, "event array round trip", events);
+    checkRoundTrip(input, "venue array round trip", venues);
+    checkRoundTrip(input, "city array round trip", cities);
+
+    checkArena(input, "artist arena views match models", artists, [](std::string_view json, Arena& arena) {
+        return JSONParser::parseArtistArray(json, arena);
+    });
+    checkArena(input, "event arena views match models", events, [](std::string_view json, Arena& arena) {
+        return JSONParser::parseEventArray(json, arena);
+    });
+    checkArena(input, "venue arena views match models", venues, [](std::string_view json, Arena& arena) {
+        return JSONParser::parseVenueArray(json, arena);
+    });
+    checkArena(input, "city arena views match models", cities, [](std::string_view json, Arena& arena) {
+        return JSONParser::parseCityArray(json, arena);
+    });
+    checkArena(input, "search arena views match models", [](const std::string& json) {
+        return JSONParser::parseSearchResponse(json);
+    }, [](std::string_view json, Arena& arena) {
+        return JSONParser::parseSearchResponse(json, arena);
+    });
+
+    std::string eager = toJSON(JSONParser::parseSearchResponse(input));
+    std::string lazy = toJSON(JSONParser::parseSearchResponseLazy(input)->toSearchResponse());
+    check(eager == lazy, "lazy search matches eager", eager + "\n--- lazy ---\n" + lazy);
+
+    checkParallel(input, "parallel artist array matches serial", artists);
+    checkParallel(input, "parallel event array matches serial", events);
+    checkParallel(input, "parallel user city array matches serial", JSONParser::parseUserCityArray);
+
+    if (size > 0) {
+        checkStream(input, data, size);
+    }
+    return 0;
+}
+
+#ifndef LOCALIFY_LIBFUZZER
+
+namespace {
+
+// Deterministic, so a failure reproduces with the same --seed
+uint64_t nextRandom(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+// One to four edits of the kinds that find parser bugs: bytes flipped,
+// JSON punctuation dropped in, ranges cut, duplicated or truncated, and
+// splices from another seed
+std::string mutate(const std::vector<bench::Payload>& corpus, uint64_t& state) {
+    static const char TOKENS[] = "{}[]\",:\\0123456789.-+eEtrufalsn u\x00\x1f\xc3\xa9\xed\xa0\x80\xf0\x9f";
+    std::string text = corpus[nextRandom(state) % corpus.size()].body;
+    size_t edits = 1 + nextRandom(state) % 4;
+    for (size_t edit = 0; edit < edits; ++edit) {
+        size_t at = text.empty() ? 0 : nextRandom(state) % text.size();
+        size_t length = std::min<size_t>(1 + nextRandom(state) % 64, text.size() - at);
+        switch (nextRandom(state) % 6) {
+            case 0:
+                if (!text.empty()) {
+                    text[at] = static_cast<char>(text[at] ^ (1 << (nextRandom(state) % 8)));
+                }
+                break;
+            case 1:
+                text.insert(at, 1, TOKENS[nextRandom(state) % (sizeof(TOKENS) - 1)]);
+                break;
+            case 2:
+                text.erase(at, length);
+                break;
+            case 3:
+                text.insert(at, text.substr(at, length));
+                break;
+            case 4:
+                text.resize(at);
+                break;
+            default: {
+                const std::string& other = corpus[nextRandom(state) % corpus.size()].body;
+                size_t from = other.empty() ? 0 : nextRandom(state) % other.size();
+                text.insert(at, other.substr(from, 1 + nextRandom(state) % 256));
+                break;
+            }
+        }
+    }
+    return text;
+}
+
+void run(const std::string& input) {
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+bool writeCorpus(const std::vector<bench::Payload>& corpus, const char* directory) {
+    for (const bench::Payload& payload : corpus) {
+        std::string path = std::string(directory) + "/" + payload.name + ".json";
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            fprintf(stderr, "json_fuzz: cannot write %s\n", path.c_str());
+            return false;
+        }
+        fwrite(payload.body.data(), 1, payload.body.size(), file);
+        fclose(file);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = 2000;
+    uint64_t seed = 0x5EED;
+    const char* corpusDirectory = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--iterations") == 0 && hasValue) {
+            iterations = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "--write-corpus") == 0 && hasValue) {
+            corpusDirectory = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--iterations N] [--seed N] [--write-corpus DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Small enough that thousands of iterations finish in seconds, large
+    // enough that arrays span several parallel decode tasks
+    std::vector<bench::Payload> corpus = bench::buildCorpus(64 * 1024);
+    if (corpusDirectory != nullptr) {
+        return writeCorpus(corpus, corpusDirectory) ? 0 : 1;
+    }
+
+    for (const bench::Payload& payload : corpus) {
+        run(payload.body);
+    }
+    uint64_t state = seed;
+    for (size_t i = 0; i < iterations; ++i) {
+        run(mutate(corpus, state));
+    }
+    printf("json_fuzz: %zu seeds and %zu mutations passed\n", corpus.size(), iterations);
+    return 0;
+}
+
+#endif // LOCALIFY_LIBFUZZER
@@ -0,0 +1,227 @@
+#include "json_regex_baseline.h"
+#include <regex>
+
+namespace localify {
+namespace bench {
+namespace regex_baseline {
+
+namespace {
+
+std::string trim(const std::string& str) {
+    size_t start = str.find_first_not_of(" \t\n\r");
+    if (start == std::string::npos) return "";
+    size_t end = str.find_last_not_of(" \t\n\r");
+    return str.substr(start, end - start + 1);
+}
+
+std::string unescapeJsonString(const std::string& str) {
+    std::regex escapePattern("\\\\([\"\\\\/bfnrt])");
+    return std::regex_replace(str, escapePattern, "$1");
+}
+
+std::string extractStringValue(const std::string& json, const std::string& key) {
+    std::regex pattern("\"" + key + "\"\\s*:\\s*\"([^\"]*?)\"");
+    std::smatch match;
+    if (std::regex_search(json, match, pattern)) {
+        return unescapeJsonString(match[1].str());
+    }
+    return "";
+}
+
+int extractIntValue(const std::string& json, const std::string& key) {
+    std::regex pattern("\"" + key + "\"\\s*:\\s*([0-9]+)");
+    std::smatch match;
+    if (std::regex_search(json, match, pattern)) {
+        return std::stoi(match[1].str());
+    }
+    return 0;
+}
+
+double extractDoubleValue(const std::string& json, const std::string& key) {
+    std::regex pattern("\"" + key + "\"\\s*:\\s*([0-9]+\\.?[0-9]*)");
+    std::smatch match;
+    if (std::regex_search(json, match, pattern)) {
+        return std::stod(match[1].str());
+    }
+    return 0.0;
+}
+
+bool extractBoolValue(const std::string& json, const std::string& key) {
+    std::regex pattern("\"" + key + "\"\\s*:\\s*(true|false)");
+    std::smatch match;
+    if (std::regex_search(json, match, pattern)) {
+        return match[1].str() == "true";
+    }
+    return false;
+}
+
+std::optional<std::string> extractOptionalStringValue(const std::string& json, const std::string& key) {
+    std::regex pattern("\"" + key + "\"\\s*:\\s*(\"([^\"]*?)\"|null)");
+    std::smatch match;
+    if (std::regex_search(json, match, pattern)) {
+        if (match[1].str() == "null") {
+            return std::nullopt;
+        }
+        return unescapeJsonString(match[2].str());
+    }
+    return std::nullopt;
+}
+
+std::string findJsonArray(const std::string& json, const std::string& key) {
+    std::regex pattern("\"" + key + "\"\\s*:\\s*(\\[.*?\\])");
+    std::smatch match;
+    if (std::regex_search(json, match, pattern)) {
+        return match[1].str();
+    }
+    return "[]";
+}
+
+std::vector<std::string> splitJsonArray(const std::string& jsonArray) {
+    std::vector<std::string> result;
+    if (jsonArray.length() < 2) return result;
+
+    std::string content = jsonArray.substr(1, jsonArray.length() - 2);
+    if (content.empty()) return result;
+
+    int braceCount = 0;
+    size_t start = 0;
+    bool inString = false;
+    bool escaped = false;
+    for (size_t i = 0; i < content.length(); ++i) {
+        char c = content[i];
+        if (!inString) {
+            if (c == '{') braceCount++;
+            else if (c == '}') braceCount--;
+            else if (c == '"') inString = true;
+            else if (c == ',' && braceCount == 0) {
+                result.push_back(trim(content.substr(start, i - start)));
+                start = i + 1;
+            }
+        } else {
+            if (!escaped) {
+                if (c == '"') inString = false;
+                else if (c == '\\') escaped = true;
+            } else {
+                escaped = false;
+            }
+        }
+    }
+    if (start < content.length()) {
+        result.push_back(trim(content.substr(start)));
+    }
+    return result;
+}
+
+ArtistResponse parseArtistResponse(const std::string& json) {
+    ArtistResponse artist;
+    artist.id = extractStringValue(json, "id");
+    artist.name = extractStringValue(json, "name");
+    artist.imageUrl = extractOptionalStringValue(json, "imageUrl");
+    artist.spotifyId = extractOptionalStringValue(json, "spotifyId");
+    artist.popularity = extractIntValue(json, "popularity");
+    artist.isFavorite = extractBoolValue(json, "isFavorite");
+
+    std::vector<std::string> genreObjects = splitJsonArray(findJsonArray(json, "genres"));
+    for (const std::string& genreStr : genreObjects) {
+        std::string genre = genreStr;
+        if (genre.front() == '"' && genre.back() == '"') {
+            genre = genre.substr(1, genre.length() - 2);
+        }
+        artist.genres.push_back(genre);
+    }
+    return artist;
+}
+
+VenueResponse parseVenueResponse(const std::string& json) {
+    VenueResponse venue;
+    venue.id = extractStringValue(json, "id");
+    venue.name = extractStringValue(json, "name");
+    venue.address = extractStringValue(json, "address");
+    venue.city = extractStringValue(json, "city");
+    venue.state = extractStringValue(json, "state");
+    venue.country = extractStringValue(json, "country");
+    venue.latitude = extractDoubleValue(json, "latitude");
+    venue.longitude = extractDoubleValue(json, "longitude");
+    venue.imageUrl = extractOptionalStringValue(json, "imageUrl");
+    venue.isFavorite = extractBoolValue(json, "isFavorite");
+    return venue;
+}
+
+CityResponse parseCityResponse(const std::string& json) {
+    CityResponse city;
+    city.id = extractStringValue(json, "id");
+    city.name = extractStringValue(json, "name");
+    city.state = extractStringValue(json, "state");
+    city.country = extractStringValue(json, "country");
+    city.latitude = extractDoubleValue(json, "latitude");
+    city.longitude = extractDoubleValue(json, "longitude");
+    return city;
+}
+
+} // namespace
+
+EventResponse parseEventResponse(const std::string& json) {
+    EventResponse event;
+    event.id = extractStringValue(json, "id");
+    event.name = extractStringValue(json, "name");
+    event.description = extractStringValue(json, "description");
+    event.startDate = extractStringValue(json, "startDate");
+    event.endDate = extractStringValue(json, "endDate");
+    event.imageUrl = extractOptionalStringValue(json, "imageUrl");
+    event.venueId = extractStringValue(json, "venueId");
+    event.venueName = extractStringValue(json, "venueName");
+    event.isFavorite = extractBoolValue(json, "isFavorite");
+    event.latitude = extractDoubleValue(json, "latitude");
+    event.longitude = extractDoubleValue(json, "longitude");
+
+    std::vector<std::string> artistObjects = splitJsonArray(findJsonArray(json, "artists"));
+    for (const std::string& artistJson : artistObjects) {
+        event.artists.push_back(parseArtistResponse(artistJson));
+    }
+    return event;
+}
+
+SearchResponse parseSearchResponse(const std::string& json) {
+    SearchResponse search;
+    search.artists = parseArtistArray(findJsonArray(json, "artists"));
+    search.events = parseEventArray(findJsonArray(json, "events"));
+    search.venues = parseVenueArray(findJsonArray(json, "venues"));
+    search.cities = parseCityArray(findJsonArray(json, "cities"));
+    return search;
+}
+
+std::vector<ArtistResponse> parseArtistArray(const std::string& json) {
+    std::vector<ArtistResponse> artists;
+    for (const std::string& artistJson : splitJsonArray(json)) {
+        artists.push_back(parseArtistResponse(artistJson));
+    }
+    return artists;
+}
+
+std::vector<EventResponse> parseEventArray(const std::string& json) {
+    std::vector<EventResponse> events;
+    for (const std::string& eventJson : splitJsonArray(json)) {
+        events.push_back(parseEventResponse(eventJson));
+    }
+    return events;
+}
+
+std::vector<VenueResponse> parseVenueArray(const std::string& json) {
+    std::vector<VenueResponse> venues;
+    for (const std::string& venueJson : splitJsonArray(json)) {
+        venues.push_back(parseVenueResponse(venueJson));
+    }
+    return venues;
+}
+
+std::vector<CityResponse> parseCityArray(const std::string& json) {
+    std::vector<CityResponse> cities;
+    for (const std::string& cityJson : splitJsonArray(json)) {
+        cities.push_back(parseCityResponse(cityJson));
+    }
+    return cities;
+}
+
+} // namespace regex_baseline
+} // namespace bench
+} // namespace localify
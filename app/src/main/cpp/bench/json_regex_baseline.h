@@ -0,0 +1,27 @@
+#ifndef LOCALIFY_JSON_REGEX_BASELINE_H
+#define LOCALIFY_JSON_REGEX_BASELINE_H
+
+#include "models.h"
+#include <string>
+#include <vector>
+
+namespace localify {
+namespace bench {
+
+// JSONParser's event and search decoding as it was before the token tape:
+// a std::regex compiled and run over the element for every field. Kept only
+// so json_bench can show what the tape replaced; nothing else may use it.
+namespace regex_baseline {
+
+EventResponse parseEventResponse(const std::string& json);
+SearchResponse parseSearchResponse(const std::string& json);
+std::vector<ArtistResponse> parseArtistArray(const std::string& json);
+std::vector<EventResponse> parseEventArray(const std::string& json);
+std::vector<VenueResponse> parseVenueArray(const std::string& json);
+std::vector<CityResponse> parseCityArray(const std::string& json);
+
+} // namespace regex_baseline
+} // namespace bench
+} // namespace localify
+
+#endif // LOCALIFY_JSON_REGEX_BASELINE_H
@@ -0,0 +1,61 @@
+#ifndef LOCALIFY_HOST_EGL_H
+#define LOCALIFY_HOST_EGL_H
+
+// Stand-in for <EGL/egl.h> in host builds. Every call succeeds and hands
+// back a placeholder handle, so the UI runs headless.
+
+#include <android/native_activity.h>
+#include <cstdint>
+
+typedef int32_t EGLint;
+typedef unsigned int EGLBoolean;
+typedef void* EGLDisplay;
+typedef void* EGLSurface;
+typedef void* EGLContext;
+typedef void* EGLConfig;
+typedef ANativeWindow* EGLNativeWindowType;
+
+#define EGL_FALSE 0
+#define EGL_TRUE 1
+#define EGL_DEFAULT_DISPLAY nullptr
+#define EGL_NO_DISPLAY static_cast<EGLDisplay>(nullptr)
+#define EGL_NO_SURFACE static_cast<EGLSurface>(nullptr)
+#define EGL_NO_CONTEXT static_cast<EGLContext>(nullptr)
+
+#define EGL_ALPHA_SIZE 0x3021
+#define EGL_BLUE_SIZE 0x3022
+#define EGL_GREEN_SIZE 0x3023
+#define EGL_RED_SIZE 0x3024
+#define EGL_DEPTH_SIZE 0x3025
+#define EGL_NONE 0x3038
+#define EGL_SURFACE_TYPE 0x3033
+#define EGL_WINDOW_BIT 0x0004
+#define EGL_CONTEXT_CLIENT_VERSION 0x3098
+
+namespace localify_host_egl {
+inline void* handle() {
+    static int placeholder;
+    return &placeholder;
+}
+}
+
+inline EGLDisplay eglGetDisplay(void*) { return localify_host_egl::handle(); }
+inline EGLBoolean eglInitialize(EGLDisplay, EGLint*, EGLint*) { return EGL_TRUE; }
+inline EGLBoolean eglChooseConfig(EGLDisplay, const EGLint*, EGLConfig* config, EGLint, EGLint* count) {
+    *config = localify_host_egl::handle();
+    *count = 1;
+    return EGL_TRUE;
+}
+inline EGLSurface eglCreateWindowSurface(EGLDisplay, EGLConfig, EGLNativeWindowType, const EGLint*) {
+    return localify_host_egl::handle();
+}
+inline EGLContext eglCreateContext(EGLDisplay, EGLConfig, EGLContext, const EGLint*) {
+    return localify_host_egl::handle();
+}
+inline EGLBoolean eglMakeCurrent(EGLDisplay, EGLSurface, EGLSurface, EGLContext) { return EGL_TRUE; }
+inline EGLBoolean eglSwapBuffers(EGLDisplay, EGLSurface) { return EGL_TRUE; }
+inline EGLBoolean eglDestroyContext(EGLDisplay, EGLContext) { return EGL_TRUE; }
+inline EGLBoolean eglDestroySurface(EGLDisplay, EGLSurface) { return EGL_TRUE; }
+inline EGLBoolean eglTerminate(EGLDisplay) { return EGL_TRUE; }
+
+#endif // LOCALIFY_HOST_EGL_H
@@ -0,0 +1,23 @@
+#ifndef LOCALIFY_HOST_GLES2_H
+#define LOCALIFY_HOST_GLES2_H
+
+// Stand-in for <GLES2/gl2.h> in host builds; the calls draw nothing
+
+typedef unsigned int GLenum;
+typedef unsigned int GLbitfield;
+typedef int GLint;
+typedef int GLsizei;
+typedef float GLfloat;
+
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_BLEND 0x0BE2
+#define GL_SRC_ALPHA 0x0302
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+
+inline void glViewport(GLint, GLint, GLsizei, GLsizei) {}
+inline void glEnable(GLenum) {}
+inline void glBlendFunc(GLenum, GLenum) {}
+inline void glClearColor(GLfloat, GLfloat, GLfloat, GLfloat) {}
+inline void glClear(GLbitfield) {}
+
+#endif // LOCALIFY_HOST_GLES2_H
@@ -0,0 +1,8 @@
+#ifndef LOCALIFY_HOST_ANDROID_ASSET_MANAGER_H
+#define LOCALIFY_HOST_ANDROID_ASSET_MANAGER_H
+
+// Stand-in for the NDK's <android/asset_manager.h> in host builds
+
+struct AAssetManager;
+
+#endif // LOCALIFY_HOST_ANDROID_ASSET_MANAGER_H
@@ -0,0 +1,33 @@
+#ifndef LOCALIFY_HOST_ANDROID_INPUT_H
+#define LOCALIFY_HOST_ANDROID_INPUT_H
+
+// Stand-in for the NDK's <android/input.h> in host builds: a single-pointer
+// motion event that host tests build directly
+
+#include <cstddef>
+#include <cstdint>
+
+enum {
+    AINPUT_EVENT_TYPE_KEY = 1,
+    AINPUT_EVENT_TYPE_MOTION = 2
+};
+
+enum {
+    AMOTION_EVENT_ACTION_DOWN = 0,
+    AMOTION_EVENT_ACTION_UP = 1,
+    AMOTION_EVENT_ACTION_MOVE = 2
+};
+
+struct AInputEvent {
+    int32_t type;
+    int32_t action;
+    float x;
+    float y;
+};
+
+inline int32_t AInputEvent_getType(const AInputEvent* event) { return event->type; }
+inline int32_t AMotionEvent_getAction(const AInputEvent* event) { return event->action; }
+inline float AMotionEvent_getX(const AInputEvent* event, size_t) { return event->x; }
+inline float AMotionEvent_getY(const AInputEvent* event, size_t) { return event->y; }
+
+#endif // LOCALIFY_HOST_ANDROID_INPUT_H
@@ -0,0 +1,40 @@
+#ifndef LOCALIFY_HOST_ANDROID_LOG_H
+#define LOCALIFY_HOST_ANDROID_LOG_H
+
+// Stand-in for the NDK's <android/log.h> in host builds. Output goes to
+// stderr, and only when LOCALIFY_HOST_LOG is set: the fuzzer feeds
+// malformed JSON on every iteration and would drown in parse errors.
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT
+};
+
+__attribute__((format(printf, 3, 4)))
+inline int __android_log_print(int priority, const char* tag, const char* format, ...) {
+    static const bool enabled = getenv("LOCALIFY_HOST_LOG") != nullptr;
+    if (!enabled) {
+        return 0;
+    }
+    static const char LEVELS[] = "??VDIWEF?";
+    fprintf(stderr, "%c/%s: ", LEVELS[priority >= 0 && priority <= ANDROID_LOG_SILENT ? priority : 0], tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    return 1;
+}
+
+#endif // LOCALIFY_HOST_ANDROID_LOG_H
@@ -0,0 +1,24 @@
+#ifndef LOCALIFY_HOST_ANDROID_NATIVE_ACTIVITY_H
+#define LOCALIFY_HOST_ANDROID_NATIVE_ACTIVITY_H
+
+// Stand-in for the NDK's <android/native_activity.h> in host builds, with
+// just what the UI code reads. Host tests fill in a window's size directly.
+
+#include <android/asset_manager.h>
+#include <android/input.h>
+#include <cstdint>
+
+struct ANativeWindow {
+    int32_t width;
+    int32_t height;
+};
+
+inline int32_t ANativeWindow_getWidth(ANativeWindow* window) { return window->width; }
+inline int32_t ANativeWindow_getHeight(ANativeWindow* window) { return window->height; }
+
+struct ANativeActivity {
+    const char* internalDataPath;
+    AAssetManager* assetManager;
+};
+
+#endif // LOCALIFY_HOST_ANDROID_NATIVE_ACTIVITY_H
@@ -0,0 +1,7 @@
+#ifndef LOCALIFY_HOST_ANDROID_WINDOW_H
+#define LOCALIFY_HOST_ANDROID_WINDOW_H
+
+// Stand-in for the NDK's <android/window.h> in host builds; ANativeWindow
+// itself is in <android/native_activity.h>
+
+#endif // LOCALIFY_HOST_ANDROID_WINDOW_H
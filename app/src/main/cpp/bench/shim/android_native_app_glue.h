@@ -0,0 +1,28 @@
+#ifndef LOCALIFY_HOST_ANDROID_NATIVE_APP_GLUE_H
+#define LOCALIFY_HOST_ANDROID_NATIVE_APP_GLUE_H
+
+// Stand-in for the NDK's android_native_app_glue.h in host builds: the
+// command numbers only
+
+enum {
+    APP_CMD_INPUT_CHANGED,
+    APP_CMD_INIT_WINDOW,
+    APP_CMD_TERM_WINDOW,
+    APP_CMD_WINDOW_RESIZED,
+    APP_CMD_WINDOW_REDRAW_NEEDED,
+    APP_CMD_CONTENT_RECT_CHANGED,
+    APP_CMD_GAINED_FOCUS,
+    APP_CMD_LOST_FOCUS,
+    APP_CMD_CONFIG_CHANGED,
+    APP_CMD_LOW_MEMORY,
+    APP_CMD_START,
+    APP_CMD_RESUME,
+    APP_CMD_SAVE_STATE,
+    APP_CMD_PAUSE,
+    APP_CMD_STOP,
+    APP_CMD_DESTROY
+};
+
+struct android_app;
+
+#endif // LOCALIFY_HOST_ANDROID_NATIVE_APP_GLUE_H
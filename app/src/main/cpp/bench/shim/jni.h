@@ -0,0 +1,32 @@
+#ifndef LOCALIFY_HOST_JNI_H
+#define LOCALIFY_HOST_JNI_H
+
+// Stand-in for <jni.h> in host builds: the types jni_bridge.cpp uses and
+// the three JNIEnv calls it makes. The calls are virtual so a test can
+// play the JVM, checking what it is handed the way CheckJNI would.
+
+#include <cstdint>
+
+typedef uint8_t jboolean;
+typedef int32_t jint;
+
+class _jobject {};
+class _jstring : public _jobject {};
+typedef _jobject* jobject;
+typedef _jstring* jstring;
+
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+
+#define JNIEXPORT __attribute__((visibility("default")))
+#define JNICALL
+
+struct _JNIEnv {
+    virtual ~_JNIEnv() {}
+    virtual jstring NewStringUTF(const char* bytes) = 0;
+    virtual const char* GetStringUTFChars(jstring string, jboolean* isCopy) = 0;
+    virtual void ReleaseStringUTFChars(jstring string, const char* chars) = 0;
+};
+typedef _JNIEnv JNIEnv;
+
+#endif // LOCALIFY_HOST_JNI_H
@@ -158,7 +158,24 @@ public:
     virtual bool handleTouch(const TouchEvent& event);
     virtual void update(float deltaTime);
     
-    void addComponent(std::unique_ptr<UIComponent> component);
+    // Called as the screen comes into view and as it leaves it, on
+    // navigation and when the app gains or loses focus
+    virtual void onShow() {}
+    virtual void onHide() {}
+    
+    // Starts loading what the screen will show, as background work, before
+    // it is ever shown; called for every other screen on each navigation
+    // once the user is signed in, so it must be cheap to repeat
+    virtual void prefetch() {}
+    
+    // Takes ownership and hands back the component for the screen to keep
+    // using; initialize() clears components, so screens hold plain pointers
+    template<typename T>
+    T* addComponent(std::unique_ptr<T> component) {
+        T* added = component.get();
+        components.push_back(std::move(component));
+        return added;
+    }
     void setTitle(const std::string& newTitle) { title = newTitle; }
     std::string getTitle() const { return title; }
 };
@@ -176,8 +193,10 @@ private:
     bool initialized;
     bool running;
     
-    std::unique_ptr<Screen> currentScreen;
+    // Every screen, indexed by ScreenType and kept for the app's lifetime;
+    // currentScreen points at the one being shown
     std::vector<std::unique_ptr<Screen>> screens;
+    Screen* currentScreen;
     
 public:
     enum ScreenType {
@@ -3,13 +3,21 @@
 
 #include "models.h"
 #include "http_client.h"
+#include "single_flight.h"
+#include "retry_policy.h"
+#include "circuit_breaker.h"
 #include <string>
 #include <memory>
 #include <future>
 #include <functional>
+#include <stdexcept>
+#include <map>
+#include <mutex>
 
 namespace localify {
 
+class LazySearchResponse;
+
 // API Error types
 enum class APIError {
     INVALID_URL,
@@ -23,13 +31,36 @@ enum class APIError {
     CANCELLED
 };
 
+// Thrown by APIService futures when a request fails
+class APIException : public std::runtime_error {
+public:
+    APIException(APIError error, const std::string& message)
+        : std::runtime_error(message), error(error) {}
+    
+    APIError getError() const { return error; }
+    
+private:
+    APIError error;
+};
+
 // HTTP Response structure
 struct HTTPResponse {
     long statusCode;
     std::string data;
     std::string error;
+    HttpError transportError;
     
-    HTTPResponse() : statusCode(0) {}
+    HTTPResponse() : statusCode(0), transportError(HttpError::NONE) {}
+};
+
+// Timing totals for one endpoint; divide by requests for averages
+struct EndpointTiming {
+    size_t requests = 0;
+    size_t failures = 0;
+    size_t reusedConnections = 0;
+    size_t resumedSessions = 0;             // new TLS connections that skipped the full handshake
+    HttpTiming sum;                         // phase durations and bytes, summed
+    std::chrono::microseconds slowest{0};
 };
 
 // Callback types
@@ -42,14 +73,59 @@ private:
     std::string apiUrl;
     std::string currentAuthToken;
     std::string authExpiresAt;
+    SingleFlight inFlightGets;
+    mutable std::mutex timingMutex;
+    std::map<std::string, EndpointTiming> endpointTimings;
+    RetryPolicy retryPolicy;
+    CircuitBreaker circuitBreaker;
+    mutable std::mutex retryMutex;
+    RetryStats retryStats;
+    
+    // Fixed scheduling classes for calls that take no caller token
+    std::shared_ptr<PriorityToken> userVisiblePriority;
+    std::shared_ptr<PriorityToken> backgroundPriority;
     
     // Private constructor for singleton
     APIService();
     
     // HTTP helper methods
+    HttpRequest buildRequest(const std::string& url, const std::string& method,
+                             const std::string& body, bool ignoreAuth) const;
     HTTPResponse performRequest(const std::string& url, const std::string& method, 
-                               const std::string& body = "", bool ignoreAuth = false);
+                               const std::string& body = "", bool ignoreAuth = false,
+                               std::shared_ptr<CancellationToken> cancellation = nullptr,
+                               std::shared_ptr<PriorityToken> priority = nullptr);
+    
+    // Feeds the outcome of an exchange with host into the circuit breaker
+    void recordHostHealth(const std::string& host, const HttpResponse& response);
+    static std::string hostOf(const std::string& url);
+    
+    // Adds a completed exchange to its endpoint's totals
+    void recordTiming(const std::string& method, const std::string& url, const HttpResponse& response);
+    std::string endpointKey(const std::string& method, const std::string& url) const;
+    
+    // Maps a failed response onto APIError and throws APIException
+    [[noreturn]] static void throwRequestFailure(const HTTPResponse& response, const std::string& context);
+    
+    // GETs a JSON array and decodes its elements while the rest is still
+    // downloading; the full body is never held in memory
+    template<typename T>
+    std::vector<T> fetchArrayStreaming(const std::string& url, T (*parseElement)(const std::string&),
+                                       const std::string& description,
+                                       std::shared_ptr<PriorityToken> priority = nullptr,
+                                       std::shared_ptr<CancellationToken> cancellation = nullptr);
+    
+    // Runs fetch once for all concurrent callers of the same GET, sharing
+    // both the network call and the parsed result
+    template<typename T>
+    T coalesceGet(const std::string& url, const std::function<T()>& fetch);
+    // As above for fetches sent at priority; fetch is given the token to send
+    // with, which callers joining at a higher priority raise
+    template<typename T>
+    T coalesceGet(const std::string& url, const std::shared_ptr<PriorityToken>& priority,
+                  const std::function<T(const std::shared_ptr<PriorityToken>&)>& fetch);
     std::string buildURL(const std::string& path) const;
+    std::string searchURL(const std::string& text, bool autoSearchSpotify) const;
     
     // JSON parsing helpers
     template<typename T>
@@ -92,13 +168,30 @@ public:
     // Favorites
     std::future<void> addFavorite(const std::string& id, FavoriteType type);
     std::future<void> removeFavorite(const std::string& id, FavoriteType type);
-    std::future<std::vector<ArtistResponse>> fetchFavoriteArtists(int page = 0, int limit = 20);
-    std::future<std::vector<EventResponse>> fetchFavoriteEvents(int page = 0, int limit = 20, bool upcoming = true);
-    std::future<std::vector<VenueResponse>> fetchFavoriteVenues(int page = 0, int limit = 20);
+    // Favorites load as background work unless the caller passes its own
+    // priority token, e.g. one raised when the favorites screen is shown.
+    // Cancelling the token abandons the load with APIError::CANCELLED
+    std::future<std::vector<ArtistResponse>> fetchFavoriteArtists(int page = 0, int limit = 20,
+                                                                  std::shared_ptr<PriorityToken> priority = nullptr,
+                                                                  std::shared_ptr<CancellationToken> cancellation = nullptr);
+    std::future<std::vector<EventResponse>> fetchFavoriteEvents(int page = 0, int limit = 20, bool upcoming = true,
+                                                                std::shared_ptr<PriorityToken> priority = nullptr,
+                                                                std::shared_ptr<CancellationToken> cancellation = nullptr);
+    std::future<std::vector<VenueResponse>> fetchFavoriteVenues(int page = 0, int limit = 20,
+                                                                std::shared_ptr<PriorityToken> priority = nullptr,
+                                                                std::shared_ptr<CancellationToken> cancellation = nullptr);
     
     // Search
-    std::future<SearchResponse> fetchSearch(const std::string& text, bool autoSearchSpotify = false);
-    std::future<std::vector<ArtistResponse>> fetchSearchArtists(const std::string& text, int limit = 12);
+    // Searches are user-visible and go ahead of queued background requests.
+    // Cancelling the token abandons the request and fails the future with APIError::CANCELLED
+    std::future<SearchResponse> fetchSearch(const std::string& text, bool autoSearchSpotify = false,
+                                            std::shared_ptr<CancellationToken> cancellation = nullptr);
+    // As fetchSearch, but each category is only decoded when first read
+    std::future<std::shared_ptr<LazySearchResponse>> fetchSearchLazy(
+        const std::string& text, bool autoSearchSpotify = false,
+        std::shared_ptr<CancellationToken> cancellation = nullptr);
+    std::future<std::vector<ArtistResponse>> fetchSearchArtists(const std::string& text, int limit = 12,
+                                                                std::shared_ptr<CancellationToken> cancellation = nullptr);
     std::future<std::vector<CityResponse>> fetchSearchCities(const std::string& text, int limit = 10);
     
     // Artist methods
@@ -137,6 +230,16 @@ public:
     void setAuthToken(const std::string& token);
     std::string getAuthToken() const;
     void clearAuth();
+    
+    // Identical GETs that joined one already in flight instead of going out
+    SingleFlightStats getCoalescingStats() const;
+    
+    // Retries of idempotent requests and hosts failed fast while unhealthy
+    RetryStats getRetryStats() const;
+    CircuitBreakerStats getCircuitBreakerStats() const;
+    
+    // Per-endpoint timing keyed by "METHOD /path", ids collapsed to {id}
+    std::map<std::string, EndpointTiming> getEndpointTimings() const;
 };
 
 } // namespace localify
@@ -19,6 +19,10 @@ public:
     static constexpr const char* SPOTIFY_CLIENT_ID = "your_spotify_client_id";
     static constexpr const char* DEEP_LINK_SCHEME = "localify";
     
+    // Serve canned API responses instead of the network (see fixture_transport.h);
+    // builds without TLS always do, since the API is HTTPS only
+    static constexpr bool USE_DEVELOPMENT_FIXTURES = false;
+    
     // UI strings (replacing strings.xml)
     static constexpr const char* WELCOME_TITLE = "Welcome to Localify";
     static constexpr const char* DISCOVER_MUSIC = "Discover local music events";
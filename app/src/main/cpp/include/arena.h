@@ -0,0 +1,88 @@
+#ifndef LOCALIFY_ARENA_H
+#define LOCALIFY_ARENA_H
+
+#include <string_view>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+namespace localify {
+
+// Monotonic allocator: memory is carved from large blocks and only given
+// back all at once by reset() or destruction. Objects placed in an arena
+// never have their destructors run, so only trivially destructible types
+// may live there. Not thread-safe.
+class Arena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // alignment must be a power of two
+    void* allocate(size_t size, size_t alignment) {
+        uintptr_t at = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        if (cursor != nullptr && at + size <= reinterpret_cast<uintptr_t>(limit)) {
+            cursor = reinterpret_cast<char*>(at + size);
+            bytesUsed += size;
+            return reinterpret_cast<void*>(at);
+        }
+        return allocateSlow(size, alignment);
+    }
+
+    // Uninitialized storage for count objects of T
+    template<typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        return count > 0 ? static_cast<T*>(allocate(sizeof(T) * count, alignof(T))) : nullptr;
+    }
+
+    std::string_view copy(std::string_view text);
+
+    // Releases everything at once. The blocks are merged into one as large
+    // as all of them together, so an arena reused for page after page
+    // settles into allocating nothing.
+    void reset();
+
+    // Bytes handed out since the last reset, and bytes held in blocks
+    size_t getBytesUsed() const { return bytesUsed; }
+    size_t getBytesReserved() const { return bytesReserved; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;    // usable bytes after the header
+    };
+
+    void* allocateSlow(size_t size, size_t alignment);
+    void addBlock(size_t size);
+    void freeBlocks();
+    static char* dataOf(Block* block) { return reinterpret_cast<char*>(block + 1); }
+
+    Block* blocks;      // most recent first
+    char* cursor;
+    char* limit;
+    size_t nextBlockSize;
+    size_t bytesUsed;
+    size_t bytesReserved;
+};
+
+// Fixed-length run of objects in an Arena
+template<typename T>
+struct ArenaSpan {
+    T* items = nullptr;
+    size_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t index) const { return items[index]; }
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_ARENA_H
@@ -0,0 +1,45 @@
+#ifndef LOCALIFY_BUFFER_POOL_H
+#define LOCALIFY_BUFFER_POOL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstddef>
+
+namespace localify {
+
+struct BufferPoolStats {
+    size_t acquired = 0;
+    size_t reused = 0;      // acquire() served from a pooled buffer
+    size_t pooled = 0;      // buffers currently waiting in the pool
+};
+
+// Recycles receive buffers so their capacity survives across requests
+class BufferPool {
+private:
+    static std::unique_ptr<BufferPool> instance;
+
+    mutable std::mutex mutex;
+    std::vector<std::string> freeBuffers;
+    BufferPoolStats stats;
+
+    BufferPool() = default;
+
+public:
+    // Buffers above this capacity are freed instead of pooled
+    static constexpr size_t MAX_RETAINED_CAPACITY = 64 * 1024;
+    static constexpr size_t MAX_POOLED_BUFFERS = 16;
+
+    static BufferPool& getInstance();
+
+    // Returns an empty buffer with at least minCapacity reserved
+    std::string acquire(size_t minCapacity);
+    void release(std::string buffer);
+
+    BufferPoolStats getStats() const;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_BUFFER_POOL_H
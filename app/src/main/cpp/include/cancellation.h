@@ -0,0 +1,47 @@
+#ifndef LOCALIFY_CANCELLATION_H
+#define LOCALIFY_CANCELLATION_H
+
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace localify {
+
+// Shared flag a caller flips to abandon work it no longer needs. Requests
+// holding the token subscribe to it and are torn down as soon as it fires.
+class CancellationToken {
+public:
+    using Callback = std::function<void()>;
+
+    static std::shared_ptr<CancellationToken> create();
+
+    // Idempotent; callbacks run on the cancelling thread and must not block
+    void cancel();
+    bool isCancelled() const { return cancelled.load(); }
+
+    // Runs callback immediately if already cancelled. Returns an id for
+    // unsubscribe(), or 0 if the callback already ran.
+    uint64_t subscribe(Callback callback);
+    void unsubscribe(uint64_t id);
+
+    // Sleeps for up to timeout, waking early on cancel(); returns isCancelled()
+    bool waitFor(std::chrono::milliseconds timeout);
+
+private:
+    CancellationToken() : cancelled(false), nextId(1) {}
+
+    std::mutex mutex;
+    std::condition_variable cancelledSignal;
+    std::atomic<bool> cancelled;
+    uint64_t nextId;
+    std::map<uint64_t, Callback> callbacks;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_CANCELLATION_H
@@ -0,0 +1,62 @@
+#ifndef LOCALIFY_CIRCUIT_BREAKER_H
+#define LOCALIFY_CIRCUIT_BREAKER_H
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+namespace localify {
+
+struct CircuitBreakerStats {
+    size_t opened = 0;          // times a host was marked unhealthy
+    size_t rejected = 0;        // requests failed fast while open
+    size_t probes = 0;          // trial requests let through after the cooldown
+};
+
+// Per-host breaker. After failureThreshold consecutive failures the host
+// is considered down and requests fail immediately for the cooldown; then
+// a single probe is let through, whose outcome closes the breaker again or
+// restarts the cooldown.
+class CircuitBreaker {
+public:
+    explicit CircuitBreaker(int failureThreshold = 5,
+                            std::chrono::milliseconds cooldown = std::chrono::seconds(30));
+
+    // False when the request should fail fast without being sent
+    bool allowRequest(const std::string& host);
+    void recordSuccess(const std::string& host);
+    void recordFailure(const std::string& host);
+
+    // True while requests to host are being failed fast
+    bool isOpen(const std::string& host) const;
+
+    CircuitBreakerStats getStats() const;
+
+private:
+    enum class State {
+        CLOSED,
+        OPEN,
+        HALF_OPEN       // one probe in flight
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Host {
+        State state = State::CLOSED;
+        int consecutiveFailures = 0;
+        Clock::time_point openUntil;
+    };
+
+    int failureThreshold;
+    std::chrono::milliseconds cooldown;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Host> hosts;
+    CircuitBreakerStats stats;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_CIRCUIT_BREAKER_H
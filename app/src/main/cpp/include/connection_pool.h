@@ -0,0 +1,87 @@
+#ifndef LOCALIFY_CONNECTION_POOL_H
+#define LOCALIFY_CONNECTION_POOL_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <cstddef>
+
+namespace localify {
+
+class TlsStream;
+
+// A socket checked out of (or destined for) the connection pool
+struct PooledConnection {
+    int fd;
+    std::string host;
+    int port;
+    std::shared_ptr<TlsStream> tls;               // set for HTTPS; released with the socket
+    bool reused;                                  // true if this socket already served a request
+    int requestsServed;
+    int maxRequests;                              // from "Keep-Alive: max=N", 0 = unlimited
+    std::chrono::seconds keepAliveTimeout;        // from "Keep-Alive: timeout=N"
+    std::chrono::steady_clock::time_point lastUsed;
+
+    PooledConnection()
+        : fd(-1), port(0), reused(false), requestsServed(0), maxRequests(0),
+          keepAliveTimeout(0) {}
+
+    bool isValid() const { return fd >= 0; }
+};
+
+struct ConnectionPoolStats {
+    size_t idleConnections = 0;
+    size_t connectionsOpened = 0;   // fresh sockets handed out via registerNew()
+    size_t connectionsReused = 0;   // acquire() hits
+    size_t connectionsEvicted = 0;  // stale, over-cap or dead sockets closed by the pool
+};
+
+// Per-host pool of idle persistent HTTP/1.1 connections
+class ConnectionPool {
+public:
+    ConnectionPool(size_t maxIdlePerHost = 4, size_t maxIdleTotal = 16,
+                   std::chrono::seconds idleTimeout = std::chrono::seconds(30));
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Returns a live idle connection for host:port, or an invalid one if none is available
+    PooledConnection acquire(const std::string& host, int port);
+
+    // Wraps a freshly connected socket so it can later be released into the pool
+    PooledConnection registerNew(int fd, const std::string& host, int port);
+
+    // Hands a connection back; it is closed instead if not reusable or the pool is full
+    void release(PooledConnection connection, bool reusable);
+
+    // Closes idle connections that outlived their keep-alive window
+    void evictStale();
+    void clear();
+
+    ConnectionPoolStats getStats() const;
+
+private:
+    static std::string makeKey(const std::string& host, int port);
+    static bool isExpired(const PooledConnection& connection,
+                          std::chrono::steady_clock::time_point now,
+                          std::chrono::seconds idleTimeout);
+    static bool isAlive(const PooledConnection& connection);
+    void evictStaleLocked(std::chrono::steady_clock::time_point now);
+
+    size_t maxIdlePerHost;
+    size_t maxIdleTotal;
+    std::chrono::seconds idleTimeout;
+
+    mutable std::mutex mutex;
+    std::map<std::string, std::deque<PooledConnection>> idle;
+    size_t idleCount;
+    ConnectionPoolStats stats;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_CONNECTION_POOL_H
@@ -0,0 +1,101 @@
+#ifndef LOCALIFY_DNS_RESOLVER_H
+#define LOCALIFY_DNS_RESOLVER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <cstddef>
+#include <sys/socket.h>
+
+namespace localify {
+
+struct ResolvedAddress {
+    struct sockaddr_storage address;
+    socklen_t length;
+    int family;                         // AF_INET or AF_INET6
+
+    ResolvedAddress() : address(), length(0), family(0) {}
+};
+
+struct DNSResult {
+    std::vector<ResolvedAddress> addresses;
+    std::string error;
+
+    bool isSuccess() const { return !addresses.empty(); }
+};
+
+struct DNSResolverStats {
+    size_t lookups = 0;        // getaddrinfo calls actually made
+    size_t cacheHits = 0;      // answered from a fresh positive entry
+    size_t negativeHits = 0;   // answered from a fresh negative entry
+    size_t coalesced = 0;      // joined a lookup already in flight
+    size_t misses = 0;
+
+    double hitRate() const {
+        size_t total = cacheHits + negativeHits + coalesced + misses;
+        return total == 0 ? 0.0 : double(cacheHits + negativeHits + coalesced) / total;
+    }
+};
+
+// Thread-safe getaddrinfo wrapper with a TTL cache and in-flight lookup merging
+// (replaces the non-reentrant gethostbyname)
+class DNSResolver {
+public:
+    // Resolves a host without a port; the default calls getaddrinfo
+    using LookupFunction = std::function<DNSResult(const std::string& host)>;
+
+private:
+    static std::unique_ptr<DNSResolver> instance;
+
+    struct CacheEntry {
+        std::shared_future<DNSResult> result;
+        std::chrono::steady_clock::time_point expiresAt;
+        bool pending;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, CacheEntry> cache;
+    DNSResolverStats stats;
+    std::chrono::seconds positiveTTL;
+    std::chrono::seconds negativeTTL;
+    LookupFunction lookupFunction;
+
+    DNSResolver();
+
+    static DNSResult lookup(const std::string& host);
+
+public:
+    ~DNSResolver();
+
+    static DNSResolver& getInstance();
+
+    // Blocks until the host is resolved; addresses carry the given port
+    DNSResult resolve(const std::string& host, int port);
+
+    // Non-blocking: fills result and returns true only if a fresh (positive or
+    // negative) answer is cached
+    bool resolveCached(const std::string& host, int port, DNSResult& result);
+
+    // Stamps the given port on every address in result
+    static void applyPort(DNSResult& result, int port);
+
+    // Starts resolving in the background so a later resolve() is a cache hit
+    void prefetch(const std::string& host);
+
+    void setTTL(std::chrono::seconds positive, std::chrono::seconds negative);
+
+    // Swaps what answers cache misses, e.g. for tests; nullptr restores
+    // getaddrinfo. Cached answers are kept.
+    void setLookupFunction(LookupFunction lookup);
+    void clear();
+    DNSResolverStats getStats() const;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_DNS_RESOLVER_H
@@ -0,0 +1,130 @@
+#ifndef LOCALIFY_FIXTURE_TRANSPORT_H
+#define LOCALIFY_FIXTURE_TRANSPORT_H
+
+#include "http_transport.h"
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+namespace localify {
+
+// A recorded exchange. On disk each fixture is one human-editable file:
+//
+//   GET https://staging.localify.org/v1/@me
+//   200
+//   Content-Type: application/json
+//
+//   {"id":"user123",...}
+//
+// named after a hash of its method and URL, so a directory of fixtures can
+// be checked in, diffed and edited by hand.
+struct HttpFixture {
+    std::string method;
+    std::string url;
+    int statusCode;
+    HttpHeaders headers;
+    std::string body;
+
+    HttpFixture() : statusCode(0) {}
+
+    static std::string fileName(const std::string& method, const std::string& url);
+    static bool load(const std::string& path, HttpFixture& fixture);
+    bool save(const std::string& directory) const;
+};
+
+// Passes every exchange through to another transport and saves each
+// successful response as a fixture. Meant for capturing a session to
+// replay later; files are written on the inner transport's thread.
+class RecordTransport : public HttpTransport {
+public:
+    RecordTransport(std::shared_ptr<HttpTransport> inner, const std::string& directory);
+
+    void submit(IOJob job) override;
+
+private:
+    std::shared_ptr<HttpTransport> inner;
+    std::string directory;
+};
+
+// Serves fixtures instead of touching the network, shaped by a fixed
+// latency before the first byte and an optional bandwidth cap on the body,
+// so whole-stack experiments are repeatable on any machine. A request
+// matches a fixture for its exact URL first, then one recorded without a
+// query string. Unmatched requests fail with HttpError::NETWORK unless a
+// default response is set. Callbacks run on the transport's own thread.
+// Deadlines are checked between delivery steps; a cancelled request is
+// finished with HttpError::CANCELLED as soon as its token fires.
+class ReplayTransport : public HttpTransport {
+public:
+    // bytesPerSecond of zero delivers the body at once
+    explicit ReplayTransport(std::chrono::milliseconds latency = std::chrono::milliseconds(0),
+                             size_t bytesPerSecond = 0);
+    ~ReplayTransport();
+
+    ReplayTransport(const ReplayTransport&) = delete;
+    ReplayTransport& operator=(const ReplayTransport&) = delete;
+
+    // Loads every fixture file in directory; returns how many were read
+    size_t loadDirectory(const std::string& directory);
+    void addFixture(const HttpFixture& fixture);
+    void setDefaultResponse(int statusCode, const std::string& body);
+
+    void submit(IOJob job) override;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+    using Clock = std::chrono::steady_clock;
+
+    struct Delivery {
+        uint64_t id;
+        uint64_t cancelSubscription;
+        IOJob job;
+        std::shared_ptr<const HttpFixture> fixture;
+        Clock::time_point submittedAt;
+        Clock::time_point firstByteAt;
+        Clock::time_point deadline;     // max() without a total timeout
+        size_t offset;          // body bytes delivered so far
+        bool headSent;
+        HttpResponse response;
+    };
+
+    // Lets cancellation callbacks, which may run after unsubscribe(), reach
+    // the transport only while it exists
+    struct CancelRelay {
+        std::mutex mutex;
+        ReplayTransport* transport;
+    };
+
+    void run();
+    // Brings delivery id forward so the worker finishes it now
+    void onCancelled(uint64_t id);
+    // Delivers the next step of delivery; returns false once it is finished,
+    // otherwise sets next to when the following step is due
+    bool step(Delivery& delivery, Clock::time_point& next);
+    void finish(Delivery& delivery, HttpError error, const std::string& message);
+
+    std::chrono::milliseconds latency;
+    size_t bytesPerSecond;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::map<std::string, std::shared_ptr<const HttpFixture>> fixtures;   // "METHOD URL"
+    std::shared_ptr<const HttpFixture> defaultFixture;
+    std::multimap<Clock::time_point, std::unique_ptr<Delivery>> schedule;
+    uint64_t nextDeliveryId;
+    std::shared_ptr<CancelRelay> relay;
+    bool stopping;
+    std::thread worker;
+};
+
+// Canned responses for the staging API, for development builds and builds
+// without TLS
+std::shared_ptr<HttpTransport> createDevelopmentTransport();
+
+} // namespace localify
+
+#endif // LOCALIFY_FIXTURE_TRANSPORT_H
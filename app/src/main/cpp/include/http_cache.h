@@ -0,0 +1,119 @@
+#ifndef LOCALIFY_HTTP_CACHE_H
+#define LOCALIFY_HTTP_CACHE_H
+
+#include "http_client.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <ctime>
+
+namespace localify {
+
+struct HttpCacheStats {
+    size_t hits = 0;            // served fresh, no network
+    size_t misses = 0;
+    size_t revalidations = 0;   // conditional requests sent for stale entries
+    size_t notModified = 0;     // revalidations answered with 304
+    size_t diskHits = 0;        // entries reloaded from disk after a memory miss
+    size_t stores = 0;
+    size_t evictions = 0;
+    size_t memoryBytes = 0;
+    size_t diskBytes = 0;
+};
+
+// Private (per-device) HTTP cache for GET responses, following RFC 7234 for
+// the parts the API uses: Cache-Control max-age / no-cache / no-store,
+// Expires, Age, Vary and ETag / Last-Modified validators. Entries are keyed
+// by method, URL and a fingerprint of Authorization, so one user's responses
+// are never served to another and no credential is written to disk; Vary
+// adds further request headers that must match.
+class HttpCache {
+public:
+    enum class Lookup {
+        MISS,
+        FRESH,      // response is usable as is
+        STALE       // response needs revalidating; conditional headers added
+    };
+
+    explicit HttpCache(size_t maxMemoryBytes = 4 * 1024 * 1024);
+    ~HttpCache();
+
+    HttpCache(const HttpCache&) = delete;
+    HttpCache& operator=(const HttpCache&) = delete;
+
+    // Persists entries under directory; empty disables the disk tier
+    void setDiskDirectory(const std::string& directory, size_t maxDiskBytes = 16 * 1024 * 1024);
+
+    // FRESH fills cached; STALE fills cached and adds If-None-Match /
+    // If-Modified-Since to request
+    Lookup lookup(HttpRequest& request, HttpResponse& cached);
+
+    // Stores a cacheable 200 response for request
+    void store(const HttpRequest& request, const HttpResponse& response);
+
+    // Turns a 304 for a STALE lookup into the full cached response and
+    // refreshes the entry's freshness from the 304's headers. False when the
+    // entry was evicted meanwhile; the request must then be sent again
+    // without its conditional headers.
+    bool revalidated(const HttpRequest& request, const HttpResponse& notModified, HttpResponse& response);
+
+    void clear();
+    HttpCacheStats getStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        int statusCode;
+        std::string body;
+        HttpHeaders headers;
+        std::vector<std::pair<std::string, std::string>> vary;  // request header values at store time
+        int64_t storedAt;       // wall clock seconds, valid across restarts
+        int64_t freshUntil;
+
+        size_t footprint() const { return key.size() + body.size() + 256; }
+    };
+
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    static std::string makeKey(const HttpRequest& request);
+    static bool isCacheable(const HttpRequest& request, const HttpResponse& response);
+    static int64_t freshUntil(const HttpHeaders& headers, int64_t now);
+    static bool varyMatches(const Entry& entry, const HttpRequest& request);
+
+    EntryPtr find(const std::string& key);
+    void insert(const EntryPtr& entry, bool persist);
+    void evictMemory();
+
+    // Disk tier
+    std::string pathFor(const std::string& key) const;
+    EntryPtr readFromDisk(const std::string& key);
+    void writerLoop();
+    void writeToDisk(const Entry& entry);
+    // Deletes files written by other versions of the cache
+    static void removeOutdatedFiles(const std::string& path);
+    void trimDisk();
+
+    mutable std::mutex mutex;
+    size_t maxMemoryBytes;
+    std::list<EntryPtr> lru;                       // front = most recent
+    std::unordered_map<std::string, std::list<EntryPtr>::iterator> index;
+    HttpCacheStats stats;
+
+    std::string directory;
+    size_t maxDiskBytes;
+    std::deque<EntryPtr> pendingWrites;
+    std::condition_variable writerWake;
+    std::thread writerThread;
+    bool stopping;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_HTTP_CACHE_H
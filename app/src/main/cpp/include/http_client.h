@@ -2,19 +2,64 @@
 #define LOCALIFY_HTTP_CLIENT_H
 
 #include <string>
-#include <map>
 #include <future>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <chrono>
+#include "connection_pool.h"
+#include "http_parser.h"
+#include "cancellation.h"
+#include "request_scheduler.h"
 
 namespace localify {
 
+class HttpTransport;
+class HttpCache;
+struct HttpCacheStats;
+struct TlsStats;
+struct IOJob;
+
+// Why a request produced no response; NONE whenever statusCode is set
+enum class HttpError {
+    NONE,
+    INVALID_URL,
+    NETWORK,        // DNS, connect, send or the connection dropped
+    PROTOCOL,       // malformed or oversized response
+    TIMED_OUT,
+    CANCELLED,
+    SHUTTING_DOWN,
+    CIRCUIT_OPEN    // host marked unhealthy; the request was not sent
+};
+
+// Where a request spent its time. Phases a request skipped (DNS and connect
+// on a pooled socket, everything after a failure) stay zero.
+struct HttpTiming {
+    std::chrono::microseconds resolve{0};
+    std::chrono::microseconds connect{0};
+    std::chrono::microseconds send{0};
+    std::chrono::microseconds firstByte{0};    // request sent to first response byte
+    std::chrono::microseconds transfer{0};     // first byte to complete response
+    std::chrono::microseconds total{0};        // submit to completion, queueing included
+    size_t bytesSent = 0;
+    size_t bytesReceived = 0;                  // on the wire, before decoding
+    std::chrono::microseconds tls{0};          // TLS handshake, new HTTPS connections only
+    bool reusedConnection = false;
+    bool resumedSession = false;               // TLS handshake resumed a cached session
+};
+
 // Simple HTTP client implementation for Android (replacing libcurl)
 struct HttpResponse {
     int statusCode;
     std::string body;
-    std::map<std::string, std::string> headers;
+    HttpHeaders headers;
     std::string error;
+    HttpError errorCode;
+    size_t bytesCopied;     // bytes memcpy'd on the receive path after recv()
+    bool fromCache;         // served or revalidated from the HTTP cache
+    HttpTiming timing;
     
-    HttpResponse() : statusCode(0) {}
+    HttpResponse() : statusCode(0), errorCode(HttpError::NONE), bytesCopied(0), fromCache(false) {}
     
     bool isSuccess() const {
         return statusCode >= 200 && statusCode < 300;
@@ -25,26 +70,40 @@ struct HttpRequest {
     std::string url;
     std::string method;
     std::string body;
-    std::map<std::string, std::string> headers;
+    HttpHeaders headers;
+    
+    // Deadlines; 0 falls back to the client defaults. connect covers DNS and
+    // the TCP handshake, first byte runs from the request being sent, and
+    // total bounds the whole exchange.
     int timeoutSeconds;
+    int connectTimeoutSeconds;
+    int firstByteTimeoutSeconds;
+    
+    // Optional; cancelling it fails the request with HttpError::CANCELLED
+    std::shared_ptr<CancellationToken> cancellation;
+    
+    // Optional; orders the request in the scheduler while it waits for a
+    // connection slot. Unset means RequestPriority::NORMAL.
+    std::shared_ptr<PriorityToken> priority;
     
     HttpRequest(const std::string& url = "", const std::string& method = "GET")
-        : url(url), method(method), timeoutSeconds(30) {}
+        : url(url), method(method), timeoutSeconds(0), connectTimeoutSeconds(0),
+          firstByteTimeoutSeconds(0) {}
     
     void setHeader(const std::string& key, const std::string& value) {
-        headers[key] = value;
+        headers.set(key, value);
     }
     
     void setContentType(const std::string& contentType) {
-        headers["Content-Type"] = contentType;
+        headers.set("Content-Type", contentType);
     }
     
     void setAuthorization(const std::string& token) {
-        headers["Authorization"] = "Bearer " + token;
+        headers.set("Authorization", "Bearer " + token);
     }
     
     void setUserAgent(const std::string& userAgent) {
-        headers["User-Agent"] = userAgent;
+        headers.set("User-Agent", userAgent);
     }
 };
 
@@ -61,37 +120,100 @@ public:
     static HttpClient& getInstance();
     
     // Synchronous methods
-    HttpResponse get(const std::string& url, const std::map<std::string, std::string>& headers = {});
-    HttpResponse post(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers = {});
-    HttpResponse put(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers = {});
-    HttpResponse patch(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers = {});
-    HttpResponse delete_(const std::string& url, const std::map<std::string, std::string>& headers = {});
+    HttpResponse get(const std::string& url, const HttpHeaders& headers = {});
+    HttpResponse post(const std::string& url, const std::string& body, const HttpHeaders& headers = {});
+    HttpResponse put(const std::string& url, const std::string& body, const HttpHeaders& headers = {});
+    HttpResponse patch(const std::string& url, const std::string& body, const HttpHeaders& headers = {});
+    HttpResponse delete_(const std::string& url, const HttpHeaders& headers = {});
     
     // Generic request method
     HttpResponse request(const HttpRequest& request);
     
     // Asynchronous methods
-    std::future<HttpResponse> getAsync(const std::string& url, const std::map<std::string, std::string>& headers = {});
-    std::future<HttpResponse> postAsync(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers = {});
+    std::future<HttpResponse> getAsync(const std::string& url, const HttpHeaders& headers = {});
+    std::future<HttpResponse> postAsync(const std::string& url, const std::string& body, const HttpHeaders& headers = {});
     std::future<HttpResponse> requestAsync(const HttpRequest& request);
     
+    // Streaming: the body is delivered in chunks as it is received and never
+    // held in full. onHeaders sees the status and headers before any chunk;
+    // returning false from it or from onChunk aborts the transfer. onComplete
+    // runs exactly once, with an empty body and error set on failure.
+    // Callbacks run on the I/O thread and must not block.
+    using HeadersCallback = std::function<bool(const HttpResponse& head)>;
+    using ChunkCallback = std::function<bool(const char* data, size_t length)>;
+    using CompleteCallback = std::function<void(const HttpResponse& response)>;
+    void stream(const HttpRequest& request, HeadersCallback onHeaders,
+                ChunkCallback onChunk, CompleteCallback onComplete);
+    
     // Configuration
     void setUserAgent(const std::string& userAgent);
     void setDefaultTimeout(int seconds);
+    void setConnectTimeout(int seconds);
+    void setFirstByteTimeout(int seconds);
+    
+    // Connection reuse
+    ConnectionPoolStats getConnectionPoolStats() const;
+    void closeIdleConnections();
+    
+    // HTTPS handshakes on the socket transport; sessions are cached per host
+    // so new connections resume them (see tls_context.h)
+    TlsStats getTlsStats() const;
+    
+    // Swaps what carries requests (see http_transport.h); nullptr restores
+    // the socket transport. Set it before issuing requests.
+    void setTransport(std::shared_ptr<HttpTransport> transport);
+    std::shared_ptr<HttpTransport> getTransport() const;
+    
+    // Requests to one host share a fixed number of slots, handed out by
+    // priority (see request_scheduler.h); fresh cache hits bypass them
+    void setHostConcurrency(size_t maxPerHost, size_t maxBackgroundPerHost);
+    RequestSchedulerStats getSchedulerStats() const;
+    
+    // Resolves the URL's host in the background so the first request skips DNS
+    void prefetchDNS(const std::string& url);
+    
+    // Response cache for GET requests made through request/get/getAsync;
+    // stream() always goes to the network
+    void setCacheEnabled(bool enabled);
+    void setCacheDirectory(const std::string& directory);
+    HttpCacheStats getCacheStats() const;
+    void clearCache();
     
 private:
     // Platform-specific HTTP implementation using Android's native networking
     HttpResponse performRequest(const HttpRequest& request);
     
+    // Serializes the request into job; returns false when the response is
+    // already known (invalid URL, already cancelled) and stored in response
+    bool prepareJob(const HttpRequest& request, IOJob& job, HttpResponse& response);
+    
+    // Answers from the cache when it can, otherwise serializes the request
+    // and submits it to the transport
+    std::future<HttpResponse> dispatch(const HttpRequest& original);
+    // Sends request again, skipping the cache lookup, and fulfils promise
+    void resend(const HttpRequest& request, std::shared_ptr<std::promise<HttpResponse>> promise);
+    
+    // Queues job in the scheduler and hands it to the transport once its
+    // host has a free slot
+    void submitScheduled(IOJob job, std::shared_ptr<PriorityToken> priority);
+    
     // URL encoding utilities
     std::string urlEncode(const std::string& value);
     std::string urlDecode(const std::string& value);
     
-    // Header parsing utilities
-    std::map<std::string, std::string> parseHeaders(const std::string& headerString);
-    std::string buildHeaderString(const std::map<std::string, std::string>& headers);
+    // Header utilities
+    void appendHeaders(std::string& out, const HttpHeaders& headers);
     
     int defaultTimeoutSeconds;
+    int connectTimeoutSeconds;
+    int firstByteTimeoutSeconds;
+    ConnectionPool connectionPool;
+    RequestScheduler scheduler;
+    std::unique_ptr<HttpCache> cache;
+    bool cacheEnabled;
+    std::shared_ptr<HttpTransport> socketTransport;
+    std::shared_ptr<HttpTransport> transport;
+    mutable std::mutex transportMutex;
 };
 
 } // namespace localify
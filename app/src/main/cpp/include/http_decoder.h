@@ -0,0 +1,89 @@
+#ifndef LOCALIFY_HTTP_DECODER_H
+#define LOCALIFY_HTTP_DECODER_H
+
+#include <string>
+#include <functional>
+#include <cstddef>
+#include <zlib.h>
+
+namespace localify {
+
+// Incremental decoder for "Transfer-Encoding: chunked". Input may be split at
+// any byte boundary; payload spans are handed to the sink as they are found.
+class ChunkedDecoder {
+public:
+    enum class Result {
+        NEED_MORE,
+        DONE,
+        ERROR
+    };
+
+    // Returns false to abort decoding (e.g. the sink rejected the data)
+    using Sink = std::function<bool(const char* data, size_t length)>;
+
+    ChunkedDecoder();
+
+    // consumed is set to the number of input bytes that belong to the message;
+    // anything after the terminating chunk is left unconsumed
+    Result decode(const char* data, size_t length, size_t& consumed, const Sink& sink);
+
+    bool isDone() const { return state == State::DONE; }
+
+private:
+    enum class State {
+        SIZE,
+        EXTENSION,
+        SIZE_LF,
+        DATA,
+        DATA_CR,
+        DATA_LF,
+        TRAILER_START,
+        TRAILER,
+        TRAILER_LF,
+        FINAL_LF,
+        DONE
+    };
+
+    State state;
+    size_t remaining;
+    int sizeDigits;
+};
+
+// Streaming gzip / deflate inflater appending decompressed bytes to a string
+class InflateDecoder {
+public:
+    enum class Format {
+        GZIP,
+        DEFLATE
+    };
+
+    explicit InflateDecoder(Format format, size_t maxOutput = 64 * 1024 * 1024);
+    ~InflateDecoder();
+
+    InflateDecoder(const InflateDecoder&) = delete;
+    InflateDecoder& operator=(const InflateDecoder&) = delete;
+
+    // Called after each inflate step when streaming; the output is cleared
+    // afterwards so memory stays bounded. Returns false to abort.
+    using Flush = std::function<bool(std::string& output)>;
+
+    bool decode(const char* data, size_t length, std::string& output, const Flush& flush = Flush());
+
+    bool isFinished() const { return finished; }
+    const std::string& getError() const { return error; }
+
+private:
+    bool initialize(const char* data, size_t length);
+
+    z_stream stream;
+    Format format;
+    size_t maxOutput;
+    bool initialized;
+    bool finished;
+    std::string header;     // DEFLATE: input held until the wrapper is known
+    std::string error;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_HTTP_DECODER_H
@@ -0,0 +1,113 @@
+#ifndef LOCALIFY_HTTP_PARSER_H
+#define LOCALIFY_HTTP_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <cstddef>
+#include <cstdint>
+
+namespace localify {
+
+// Flat, case-insensitive HTTP header list. All names and values live in one
+// contiguous string; fields are offset pairs into it, so parsing a header block
+// costs two allocations regardless of the number of headers. Views returned by
+// get() and iteration stay valid until the next mutation.
+class HttpHeaders {
+public:
+    struct Field {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    class const_iterator {
+    public:
+        const_iterator(const HttpHeaders* headers, size_t index) : headers(headers), index(index) {}
+        Field operator*() const { return headers->at(index); }
+        const_iterator& operator++() { ++index; return *this; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+
+    private:
+        const HttpHeaders* headers;
+        size_t index;
+    };
+
+    HttpHeaders() = default;
+    HttpHeaders(std::initializer_list<std::pair<std::string_view, std::string_view>> fields);
+
+    // Replaces any existing field with the same name
+    void set(std::string_view name, std::string_view value);
+    // Appends without checking for duplicates (used when parsing)
+    void add(std::string_view name, std::string_view value);
+    bool remove(std::string_view name);
+
+    // Empty view if absent
+    std::string_view get(std::string_view name) const;
+    bool has(std::string_view name) const;
+
+    Field at(size_t index) const;
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear();
+    void reserve(size_t fields, size_t bytes);
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, entries.size()); }
+
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b);
+    // True if the comma/space separated value contains token (case-insensitive)
+    static bool containsToken(std::string_view value, std::string_view token);
+
+private:
+    struct Entry {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t valueOffset;
+        uint32_t valueLength;
+    };
+
+    int find(std::string_view name) const;
+
+    std::string storage;
+    std::vector<Entry> entries;
+};
+
+// Components of an http(s) URL, as views into the original string
+struct ParsedUrl {
+    std::string_view scheme;
+    std::string_view host;      // without IPv6 brackets
+    std::string_view path;      // "/" if absent
+    std::string_view query;     // including the leading '?', empty if absent
+    int port;
+    bool isHttps;
+
+    ParsedUrl() : port(0), isHttps(false) {}
+};
+
+// Hand-written HTTP/1.x parsing helpers; none of them allocate
+class HttpParser {
+public:
+    static bool parseUrl(std::string_view url, ParsedUrl& result);
+
+    // "HTTP/1.1 200 OK"
+    static bool parseStatusLine(std::string_view line, int& statusCode, int& minorVersion);
+
+    // Header lines after the status line, without the terminating blank line
+    static void parseHeaderLines(std::string_view block, HttpHeaders& headers);
+
+    static std::string_view trim(std::string_view value);
+
+    // IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT") to Unix seconds, or -1
+    static int64_t parseHttpDate(std::string_view value);
+
+    // 64-bit FNV-1a; stable across builds, unlike std::hash, so it can name
+    // files that must survive app updates
+    static uint64_t fingerprint(std::string_view value);
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_HTTP_PARSER_H
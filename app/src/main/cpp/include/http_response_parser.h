@@ -0,0 +1,125 @@
+#ifndef LOCALIFY_HTTP_RESPONSE_PARSER_H
+#define LOCALIFY_HTTP_RESPONSE_PARSER_H
+
+#include "http_client.h"
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+namespace localify {
+
+class ChunkedDecoder;
+class InflateDecoder;
+
+// Incremental HTTP/1.x response parser. The caller receives straight into the
+// parser's storage: prepare() hands out a writable window, commit() reports how
+// many bytes landed there. Headers are read into a pooled buffer; the body is
+// received directly into the string that becomes HttpResponse::body, pre-sized
+// from Content-Length, so the common case copies only the few body bytes that
+// arrive in the same segment as the headers. Chunked and gzip/deflate bodies
+// are received into a pooled scratch window and decoded incrementally.
+// With stream handlers set, the decoded body is handed out as it arrives and
+// never accumulated.
+class HttpResponseParser {
+public:
+    // Status line and headers as received; return false to abort the transfer
+    using HeadHandler = std::function<bool(const HttpResponse& head)>;
+    using BodySink = std::function<bool(const char* data, size_t length)>;
+
+    enum class Status {
+        NEED_MORE,
+        COMPLETE,
+        ERROR
+    };
+
+    struct Window {
+        char* data;
+        size_t size;
+    };
+
+    explicit HttpResponseParser(const std::string& method);
+    ~HttpResponseParser();
+
+    HttpResponseParser(const HttpResponseParser&) = delete;
+    HttpResponseParser& operator=(const HttpResponseParser&) = delete;
+
+    // Must be called before the first byte is committed
+    void setStreamHandlers(HeadHandler onHead, BodySink onBody);
+
+    Window prepare();
+    Status commit(size_t length);
+
+    // Convenience for callers that already hold the bytes elsewhere
+    Status feed(const char* data, size_t length);
+
+    // Called when the peer closes the connection
+    Status finish();
+
+    bool hasReceivedData() const { return headerFilled > 0; }
+    bool headersComplete() const { return headerEnd != std::string::npos; }
+
+    // Valid once COMPLETE: whether the connection can carry another request
+    bool isKeepAlive() const;
+    int getKeepAliveTimeout() const { return keepAliveTimeout; }
+    int getKeepAliveMax() const { return keepAliveMax; }
+
+    const std::string& getError() const { return error; }
+    // True if a stream handler asked to stop
+    bool isAborted() const { return aborted; }
+    HttpResponse takeResponse();
+
+private:
+    enum class Framing {
+        NONE,
+        CONTENT_LENGTH,
+        CHUNKED,
+        UNTIL_CLOSE
+    };
+
+    Status parseHeaderSection();
+    Status checkBody();
+    Status markComplete();
+    void growBody(size_t minFree);
+    Status decodeRaw(const char* data, size_t length);
+    bool emit(const char* data, size_t length);
+    bool isDecoding() const { return chunkedDecoder || inflater || streaming; }
+
+    std::string method;
+
+    // Header phase storage (pooled)
+    std::string headerBuffer;
+    size_t headerFilled;
+    size_t headerEnd;
+
+    // Body storage, moved into the response when complete
+    std::string body;
+    size_t bodyFilled;
+
+    // Decoding pipeline for chunked / compressed bodies
+    std::string scratch;
+    std::unique_ptr<ChunkedDecoder> chunkedDecoder;
+    std::unique_ptr<InflateDecoder> inflater;
+
+    // Streaming delivery
+    HeadHandler headHandler;
+    BodySink bodySink;
+    bool streaming;
+    bool aborted;
+
+    Framing framing;
+    size_t contentLength;
+    size_t rawReceived;    // encoded bytes consumed, when decoding
+    bool overflow;         // bytes arrived past the end of the message
+    bool complete;
+    bool keepAlive;
+    int keepAliveTimeout;
+    int keepAliveMax;
+    size_t bytesCopied;
+    std::string error;
+    HttpResponse response;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_HTTP_RESPONSE_PARSER_H
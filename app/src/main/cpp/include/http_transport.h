@@ -0,0 +1,54 @@
+#ifndef LOCALIFY_HTTP_TRANSPORT_H
+#define LOCALIFY_HTTP_TRANSPORT_H
+
+#include "http_client.h"
+#include "cancellation.h"
+#include <string>
+#include <memory>
+#include <functional>
+#include <chrono>
+
+namespace localify {
+
+// One serialized HTTP request for a transport to carry out
+struct IOJob {
+    std::string url;
+    std::string host;
+    int port;
+    bool secure;
+    std::string method;
+    std::string requestData;
+    std::function<void(HttpResponse)> onComplete;
+
+    // Optional streaming delivery; when onBody is set the completed response
+    // carries no body
+    std::function<bool(const HttpResponse&)> onHead;
+    std::function<bool(const char*, size_t)> onBody;
+
+    // Zero disables the corresponding deadline
+    std::chrono::milliseconds connectTimeout;
+    std::chrono::milliseconds firstByteTimeout;
+    std::chrono::milliseconds totalTimeout;
+    std::shared_ptr<CancellationToken> cancellation;
+
+    IOJob() : port(0), secure(false), connectTimeout(0), firstByteTimeout(0), totalTimeout(0) {}
+};
+
+// Moves serialized requests to a server and back. HttpClient owns the URL
+// parsing, caching and serialization and hands every exchange to one of
+// these, so what sits underneath (sockets, recorded fixtures) is invisible
+// to callers.
+//
+// Implementations must call job.onComplete exactly once, honour onHead /
+// onBody, the deadlines and the cancellation token, and never block the
+// submitting thread. Callbacks may run on any thread the transport owns.
+class HttpTransport {
+public:
+    virtual ~HttpTransport() = default;
+
+    virtual void submit(IOJob job) = 0;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_HTTP_TRANSPORT_H
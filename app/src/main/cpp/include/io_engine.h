@@ -0,0 +1,187 @@
+#ifndef LOCALIFY_IO_ENGINE_H
+#define LOCALIFY_IO_ENGINE_H
+
+#include "http_transport.h"
+#include "connection_pool.h"
+#include "dns_resolver.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+namespace localify {
+
+class HttpResponseParser;
+
+struct IOEngineStats {
+    size_t submitted = 0;
+    size_t completed = 0;
+    size_t failed = 0;
+    size_t active = 0;         // transfers currently owned by the loop
+    size_t peakActive = 0;
+    size_t staleRetries = 0;   // pooled sockets found dead and replaced
+    size_t timedOut = 0;
+    size_t cancelled = 0;
+    size_t connectFallbacks = 0;   // races won by an address other than the first
+};
+
+// The socket transport: a single-threaded epoll event loop that drives many
+// HTTP/1.1 exchanges over non-blocking sockets. Completion handlers run on
+// the loop thread and must not block. Deadlines live in an ordered timer map
+// whose earliest entry bounds each epoll_wait. New connections race the
+// resolved addresses Happy Eyeballs style (RFC 8305): families interleaved,
+// the host's last winning family first, each attempt started a short delay
+// after the previous one unless that one fails sooner. HTTPS connections
+// run a non-blocking TLS handshake (tls_context.h) before the request and
+// keep their TLS stream with the socket in the pool.
+class IOEngine : public HttpTransport {
+public:
+    explicit IOEngine(ConnectionPool& pool);
+    ~IOEngine();
+
+    IOEngine(const IOEngine&) = delete;
+    IOEngine& operator=(const IOEngine&) = delete;
+
+    void submit(IOJob job) override;
+
+    IOEngineStats getStats() const;
+
+private:
+    enum class State {
+        RESOLVING,
+        CONNECTING,
+        HANDSHAKING,    // TLS, on a freshly connected socket
+        SENDING,
+        RECEIVING
+    };
+
+    struct Transfer;
+    using Clock = std::chrono::steady_clock;
+
+    // One entrant of a connection race, registered in epoll on its own
+    struct ConnectAttempt {
+        Transfer* transfer;
+        int fd;
+        int family;
+        size_t addressIndex;
+        uint64_t tag;       // epoll tag while the fd is in the set, 0 otherwise
+    };
+    using TimerMap = std::multimap<Clock::time_point, Transfer*>;
+
+    struct Transfer {
+        IOJob job;
+        uint64_t id;
+        State state;
+        PooledConnection connection;
+        DNSResult resolved;
+        size_t nextAddress;
+        std::vector<std::unique_ptr<ConnectAttempt>> attempts;   // in flight while CONNECTING
+        size_t bytesSent;
+        bool retried;
+        uint64_t tag;              // epoll tag while the fd is in the set, 0 otherwise
+        uint32_t watchedEvents;    // epoll mask while registered
+        std::unique_ptr<HttpResponseParser> parser;
+
+        Clock::time_point totalDeadline;
+        Clock::time_point phaseDeadline;   // connect or first byte, max() when idle
+        Clock::time_point nextAttemptAt;   // next race entrant, max() when none is due
+        TimerMap::iterator timer;
+        bool timerArmed;
+        uint64_t cancelSubscription;
+
+        HttpTiming timing;
+        Clock::time_point submittedAt;
+        Clock::time_point phaseStartedAt;
+
+        Transfer();
+        ~Transfer();
+    };
+
+    // Cross-thread task queue; shared with resolver threads so a late lookup
+    // can never post into a destroyed engine
+    struct TaskQueue {
+        std::mutex mutex;
+        std::vector<std::function<void()>> tasks;
+        int wakeFd;
+        bool closed;
+
+        TaskQueue();
+        ~TaskQueue();
+        bool post(std::function<void()> task);
+    };
+
+    void run();
+    void drainTasks();
+
+    void start(Transfer* transfer);
+    void onResolved(const std::string& host, const DNSResult& result);
+    // Starts the next address in the race; fails the transfer once every
+    // address has been tried and none is still connecting
+    void connectNext(Transfer* transfer);
+    void orderAddresses(Transfer* transfer);
+    void onAttemptReady(ConnectAttempt* attempt, uint32_t events);
+    void winRace(ConnectAttempt* attempt);
+    void closeAttempts(Transfer* transfer);
+    void startHandshake(Transfer* transfer);
+    void continueHandshake(Transfer* transfer);
+    void beginExchange(Transfer* transfer);
+    void handleEvent(Transfer* transfer, uint32_t events);
+    void onWritable(Transfer* transfer);
+    void onReadable(Transfer* transfer);
+    void watch(Transfer* transfer, uint32_t events);
+    void unwatch(Transfer* transfer);
+
+    // Deadlines
+    void setPhaseDeadline(Transfer* transfer, std::chrono::milliseconds timeout);
+    void clearPhaseDeadline(Transfer* transfer);
+    void rearmTimer(Transfer* transfer);
+    int nextTimeoutMs() const;
+    void expireTimers();
+    void onTimeout(Transfer* transfer);
+
+    // Records the time since the previous mark into field and starts the next phase
+    void markPhase(Transfer* transfer, std::chrono::microseconds HttpTiming::*field);
+    void finishTiming(Transfer* transfer, HttpResponse& response);
+
+    // A reused socket died before yielding a response: retry on a fresh one
+    bool retryIfStale(Transfer* transfer);
+    void complete(Transfer* transfer, bool reusable);
+    void failParse(Transfer* transfer);
+    void fail(Transfer* transfer, HttpError code, const std::string& error);
+    // Destroys transfer, then hands response to its completion handler
+    void report(Transfer* transfer, HttpResponse response);
+    void destroy(Transfer* transfer);
+
+    ConnectionPool& pool;
+    int epollFd;
+    std::shared_ptr<TaskQueue> taskQueue;
+    std::atomic<bool> running;
+    std::thread loopThread;
+
+    // Owned by the loop thread
+    std::map<Transfer*, std::unique_ptr<Transfer>> transfers;
+    std::map<std::string, std::vector<Transfer*>> awaitingDNS;
+    TimerMap timers;
+    uint64_t nextTransferId;
+    // Epoll events carry a tag, never reused, instead of a pointer: a batch
+    // can still hold events for an fd that an earlier event in it closed,
+    // and its Transfer or ConnectAttempt may be gone or its address reused
+    uint64_t nextTag;
+    std::unordered_map<uint64_t, Transfer*> watchedTransfers;
+    std::unordered_map<uint64_t, ConnectAttempt*> pendingConnects;
+    std::unordered_map<std::string, int> preferredFamily;   // host -> last winning family
+
+    mutable std::mutex statsMutex;
+    IOEngineStats stats;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_IO_ENGINE_H
@@ -0,0 +1,342 @@
+#ifndef LOCALIFY_JSON_BINDING_H
+#define LOCALIFY_JSON_BINDING_H
+
+#include "arena.h"
+#include "json_tape.h"
+#include "json_writer.h"
+#include "string_pool.h"
+#include <array>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+namespace localify {
+
+// Binds a JSON member name to a data member of T
+template<typename T, typename M>
+struct JSONField {
+    std::string_view name;
+    M T::*member;
+};
+
+template<typename T, typename M>
+constexpr JSONField<T, M> jsonField(std::string_view name, M T::*member) {
+    return JSONField<T, M>{name, member};
+}
+
+// Describes how T maps to a JSON object. Specializations provide
+//     static constexpr auto fields = std::make_tuple(jsonField("id", &T::id), ...);
+// and both decoding and encoding are generated from that one list.
+template<typename T>
+struct JSONSchema;
+
+template<typename T, typename = void>
+struct HasJSONSchema : std::false_type {};
+
+template<typename T>
+struct HasJSONSchema<T, std::void_t<decltype(JSONSchema<T>::fields)>> : std::true_type {};
+
+namespace json_detail {
+
+// Mixes the length and a few bytes of a key; FieldTable searches for a seed
+// under which a schema's names land in distinct slots
+constexpr uint32_t hashKey(std::string_view key, uint32_t seed) {
+    uint32_t h = seed ^ (static_cast<uint32_t>(key.size()) * 0x9E3779B1u);
+    if (!key.empty()) {
+        size_t size = key.size();
+        h = (h ^ static_cast<uint8_t>(key[0])) * 0x01000193u;
+        h = (h ^ static_cast<uint8_t>(key[size / 4])) * 0x01000193u;
+        h = (h ^ static_cast<uint8_t>(key[size / 2])) * 0x01000193u;
+        h = (h ^ static_cast<uint8_t>(key[size - 1])) * 0x01000193u;
+    }
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+constexpr uint8_t EMPTY_SLOT = 0xFF;
+
+template<typename Tuple, size_t... I>
+constexpr auto fieldNames(const Tuple& fields, std::index_sequence<I...>) {
+    return std::array<std::string_view, sizeof...(I)>{{std::get<I>(fields).name...}};
+}
+
+template<size_t N>
+constexpr bool placesDistinctly(const std::array<std::string_view, N>& names, uint32_t seed, uint32_t bits) {
+    bool used[256] = {};
+    for (size_t i = 0; i < N; ++i) {
+        uint32_t slot = hashKey(names[i], seed) >> (32 - bits);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+// Perfect hash over one schema's member names, built at compile time:
+// looking up a key costs one hash, one table read and one comparison
+template<typename T>
+struct FieldTable {
+    using Fields = std::decay_t<decltype(JSONSchema<T>::fields)>;
+    static constexpr size_t COUNT = std::tuple_size<Fields>::value;
+    static_assert(COUNT > 0 && COUNT < 64, "JSONSchema needs between 1 and 63 fields");
+
+    static constexpr std::array<std::string_view, COUNT> names =
+        fieldNames(JSONSchema<T>::fields, std::make_index_sequence<COUNT>());
+
+    static constexpr uint32_t computeBits() {
+        uint32_t bits = 1;
+        while ((size_t(1) << bits) < COUNT * 2) {
+            ++bits;
+        }
+        return bits;
+    }
+    static constexpr uint32_t BITS = computeBits();
+
+    static constexpr uint32_t computeSeed() {
+        for (uint32_t seed = 1; seed < 20000; ++seed) {
+            if (placesDistinctly(names, seed, BITS)) {
+                return seed;
+            }
+        }
+        return 0;
+    }
+    static constexpr uint32_t SEED = computeSeed();
+    static_assert(SEED != 0, "No perfect hash for this JSONSchema; are two field names the same?");
+
+    static constexpr std::array<uint8_t, (size_t(1) << BITS)> computeSlots() {
+        std::array<uint8_t, (size_t(1) << BITS)> slots{};
+        for (auto& slot : slots) {
+            slot = EMPTY_SLOT;
+        }
+        for (size_t i = 0; i < COUNT; ++i) {
+            slots[hashKey(names[i], SEED) >> (32 - BITS)] = static_cast<uint8_t>(i);
+        }
+        return slots;
+    }
+    static constexpr std::array<uint8_t, (size_t(1) << BITS)> slots = computeSlots();
+
+    // Index into JSONSchema<T>::fields, or -1 for a key T does not have
+    static int find(std::string_view key) {
+        uint8_t index = slots[hashKey(key, SEED) >> (32 - BITS)];
+        return index != EMPTY_SLOT && names[index] == key ? index : -1;
+    }
+};
+
+// True if A's and B's schemas name the same members in the same order
+template<typename A, typename B>
+constexpr bool sameFieldNames() {
+    if (FieldTable<A>::COUNT != FieldTable<B>::COUNT) {
+        return false;
+    }
+    for (size_t i = 0; i < FieldTable<A>::COUNT; ++i) {
+        if (FieldTable<A>::names[i] != FieldTable<B>::names[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Tuple, typename F, size_t... I>
+void visitField(const Tuple& fields, int index, F&& f, std::index_sequence<I...>) {
+    (void)((index == static_cast<int>(I) ? (f(std::get<I>(fields)), true) : false) || ...);
+}
+
+template<typename Tuple, typename F, size_t... I>
+void forEachField(const Tuple& fields, F&& f, std::index_sequence<I...>) {
+    (f(std::get<I>(fields)), ...);
+}
+
+} // namespace json_detail
+
+// Decoding: absent members and values of the wrong type leave the
+// destination value-initialized, as the API models expect
+inline void readJSON(JSONValue value, std::string& out) { out = value.asString(); }
+inline void readJSON(JSONValue value, std::optional<std::string>& out) { out = value.asOptionalString(); }
+inline void readJSON(JSONValue value, int& out) { out = value.asInt(); }
+inline void readJSON(JSONValue value, int64_t& out) { out = value.asInt64(); }
+inline void readJSON(JSONValue value, std::optional<int>& out) { out = value.asOptionalInt(); }
+inline void readJSON(JSONValue value, double& out) { out = value.asDouble(); }
+inline void readJSON(JSONValue value, bool& out) { out = value.asBool(); }
+
+// Interned values are looked up straight from the source text, so a repeat
+// costs no allocation at all
+inline void readJSON(JSONValue value, InternedString& out) {
+    std::string scratch;
+    out = StringPool::getInstance().intern(value.asStringView(scratch));
+}
+
+inline void readJSON(JSONValue value, std::optional<InternedString>& out) {
+    if (value.isString()) {
+        out.emplace();
+        readJSON(value, *out);
+    } else {
+        out.reset();
+    }
+}
+
+template<typename T>
+std::enable_if_t<HasJSONSchema<T>::value> readJSON(JSONValue value, T& out);
+
+template<typename U>
+void readJSON(JSONValue value, std::vector<U>& out) {
+    out.clear();
+    out.reserve(value.size());
+    value.forEachElement([&out](JSONValue element) {
+        out.emplace_back();
+        readJSON(element, out.back());
+    });
+}
+
+template<typename T>
+std::enable_if_t<HasJSONSchema<T>::value> readJSON(JSONValue value, T& out) {
+    using Table = json_detail::FieldTable<T>;
+    value.forEachMember([&out](std::string_view key, JSONValue member) {
+        int index = Table::find(key);
+        if (index < 0) {
+            return;
+        }
+        json_detail::visitField(JSONSchema<T>::fields, index, [&](const auto& field) {
+            readJSON(member, out.*(field.member));
+        }, std::make_index_sequence<Table::COUNT>());
+    });
+}
+
+template<typename T>
+T fromJSON(JSONValue value) {
+    T out{};
+    readJSON(value, out);
+    return out;
+}
+
+// Arena decoding, for read-only views: strings and arrays are placed in the
+// arena, and unescaped strings point straight into the source text, which
+// must live in the same arena
+inline void readJSON(JSONValue value, std::string_view& out, Arena& arena) {
+    if (!value.isString()) {
+        out = std::string_view();
+        return;
+    }
+    std::string_view raw = value.raw();
+    if (!value.isEscaped()) {
+        out = raw;
+        return;
+    }
+    char* text = arena.allocateArray<char>(raw.size());
+    out = std::string_view(text, JSONTape::unescape(raw, text));
+}
+
+inline void readJSON(JSONValue value, std::optional<std::string_view>& out, Arena& arena) {
+    if (value.isString()) {
+        out.emplace();
+        readJSON(value, *out, arena);
+    } else {
+        out.reset();
+    }
+}
+
+// Members that need no arena decode as usual
+template<typename U>
+auto readJSON(JSONValue value, U& out, Arena&)
+    -> std::enable_if_t<!HasJSONSchema<U>::value, decltype(readJSON(value, out))> {
+    readJSON(value, out);
+}
+
+template<typename T>
+std::enable_if_t<HasJSONSchema<T>::value> readJSON(JSONValue value, T& out, Arena& arena);
+
+template<typename U>
+void readJSON(JSONValue value, ArenaSpan<U>& out, Arena& arena) {
+    out.count = value.isArray() ? value.size() : 0;
+    out.items = arena.allocateArray<U>(out.count);
+    size_t index = 0;
+    value.forEachElement([&](JSONValue element) {
+        U* item = new (&out.items[index++]) U{};
+        readJSON(element, *item, arena);
+    });
+}
+
+template<typename T>
+std::enable_if_t<HasJSONSchema<T>::value> readJSON(JSONValue value, T& out, Arena& arena) {
+    using Table = json_detail::FieldTable<T>;
+    value.forEachMember([&out, &arena](std::string_view key, JSONValue member) {
+        int index = Table::find(key);
+        if (index < 0) {
+            return;
+        }
+        json_detail::visitField(JSONSchema<T>::fields, index, [&](const auto& field) {
+            readJSON(member, out.*(field.member), arena);
+        }, std::make_index_sequence<Table::COUNT>());
+    });
+}
+
+// Encoding
+inline void writeJSON(JSONWriter& out, const std::string& value) { out.value(value); }
+inline void writeJSON(JSONWriter& out, int value) { out.value(value); }
+inline void writeJSON(JSONWriter& out, int64_t value) { out.value(value); }
+inline void writeJSON(JSONWriter& out, double value) { out.value(value); }
+inline void writeJSON(JSONWriter& out, bool value) { out.value(value); }
+inline void writeJSON(JSONWriter& out, const InternedString& value) { out.value(value.view()); }
+inline void writeJSON(JSONWriter& out, std::string_view value) { out.value(value); }
+
+template<typename T>
+std::enable_if_t<HasJSONSchema<T>::value> writeJSON(JSONWriter& out, const T& value);
+
+template<typename U>
+void writeJSON(JSONWriter& out, const std::optional<U>& value) {
+    if (value.has_value()) {
+        writeJSON(out, *value);
+    } else {
+        out.null();
+    }
+}
+
+template<typename U>
+void writeJSON(JSONWriter& out, const std::vector<U>& values) {
+    out.beginArray();
+    for (const U& element : values) {
+        writeJSON(out, element);
+    }
+    out.endArray();
+}
+
+template<typename U>
+void writeJSON(JSONWriter& out, const ArenaSpan<U>& values) {
+    out.beginArray();
+    for (const U& element : values) {
+        writeJSON(out, element);
+    }
+    out.endArray();
+}
+
+template<typename T>
+std::enable_if_t<HasJSONSchema<T>::value> writeJSON(JSONWriter& out, const T& value) {
+    using Table = json_detail::FieldTable<T>;
+    out.beginObject();
+    json_detail::forEachField(JSONSchema<T>::fields, [&](const auto& field) {
+        out.key(field.name);
+        writeJSON(out, value.*(field.member));
+    }, std::make_index_sequence<Table::COUNT>());
+    out.endObject();
+}
+
+// Serializes through this thread's scratch writer, so the returned string
+// is normally the only allocation
+template<typename T>
+std::string toJSON(const T& value) {
+    JSONWriter& out = JSONWriter::scratch();
+    writeJSON(out, value);
+    return out.str();
+}
+
+} // namespace localify
+
+#endif // LOCALIFY_JSON_BINDING_H
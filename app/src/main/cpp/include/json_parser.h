@@ -2,11 +2,26 @@
 #define LOCALIFY_JSON_PARSER_H
 
 #include "models.h"
+#include "arena.h"
+#include "json_scan.h"
+#include "json_tape.h"
 #include <string>
+#include <string_view>
 #include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <cstddef>
 
 namespace localify {
 
+class LazySearchResponse;
+struct ArtistView;
+struct EventView;
+struct VenueView;
+struct CityView;
+struct SearchView;
+
 class JSONParser {
 public:
     // Parse individual objects
@@ -18,6 +33,7 @@ public:
     static CityResponse parseCityResponse(const std::string& json);
     static UserCity parseUserCity(const std::string& json);
     static SearchResponse parseSearchResponse(const std::string& json);
+    static std::shared_ptr<LazySearchResponse> parseSearchResponseLazy(std::string json);
     static ErrorResponse parseErrorResponse(const std::string& json);
     
     // Parse arrays
@@ -28,29 +44,108 @@ public:
     static std::vector<UserCity> parseUserCityArray(const std::string& json);
     static std::vector<std::string> parseStringArray(const std::string& json);
     
+    // Arena mode: the body and everything decoded from it go into arena as
+    // read-only views (model_views.h), with no per-field allocations, and
+    // stay there until arena.reset(). A malformed body reads as empty.
+    static ArenaSpan<ArtistView> parseArtistArray(std::string_view json, Arena& arena);
+    static ArenaSpan<EventView> parseEventArray(std::string_view json, Arena& arena);
+    static ArenaSpan<VenueView> parseVenueArray(std::string_view json, Arena& arena);
+    static ArenaSpan<CityView> parseCityArray(std::string_view json, Arena& arena);
+    static SearchView parseSearchResponse(std::string_view json, Arena& arena);
+    
+    // Top-level arrays of at least this many bytes have their elements
+    // decoded across WorkerPool; 0 keeps all decoding on the calling thread
+    static void setParallelDecodeThreshold(size_t bytes);
+    static size_t getParallelDecodeThreshold();
+    
     // Serialize objects to JSON
     static std::string serializeUserDetails(const UserDetails& user);
     static std::string serializeUserCity(const UserCity& userCity);
     static std::string serializeStringArray(const std::vector<std::string>& strings);
-    
+};
+
+// Incremental splitter for a top-level JSON array that arrives in pieces, e.g.
+// from HttpClient::stream. Each element is handed out as soon as its last byte
+// is seen; only the element currently being received is buffered. Pieces are
+// indexed with JSONStructuralIndexer, so only structural characters are
+// visited one at a time and each element is copied out in one go.
+class JSONArrayStream {
+public:
+    using ElementHandler = std::function<void(std::string element)>;
+
+    explicit JSONArrayStream(ElementHandler onElement);
+
+    // Returns false once the input is not a JSON array (no opening bracket,
+    // a missing, doubled or trailing comma); later input is ignored. Elements
+    // are checked by whoever decodes them, not here.
+    bool feed(const char* data, size_t length);
+
+    bool isComplete() const { return state == State::DONE; }
+    bool isMalformed() const { return state == State::MALFORMED; }
+    size_t getElementCount() const { return elementCount; }
+
 private:
-    // Helper methods for parsing
-    static std::string extractStringValue(const std::string& json, const std::string& key);
-    static int extractIntValue(const std::string& json, const std::string& key);
-    static double extractDoubleValue(const std::string& json, const std::string& key);
-    static bool extractBoolValue(const std::string& json, const std::string& key);
-    static std::optional<std::string> extractOptionalStringValue(const std::string& json, const std::string& key);
-    static std::optional<int> extractOptionalIntValue(const std::string& json, const std::string& key);
-    
-    // Helper methods for array parsing
-    static std::vector<std::string> splitJsonArray(const std::string& jsonArray);
-    static std::string findJsonObject(const std::string& json, const std::string& key);
-    static std::string findJsonArray(const std::string& json, const std::string& key);
-    
-    // String utilities
-    static std::string trim(const std::string& str);
-    static std::string escapeJsonString(const std::string& str);
-    static std::string unescapeJsonString(const std::string& str);
+    enum class State {
+        BEFORE_ARRAY,
+        BEFORE_ELEMENT,     // after the opening bracket or a comma
+        IN_ELEMENT,
+        AFTER_ELEMENT,      // expecting a comma or the closing bracket
+        DONE,
+        MALFORMED
+    };
+
+    void flushElement();
+
+    ElementHandler onElement;
+    State state;
+    std::string element;
+    int depth;
+    size_t elementCount;
+    JSONStructuralIndexer indexer;
+    std::vector<uint32_t> structurals;  // scratch for the piece being fed
+};
+
+// Search results that decode each category the first time it is read. The
+// body is tokenized once when the response arrives; a screen showing one tab
+// then pays only for that tab's objects. Categories are decoded at most once
+// and may be read from any thread.
+class LazySearchResponse {
+public:
+    // No results
+    LazySearchResponse();
+    // Takes the response body; a malformed body reads as no results
+    explicit LazySearchResponse(std::string body);
+
+    LazySearchResponse(const LazySearchResponse&) = delete;
+    LazySearchResponse& operator=(const LazySearchResponse&) = delete;
+
+    const std::vector<ArtistResponse>& artists() const;
+    const std::vector<EventResponse>& events() const;
+    const std::vector<VenueResponse>& venues() const;
+    const std::vector<CityResponse>& cities() const;
+
+    // Decodes whatever has not been read yet and copies out the lot
+    SearchResponse toSearchResponse() const;
+
+private:
+    template<typename T>
+    const std::vector<T>& decode(std::once_flag& once, std::vector<T>& cache, JSONValue value) const;
+
+    std::string body;
+    JSONTape tape;      // points into body
+    JSONValue artistsValue;
+    JSONValue eventsValue;
+    JSONValue venuesValue;
+    JSONValue citiesValue;
+
+    mutable std::once_flag artistsOnce;
+    mutable std::once_flag eventsOnce;
+    mutable std::once_flag venuesOnce;
+    mutable std::once_flag citiesOnce;
+    mutable std::vector<ArtistResponse> artistsCache;
+    mutable std::vector<EventResponse> eventsCache;
+    mutable std::vector<VenueResponse> venuesCache;
+    mutable std::vector<CityResponse> citiesCache;
 };
 
 } // namespace localify
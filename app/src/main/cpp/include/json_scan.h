@@ -0,0 +1,39 @@
+#ifndef LOCALIFY_JSON_SCAN_H
+#define LOCALIFY_JSON_SCAN_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace localify {
+
+// Finds JSON structure 64 bytes at a time: SSE2, or AVX2 when the CPU has
+// it, on x86; NEON on arm64; a portable loop elsewhere. Input may arrive in
+// pieces of any size, as string and escape state carries over between calls.
+class JSONStructuralIndexer {
+public:
+    JSONStructuralIndexer() { reset(); }
+
+    // Appends base + offset for every unescaped quote, and for every
+    // { } [ ] , : outside a string, in data[0, length)
+    void index(const char* data, size_t length, uint32_t base, std::vector<uint32_t>& positions);
+
+    void reset();
+
+    // Whether the input so far ends inside a string
+    bool inString() const { return previousInString != 0; }
+
+    // The instruction set index() is using, for logs
+    static const char* implementation();
+
+private:
+    // Returns the block's escaped-byte mask
+    uint64_t indexBlock(const char* block, uint32_t base, std::vector<uint32_t>& positions);
+
+    uint64_t previousEscaped;    // 1 if the next byte is escaped by a trailing backslash
+    uint64_t previousInString;   // all ones while inside a string
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_JSON_SCAN_H
@@ -0,0 +1,167 @@
+#ifndef LOCALIFY_JSON_TAPE_H
+#define LOCALIFY_JSON_TAPE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+namespace localify {
+
+enum class JSONType : uint8_t {
+    OBJECT,
+    ARRAY,
+    STRING,
+    NUMBER,
+    TRUE,
+    FALSE,
+    NUL
+};
+
+// One value on the tape. Offsets point into the source text, which the
+// tape does not copy and which must outlive it.
+struct JSONToken {
+    JSONType type;
+    bool escaped;       // string contains escape sequences and needs decoding
+    uint32_t offset;    // strings: first byte inside the quotes; others: first byte
+    uint32_t length;    // strings and numbers: bytes; objects: members; arrays: elements
+    uint32_t next;      // tape index just past this value, skipping container contents
+};
+
+class JSONTape;
+
+// Read-only cursor onto one value of a JSONTape. Accessors never throw: a
+// missing member or a value of the wrong type yields the fallback, matching
+// how the API models treat absent fields.
+class JSONValue {
+public:
+    JSONValue() : tape(nullptr), index(0) {}
+    JSONValue(const JSONTape* tape, uint32_t index) : tape(tape), index(index) {}
+
+    bool isValid() const { return tape != nullptr; }
+    JSONType type() const;
+    bool isObject() const { return isValid() && type() == JSONType::OBJECT; }
+    bool isArray() const { return isValid() && type() == JSONType::ARRAY; }
+    bool isString() const { return isValid() && type() == JSONType::STRING; }
+    bool isNull() const { return isValid() && type() == JSONType::NUL; }
+    // A string whose escape sequences must be decoded before use
+    bool isEscaped() const { return isString() && token().escaped; }
+
+    // Members of an object or elements of an array
+    size_t size() const;
+
+    std::string asString() const;
+    std::optional<std::string> asOptionalString() const;
+    // Points into the source unless escapes need decoding, in which case
+    // the text is decoded into scratch
+    std::string_view asStringView(std::string& scratch) const;
+    int asInt(int fallback = 0) const;
+    std::optional<int> asOptionalInt() const;
+    int64_t asInt64(int64_t fallback = 0) const;
+    double asDouble(double fallback = 0.0) const;
+    bool asBool(bool fallback = false) const;
+
+    // Undecoded source text: string contents without quotes, number lexemes
+    std::string_view raw() const;
+
+    // Linear member lookup; invalid when absent. Parsers reading many fields
+    // should walk forEachMember once instead.
+    JSONValue operator[](std::string_view key) const;
+
+    // f(std::string_view key, JSONValue value) for each member, in order
+    template<typename F>
+    void forEachMember(F&& f) const;
+
+    // f(JSONValue element) for each element, in order
+    template<typename F>
+    void forEachElement(F&& f) const;
+
+private:
+    const JSONToken& token() const;
+
+    const JSONTape* tape;
+    uint32_t index;
+};
+
+// Single-pass JSON tokenizer. parse() validates the document and records
+// every value as a fixed-size token in document order, with skip links over
+// nested containers, so readers visit each field once and jump over whatever
+// they do not need. Strings are left escaped in the source and only decoded
+// when read. A tape can be reused; its storage is kept between documents.
+class JSONTape {
+public:
+    // Returns false, with getError() set, if json is not a single valid JSON value
+    bool parse(std::string_view json);
+
+    JSONValue root() const { return tokens.empty() ? JSONValue() : JSONValue(this, 0); }
+    const std::string& getError() const { return error; }
+    size_t getTokenCount() const { return tokens.size(); }
+    // Token storage kept for the next document
+    size_t getRetainedBytes() const;
+
+    // This thread's tape, for documents read as soon as they are parsed.
+    // Storage is reused from one document to the next, up to a limit; a
+    // value read from it is only good until the thread parses another.
+    static JSONTape& scratch();
+
+    // Decodes a string body's escape sequences, \uXXXX included, to UTF-8
+    static std::string unescape(std::string_view raw);
+    // Same, into out, which needs raw.size() bytes: decoding never grows
+    // the text. Returns the decoded length.
+    static size_t unescape(std::string_view raw, char* out);
+
+private:
+    friend class JSONValue;
+
+    bool fail(const char* message, size_t position);
+
+    std::string_view source;
+    std::vector<JSONToken> tokens;
+    std::vector<uint32_t> open;     // indices of containers not yet closed
+    std::string error;
+};
+
+inline const JSONToken& JSONValue::token() const {
+    return tape->tokens[index];
+}
+
+inline JSONType JSONValue::type() const {
+    return token().type;
+}
+
+template<typename F>
+void JSONValue::forEachMember(F&& f) const {
+    if (!isObject()) {
+        return;
+    }
+    uint32_t end = token().next;
+    uint32_t key = index + 1;
+    while (key < end) {
+        const JSONToken& keyToken = tape->tokens[key];
+        std::string_view name = tape->source.substr(keyToken.offset, keyToken.length);
+        if (keyToken.escaped) {
+            std::string decoded = JSONTape::unescape(name);
+            f(std::string_view(decoded), JSONValue(tape, key + 1));
+        } else {
+            f(name, JSONValue(tape, key + 1));
+        }
+        key = tape->tokens[key + 1].next;
+    }
+}
+
+template<typename F>
+void JSONValue::forEachElement(F&& f) const {
+    if (!isArray()) {
+        return;
+    }
+    uint32_t end = token().next;
+    for (uint32_t element = index + 1; element < end; element = tape->tokens[element].next) {
+        f(JSONValue(tape, element));
+    }
+}
+
+} // namespace localify
+
+#endif // LOCALIFY_JSON_TAPE_H
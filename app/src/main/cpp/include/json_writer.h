@@ -0,0 +1,82 @@
+#ifndef LOCALIFY_JSON_WRITER_H
+#define LOCALIFY_JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace localify {
+
+// Builds JSON text in one growing buffer. Commas are placed automatically;
+// strings are escaped, with UTF-8 passed through as is; integers and
+// doubles are formatted with to_chars, non-finite doubles as null.
+//
+//     JSONWriter writer;
+//     writer.beginObject();
+//     writer.field("token", token);
+//     writer.endObject();
+//     send(writer.str());
+class JSONWriter {
+public:
+    explicit JSONWriter(size_t capacity = 0);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    // Member name; the next value belongs to it
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text) { value(std::string_view(text)); }
+    void value(const std::string& text) { value(std::string_view(text)); }
+    void value(int number) { appendInteger(number); }
+    void value(long number) { appendInteger(number); }
+    void value(long long number) { appendInteger(number); }
+    void value(double number);
+    void value(bool flag);
+    void null();
+
+    template<typename V>
+    void field(std::string_view name, const V& v) {
+        key(name);
+        value(v);
+    }
+
+    // Write characters outside the Basic Multilingual Plane as \u surrogate
+    // pairs, and each malformed UTF-8 sequence as \ufffd. JNI's NewStringUTF
+    // takes modified UTF-8, which has no 4-byte sequences, and CheckJNI
+    // aborts on malformed input, so text headed for Java must have neither.
+    void setEscapeSupplementary(bool escape) { escapeSupplementary = escape; }
+
+    const std::string& str() const { return buffer; }
+    size_t size() const { return buffer.size(); }
+    void reserve(size_t capacity) { buffer.reserve(capacity); }
+
+    // Empties the writer but keeps its capacity and options
+    void clear();
+
+    // This thread's writer, cleared and with default options. Its buffer
+    // survives between uses, so steady-state serialization allocates nothing.
+    static JSONWriter& scratch();
+
+private:
+    void separate() {
+        if (needsComma) {
+            buffer += ',';
+        }
+        needsComma = false;
+    }
+    void appendInteger(long long number);
+    void appendString(std::string_view text);
+
+    std::string buffer;
+    bool needsComma;
+    bool escapeSupplementary;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_JSON_WRITER_H
@@ -0,0 +1,132 @@
+#ifndef LOCALIFY_MODEL_SCHEMA_H
+#define LOCALIFY_MODEL_SCHEMA_H
+
+#include "models.h"
+#include "json_binding.h"
+
+namespace localify {
+
+// JSON field lists for the API models, in the order the API sends them.
+// Adding a member to a model means adding it here, once, for both
+// JSONParser and the JNI serializers.
+
+template<>
+struct JSONSchema<AuthResponse> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("token", &AuthResponse::token),
+        jsonField("refreshToken", &AuthResponse::refreshToken),
+        jsonField("expiresIn", &AuthResponse::expiresIn));
+};
+
+template<>
+struct JSONSchema<UserDetails> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &UserDetails::id),
+        jsonField("name", &UserDetails::name),
+        jsonField("email", &UserDetails::email),
+        jsonField("appleId", &UserDetails::appleId),
+        jsonField("spotifyId", &UserDetails::spotifyId),
+        jsonField("accountCreationDate", &UserDetails::accountCreationDate),
+        jsonField("profileImage", &UserDetails::profileImage),
+        jsonField("spotifyProfileImage", &UserDetails::spotifyProfileImage),
+        jsonField("playlistLocalSongsPerSeed", &UserDetails::playlistLocalSongsPerSeed),
+        jsonField("anonymousUser", &UserDetails::anonymousUser),
+        jsonField("emailConnected", &UserDetails::emailConnected),
+        jsonField("appleConnected", &UserDetails::appleConnected),
+        jsonField("spotifyConnected", &UserDetails::spotifyConnected),
+        jsonField("emailVerified", &UserDetails::emailVerified),
+        jsonField("emailOptIn", &UserDetails::emailOptIn),
+        jsonField("isAdmin", &UserDetails::isAdmin),
+        jsonField("isTeamMember", &UserDetails::isTeamMember),
+        jsonField("playlistUseSeedSongs", &UserDetails::playlistUseSeedSongs),
+        jsonField("playlistGeneration", &UserDetails::playlistGeneration));
+};
+
+template<>
+struct JSONSchema<ArtistResponse> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &ArtistResponse::id),
+        jsonField("name", &ArtistResponse::name),
+        jsonField("imageUrl", &ArtistResponse::imageUrl),
+        jsonField("spotifyId", &ArtistResponse::spotifyId),
+        jsonField("genres", &ArtistResponse::genres),
+        jsonField("popularity", &ArtistResponse::popularity),
+        jsonField("isFavorite", &ArtistResponse::isFavorite));
+};
+
+template<>
+struct JSONSchema<EventResponse> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &EventResponse::id),
+        jsonField("name", &EventResponse::name),
+        jsonField("description", &EventResponse::description),
+        jsonField("startDate", &EventResponse::startDate),
+        jsonField("endDate", &EventResponse::endDate),
+        jsonField("imageUrl", &EventResponse::imageUrl),
+        jsonField("venueId", &EventResponse::venueId),
+        jsonField("venueName", &EventResponse::venueName),
+        jsonField("artists", &EventResponse::artists),
+        jsonField("isFavorite", &EventResponse::isFavorite),
+        jsonField("latitude", &EventResponse::latitude),
+        jsonField("longitude", &EventResponse::longitude));
+};
+
+template<>
+struct JSONSchema<VenueResponse> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &VenueResponse::id),
+        jsonField("name", &VenueResponse::name),
+        jsonField("address", &VenueResponse::address),
+        jsonField("city", &VenueResponse::city),
+        jsonField("state", &VenueResponse::state),
+        jsonField("country", &VenueResponse::country),
+        jsonField("latitude", &VenueResponse::latitude),
+        jsonField("longitude", &VenueResponse::longitude),
+        jsonField("imageUrl", &VenueResponse::imageUrl),
+        jsonField("isFavorite", &VenueResponse::isFavorite));
+};
+
+template<>
+struct JSONSchema<CityResponse> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &CityResponse::id),
+        jsonField("name", &CityResponse::name),
+        jsonField("state", &CityResponse::state),
+        jsonField("country", &CityResponse::country),
+        jsonField("latitude", &CityResponse::latitude),
+        jsonField("longitude", &CityResponse::longitude));
+};
+
+template<>
+struct JSONSchema<UserCity> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &UserCity::id),
+        jsonField("cityId", &UserCity::cityId),
+        jsonField("cityName", &UserCity::cityName),
+        jsonField("radius", &UserCity::radius),
+        jsonField("selected", &UserCity::selected));
+};
+
+template<>
+struct JSONSchema<SearchResponse> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("artists", &SearchResponse::artists),
+        jsonField("events", &SearchResponse::events),
+        jsonField("venues", &SearchResponse::venues),
+        jsonField("cities", &SearchResponse::cities));
+};
+
+template<>
+struct JSONSchema<ErrorResponse> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("status", &ErrorResponse::status),
+        jsonField("error", &ErrorResponse::error),
+        jsonField("message", &ErrorResponse::message),
+        jsonField("path", &ErrorResponse::path),
+        jsonField("timestamp", &ErrorResponse::timestamp),
+        jsonField("requestId", &ErrorResponse::requestId));
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_MODEL_SCHEMA_H
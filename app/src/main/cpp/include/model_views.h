@@ -0,0 +1,145 @@
+#ifndef LOCALIFY_MODEL_VIEWS_H
+#define LOCALIFY_MODEL_VIEWS_H
+
+#include "arena.h"
+#include "json_binding.h"
+#include "model_schema.h"
+#include <optional>
+#include <string_view>
+
+namespace localify {
+
+// Read-only counterparts of the list models, decoded into an Arena by the
+// JSONParser overloads that take one. Every string and array points into
+// the arena, which also holds the response body, so a whole page is freed
+// by one Arena::reset() and nothing here is valid after it.
+
+struct ArtistView {
+    std::string_view id;
+    std::string_view name;
+    std::optional<std::string_view> imageUrl;
+    std::optional<std::string_view> spotifyId;
+    ArenaSpan<std::string_view> genres;
+    int popularity;
+    bool isFavorite;
+};
+
+struct EventView {
+    std::string_view id;
+    std::string_view name;
+    std::string_view description;
+    std::string_view startDate;
+    std::string_view endDate;
+    std::optional<std::string_view> imageUrl;
+    std::string_view venueId;
+    std::string_view venueName;
+    ArenaSpan<ArtistView> artists;
+    bool isFavorite;
+    double latitude;
+    double longitude;
+};
+
+struct VenueView {
+    std::string_view id;
+    std::string_view name;
+    std::string_view address;
+    std::string_view city;
+    std::string_view state;
+    std::string_view country;
+    double latitude;
+    double longitude;
+    std::optional<std::string_view> imageUrl;
+    bool isFavorite;
+};
+
+struct CityView {
+    std::string_view id;
+    std::string_view name;
+    std::string_view state;
+    std::string_view country;
+    double latitude;
+    double longitude;
+};
+
+struct SearchView {
+    ArenaSpan<ArtistView> artists;
+    ArenaSpan<EventView> events;
+    ArenaSpan<VenueView> venues;
+    ArenaSpan<CityView> cities;
+};
+
+template<>
+struct JSONSchema<ArtistView> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &ArtistView::id),
+        jsonField("name", &ArtistView::name),
+        jsonField("imageUrl", &ArtistView::imageUrl),
+        jsonField("spotifyId", &ArtistView::spotifyId),
+        jsonField("genres", &ArtistView::genres),
+        jsonField("popularity", &ArtistView::popularity),
+        jsonField("isFavorite", &ArtistView::isFavorite));
+};
+
+template<>
+struct JSONSchema<EventView> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &EventView::id),
+        jsonField("name", &EventView::name),
+        jsonField("description", &EventView::description),
+        jsonField("startDate", &EventView::startDate),
+        jsonField("endDate", &EventView::endDate),
+        jsonField("imageUrl", &EventView::imageUrl),
+        jsonField("venueId", &EventView::venueId),
+        jsonField("venueName", &EventView::venueName),
+        jsonField("artists", &EventView::artists),
+        jsonField("isFavorite", &EventView::isFavorite),
+        jsonField("latitude", &EventView::latitude),
+        jsonField("longitude", &EventView::longitude));
+};
+
+template<>
+struct JSONSchema<VenueView> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &VenueView::id),
+        jsonField("name", &VenueView::name),
+        jsonField("address", &VenueView::address),
+        jsonField("city", &VenueView::city),
+        jsonField("state", &VenueView::state),
+        jsonField("country", &VenueView::country),
+        jsonField("latitude", &VenueView::latitude),
+        jsonField("longitude", &VenueView::longitude),
+        jsonField("imageUrl", &VenueView::imageUrl),
+        jsonField("isFavorite", &VenueView::isFavorite));
+};
+
+template<>
+struct JSONSchema<CityView> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("id", &CityView::id),
+        jsonField("name", &CityView::name),
+        jsonField("state", &CityView::state),
+        jsonField("country", &CityView::country),
+        jsonField("latitude", &CityView::latitude),
+        jsonField("longitude", &CityView::longitude));
+};
+
+template<>
+struct JSONSchema<SearchView> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("artists", &SearchView::artists),
+        jsonField("events", &SearchView::events),
+        jsonField("venues", &SearchView::venues),
+        jsonField("cities", &SearchView::cities));
+};
+
+// A view must decode exactly what its model does, or the arena and the
+// owning parse paths would quietly disagree about a response
+static_assert(json_detail::sameFieldNames<ArtistView, ArtistResponse>(), "ArtistView and ArtistResponse differ");
+static_assert(json_detail::sameFieldNames<EventView, EventResponse>(), "EventView and EventResponse differ");
+static_assert(json_detail::sameFieldNames<VenueView, VenueResponse>(), "VenueView and VenueResponse differ");
+static_assert(json_detail::sameFieldNames<CityView, CityResponse>(), "CityView and CityResponse differ");
+static_assert(json_detail::sameFieldNames<SearchView, SearchResponse>(), "SearchView and SearchResponse differ");
+
+} // namespace localify
+
+#endif // LOCALIFY_MODEL_VIEWS_H
@@ -5,6 +5,8 @@
 #include <vector>
 #include <memory>
 #include <optional>
+#include <cstdint>
+#include "string_pool.h"
 
 namespace localify {
 
@@ -46,7 +48,7 @@ struct UserDetails {
     std::optional<std::string> email;
     std::optional<std::string> appleId;
     std::optional<std::string> spotifyId;
-    long accountCreationDate;
+    int64_t accountCreationDate;
     std::optional<std::string> profileImage;
     std::optional<std::string> spotifyProfileImage;
     std::optional<int> playlistLocalSongsPerSeed;
@@ -66,11 +68,12 @@ struct UserDetails {
 
 // Artist Response
 struct ArtistResponse {
-    std::string id;
-    std::string name;
-    std::optional<std::string> imageUrl;
-    std::optional<std::string> spotifyId;
-    std::vector<std::string> genres;
+    // Artists recur across events and searches, so their strings are pooled
+    InternedString id;
+    InternedString name;
+    std::optional<InternedString> imageUrl;
+    std::optional<InternedString> spotifyId;
+    std::vector<InternedString> genres;
     int popularity;
     bool isFavorite;
     
@@ -85,8 +88,8 @@ struct EventResponse {
     std::string startDate;
     std::string endDate;
     std::optional<std::string> imageUrl;
-    std::string venueId;
-    std::string venueName;
+    InternedString venueId;
+    InternedString venueName;
     std::vector<ArtistResponse> artists;
     bool isFavorite;
     double latitude;
@@ -100,9 +103,9 @@ struct VenueResponse {
     std::string id;
     std::string name;
     std::string address;
-    std::string city;
-    std::string state;
-    std::string country;
+    InternedString city;
+    InternedString state;
+    InternedString country;
     double latitude;
     double longitude;
     std::optional<std::string> imageUrl;
@@ -115,8 +118,8 @@ struct VenueResponse {
 struct CityResponse {
     std::string id;
     std::string name;
-    std::string state;
-    std::string country;
+    InternedString state;
+    InternedString country;
     double latitude;
     double longitude;
     
@@ -0,0 +1,137 @@
+#ifndef LOCALIFY_REQUEST_SCHEDULER_H
+#define LOCALIFY_REQUEST_SCHEDULER_H
+
+#include "cancellation.h"
+#include <string>
+#include <map>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+namespace localify {
+
+// Scheduling classes, lowest first
+enum class RequestPriority {
+    BACKGROUND,     // prefetching, favorites and recommendation loads
+    NORMAL,
+    USER_VISIBLE    // the user is waiting on it, e.g. search as you type
+};
+
+// Adjustable priority shared by the requests a caller issues. A screen
+// keeps one and raises it when it becomes visible; any of its requests
+// still waiting in the scheduler are reordered at once.
+class PriorityToken {
+public:
+    using Callback = std::function<void()>;
+
+    static std::shared_ptr<PriorityToken> create(RequestPriority priority = RequestPriority::NORMAL);
+
+    // Callbacks run on the calling thread and must not block
+    void set(RequestPriority priority);
+    RequestPriority get() const { return priority.load(); }
+
+    // As set(), but only ever moves the priority up
+    void raise(RequestPriority priority);
+
+    // Runs callback after every change; returns an id for unsubscribe()
+    uint64_t subscribe(Callback callback);
+    void unsubscribe(uint64_t id);
+
+private:
+    explicit PriorityToken(RequestPriority priority) : priority(priority), nextId(1) {}
+
+    void change(RequestPriority value, bool raiseOnly);
+
+    std::mutex mutex;
+    std::atomic<RequestPriority> priority;
+    uint64_t nextId;
+    std::map<uint64_t, Callback> callbacks;
+};
+
+struct RequestSchedulerStats {
+    size_t dispatched = 0;
+    size_t delayed = 0;                 // had to wait for a slot
+    size_t reprioritised = 0;           // priority changed while waiting
+    size_t cancelledWhileQueued = 0;
+    size_t waiting = 0;
+    size_t peakWaiting = 0;
+};
+
+// Decides when requests reach the transport. Each host gets a fixed number
+// of concurrent requests; waiting requests go out highest priority first,
+// oldest first within a class. Background requests may only fill part of a
+// host's slots, so a user-visible request never queues behind a host full of
+// background downloads.
+class RequestScheduler {
+public:
+    explicit RequestScheduler(size_t maxPerHost = 6, size_t maxBackgroundPerHost = 4);
+
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    // Called with the ticket to hand back to finished() once the request is done
+    using StartFunction = std::function<void(uint64_t ticket)>;
+
+    // Runs start now or once the host has a free slot. If cancellation fires
+    // first the request is dropped from the queue and cancelled runs instead.
+    void submit(const std::string& host, std::shared_ptr<PriorityToken> priority,
+                std::shared_ptr<CancellationToken> cancellation,
+                StartFunction start, std::function<void()> cancelled);
+
+    // Frees the ticket's slot and starts whatever is next in line for its host
+    void finished(uint64_t ticket);
+
+    void setLimits(size_t maxPerHost, size_t maxBackgroundPerHost);
+    RequestSchedulerStats getStats() const;
+
+private:
+    struct Pending {
+        uint64_t id;
+        std::string host;
+        std::shared_ptr<PriorityToken> priority;
+        std::shared_ptr<CancellationToken> cancellation;
+        StartFunction start;
+        std::function<void()> cancelled;
+        uint64_t prioritySubscription;
+        uint64_t cancelSubscription;
+        bool queued;
+    };
+    using PendingPtr = std::shared_ptr<Pending>;
+
+    struct HostState {
+        size_t active = 0;
+        size_t activeBackground = 0;
+        std::list<PendingPtr> waiting;  // submission order
+    };
+
+    // A started request; the slot class is fixed when it starts
+    struct Running {
+        std::string host;
+        bool background;
+    };
+
+    static RequestPriority priorityOf(const Pending& pending);
+
+    // Moves every request that may start now out of host's queue into ready
+    void takeRunnableLocked(const std::string& host, std::list<PendingPtr>& ready);
+    void launch(std::list<PendingPtr>& ready);
+    void onPriorityChanged(const std::string& host, uint64_t id);
+    void onCancelled(const std::string& host, uint64_t id);
+
+    size_t maxPerHost;
+    size_t maxBackgroundPerHost;
+
+    mutable std::mutex mutex;
+    std::map<std::string, HostState> hosts;
+    std::map<uint64_t, Running> running;
+    uint64_t nextId;
+    RequestSchedulerStats stats;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_REQUEST_SCHEDULER_H
@@ -0,0 +1,40 @@
+#ifndef LOCALIFY_RETRY_POLICY_H
+#define LOCALIFY_RETRY_POLICY_H
+
+#include "http_client.h"
+#include <string>
+#include <chrono>
+
+namespace localify {
+
+struct RetryStats {
+    size_t retries = 0;             // extra attempts made
+    size_t recovered = 0;           // requests that succeeded on a retry
+    size_t exhausted = 0;           // requests still failing after the last attempt
+    size_t retryAfterHonoured = 0;  // delays taken from a Retry-After header
+};
+
+// When and how long to wait before repeating a failed request. Only
+// idempotent methods are retried, and only for failures a repeat can fix:
+// connection errors, timeouts, 408, 429, 502, 503 and 504. Delays grow
+// exponentially with full jitter, so clients that failed together do not
+// come back together; a Retry-After from the server takes precedence.
+struct RetryPolicy {
+    int maxAttempts = 3;                                // including the first
+    std::chrono::milliseconds baseDelay{250};
+    std::chrono::milliseconds maxDelay{4000};
+    std::chrono::milliseconds maxRetryAfter{10000};     // longer waits give up instead
+
+    static bool isIdempotent(const std::string& method);
+    static bool isRetryable(const HttpResponse& response);
+
+    // Retry-After as a delay (delta-seconds or HTTP-date), or -1 if absent
+    static std::chrono::milliseconds retryAfter(const HttpResponse& response);
+
+    // Random delay in [0, min(maxDelay, baseDelay * 2^(attempt-1))]
+    std::chrono::milliseconds backoff(int attempt) const;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_RETRY_POLICY_H
@@ -3,6 +3,10 @@
 
 #include "android_ui.h"
 #include "models.h"
+#include "cancellation.h"
+#include "request_scheduler.h"
+#include "json_parser.h"
+#include <future>
 #include <memory>
 
 namespace localify {
@@ -10,9 +14,9 @@ namespace localify {
 // Login Screen
 class LoginScreen : public Screen {
 private:
-    std::unique_ptr<Button> guestLoginButton;
-    std::unique_ptr<Button> appleLoginButton;
-    std::unique_ptr<Button> spotifyLoginButton;
+    Button* guestLoginButton = nullptr;
+    Button* appleLoginButton = nullptr;
+    Button* spotifyLoginButton = nullptr;
     
 public:
     LoginScreen();
@@ -27,9 +31,9 @@ private:
 // Home Screen
 class HomeScreen : public Screen {
 private:
-    std::unique_ptr<ListView> recommendationsList;
-    std::unique_ptr<Button> refreshButton;
-    std::unique_ptr<Button> mapButton;
+    ListView* recommendationsList = nullptr;
+    Button* refreshButton = nullptr;
+    Button* mapButton = nullptr;
     
     std::vector<EventResponse> currentEvents;
     std::vector<ArtistResponse> currentArtists;
@@ -49,18 +53,22 @@ private:
 // Search Screen
 class SearchScreen : public Screen {
 private:
-    std::unique_ptr<SearchBar> searchBar;
-    std::unique_ptr<ListView> resultsList;
-    std::unique_ptr<Button> artistsTab;
-    std::unique_ptr<Button> eventsTab;
-    std::unique_ptr<Button> venuesTab;
+    SearchBar* searchBar = nullptr;
+    ListView* resultsList = nullptr;
+    Button* artistsTab = nullptr;
+    Button* eventsTab = nullptr;
+    Button* venuesTab = nullptr;
     
-    SearchResponse currentResults;
+    std::shared_ptr<LazySearchResponse> currentResults;  // tabs decode on first view
     int selectedTab; // 0=artists, 1=events, 2=venues
+    std::shared_ptr<CancellationToken> searchCancellation;  // in-flight search, if any
+    std::future<std::shared_ptr<LazySearchResponse>> pendingSearch;  // its results, picked up by update()
     
 public:
     SearchScreen();
+    ~SearchScreen() override;
     void initialize() override;
+    void update(float deltaTime) override;
     
 private:
     void onSearch(const std::string& query);
@@ -72,20 +80,31 @@ private:
 // Favorites Screen
 class FavoritesScreen : public Screen {
 private:
-    std::unique_ptr<Button> artistsTab;
-    std::unique_ptr<Button> eventsTab;
-    std::unique_ptr<Button> venuesTab;
-    std::unique_ptr<ListView> favoritesList;
+    Button* artistsTab = nullptr;
+    Button* eventsTab = nullptr;
+    Button* venuesTab = nullptr;
+    ListView* favoritesList = nullptr;
     
     std::vector<ArtistResponse> favoriteArtists;
     std::vector<EventResponse> favoriteEvents;
     std::vector<VenueResponse> favoriteVenues;
     int selectedTab; // 0=artists, 1=events, 2=venues
+    std::shared_ptr<PriorityToken> loadPriority;  // user-visible only while the screen is shown
+    std::shared_ptr<CancellationToken> loadCancellation;  // fired when the screen goes away
+    
+    // Loads in flight; update() picks up each one as it completes
+    std::future<std::vector<ArtistResponse>> pendingArtists;
+    std::future<std::vector<EventResponse>> pendingEvents;
+    std::future<std::vector<VenueResponse>> pendingVenues;
     
 public:
     FavoritesScreen();
+    ~FavoritesScreen() override;
     void initialize() override;
     void update(float deltaTime) override;
+    void onShow() override;
+    void onHide() override;
+    void prefetch() override;
     
 private:
     void loadFavorites();
@@ -97,10 +116,10 @@ private:
 // Profile Screen
 class ProfileScreen : public Screen {
 private:
-    std::unique_ptr<Button> connectEmailButton;
-    std::unique_ptr<Button> connectSpotifyButton;
-    std::unique_ptr<Button> logoutButton;
-    std::unique_ptr<Button> deleteAccountButton;
+    Button* connectEmailButton = nullptr;
+    Button* connectSpotifyButton = nullptr;
+    Button* logoutButton = nullptr;
+    Button* deleteAccountButton = nullptr;
     
     UserDetails currentUser;
     bool userLoaded;
@@ -122,8 +141,8 @@ private:
 // Map Screen (for radius selection)
 class MapScreen : public Screen {
 private:
-    std::unique_ptr<Button> backButton;
-    std::unique_ptr<Button> confirmButton;
+    Button* backButton = nullptr;
+    Button* confirmButton = nullptr;
     
     float currentRadius;
     float centerX, centerY;
@@ -0,0 +1,109 @@
+#ifndef LOCALIFY_SINGLE_FLIGHT_H
+#define LOCALIFY_SINGLE_FLIGHT_H
+
+#include "request_scheduler.h"
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <memory>
+#include <cstddef>
+
+namespace localify {
+
+struct SingleFlightStats {
+    size_t started = 0;     // calls that ran their work
+    size_t saved = 0;       // calls that joined one already in flight
+};
+
+// Collapses concurrent calls with the same key into one: the first caller
+// runs the work, later callers block on its result (or exception) instead
+// of repeating it. Nothing is kept once the work finishes, so this is not
+// a cache; a call that starts afterwards runs again.
+class SingleFlight {
+public:
+    SingleFlight() = default;
+
+    SingleFlight(const SingleFlight&) = delete;
+    SingleFlight& operator=(const SingleFlight&) = delete;
+
+    template<typename T>
+    T run(const std::string& key, const std::function<T()>& work) {
+        return run<T>(key, nullptr, [&work](const std::shared_ptr<PriorityToken>&) { return work(); });
+    }
+
+    // As run(), for work sent at priority. The leader's work is handed a
+    // token of its own to send with; every caller raises it to its own
+    // priority while it waits, so joining background work from a screen
+    // the user is looking at does not leave the user waiting behind it.
+    template<typename T>
+    T run(const std::string& key, const std::shared_ptr<PriorityToken>& priority,
+          const std::function<T(const std::shared_ptr<PriorityToken>&)>& work) {
+        std::shared_future<T> shared;
+        std::promise<T> promise;
+        std::shared_ptr<PriorityToken> flightPriority;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = inFlight.find(key);
+            if (it != inFlight.end()) {
+                // Keys are only ever shared by calls producing the same type
+                shared = *std::static_pointer_cast<std::shared_future<T>>(it->second.result);
+                flightPriority = it->second.priority;
+                stats.saved++;
+            } else {
+                shared = promise.get_future().share();
+                if (priority) {
+                    flightPriority = PriorityToken::create(priority->get());
+                }
+                inFlight[key] = Flight{std::make_shared<std::shared_future<T>>(shared), flightPriority};
+                stats.started++;
+                leader = true;
+            }
+        }
+
+        uint64_t subscription = 0;
+        if (priority && flightPriority) {
+            // Only runs inside priority->set(), so priority is alive
+            PriorityToken* caller = priority.get();
+            subscription = priority->subscribe([caller, flightPriority]() { flightPriority->raise(caller->get()); });
+            flightPriority->raise(priority->get());
+        }
+        if (leader) {
+            // Publish before forgetting the key so no joiner is stranded
+            try {
+                promise.set_value(work(flightPriority));
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight.erase(key);
+        } else {
+            shared.wait();
+        }
+        if (subscription != 0) {
+            priority->unsubscribe(subscription);
+        }
+        return shared.get();
+    }
+
+    SingleFlightStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    struct Flight {
+        std::shared_ptr<void> result;                   // shared_future<T>
+        std::shared_ptr<PriorityToken> priority;        // what the leader's work is sent at, if given
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Flight> inFlight;
+    SingleFlightStats stats;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_SINGLE_FLIGHT_H
@@ -0,0 +1,130 @@
+#ifndef LOCALIFY_STRING_POOL_H
+#define LOCALIFY_STRING_POOL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace localify {
+
+namespace string_pool_detail {
+// Header and text in one allocation
+struct Entry {
+    std::atomic<uint32_t> references;
+    uint32_t length;
+    uint32_t hash;
+    bool pooled;        // owned by the pool, which frees it once unreferenced
+    char text[1];       // length bytes and a terminating NUL
+};
+}
+
+// Immutable string shared through StringPool. One pointer wide; copies
+// bump a reference count instead of copying text.
+class InternedString {
+public:
+    InternedString() : entry(nullptr) {}
+    // Interns text in StringPool::getInstance()
+    InternedString(std::string_view text);
+    InternedString(const char* text) : InternedString(std::string_view(text)) {}
+    InternedString(const std::string& text) : InternedString(std::string_view(text)) {}
+
+    InternedString(const InternedString& other) : entry(other.entry) { retain(); }
+    InternedString(InternedString&& other) noexcept : entry(other.entry) { other.entry = nullptr; }
+    InternedString& operator=(const InternedString& other);
+    InternedString& operator=(InternedString&& other) noexcept;
+    ~InternedString() { release(); }
+
+    std::string_view view() const { return entry ? std::string_view(entry->text, entry->length) : std::string_view(); }
+    operator std::string_view() const { return view(); }
+    const char* c_str() const { return entry ? entry->text : ""; }
+    std::string str() const { return std::string(view()); }
+    size_t size() const { return entry ? entry->length : 0; }
+    bool empty() const { return size() == 0; }
+
+    bool operator==(const InternedString& other) const {
+        return entry == other.entry || view() == other.view();
+    }
+    bool operator!=(const InternedString& other) const { return !(*this == other); }
+
+private:
+    friend class StringPool;
+    using Entry = string_pool_detail::Entry;
+
+    // Takes over a reference the caller already holds
+    explicit InternedString(Entry* adopted) : entry(adopted) {}
+
+    void retain() {
+        if (entry) {
+            entry->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void release();
+
+    Entry* entry;
+};
+
+struct StringPoolStats {
+    size_t lookups = 0;
+    size_t hits = 0;            // lookups served by an existing entry
+    size_t savedBytes = 0;      // text the hits did not have to store again
+    size_t entries = 0;         // distinct strings currently pooled
+    size_t bytes = 0;           // text held by those entries
+};
+
+// Deduplicates the short values API models repeat from record to record:
+// venue names, cities, genres, nested artists. Safe to use from the decode
+// workers. Entries nobody references are swept out whenever a shard fills.
+class StringPool {
+private:
+    static std::unique_ptr<StringPool> instance;
+
+    using Entry = string_pool_detail::Entry;
+
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t MIN_TABLE_SIZE = 256;
+
+    // Open addressing with linear probing; entries keep their hash, so a
+    // probe only touches text when hash and length already match
+    struct Shard {
+        std::mutex mutex;
+        std::vector<Entry*> table;
+        size_t count = 0;
+        size_t bytes = 0;
+        size_t lookups = 0;
+        size_t hits = 0;
+        size_t savedBytes = 0;
+    };
+
+    mutable Shard shards[SHARD_COUNT];
+
+    StringPool() = default;
+
+    static Entry* allocate(std::string_view text, uint32_t hash, bool pooled);
+    // Frees the shard's unreferenced entries and resizes its table to fit
+    // the rest; called with its mutex held
+    static void rebuild(Shard& shard);
+
+    friend class InternedString;
+    static void destroy(Entry* entry);
+
+public:
+    // Longer values are rarely repeated; they get an unshared handle
+    static constexpr size_t MAX_POOLED_LENGTH = 256;
+
+    ~StringPool();
+
+    static StringPool& getInstance();
+
+    InternedString intern(std::string_view text);
+
+    StringPoolStats getStats() const;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_STRING_POOL_H
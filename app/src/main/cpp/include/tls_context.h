@@ -0,0 +1,127 @@
+#ifndef LOCALIFY_TLS_CONTEXT_H
+#define LOCALIFY_TLS_CONTEXT_H
+
+#include <string>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+// OpenSSL / BoringSSL handle types, kept opaque so callers need no TLS headers
+struct ssl_st;
+struct ssl_ctx_st;
+struct ssl_session_st;
+
+namespace localify {
+
+struct TlsStats {
+    size_t fullHandshakes = 0;
+    size_t resumedHandshakes = 0;       // abbreviated, using a cached session
+    size_t failedHandshakes = 0;
+    size_t sessionsCached = 0;          // tickets / sessions received from servers
+    std::chrono::microseconds fullHandshakeTime{0};      // summed; divide by the count
+    std::chrono::microseconds resumedHandshakeTime{0};
+};
+
+// Outcome of one non-blocking TLS operation
+enum class TlsStatus {
+    OK,
+    WANT_READ,      // retry once the socket is readable
+    WANT_WRITE,     // retry once the socket is writable
+    CLOSED,         // peer closed the connection
+    ERROR
+};
+
+// TLS over one connected, non-blocking socket. Created by TlsContext; it
+// does not own the descriptor, which stays with the PooledConnection, so a
+// stream travels through the connection pool alongside its socket.
+class TlsStream {
+public:
+    ~TlsStream();
+
+    TlsStream(const TlsStream&) = delete;
+    TlsStream& operator=(const TlsStream&) = delete;
+
+    // Drives the client handshake; call again after WANT_READ / WANT_WRITE
+    TlsStatus handshake();
+    TlsStatus read(char* buffer, size_t size, size_t& bytesRead);
+    TlsStatus write(const char* data, size_t size, size_t& bytesWritten);
+
+    // For a pooled stream whose socket turned readable while idle: processes
+    // records that are not application data, such as TLS 1.3 session tickets
+    // a server sends after the response. True if the stream is still open
+    // with nothing else pending; false after close_notify, an error or
+    // unsolicited application data.
+    bool drainIdle();
+
+    bool isResumed() const;
+    const std::string& getError() const { return error; }
+
+private:
+    friend class TlsContext;
+    TlsStream(ssl_st* ssl, const std::string& sessionKey);
+
+    TlsStatus translate(int result);
+
+    ssl_st* ssl;
+    std::string sessionKey;             // "host:port" the session cache files sessions under
+    std::string error;
+    std::chrono::steady_clock::time_point handshakeStarted;
+    bool handshakeDone;
+};
+
+// Process-wide client TLS configuration and session cache. Sessions (TLS 1.2
+// session ids, TLS 1.3 tickets) are kept per host:port so that every new
+// connection to a host, pooled or not, can resume instead of running a full
+// handshake. TLS 1.3 tickets are used once each, as RFC 8446 recommends;
+// servers send fresh ones on every connection.
+//
+// Only available when built with OpenSSL (LOCALIFY_HAS_TLS); otherwise
+// isAvailable() is false and HTTPS requests fail in the socket transport.
+class TlsContext {
+public:
+    static TlsContext& getInstance();
+    static bool isAvailable();
+
+    ~TlsContext();
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    // Wraps fd for host (SNI and certificate name) and attaches a cached
+    // session if one exists; nullptr if TLS is unavailable or setup failed
+    std::unique_ptr<TlsStream> connect(int fd, const std::string& host, int port);
+
+    // Trusts the certificates in a PEM file in addition to the system store
+    bool addTrustedCertificates(const std::string& pemPath);
+
+    // Drops every cached session so the next handshakes are full ones
+    void clearSessions();
+
+    TlsStats getStats() const;
+
+private:
+    TlsContext();
+
+    static int onNewSession(ssl_st* ssl, ssl_session_st* session);
+    void storeSession(const std::string& key, ssl_session_st* session);
+    ssl_session_st* takeSession(const std::string& key);
+    void recordHandshake(bool resumed, std::chrono::microseconds elapsed, bool failed);
+
+    friend class TlsStream;
+
+    static std::unique_ptr<TlsContext> instance;
+
+    static constexpr size_t MAX_SESSIONS_PER_HOST = 4;
+
+    ssl_ctx_st* context;
+    mutable std::mutex mutex;
+    std::map<std::string, std::deque<ssl_session_st*>> sessions;   // newest at the back
+    TlsStats stats;
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_TLS_CONTEXT_H
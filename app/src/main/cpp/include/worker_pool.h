@@ -0,0 +1,66 @@
+#ifndef LOCALIFY_WORKER_POOL_H
+#define LOCALIFY_WORKER_POOL_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <cstddef>
+
+namespace localify {
+
+// Small fixed set of threads for CPU-bound work such as decoding large
+// responses. The thread that calls parallelFor works too, so a pool of N
+// threads runs N - 1 workers and a call made from a worker cannot deadlock.
+class WorkerPool {
+private:
+    static std::unique_ptr<WorkerPool> instance;
+
+    struct Batch {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        std::atomic<size_t> next;
+        std::atomic<size_t> finished;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    using BatchPtr = std::shared_ptr<Batch>;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<BatchPtr> batches;
+    std::vector<std::thread> workers;
+    bool stopping;
+
+    WorkerPool();
+
+    void workerLoop();
+    void startWorkers(size_t count);
+    void stopWorkers();
+
+    // Claims and runs indices of batch until none are left
+    static void runBatch(Batch& batch);
+
+public:
+    ~WorkerPool();
+
+    static WorkerPool& getInstance();
+
+    // Runs task(0) .. task(count - 1), spread over the pool, and returns once
+    // all have finished. The first exception thrown by a task is rethrown.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    // Threads parallelFor may use, the caller included
+    size_t getThreadCount() const;
+    void setThreadCount(size_t threads);
+};
+
+} // namespace localify
+
+#endif // LOCALIFY_WORKER_POOL_H
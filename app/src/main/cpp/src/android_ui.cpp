@@ -1,4 +1,10 @@
 #include "android_ui.h"
+#include "screens.h"
+#include "api_service.h"
+#include "http_client.h"
+#include "fixture_transport.h"
+#include "tls_context.h"
+#include "app_config.h"
 #include <android/log.h>
 #include <android_native_app_glue.h>
 #include <EGL/egl.h>
@@ -220,16 +226,12 @@ void Screen::update(float deltaTime) {
     }
 }
 
-void Screen::addComponent(std::unique_ptr<UIComponent> component) {
-    components.push_back(std::move(component));
-}
-
 // LocalifyApp implementation
 LocalifyApp::LocalifyApp(ANativeActivity* activity) 
     : activity(activity), window(nullptr), display(EGL_NO_DISPLAY), 
       surface(EGL_NO_SURFACE), context(EGL_NO_CONTEXT),
       width(0), height(0), initialized(false), running(false),
-      currentScreenType(LOGIN_SCREEN) {
+      currentScreen(nullptr), currentScreenType(LOGIN_SCREEN) {
 }
 
 LocalifyApp::~LocalifyApp() {
@@ -241,6 +243,14 @@ bool LocalifyApp::initialize() {
     
     LOGI("Initializing Localify App");
     
+    // Keep cached API responses across launches in app-private storage
+    if (activity && activity->internalDataPath) {
+        HttpClient::getInstance().setCacheDirectory(std::string(activity->internalDataPath) + "/http-cache");
+    }
+    if (AppConfig::USE_DEVELOPMENT_FIXTURES || !TlsContext::isAvailable()) {
+        HttpClient::getInstance().setTransport(createDevelopmentTransport());
+    }
+    
     // Window will be set via setWindow() method when available
     if (!window) {
         LOGI("Window not yet available, will initialize when window is created");
@@ -277,8 +287,8 @@ void LocalifyApp::shutdown() {
     
     LOGI("Shutting down Localify App");
     
+    currentScreen = nullptr;
     screens.clear();
-    currentScreen.reset();
     
     shutdownEGL();
     
@@ -376,20 +386,41 @@ void LocalifyApp::shutdownEGL() {
 }
 
 void LocalifyApp::createScreens() {
-    // Create all screens
-    screens.resize(5);
-    // We'll implement these in screens.cpp
+    // In ScreenType order
+    screens.clear();
+    screens.push_back(std::make_unique<LoginScreen>());
+    screens.push_back(std::make_unique<HomeScreen>());
+    screens.push_back(std::make_unique<SearchScreen>());
+    screens.push_back(std::make_unique<FavoritesScreen>());
+    screens.push_back(std::make_unique<ProfileScreen>());
+    screens.push_back(std::make_unique<MapScreen>());
     
     // Start with login screen
     navigateToScreen(LOGIN_SCREEN);
 }
 
 void LocalifyApp::navigateToScreen(ScreenType screenType) {
+    if (static_cast<size_t>(screenType) >= screens.size()) {
+        return;
+    }
     currentScreenType = screenType;
     
-    if (screenType < screens.size() && screens[screenType]) {
-        currentScreen = std::move(screens[screenType]);
-        currentScreen->initialize();
+    if (currentScreen) {
+        currentScreen->onHide();
+    }
+    currentScreen = screens[screenType].get();
+    currentScreen->initialize();
+    currentScreen->onShow();
+    
+    // Screens the user may open next start loading now, behind the current
+    // one; their loads are all authenticated, so not before sign-in
+    if (APIService::getInstance().getAuthToken().empty()) {
+        return;
+    }
+    for (const auto& screen : screens) {
+        if (screen.get() != currentScreen) {
+            screen->prefetch();
+        }
     }
 }
 
@@ -464,10 +495,16 @@ void LocalifyApp::handleCommand(int32_t cmd) {
         case 10: // APP_CMD_GAINED_FOCUS
             LOGI("App gained focus");
             running = true;
+            if (currentScreen) {
+                currentScreen->onShow();
+            }
             break;
         case 11: // APP_CMD_LOST_FOCUS
             LOGI("App lost focus");
             running = false;
+            if (currentScreen) {
+                currentScreen->onHide();
+            }
             break;
         default:
             LOGI("Unhandled command: %d", cmd);
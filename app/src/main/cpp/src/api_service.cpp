@@ -1,10 +1,16 @@
 #include "api_service.h"
 #include "json_parser.h"
+#include "json_writer.h"
 #include "app_config.h"
 #include <android/log.h>
 #include <sstream>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <typeinfo>
+#include <algorithm>
 
 #define LOG_TAG "LocalifyAPI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -12,9 +18,24 @@
 
 namespace localify {
 
+namespace {
+
+// Path segments carrying digits are ids, except the API version ("v1")
+bool isIdSegment(std::string_view segment) {
+    bool hasDigit = std::any_of(segment.begin(), segment.end(), [](char c) { return c >= '0' && c <= '9'; });
+    bool isVersion = segment.size() > 1 && segment[0] == 'v' &&
+                     std::all_of(segment.begin() + 1, segment.end(), [](char c) { return c >= '0' && c <= '9'; });
+    return hasDigit && !isVersion;
+}
+
+} // namespace
+
 std::unique_ptr<APIService> APIService::instance = nullptr;
 
-APIService::APIService() : apiUrl(AppConfig::API_BASE_URL) {
+APIService::APIService()
+    : apiUrl(AppConfig::API_BASE_URL),
+      userVisiblePriority(PriorityToken::create(RequestPriority::USER_VISIBLE)),
+      backgroundPriority(PriorityToken::create(RequestPriority::BACKGROUND)) {
     LOGI("Initializing APIService with base URL: %s", apiUrl.c_str());
 }
 
@@ -29,12 +50,8 @@ APIService& APIService::getInstance() {
     return *instance;
 }
 
-HTTPResponse APIService::performRequest(const std::string& url, const std::string& method, 
-                                       const std::string& body, bool ignoreAuth) {
-    HTTPResponse response;
-    
-    LOGI("API Request: %s %s", method.c_str(), url.c_str());
-    
+HttpRequest APIService::buildRequest(const std::string& url, const std::string& method,
+                                     const std::string& body, bool ignoreAuth) const {
     // Create HTTP request
     HttpRequest request(url, method);
     request.body = body;
@@ -48,19 +65,288 @@ HTTPResponse APIService::performRequest(const std::string& url, const std::strin
         request.setAuthorization(currentAuthToken);
     }
     
-    // Perform request using our HttpClient
-    HttpResponse httpResponse = HttpClient::getInstance().request(request);
+    return request;
+}
+
+HTTPResponse APIService::performRequest(const std::string& url, const std::string& method, 
+                                       const std::string& body, bool ignoreAuth,
+                                       std::shared_ptr<CancellationToken> cancellation,
+                                       std::shared_ptr<PriorityToken> priority) {
+    HTTPResponse response;
+    
+    LOGI("API Request: %s %s", method.c_str(), url.c_str());
+    
+    HttpRequest request = buildRequest(url, method, body, ignoreAuth);
+    request.cancellation = cancellation;
+    request.priority = priority;
+    std::string host = hostOf(url);
+    
+    // Idempotent requests are repeated on transient failures; this thread is
+    // a worker already waiting on the result, so backing off here is cheap
+    HttpResponse httpResponse;
+    int attempt = 1;
+    while (true) {
+        if (!circuitBreaker.allowRequest(host)) {
+            httpResponse = HttpResponse();
+            httpResponse.error = "Circuit open for " + host;
+            httpResponse.errorCode = HttpError::CIRCUIT_OPEN;
+            break;
+        }
+        httpResponse = HttpClient::getInstance().request(request);
+        recordTiming(method, url, httpResponse);
+        recordHostHealth(host, httpResponse);
+        
+        bool retryable = RetryPolicy::isIdempotent(method) && RetryPolicy::isRetryable(httpResponse);
+        if (!retryable) {
+            if (attempt > 1 && httpResponse.error.empty() && httpResponse.isSuccess()) {
+                std::lock_guard<std::mutex> lock(retryMutex);
+                retryStats.recovered++;
+            }
+            break;
+        }
+        
+        std::chrono::milliseconds delay = RetryPolicy::retryAfter(httpResponse);
+        bool serverDelay = delay.count() >= 0;
+        if (!serverDelay) {
+            delay = retryPolicy.backoff(attempt);
+        }
+        if (attempt >= retryPolicy.maxAttempts || delay > retryPolicy.maxRetryAfter || circuitBreaker.isOpen(host)) {
+            std::lock_guard<std::mutex> lock(retryMutex);
+            retryStats.exhausted++;
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(retryMutex);
+            retryStats.retries++;
+            if (serverDelay) {
+                retryStats.retryAfterHonoured++;
+            }
+        }
+        LOGI("Retrying %s %s in %lld ms (attempt %d failed: %ld %s)", method.c_str(), url.c_str(),
+             static_cast<long long>(delay.count()), attempt, static_cast<long>(httpResponse.statusCode),
+             httpResponse.error.c_str());
+        
+        bool cancelled = cancellation ? cancellation->waitFor(delay) : (std::this_thread::sleep_for(delay), false);
+        if (cancelled) {
+            httpResponse = HttpResponse();
+            httpResponse.error = "Request cancelled";
+            httpResponse.errorCode = HttpError::CANCELLED;
+            break;
+        }
+        attempt++;
+    }
     
     // Convert HttpResponse to HTTPResponse
     response.statusCode = httpResponse.statusCode;
     response.data = httpResponse.body;
     response.error = httpResponse.error;
+    response.transportError = httpResponse.errorCode;
     
     LOGI("API Response: %ld", response.statusCode);
     
     return response;
 }
 
+std::string APIService::endpointKey(const std::string& method, const std::string& url) const {
+    std::string key = method + " ";
+    size_t start = url.compare(0, apiUrl.size(), apiUrl) == 0 ? apiUrl.size() : 0;
+    size_t end = std::min(url.find('?', start), url.size());
+    
+    // Collapse ids so /v1/artists/42 and /v1/artists/43 aggregate together
+    while (start < end) {
+        size_t slash = url.find('/', start + 1);
+        if (slash == std::string::npos || slash > end) {
+            slash = end;
+        }
+        if (isIdSegment(std::string_view(url).substr(start + 1, slash - start - 1))) {
+            key.append("/{id}");
+        } else {
+            key.append(url, start, slash - start);
+        }
+        start = slash;
+    }
+    return key;
+}
+
+std::string APIService::hostOf(const std::string& url) {
+    ParsedUrl parsed;
+    return HttpParser::parseUrl(url, parsed) ? std::string(parsed.host) : url;
+}
+
+void APIService::recordHostHealth(const std::string& host, const HttpResponse& response) {
+    // Client errors mean the host is up and answering; only outages count
+    if (response.errorCode == HttpError::NETWORK || response.errorCode == HttpError::TIMED_OUT ||
+        (response.error.empty() && response.statusCode >= 500)) {
+        circuitBreaker.recordFailure(host);
+    } else if (response.error.empty()) {
+        circuitBreaker.recordSuccess(host);
+    }
+}
+
+void APIService::recordTiming(const std::string& method, const std::string& url, const HttpResponse& response) {
+    // Fresh cache hits and requests rejected before submission never hit the wire
+    if (response.timing.total.count() == 0) {
+        return;
+    }
+    std::string key = endpointKey(method, url);
+    const HttpTiming& timing = response.timing;
+    
+    std::lock_guard<std::mutex> lock(timingMutex);
+    EndpointTiming& entry = endpointTimings[key];
+    entry.requests++;
+    if (!response.error.empty()) {
+        entry.failures++;
+    }
+    if (timing.reusedConnection) {
+        entry.reusedConnections++;
+    }
+    if (timing.resumedSession) {
+        entry.resumedSessions++;
+    }
+    entry.sum.resolve += timing.resolve;
+    entry.sum.connect += timing.connect;
+    entry.sum.tls += timing.tls;
+    entry.sum.send += timing.send;
+    entry.sum.firstByte += timing.firstByte;
+    entry.sum.transfer += timing.transfer;
+    entry.sum.total += timing.total;
+    entry.sum.bytesSent += timing.bytesSent;
+    entry.sum.bytesReceived += timing.bytesReceived;
+    entry.slowest = std::max(entry.slowest, timing.total);
+}
+
+void APIService::throwRequestFailure(const HTTPResponse& response, const std::string& context) {
+    APIError error = APIError::REQUEST_FAILED;
+    if (response.transportError == HttpError::CANCELLED) {
+        error = APIError::CANCELLED;
+    } else if (response.transportError == HttpError::INVALID_URL) {
+        error = APIError::INVALID_URL;
+    } else if (response.statusCode == 401 || response.statusCode == 403) {
+        error = APIError::AUTHENTICATION_FAILURE;
+    } else if (response.statusCode >= 400 && response.statusCode < 500) {
+        error = APIError::CLIENT_4XX_ERROR;
+    } else if (response.statusCode >= 500) {
+        error = APIError::SERVER_5XX_ERROR;
+    }
+    throw APIException(error, context + ": " + response.error);
+}
+
+template<typename T>
+std::vector<T> APIService::fetchArrayStreaming(const std::string& url, T (*parseElement)(const std::string&),
+                                               const std::string& description,
+                                               std::shared_ptr<PriorityToken> priority,
+                                               std::shared_ptr<CancellationToken> cancellation) {
+    // Elements are split out on the I/O thread and decoded here, so decoding
+    // overlaps with the remainder of the download
+    struct ElementQueue {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<std::string> elements;
+        bool finished = false;
+        long statusCode = 0;
+        std::string error;
+        HttpError transportError = HttpError::NONE;
+    };
+    auto queue = std::make_shared<ElementQueue>();
+    auto splitter = std::make_shared<JSONArrayStream>([queue](std::string element) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->elements.push_back(std::move(element));
+        queue->ready.notify_one();
+    });
+    
+    LOGI("API Request (streaming): GET %s", url.c_str());
+    
+    // Elements may already have been handed out when a stream fails, so
+    // streams are not retried, only gated by the breaker
+    std::string host = hostOf(url);
+    if (!circuitBreaker.allowRequest(host)) {
+        HTTPResponse failure;
+        failure.error = "Circuit open for " + host;
+        failure.transportError = HttpError::CIRCUIT_OPEN;
+        throwRequestFailure(failure, "Failed to fetch " + description);
+    }
+    
+    HttpRequest request = buildRequest(url, "GET", "", false);
+    request.priority = priority;
+    request.cancellation = cancellation;
+    HttpClient::getInstance().stream(request,
+        [queue](const HttpResponse& head) {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->statusCode = head.statusCode;
+            return true;
+        },
+        [queue, splitter](const char* data, size_t length) {
+            // Error bodies are not arrays; drain them without splitting
+            if (queue->statusCode >= 200 && queue->statusCode < 300 && !splitter->isMalformed()) {
+                splitter->feed(data, length);
+            }
+            return true;
+        },
+        [this, queue, url, host](const HttpResponse& response) {
+            recordTiming("GET", url, response);
+            recordHostHealth(host, response);
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->statusCode = response.statusCode;
+            queue->error = response.error;
+            queue->transportError = response.errorCode;
+            queue->finished = true;
+            queue->ready.notify_one();
+        });
+    
+    std::vector<T> items;
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    while (true) {
+        queue->ready.wait(lock, [&queue]() { return !queue->elements.empty() || queue->finished; });
+        if (queue->elements.empty()) {
+            break;
+        }
+        std::string element = std::move(queue->elements.front());
+        queue->elements.pop_front();
+        // Once cancelled, split-out elements are dropped undecoded until the
+        // transfer winds down
+        if (cancellation && cancellation->isCancelled()) {
+            continue;
+        }
+        lock.unlock();
+        items.push_back(parseElement(element));
+        lock.lock();
+    }
+    
+    LOGI("API Response: %ld (%zu elements streamed)", queue->statusCode, items.size());
+    
+    if (cancellation && cancellation->isCancelled()) {
+        HTTPResponse failure;
+        failure.error = "Request cancelled";
+        failure.transportError = HttpError::CANCELLED;
+        throwRequestFailure(failure, "Failed to fetch " + description);
+    }
+    if (queue->statusCode < 200 || queue->statusCode >= 300) {
+        HTTPResponse failure;
+        failure.statusCode = queue->statusCode;
+        failure.error = queue->error;
+        failure.transportError = queue->transportError;
+        throwRequestFailure(failure, "Failed to fetch " + description);
+    }
+    if (splitter->isMalformed() || !splitter->isComplete()) {
+        LOGE("Unexpected %s response: not a complete JSON array", description.c_str());
+    }
+    return items;
+}
+
+template<typename T>
+T APIService::coalesceGet(const std::string& url, const std::function<T()>& fetch) {
+    // The token is part of the key so responses never cross accounts
+    std::string key = url + "\n" + currentAuthToken + "\n" + typeid(T).name();
+    return inFlightGets.run<T>(key, fetch);
+}
+
+template<typename T>
+T APIService::coalesceGet(const std::string& url, const std::shared_ptr<PriorityToken>& priority,
+                          const std::function<T(const std::shared_ptr<PriorityToken>&)>& fetch) {
+    std::string key = url + "\n" + currentAuthToken + "\n" + typeid(T).name();
+    return inFlightGets.run<T>(key, priority, fetch);
+}
+
 std::string APIService::buildURL(const std::string& path) const {
     return apiUrl + path;
 }
@@ -94,7 +380,7 @@ std::future<AuthResponse> APIService::refreshAuth(bool force) {
             storeAuth(auth);
             return auth;
         } else {
-            throw std::runtime_error("Failed to refresh token: " + response.error);
+            throwRequestFailure(response, "Failed to refresh token");
         }
     });
 }
@@ -102,16 +388,20 @@ std::future<AuthResponse> APIService::refreshAuth(bool force) {
 std::future<AuthResponse> APIService::exchangeToken(const std::string& token, const std::string& secret) {
     return std::async(std::launch::async, [this, token, secret]() -> AuthResponse {
         std::string url = buildURL("/v1/auth/token");
-        std::string body = R"({"token": ")" + token + R"(", "secret": ")" + secret + R"("})";
+        JSONWriter body(token.size() + secret.size() + 32);
+        body.beginObject();
+        body.field("token", token);
+        body.field("secret", secret);
+        body.endObject();
         
-        HTTPResponse response = performRequest(url, "POST", body, true);
+        HTTPResponse response = performRequest(url, "POST", body.str(), true);
         
         if (response.statusCode >= 200 && response.statusCode < 300) {
             AuthResponse auth = JSONParser::parseAuthResponse(response.data);
             storeAuth(auth);
             return auth;
         } else {
-            throw std::runtime_error("Failed to exchange token: " + response.error);
+            throwRequestFailure(response, "Failed to exchange token");
         }
     });
 }
@@ -127,7 +417,7 @@ std::future<AuthResponse> APIService::createGuestUser() {
             storeAuth(auth);
             return auth;
         } else {
-            throw std::runtime_error("Failed to create guest user: " + response.error);
+            throwRequestFailure(response, "Failed to create guest user");
         }
     });
 }
@@ -136,50 +426,86 @@ std::future<UserDetails> APIService::fetchUserDetails() {
     return std::async(std::launch::async, [this]() -> UserDetails {
         std::string url = buildURL("/v1/@me");
         
-        HTTPResponse response = performRequest(url, "GET");
-        
-        if (response.statusCode >= 200 && response.statusCode < 300) {
-            return JSONParser::parseUserDetails(response.data);
-        } else {
-            throw std::runtime_error("Failed to fetch user details: " + response.error);
-        }
+        return coalesceGet<UserDetails>(url, [this, &url]() -> UserDetails {
+            HTTPResponse response = performRequest(url, "GET");
+            
+            if (response.statusCode >= 200 && response.statusCode < 300) {
+                return JSONParser::parseUserDetails(response.data);
+            } else {
+                throwRequestFailure(response, "Failed to fetch user details");
+            }
+        });
     });
 }
 
-std::future<SearchResponse> APIService::fetchSearch(const std::string& text, bool autoSearchSpotify) {
-    return std::async(std::launch::async, [this, text, autoSearchSpotify]() -> SearchResponse {
+std::future<SearchResponse> APIService::fetchSearch(const std::string& text, bool autoSearchSpotify,
+                                                    std::shared_ptr<CancellationToken> cancellation) {
+    return std::async(std::launch::async, [this, text, autoSearchSpotify, cancellation]() -> SearchResponse {
         if (text.empty()) {
             return SearchResponse();
         }
         
-        std::string url = buildURL("/v1/search?q=" + text + "&autoSearchSpotify=" + 
-                                 (autoSearchSpotify ? "true" : "false"));
-        
-        HTTPResponse response = performRequest(url, "GET");
-        
-        if (response.statusCode >= 200 && response.statusCode < 300) {
-            return JSONParser::parseSearchResponse(response.data);
-        } else {
-            throw std::runtime_error("Failed to perform search: " + response.error);
+        std::string url = searchURL(text, autoSearchSpotify);
+        std::function<SearchResponse()> fetch = [this, &url, &cancellation]() -> SearchResponse {
+            HTTPResponse response = performRequest(url, "GET", "", false, cancellation, userVisiblePriority);
+            
+            if (response.statusCode >= 200 && response.statusCode < 300) {
+                return JSONParser::parseSearchResponse(response.data);
+            } else {
+                throwRequestFailure(response, "Failed to perform search");
+            }
+        };
+        // A cancellable caller must not share a request another caller may cancel
+        return cancellation ? fetch() : coalesceGet(url, fetch);
+    });
+}
+
+std::future<std::shared_ptr<LazySearchResponse>> APIService::fetchSearchLazy(
+    const std::string& text, bool autoSearchSpotify, std::shared_ptr<CancellationToken> cancellation) {
+    return std::async(std::launch::async,
+                      [this, text, autoSearchSpotify, cancellation]() -> std::shared_ptr<LazySearchResponse> {
+        if (text.empty()) {
+            return std::make_shared<LazySearchResponse>();
         }
+        
+        std::string url = searchURL(text, autoSearchSpotify);
+        std::function<std::shared_ptr<LazySearchResponse>()> fetch =
+            [this, &url, &cancellation]() -> std::shared_ptr<LazySearchResponse> {
+            HTTPResponse response = performRequest(url, "GET", "", false, cancellation, userVisiblePriority);
+            
+            if (response.statusCode >= 200 && response.statusCode < 300) {
+                return JSONParser::parseSearchResponseLazy(std::move(response.data));
+            } else {
+                throwRequestFailure(response, "Failed to perform search");
+            }
+        };
+        return cancellation ? fetch() : coalesceGet(url, fetch);
     });
 }
 
-std::future<std::vector<ArtistResponse>> APIService::fetchSearchArtists(const std::string& text, int limit) {
-    return std::async(std::launch::async, [this, text, limit]() -> std::vector<ArtistResponse> {
+std::string APIService::searchURL(const std::string& text, bool autoSearchSpotify) const {
+    return buildURL("/v1/search?q=" + text + "&autoSearchSpotify=" + (autoSearchSpotify ? "true" : "false"));
+}
+
+std::future<std::vector<ArtistResponse>> APIService::fetchSearchArtists(const std::string& text, int limit,
+                                                                        std::shared_ptr<CancellationToken> cancellation) {
+    return std::async(std::launch::async, [this, text, limit, cancellation]() -> std::vector<ArtistResponse> {
         if (text.empty()) {
             return std::vector<ArtistResponse>();
         }
         
         std::string url = buildURL("/v1/artists/search?q=" + text + "&limit=" + std::to_string(limit));
         
-        HTTPResponse response = performRequest(url, "GET");
-        
-        if (response.statusCode >= 200 && response.statusCode < 300) {
-            return JSONParser::parseArtistArray(response.data);
-        } else {
-            throw std::runtime_error("Failed to search artists: " + response.error);
-        }
+        std::function<std::vector<ArtistResponse>()> fetch = [this, &url, &cancellation]() -> std::vector<ArtistResponse> {
+            HTTPResponse response = performRequest(url, "GET", "", false, cancellation, userVisiblePriority);
+            
+            if (response.statusCode >= 200 && response.statusCode < 300) {
+                return JSONParser::parseArtistArray(response.data);
+            } else {
+                throwRequestFailure(response, "Failed to search artists");
+            }
+        };
+        return cancellation ? fetch() : coalesceGet(url, fetch);
     });
 }
 
@@ -197,7 +523,7 @@ std::future<void> APIService::addFavorite(const std::string& id, FavoriteType ty
         HTTPResponse response = performRequest(url, "PUT");
         
         if (response.statusCode < 200 || response.statusCode >= 300) {
-            throw std::runtime_error("Failed to add favorite: " + response.error);
+            throwRequestFailure(response, "Failed to add favorite");
         }
     });
 }
@@ -216,7 +542,7 @@ std::future<void> APIService::removeFavorite(const std::string& id, FavoriteType
         HTTPResponse response = performRequest(url, "DELETE");
         
         if (response.statusCode < 200 || response.statusCode >= 300) {
-            throw std::runtime_error("Failed to remove favorite: " + response.error);
+            throwRequestFailure(response, "Failed to remove favorite");
         }
     });
 }
@@ -235,28 +561,81 @@ void APIService::clearAuth() {
     authExpiresAt.clear();
 }
 
-// Stub implementations for missing methods (to be implemented later)
-std::future<std::vector<ArtistResponse>> APIService::fetchFavoriteArtists(int page, int limit) {
-    return std::async(std::launch::async, []() -> std::vector<ArtistResponse> {
-        LOGI("fetchFavoriteArtists stub called");
-        return std::vector<ArtistResponse>();
+SingleFlightStats APIService::getCoalescingStats() const {
+    return inFlightGets.getStats();
+}
+
+RetryStats APIService::getRetryStats() const {
+    std::lock_guard<std::mutex> lock(retryMutex);
+    return retryStats;
+}
+
+CircuitBreakerStats APIService::getCircuitBreakerStats() const {
+    return circuitBreaker.getStats();
+}
+
+std::map<std::string, EndpointTiming> APIService::getEndpointTimings() const {
+    std::lock_guard<std::mutex> lock(timingMutex);
+    return endpointTimings;
+}
+
+std::future<std::vector<ArtistResponse>> APIService::fetchFavoriteArtists(int page, int limit,
+                                                                          std::shared_ptr<PriorityToken> priority,
+                                                                          std::shared_ptr<CancellationToken> cancellation) {
+    return std::async(std::launch::async, [this, page, limit, priority, cancellation]() -> std::vector<ArtistResponse> {
+        std::string url = buildURL("/v1/@me/artists/favorites?page=" + std::to_string(page) +
+                                   "&limit=" + std::to_string(limit));
+        std::shared_ptr<PriorityToken> sendPriority = priority ? priority : backgroundPriority;
+        std::function<std::vector<ArtistResponse>(const std::shared_ptr<PriorityToken>&)> fetch =
+            [this, &url, &cancellation](const std::shared_ptr<PriorityToken>& sendAt) {
+            return fetchArrayStreaming(url, &JSONParser::parseArtistResponse, "favorite artists", sendAt, cancellation);
+        };
+        return cancellation ? fetch(sendPriority) : coalesceGet(url, sendPriority, fetch);
+    });
+}
+
+std::future<std::vector<EventResponse>> APIService::fetchFavoriteEvents(int page, int limit, bool upcoming,
+                                                                        std::shared_ptr<PriorityToken> priority,
+                                                                        std::shared_ptr<CancellationToken> cancellation) {
+    return std::async(std::launch::async, [this, page, limit, upcoming, priority, cancellation]() -> std::vector<EventResponse> {
+        std::string url = buildURL("/v1/@me/events/favorites?page=" + std::to_string(page) +
+                                   "&limit=" + std::to_string(limit) +
+                                   "&upcoming=" + (upcoming ? "true" : "false"));
+        std::shared_ptr<PriorityToken> sendPriority = priority ? priority : backgroundPriority;
+        std::function<std::vector<EventResponse>(const std::shared_ptr<PriorityToken>&)> fetch =
+            [this, &url, &cancellation](const std::shared_ptr<PriorityToken>& sendAt) {
+            return fetchArrayStreaming(url, &JSONParser::parseEventResponse, "favorite events", sendAt, cancellation);
+        };
+        return cancellation ? fetch(sendPriority) : coalesceGet(url, sendPriority, fetch);
     });
 }
 
-std::future<std::vector<EventResponse>> APIService::fetchFavoriteEvents(int page, int limit, bool upcoming) {
-    return std::async(std::launch::async, []() -> std::vector<EventResponse> {
-        LOGI("fetchFavoriteEvents stub called");
-        return std::vector<EventResponse>();
+std::future<std::vector<EventResponse>> APIService::fetchEventsForCities(const std::string& cityId, int page, int limit) {
+    return std::async(std::launch::async, [this, cityId, page, limit]() -> std::vector<EventResponse> {
+        std::string url = buildURL("/v1/cities/" + cityId + "/events?page=" + std::to_string(page) +
+                                   "&limit=" + std::to_string(limit));
+        return coalesceGet<std::vector<EventResponse>>(url, [this, &url]() {
+            return fetchArrayStreaming(url, &JSONParser::parseEventResponse, "city events");
+        });
     });
 }
 
-std::future<std::vector<VenueResponse>> APIService::fetchFavoriteVenues(int page, int limit) {
-    return std::async(std::launch::async, []() -> std::vector<VenueResponse> {
-        LOGI("fetchFavoriteVenues stub called");
-        return std::vector<VenueResponse>();
+std::future<std::vector<VenueResponse>> APIService::fetchFavoriteVenues(int page, int limit,
+                                                                        std::shared_ptr<PriorityToken> priority,
+                                                                        std::shared_ptr<CancellationToken> cancellation) {
+    return std::async(std::launch::async, [this, page, limit, priority, cancellation]() -> std::vector<VenueResponse> {
+        std::string url = buildURL("/v1/@me/venues/favorites?page=" + std::to_string(page) +
+                                   "&limit=" + std::to_string(limit));
+        std::shared_ptr<PriorityToken> sendPriority = priority ? priority : backgroundPriority;
+        std::function<std::vector<VenueResponse>(const std::shared_ptr<PriorityToken>&)> fetch =
+            [this, &url, &cancellation](const std::shared_ptr<PriorityToken>& sendAt) {
+            return fetchArrayStreaming(url, &JSONParser::parseVenueResponse, "favorite venues", sendAt, cancellation);
+        };
+        return cancellation ? fetch(sendPriority) : coalesceGet(url, sendPriority, fetch);
     });
 }
 
+// Stub implementations for missing methods (to be implemented later)
 std::future<void> APIService::deleteUserAccount() {
     return std::async(std::launch::async, [this]() -> void {
         LOGI("deleteUserAccount stub called");
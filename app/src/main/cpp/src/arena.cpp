@@ -0,0 +1,74 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace localify {
+
+namespace {
+// Blocks double from the configured size up to this; bigger requests get
+// a block of their own
+const size_t MAX_GROWN_BLOCK_SIZE = 1024 * 1024;
+}
+
+Arena::Arena(size_t blockSize)
+    : blocks(nullptr), cursor(nullptr), limit(nullptr),
+      nextBlockSize(std::max<size_t>(blockSize, 256)), bytesUsed(0), bytesReserved(0) {}
+
+Arena::~Arena() {
+    freeBlocks();
+}
+
+void Arena::addBlock(size_t size) {
+    Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+    block->next = blocks;
+    block->size = size;
+    blocks = block;
+    cursor = dataOf(block);
+    limit = cursor + size;
+    bytesReserved += size;
+}
+
+void Arena::freeBlocks() {
+    while (blocks != nullptr) {
+        Block* next = blocks->next;
+        ::operator delete(blocks);
+        blocks = next;
+    }
+    cursor = nullptr;
+    limit = nullptr;
+    bytesReserved = 0;
+}
+
+void* Arena::allocateSlow(size_t size, size_t alignment) {
+    // Whatever is left of the current block is abandoned until reset()
+    size_t needed = size + alignment;
+    addBlock(std::max(nextBlockSize, needed));
+    if (needed <= nextBlockSize) {
+        nextBlockSize = std::min(nextBlockSize * 2, std::max(MAX_GROWN_BLOCK_SIZE, nextBlockSize));
+    }
+    return allocate(size, alignment);
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* out = static_cast<char*>(allocate(text.size(), 1));
+    memcpy(out, text.data(), text.size());
+    return std::string_view(out, text.size());
+}
+
+void Arena::reset() {
+    if (blocks != nullptr && blocks->next != nullptr) {
+        size_t total = bytesReserved;
+        freeBlocks();
+        addBlock(total);
+    } else if (blocks != nullptr) {
+        cursor = dataOf(blocks);
+        limit = cursor + blocks->size;
+    }
+    bytesUsed = 0;
+}
+
+} // namespace localify
@@ -0,0 +1,48 @@
+#include "buffer_pool.h"
+
+namespace localify {
+
+std::unique_ptr<BufferPool> BufferPool::instance = nullptr;
+
+BufferPool& BufferPool::getInstance() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        instance = std::unique_ptr<BufferPool>(new BufferPool());
+    });
+    return *instance;
+}
+
+std::string BufferPool::acquire(size_t minCapacity) {
+    std::string buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.acquired++;
+        if (!freeBuffers.empty()) {
+            buffer = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+            stats.reused++;
+        }
+    }
+    buffer.clear();
+    buffer.reserve(minCapacity);
+    return buffer;
+}
+
+void BufferPool::release(std::string buffer) {
+    if (buffer.capacity() > MAX_RETAINED_CAPACITY) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeBuffers.size() < MAX_POOLED_BUFFERS) {
+        freeBuffers.push_back(std::move(buffer));
+    }
+}
+
+BufferPoolStats BufferPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    BufferPoolStats result = stats;
+    result.pooled = freeBuffers.size();
+    return result;
+}
+
+} // namespace localify
@@ -0,0 +1,50 @@
+#include "cancellation.h"
+
+namespace localify {
+
+std::shared_ptr<CancellationToken> CancellationToken::create() {
+    return std::shared_ptr<CancellationToken>(new CancellationToken());
+}
+
+void CancellationToken::cancel() {
+    std::map<uint64_t, Callback> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cancelled.exchange(true)) {
+            return;
+        }
+        pending.swap(callbacks);
+    }
+    cancelledSignal.notify_all();
+    for (auto& entry : pending) {
+        entry.second();
+    }
+}
+
+uint64_t CancellationToken::subscribe(Callback callback) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!cancelled) {
+            uint64_t id = nextId++;
+            callbacks[id] = std::move(callback);
+            return id;
+        }
+    }
+    callback();
+    return 0;
+}
+
+bool CancellationToken::waitFor(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return cancelledSignal.wait_for(lock, timeout, [this]() { return cancelled.load(); });
+}
+
+void CancellationToken::unsubscribe(uint64_t id) {
+    if (id == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    callbacks.erase(id);
+}
+
+} // namespace localify
@@ -0,0 +1,72 @@
+#include "circuit_breaker.h"
+#include <android/log.h>
+
+#define LOG_TAG "LocalifyHTTP"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+CircuitBreaker::CircuitBreaker(int failureThreshold, std::chrono::milliseconds cooldown)
+    : failureThreshold(failureThreshold), cooldown(cooldown) {}
+
+bool CircuitBreaker::allowRequest(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = hosts.find(host);
+    if (it == hosts.end() || it->second.state == State::CLOSED) {
+        return true;
+    }
+
+    // A probe that never reported back (cancelled, abandoned) expires like
+    // the cooldown, so the host cannot stay blocked forever
+    Host& entry = it->second;
+    Clock::time_point now = Clock::now();
+    if (now < entry.openUntil) {
+        stats.rejected++;
+        return false;
+    }
+    entry.state = State::HALF_OPEN;
+    entry.openUntil = now + cooldown;
+    stats.probes++;
+    LOGI("Circuit for %s half-open, probing", host.c_str());
+    return true;
+}
+
+void CircuitBreaker::recordSuccess(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = hosts.find(host);
+    if (it == hosts.end()) {
+        return;
+    }
+    if (it->second.state != State::CLOSED) {
+        LOGI("Circuit for %s closed", host.c_str());
+    }
+    hosts.erase(it);
+}
+
+void CircuitBreaker::recordFailure(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Host& entry = hosts[host];
+    entry.consecutiveFailures++;
+    if (entry.state == State::HALF_OPEN || entry.consecutiveFailures >= failureThreshold) {
+        if (entry.state != State::OPEN) {
+            stats.opened++;
+            LOGE("Circuit for %s open after %d consecutive failures", host.c_str(), entry.consecutiveFailures);
+        }
+        entry.state = State::OPEN;
+        entry.openUntil = Clock::now() + cooldown;
+    }
+}
+
+bool CircuitBreaker::isOpen(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = hosts.find(host);
+    return it != hosts.end() && it->second.state != State::CLOSED && Clock::now() < it->second.openUntil;
+}
+
+CircuitBreakerStats CircuitBreaker::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+} // namespace localify
@@ -0,0 +1,207 @@
+#include "connection_pool.h"
+#include "tls_context.h"
+#include <android/log.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+
+#define LOG_TAG "LocalifyPool"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+ConnectionPool::ConnectionPool(size_t maxIdlePerHost, size_t maxIdleTotal,
+                               std::chrono::seconds idleTimeout)
+    : maxIdlePerHost(maxIdlePerHost), maxIdleTotal(maxIdleTotal),
+      idleTimeout(idleTimeout), idleCount(0) {}
+
+ConnectionPool::~ConnectionPool() {
+    clear();
+}
+
+std::string ConnectionPool::makeKey(const std::string& host, int port) {
+    return host + ":" + std::to_string(port);
+}
+
+bool ConnectionPool::isExpired(const PooledConnection& connection,
+                               std::chrono::steady_clock::time_point now,
+                               std::chrono::seconds idleTimeout) {
+    // The server's advertised keep-alive window wins over our own default
+    std::chrono::seconds limit = idleTimeout;
+    if (connection.keepAliveTimeout.count() > 0 && connection.keepAliveTimeout < limit) {
+        limit = connection.keepAliveTimeout;
+    }
+    return now - connection.lastUsed >= limit;
+}
+
+bool ConnectionPool::isAlive(const PooledConnection& connection) {
+    // An idle HTTP connection must have nothing to read: readability means the
+    // peer closed it (EOF), reset it, or sent unsolicited bytes. Over TLS it
+    // may also be a record TLS itself consumes, such as a late session ticket.
+    struct pollfd pfd;
+    pfd.fd = connection.fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ready = poll(&pfd, 1, 0);
+    if (ready < 0) {
+        return false;
+    }
+    if (ready == 0) {
+        return true;
+    }
+    if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        return false;
+    }
+    if (connection.tls) {
+        return connection.tls->drainIdle();
+    }
+
+    char probe;
+    ssize_t peeked = recv(connection.fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+    }
+    return false;
+}
+
+PooledConnection ConnectionPool::acquire(const std::string& host, int port) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+
+    auto it = idle.find(makeKey(host, port));
+    if (it == idle.end()) {
+        return PooledConnection();
+    }
+
+    std::deque<PooledConnection>& connections = it->second;
+    while (!connections.empty()) {
+        // Most recently used first: it is the least likely to have been closed
+        PooledConnection connection = connections.back();
+        connections.pop_back();
+        idleCount--;
+
+        if (isExpired(connection, now, idleTimeout) || !isAlive(connection)) {
+            close(connection.fd);
+            stats.connectionsEvicted++;
+            continue;
+        }
+
+        connection.reused = true;
+        stats.connectionsReused++;
+        if (connections.empty()) {
+            idle.erase(it);
+        }
+        return connection;
+    }
+
+    idle.erase(it);
+    return PooledConnection();
+}
+
+PooledConnection ConnectionPool::registerNew(int fd, const std::string& host, int port) {
+    PooledConnection connection;
+    connection.fd = fd;
+    connection.host = host;
+    connection.port = port;
+    connection.lastUsed = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.connectionsOpened++;
+    return connection;
+}
+
+void ConnectionPool::release(PooledConnection connection, bool reusable) {
+    if (!connection.isValid()) {
+        return;
+    }
+
+    connection.requestsServed++;
+    if (connection.maxRequests > 0 && connection.requestsServed >= connection.maxRequests) {
+        reusable = false;
+    }
+    if (!reusable) {
+        close(connection.fd);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    connection.lastUsed = now;
+    evictStaleLocked(now);
+
+    std::deque<PooledConnection>& connections = idle[makeKey(connection.host, connection.port)];
+    if (connections.size() >= maxIdlePerHost) {
+        close(connections.front().fd);
+        connections.pop_front();
+        idleCount--;
+        stats.connectionsEvicted++;
+    }
+
+    if (idleCount >= maxIdleTotal) {
+        // Drop the globally oldest idle connection to stay under the cap
+        auto oldest = idle.end();
+        for (auto it = idle.begin(); it != idle.end(); ++it) {
+            if (!it->second.empty() &&
+                (oldest == idle.end() || it->second.front().lastUsed < oldest->second.front().lastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest != idle.end()) {
+            close(oldest->second.front().fd);
+            oldest->second.pop_front();
+            idleCount--;
+            stats.connectionsEvicted++;
+        }
+    }
+
+    connections.push_back(connection);
+    idleCount++;
+}
+
+void ConnectionPool::evictStale() {
+    std::lock_guard<std::mutex> lock(mutex);
+    evictStaleLocked(std::chrono::steady_clock::now());
+}
+
+void ConnectionPool::evictStaleLocked(std::chrono::steady_clock::time_point now) {
+    for (auto it = idle.begin(); it != idle.end();) {
+        std::deque<PooledConnection>& connections = it->second;
+        for (auto conn = connections.begin(); conn != connections.end();) {
+            if (isExpired(*conn, now, idleTimeout)) {
+                close(conn->fd);
+                conn = connections.erase(conn);
+                idleCount--;
+                stats.connectionsEvicted++;
+            } else {
+                ++conn;
+            }
+        }
+        it = connections.empty() ? idle.erase(it) : std::next(it);
+    }
+}
+
+void ConnectionPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : idle) {
+        for (const PooledConnection& connection : entry.second) {
+            close(connection.fd);
+        }
+    }
+    if (idleCount > 0) {
+        LOGI("Closed %zu pooled connections", idleCount);
+    }
+    idle.clear();
+    idleCount = 0;
+}
+
+ConnectionPoolStats ConnectionPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ConnectionPoolStats result = stats;
+    result.idleConnections = idleCount;
+    return result;
+}
+
+} // namespace localify
@@ -0,0 +1,189 @@
+#include "dns_resolver.h"
+#include <android/log.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <cstring>
+#include <thread>
+
+#define LOG_TAG "LocalifyDNS"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+std::unique_ptr<DNSResolver> DNSResolver::instance = nullptr;
+
+DNSResolver::DNSResolver()
+    : positiveTTL(std::chrono::seconds(60)), negativeTTL(std::chrono::seconds(10)), lookupFunction(lookup) {
+    LOGI("DNSResolver initialized");
+}
+
+DNSResolver::~DNSResolver() {
+    LOGI("DNSResolver destroyed");
+}
+
+DNSResolver& DNSResolver::getInstance() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        instance = std::unique_ptr<DNSResolver>(new DNSResolver());
+    });
+    return *instance;
+}
+
+DNSResult DNSResolver::lookup(const std::string& host) {
+    DNSResult result;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+
+    struct addrinfo* info = nullptr;
+    int status = getaddrinfo(host.c_str(), nullptr, &hints, &info);
+    if (status != 0) {
+        result.error = "Host not found: " + host + " (" + gai_strerror(status) + ")";
+        LOGE("DNS lookup failed for %s: %s", host.c_str(), gai_strerror(status));
+        return result;
+    }
+
+    for (struct addrinfo* entry = info; entry != nullptr; entry = entry->ai_next) {
+        if (entry->ai_family != AF_INET && entry->ai_family != AF_INET6) {
+            continue;
+        }
+        ResolvedAddress address;
+        memcpy(&address.address, entry->ai_addr, entry->ai_addrlen);
+        address.length = entry->ai_addrlen;
+        address.family = entry->ai_family;
+        result.addresses.push_back(address);
+    }
+    freeaddrinfo(info);
+
+    if (result.addresses.empty()) {
+        result.error = "No usable addresses for host: " + host;
+    }
+    LOGI("Resolved %s to %zu address(es)", host.c_str(), result.addresses.size());
+    return result;
+}
+
+DNSResult DNSResolver::resolve(const std::string& host, int port) {
+    std::shared_future<DNSResult> future;
+    std::promise<DNSResult> promise;
+    LookupFunction ownerLookup;
+    bool owner = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        auto it = cache.find(host);
+
+        if (it != cache.end() && it->second.pending) {
+            stats.coalesced++;
+            future = it->second.result;
+        } else if (it != cache.end() && now < it->second.expiresAt) {
+            if (it->second.result.get().isSuccess()) {
+                stats.cacheHits++;
+            } else {
+                stats.negativeHits++;
+            }
+            future = it->second.result;
+        } else {
+            // Miss or expired: this caller performs the lookup, later callers wait on it
+            stats.misses++;
+            stats.lookups++;
+            owner = true;
+            ownerLookup = lookupFunction;
+            future = promise.get_future().share();
+            cache[host] = CacheEntry{future, now, true};
+        }
+    }
+
+    if (owner) {
+        DNSResult result = ownerLookup(host);
+        bool success = result.isSuccess();
+        promise.set_value(std::move(result));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(host);
+        if (it != cache.end()) {
+            it->second.pending = false;
+            it->second.expiresAt = std::chrono::steady_clock::now() + (success ? positiveTTL : negativeTTL);
+        }
+    }
+
+    // Cached entries hold port-less addresses; stamp the requested port on a copy
+    DNSResult result = future.get();
+    applyPort(result, port);
+    return result;
+}
+
+bool DNSResolver::resolveCached(const std::string& host, int port, DNSResult& result) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(host);
+        if (it == cache.end() || it->second.pending ||
+            std::chrono::steady_clock::now() >= it->second.expiresAt) {
+            return false;
+        }
+        result = it->second.result.get();
+        if (result.isSuccess()) {
+            stats.cacheHits++;
+        } else {
+            stats.negativeHits++;
+        }
+    }
+    applyPort(result, port);
+    return true;
+}
+
+void DNSResolver::applyPort(DNSResult& result, int port) {
+    for (ResolvedAddress& address : result.addresses) {
+        if (address.family == AF_INET) {
+            reinterpret_cast<struct sockaddr_in*>(&address.address)->sin_port = htons(port);
+        } else {
+            reinterpret_cast<struct sockaddr_in6*>(&address.address)->sin6_port = htons(port);
+        }
+    }
+}
+
+void DNSResolver::prefetch(const std::string& host) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(host);
+        if (it != cache.end() &&
+            (it->second.pending || std::chrono::steady_clock::now() < it->second.expiresAt)) {
+            return;
+        }
+    }
+
+    LOGI("Prefetching DNS for %s", host.c_str());
+    std::thread([this, host]() {
+        resolve(host, 0);
+    }).detach();
+}
+
+void DNSResolver::setTTL(std::chrono::seconds positive, std::chrono::seconds negative) {
+    std::lock_guard<std::mutex> lock(mutex);
+    positiveTTL = positive;
+    negativeTTL = negative;
+}
+
+void DNSResolver::setLookupFunction(LookupFunction lookup) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lookupFunction = lookup ? std::move(lookup) : LookupFunction(DNSResolver::lookup);
+}
+
+void DNSResolver::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = cache.begin(); it != cache.end();) {
+        // Keep in-flight lookups so their owners can still publish the result
+        it = it->second.pending ? std::next(it) : cache.erase(it);
+    }
+}
+
+DNSResolverStats DNSResolver::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+} // namespace localify
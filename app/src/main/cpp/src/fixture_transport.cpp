@@ -0,0 +1,428 @@
+#include "fixture_transport.h"
+#include "app_config.h"
+#include <android/log.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <cstdio>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#define LOG_TAG "LocalifyTransport"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+namespace {
+
+// Framing headers describe the original wire format, not the decoded body
+// a fixture stores
+const char* const FRAMING_HEADERS[] = {"Content-Length", "Transfer-Encoding", "Content-Encoding",
+                                       "Connection", "Keep-Alive"};
+
+std::string withoutQuery(const std::string& url) {
+    size_t query = url.find('?');
+    return query == std::string::npos ? url : url.substr(0, query);
+}
+
+// Next line of in without its terminator; false at the end of input
+bool nextLine(std::string_view& in, std::string_view& line) {
+    if (in.empty()) {
+        return false;
+    }
+    size_t newline = in.find('\n');
+    line = in.substr(0, newline);
+    in.remove_prefix(newline == std::string_view::npos ? in.size() : newline + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return true;
+}
+
+} // namespace
+
+std::string HttpFixture::fileName(const std::string& method, const std::string& url) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.http",
+             static_cast<unsigned long long>(HttpParser::fingerprint(method + " " + url)));
+    return name;
+}
+
+bool HttpFixture::load(const std::string& path, HttpFixture& fixture) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string_view in(contents);
+    std::string_view line;
+
+    // "METHOD URL"
+    if (!nextLine(in, line)) {
+        return false;
+    }
+    size_t space = line.find(' ');
+    if (space == std::string_view::npos) {
+        return false;
+    }
+    fixture.method = std::string(line.substr(0, space));
+    fixture.url = std::string(HttpParser::trim(line.substr(space + 1)));
+
+    // Status code
+    if (!nextLine(in, line) ||
+        std::from_chars(line.data(), line.data() + line.size(), fixture.statusCode).ec != std::errc()) {
+        return false;
+    }
+
+    // Headers up to a blank line; the rest is the body, byte for byte
+    fixture.headers.clear();
+    while (nextLine(in, line) && !line.empty()) {
+        size_t colon = line.find(':');
+        if (colon != std::string_view::npos && colon > 0) {
+            fixture.headers.add(HttpParser::trim(line.substr(0, colon)), HttpParser::trim(line.substr(colon + 1)));
+        }
+    }
+    fixture.body.assign(in.data(), in.size());
+    return true;
+}
+
+bool HttpFixture::save(const std::string& directory) const {
+    std::string out;
+    out.reserve(body.size() + url.size() + 256);
+    out.append(method).append(" ").append(url).append("\n");
+    out.append(std::to_string(statusCode)).append("\n");
+    for (HttpHeaders::Field header : headers) {
+        bool framing = false;
+        for (const char* name : FRAMING_HEADERS) {
+            framing = framing || HttpHeaders::equalsIgnoreCase(header.name, name);
+        }
+        if (!framing) {
+            out.append(header.name.data(), header.name.size()).append(": ");
+            out.append(header.value.data(), header.value.size()).append("\n");
+        }
+    }
+    out.append("\n").append(body);
+
+    std::ofstream file(directory + "/" + fileName(method, url), std::ios::binary | std::ios::trunc);
+    return static_cast<bool>(file.write(out.data(), out.size()));
+}
+
+// RecordTransport
+
+RecordTransport::RecordTransport(std::shared_ptr<HttpTransport> inner, const std::string& directory)
+    : inner(std::move(inner)), directory(directory) {
+    mkdir(directory.c_str(), 0700);
+    LOGI("Recording HTTP fixtures to %s", directory.c_str());
+}
+
+void RecordTransport::submit(IOJob job) {
+    auto fixture = std::make_shared<HttpFixture>();
+    fixture->method = job.method;
+    fixture->url = job.url;
+
+    // Streamed bodies never reach the completed response; keep a copy
+    if (job.onBody) {
+        auto onBody = std::move(job.onBody);
+        job.onBody = [fixture, onBody](const char* data, size_t length) {
+            fixture->body.append(data, length);
+            return onBody(data, length);
+        };
+    }
+
+    auto onComplete = std::move(job.onComplete);
+    std::string target = directory;
+    job.onComplete = [fixture, onComplete, target](HttpResponse response) {
+        if (response.error.empty()) {
+            fixture->statusCode = response.statusCode;
+            fixture->headers = response.headers;
+            if (!response.body.empty()) {
+                fixture->body = response.body;
+            }
+            if (!fixture->save(target)) {
+                LOGE("Failed to record fixture for %s %s", fixture->method.c_str(), fixture->url.c_str());
+            }
+        }
+        onComplete(std::move(response));
+    };
+    inner->submit(std::move(job));
+}
+
+// ReplayTransport
+
+ReplayTransport::ReplayTransport(std::chrono::milliseconds latency, size_t bytesPerSecond)
+    : latency(latency), bytesPerSecond(bytesPerSecond), nextDeliveryId(1),
+      relay(std::make_shared<CancelRelay>()), stopping(false) {
+    relay->transport = this;
+    worker = std::thread(&ReplayTransport::run, this);
+}
+
+ReplayTransport::~ReplayTransport() {
+    {
+        std::lock_guard<std::mutex> lock(relay->mutex);
+        relay->transport = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+size_t ReplayTransport::loadDirectory(const std::string& directory) {
+    size_t loaded = 0;
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        LOGE("Cannot open fixture directory %s", directory.c_str());
+        return 0;
+    }
+    while (struct dirent* item = readdir(dir)) {
+        std::string name = item->d_name;
+        if (name.size() < 5 || name.compare(name.size() - 5, 5, ".http") != 0) {
+            continue;
+        }
+        HttpFixture fixture;
+        if (HttpFixture::load(directory + "/" + name, fixture)) {
+            addFixture(fixture);
+            loaded++;
+        } else {
+            LOGE("Skipping malformed fixture %s", name.c_str());
+        }
+    }
+    closedir(dir);
+    LOGI("Loaded %zu HTTP fixtures from %s", loaded, directory.c_str());
+    return loaded;
+}
+
+void ReplayTransport::addFixture(const HttpFixture& fixture) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fixtures[fixture.method + " " + fixture.url] = std::make_shared<const HttpFixture>(fixture);
+}
+
+void ReplayTransport::setDefaultResponse(int statusCode, const std::string& body) {
+    auto fixture = std::make_shared<HttpFixture>();
+    fixture->statusCode = statusCode;
+    fixture->headers.set("Content-Type", "application/json");
+    fixture->body = body;
+    std::lock_guard<std::mutex> lock(mutex);
+    defaultFixture = std::move(fixture);
+}
+
+void ReplayTransport::submit(IOJob job) {
+    std::shared_ptr<const HttpFixture> fixture;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = fixtures.find(job.method + " " + job.url);
+        if (it == fixtures.end()) {
+            it = fixtures.find(job.method + " " + withoutQuery(job.url));
+        }
+        fixture = it != fixtures.end() ? it->second : defaultFixture;
+    }
+    if (!fixture) {
+        HttpResponse response;
+        response.error = "No fixture for " + job.method + " " + job.url;
+        response.errorCode = HttpError::NETWORK;
+        LOGE("%s", response.error.c_str());
+        job.onComplete(std::move(response));
+        return;
+    }
+
+    std::unique_ptr<Delivery> delivery(new Delivery());
+    delivery->cancelSubscription = 0;
+    delivery->submittedAt = Clock::now();
+    delivery->deadline = job.totalTimeout.count() > 0 ? delivery->submittedAt + job.totalTimeout
+                                                      : Clock::time_point::max();
+    delivery->job = std::move(job);
+    delivery->fixture = std::move(fixture);
+    delivery->offset = 0;
+    delivery->headSent = false;
+
+    Clock::time_point due = std::min(delivery->submittedAt + latency, delivery->deadline);
+    std::shared_ptr<CancellationToken> cancellation = delivery->job.cancellation;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        delivery->id = nextDeliveryId++;
+    }
+    if (cancellation) {
+        // Subscribed without the lock held: an already cancelled token runs
+        // the callback right here, and it takes the lock
+        std::weak_ptr<CancelRelay> weakRelay = relay;
+        uint64_t id = delivery->id;
+        delivery->cancelSubscription = cancellation->subscribe([weakRelay, id]() {
+            if (auto target = weakRelay.lock()) {
+                std::lock_guard<std::mutex> lock(target->mutex);
+                if (target->transport) {
+                    target->transport->onCancelled(id);
+                }
+            }
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // A cancel that ran before this point found nothing to bring forward
+        if (cancellation && cancellation->isCancelled()) {
+            due = Clock::now();
+        }
+        schedule.emplace(due, std::move(delivery));
+    }
+    wake.notify_one();
+}
+
+void ReplayTransport::onCancelled(uint64_t id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = schedule.begin(); it != schedule.end(); ++it) {
+            if (it->second->id == id) {
+                std::unique_ptr<Delivery> delivery = std::move(it->second);
+                schedule.erase(it);
+                schedule.emplace(Clock::now(), std::move(delivery));
+                break;
+            }
+        }
+        // Not found: the worker is stepping it and reschedules it for now
+    }
+    wake.notify_one();
+}
+
+void ReplayTransport::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (schedule.empty()) {
+            wake.wait(lock);
+            continue;
+        }
+        auto due = schedule.begin();
+        if (due->first > Clock::now()) {
+            wake.wait_until(lock, due->first);
+            continue;
+        }
+        std::unique_ptr<Delivery> delivery = std::move(due->second);
+        schedule.erase(due);
+
+        lock.unlock();
+        Clock::time_point next;
+        bool pending = step(*delivery, next);
+        lock.lock();
+
+        if (pending) {
+            const std::shared_ptr<CancellationToken>& cancellation = delivery->job.cancellation;
+            if (cancellation && cancellation->isCancelled()) {
+                next = Clock::now();
+            }
+            schedule.emplace(std::min(next, delivery->deadline), std::move(delivery));
+        }
+    }
+
+    std::multimap<Clock::time_point, std::unique_ptr<Delivery>> remaining;
+    remaining.swap(schedule);
+    lock.unlock();
+    for (auto& entry : remaining) {
+        finish(*entry.second, HttpError::SHUTTING_DOWN, "HttpClient is shutting down");
+    }
+}
+
+bool ReplayTransport::step(Delivery& delivery, Clock::time_point& next) {
+    Clock::time_point now = Clock::now();
+    const IOJob& job = delivery.job;
+    const std::string& body = delivery.fixture->body;
+
+    if (job.cancellation && job.cancellation->isCancelled()) {
+        finish(delivery, HttpError::CANCELLED, "Request cancelled");
+        return false;
+    }
+    if (now >= delivery.deadline) {
+        finish(delivery, HttpError::TIMED_OUT, "Request timed out");
+        return false;
+    }
+
+    // Body bytes arrive one chunk at a time, each after its transfer time
+    auto chunkTime = [this](size_t bytes) {
+        return std::chrono::microseconds(bytes * 1000000 / bytesPerSecond);
+    };
+
+    if (!delivery.headSent) {
+        delivery.headSent = true;
+        delivery.firstByteAt = now;
+        delivery.response.statusCode = delivery.fixture->statusCode;
+        delivery.response.headers = delivery.fixture->headers;
+        if (job.onHead && !job.onHead(delivery.response)) {
+            finish(delivery, HttpError::CANCELLED, "Cancelled by response handler");
+            return false;
+        }
+        if (bytesPerSecond > 0 && !body.empty()) {
+            next = now + chunkTime(std::min(CHUNK_SIZE, body.size()));
+            return true;
+        }
+    }
+
+    size_t length = bytesPerSecond > 0 ? std::min(CHUNK_SIZE, body.size() - delivery.offset)
+                                       : body.size() - delivery.offset;
+    if (length > 0) {
+        if (job.onBody) {
+            if (!job.onBody(body.data() + delivery.offset, length)) {
+                finish(delivery, HttpError::CANCELLED, "Cancelled by body handler");
+                return false;
+            }
+        } else {
+            delivery.response.body.append(body, delivery.offset, length);
+        }
+        delivery.offset += length;
+    }
+
+    if (delivery.offset < body.size()) {
+        next = now + chunkTime(std::min(CHUNK_SIZE, body.size() - delivery.offset));
+        return true;
+    }
+    finish(delivery, HttpError::NONE, "");
+    return false;
+}
+
+void ReplayTransport::finish(Delivery& delivery, HttpError error, const std::string& message) {
+    if (delivery.job.cancellation) {
+        delivery.job.cancellation->unsubscribe(delivery.cancelSubscription);
+    }
+    Clock::time_point now = Clock::now();
+    HttpResponse response;
+    if (error == HttpError::NONE) {
+        response = std::move(delivery.response);
+        response.timing.firstByte = std::chrono::duration_cast<std::chrono::microseconds>(
+            delivery.firstByteAt - delivery.submittedAt);
+        response.timing.transfer = std::chrono::duration_cast<std::chrono::microseconds>(now - delivery.firstByteAt);
+        response.timing.bytesReceived = delivery.fixture->body.size();
+    } else {
+        response.error = message;
+        response.errorCode = error;
+    }
+    response.timing.bytesSent = delivery.job.requestData.size();
+    response.timing.total = std::chrono::duration_cast<std::chrono::microseconds>(now - delivery.submittedAt);
+    delivery.job.onComplete(std::move(response));
+}
+
+std::shared_ptr<HttpTransport> createDevelopmentTransport() {
+    auto transport = std::make_shared<ReplayTransport>();
+    std::string base = AppConfig::API_BASE_URL;
+
+    auto add = [&transport](const std::string& method, const std::string& url, const std::string& body) {
+        HttpFixture fixture;
+        fixture.method = method;
+        fixture.url = url;
+        fixture.statusCode = 200;
+        fixture.headers.set("Content-Type", "application/json");
+        fixture.body = body;
+        transport->addFixture(fixture);
+    };
+    add("POST", base + "/v1/auth/guest",
+        R"({"token":"guest_token_123","refreshToken":"refresh_token_456","expiresIn":3600})");
+    add("GET", base + "/v1/@me",
+        R"({"id":"user123","name":"Guest User","anonymousUser":true,"emailConnected":false,"spotifyConnected":false,"appleConnected":false,"emailVerified":false,"emailOptIn":false,"isAdmin":false,"isTeamMember":false,"playlistUseSeedSongs":false,"playlistGeneration":false})");
+    add("GET", base + "/v1/search",
+        R"({"artists":[{"id":"artist1","name":"Arctic Monkeys","popularity":85}],"events":[{"id":"event1","name":"Concert Tonight","venueName":"The Fillmore"}],"venues":[{"id":"venue1","name":"The Fillmore","city":"San Francisco"}],"cities":[{"id":"city1","name":"San Francisco","country":"USA"}]})");
+    transport->setDefaultResponse(200, R"({"message":"API endpoint not implemented in development mode"})");
+    return transport;
+}
+
+} // namespace localify
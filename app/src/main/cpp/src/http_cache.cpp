@@ -0,0 +1,586 @@
+#include "http_cache.h"
+#include <android/log.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#define LOG_TAG "LocalifyCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+namespace {
+
+// Version 1 files held the raw Authorization header and are removed on start
+const char* const FILE_MAGIC = "LOCALIFY-HTTP-CACHE 2";
+
+// Headers a 304 may carry that replace the stored ones (RFC 7234 section 4.3.4)
+const char* const REFRESHED_HEADERS[] = {"Cache-Control", "Expires", "ETag", "Last-Modified", "Date", "Age"};
+
+// Credentials never reach the key or the disk, only a fingerprint of them
+std::string credentialFingerprint(std::string_view value) {
+    char hex[24];
+    snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(HttpParser::fingerprint(value)));
+    return hex;
+}
+
+// What an entry records for a Vary'd request header
+std::string varyValue(std::string_view name, std::string_view value) {
+    if (HttpHeaders::equalsIgnoreCase(name, "Authorization") && !value.empty()) {
+        return credentialFingerprint(value);
+    }
+    return std::string(value);
+}
+
+int64_t nowSeconds() {
+    return static_cast<int64_t>(time(nullptr));
+}
+
+// Value of "name=<digits>" in a Cache-Control header, or -1
+int64_t directiveValue(std::string_view cacheControl, std::string_view name) {
+    size_t pos = 0;
+    while ((pos = cacheControl.find(name, pos)) != std::string_view::npos) {
+        bool startsToken = pos == 0 || cacheControl[pos - 1] == ' ' || cacheControl[pos - 1] == ',';
+        size_t valueStart = pos + name.size();
+        if (startsToken && valueStart < cacheControl.size() && cacheControl[valueStart] == '=') {
+            int64_t value = -1;
+            const char* begin = cacheControl.data() + valueStart + 1;
+            std::from_chars(begin, cacheControl.data() + cacheControl.size(), value);
+            return value;
+        }
+        pos = valueStart;
+    }
+    return -1;
+}
+
+void writeField(std::string& out, std::string_view value) {
+    out.append(std::to_string(value.size())).append("\n");
+    out.append(value.data(), value.size()).append("\n");
+}
+
+bool readField(std::string_view& in, std::string& value) {
+    size_t newline = in.find('\n');
+    if (newline == std::string_view::npos) {
+        return false;
+    }
+    size_t length = 0;
+    auto parsed = std::from_chars(in.data(), in.data() + newline, length);
+    if (parsed.ec != std::errc() || newline + 1 + length + 1 > in.size()) {
+        return false;
+    }
+    value.assign(in.data() + newline + 1, length);
+    in.remove_prefix(newline + 1 + length + 1);
+    return true;
+}
+
+bool readNumber(std::string_view& in, int64_t& value) {
+    std::string text;
+    if (!readField(in, text)) {
+        return false;
+    }
+    return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+}
+
+} // namespace
+
+HttpCache::HttpCache(size_t maxMemoryBytes)
+    : maxMemoryBytes(maxMemoryBytes), maxDiskBytes(0), stopping(false) {}
+
+HttpCache::~HttpCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    writerWake.notify_all();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+}
+
+void HttpCache::setDiskDirectory(const std::string& path, size_t maxBytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        directory = path;
+        maxDiskBytes = maxBytes;
+    }
+    if (path.empty()) {
+        return;
+    }
+    mkdir(path.c_str(), 0700);
+    removeOutdatedFiles(path);
+    trimDisk();
+    if (!writerThread.joinable()) {
+        writerThread = std::thread(&HttpCache::writerLoop, this);
+    }
+    LOGI("HTTP cache directory: %s", path.c_str());
+}
+
+std::string HttpCache::makeKey(const HttpRequest& request) {
+    std::string key;
+    key.reserve(request.method.size() + request.url.size() + 64);
+    key.append(request.method).append(" ").append(request.url);
+    std::string_view authorization = request.headers.get("Authorization");
+    if (!authorization.empty()) {
+        key.append("\nAuthorization: ").append(credentialFingerprint(authorization));
+    }
+    return key;
+}
+
+int64_t HttpCache::freshUntil(const HttpHeaders& headers, int64_t now) {
+    std::string_view cacheControl = headers.get("Cache-Control");
+    if (HttpHeaders::containsToken(cacheControl, "no-cache")) {
+        return now;
+    }
+
+    int64_t lifetime = directiveValue(cacheControl, "max-age");
+    if (lifetime < 0) {
+        std::string_view expires = headers.get("Expires");
+        int64_t expiresAt = expires.empty() ? -1 : HttpParser::parseHttpDate(expires);
+        if (expiresAt >= 0) {
+            std::string_view date = headers.get("Date");
+            int64_t dateValue = date.empty() ? -1 : HttpParser::parseHttpDate(date);
+            lifetime = expiresAt - (dateValue >= 0 ? dateValue : now);
+        } else {
+            lifetime = 0;
+        }
+    }
+
+    int64_t age = 0;
+    std::string_view ageHeader = headers.get("Age");
+    std::from_chars(ageHeader.data(), ageHeader.data() + ageHeader.size(), age);
+    return now + std::max<int64_t>(0, lifetime - age);
+}
+
+bool HttpCache::isCacheable(const HttpRequest& request, const HttpResponse& response) {
+    if (request.method != "GET" || response.statusCode != 200 || !response.error.empty()) {
+        return false;
+    }
+    if (HttpHeaders::containsToken(request.headers.get("Cache-Control"), "no-store")) {
+        return false;
+    }
+    std::string_view cacheControl = response.headers.get("Cache-Control");
+    if (HttpHeaders::containsToken(cacheControl, "no-store") || response.headers.get("Vary") == "*") {
+        return false;
+    }
+    // Worth keeping only if it can be served fresh or revalidated cheaply
+    return directiveValue(cacheControl, "max-age") > 0 || response.headers.has("Expires") ||
+           response.headers.has("ETag") || response.headers.has("Last-Modified");
+}
+
+bool HttpCache::varyMatches(const Entry& entry, const HttpRequest& request) {
+    for (const auto& header : entry.vary) {
+        if (varyValue(header.first, request.headers.get(header.first)) != header.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+HttpCache::EntryPtr HttpCache::find(const std::string& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    return *it->second;
+}
+
+void HttpCache::insert(const EntryPtr& entry, bool persist) {
+    auto it = index.find(entry->key);
+    if (it != index.end()) {
+        stats.memoryBytes -= (*it->second)->footprint();
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    lru.push_front(entry);
+    index[entry->key] = lru.begin();
+    stats.memoryBytes += entry->footprint();
+    evictMemory();
+
+    if (persist && !directory.empty()) {
+        pendingWrites.push_back(entry);
+        writerWake.notify_one();
+    }
+}
+
+void HttpCache::evictMemory() {
+    // Evicted entries stay on disk and are reloaded on demand
+    while (stats.memoryBytes > maxMemoryBytes && lru.size() > 1) {
+        const EntryPtr& victim = lru.back();
+        stats.memoryBytes -= victim->footprint();
+        index.erase(victim->key);
+        lru.pop_back();
+        stats.evictions++;
+    }
+}
+
+HttpCache::Lookup HttpCache::lookup(HttpRequest& request, HttpResponse& cached) {
+    if (request.method != "GET") {
+        return Lookup::MISS;
+    }
+    std::string_view requestCacheControl = request.headers.get("Cache-Control");
+    std::string key = makeKey(request);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (HttpHeaders::containsToken(requestCacheControl, "no-store")) {
+        stats.misses++;
+        return Lookup::MISS;
+    }
+
+    EntryPtr entry = find(key);
+    if (!entry && !directory.empty()) {
+        // Disk reads happen without the lock so the I/O thread never waits on them
+        lock.unlock();
+        entry = readFromDisk(key);
+        lock.lock();
+        if (entry) {
+            stats.diskHits++;
+            insert(entry, false);
+        }
+    }
+    if (!entry || !varyMatches(*entry, request)) {
+        stats.misses++;
+        return Lookup::MISS;
+    }
+
+    cached.statusCode = entry->statusCode;
+    cached.body = entry->body;
+    cached.headers = entry->headers;
+    cached.fromCache = true;
+
+    if (entry->freshUntil > nowSeconds() && !HttpHeaders::containsToken(requestCacheControl, "no-cache")) {
+        stats.hits++;
+        return Lookup::FRESH;
+    }
+
+    std::string_view etag = entry->headers.get("ETag");
+    std::string_view lastModified = entry->headers.get("Last-Modified");
+    if (etag.empty() && lastModified.empty()) {
+        stats.misses++;
+        return Lookup::MISS;
+    }
+    if (!etag.empty() && !request.headers.has("If-None-Match")) {
+        request.headers.set("If-None-Match", etag);
+    }
+    if (!lastModified.empty() && !request.headers.has("If-Modified-Since")) {
+        request.headers.set("If-Modified-Since", lastModified);
+    }
+    stats.revalidations++;
+    return Lookup::STALE;
+}
+
+void HttpCache::store(const HttpRequest& request, const HttpResponse& response) {
+    std::string key = makeKey(request);
+
+    if (!isCacheable(request, response)) {
+        if (request.method == "GET" && response.statusCode == 200) {
+            // The resource stopped being cacheable; drop what we had
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                stats.memoryBytes -= (*it->second)->footprint();
+                lru.erase(it->second);
+                index.erase(it);
+            }
+            if (!directory.empty()) {
+                unlink(pathFor(key).c_str());
+            }
+        }
+        return;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->key = std::move(key);
+    entry->statusCode = response.statusCode;
+    entry->body = response.body;
+    entry->headers = response.headers;
+    entry->storedAt = nowSeconds();
+    entry->freshUntil = freshUntil(response.headers, entry->storedAt);
+
+    // Vary names the request headers the representation depends on
+    std::string_view vary = response.headers.get("Vary");
+    size_t pos = 0;
+    while (pos < vary.size()) {
+        size_t comma = vary.find(',', pos);
+        std::string_view name = HttpParser::trim(vary.substr(pos, comma == std::string_view::npos ? std::string_view::npos : comma - pos));
+        if (!name.empty()) {
+            entry->vary.emplace_back(std::string(name), varyValue(name, request.headers.get(name)));
+        }
+        pos = comma == std::string_view::npos ? vary.size() : comma + 1;
+    }
+
+    if (entry->footprint() > maxMemoryBytes / 2) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    insert(entry, true);
+    stats.stores++;
+}
+
+bool HttpCache::revalidated(const HttpRequest& request, const HttpResponse& notModified, HttpResponse& response) {
+    std::string key = makeKey(request);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    EntryPtr entry = find(key);
+    if (!entry) {
+        return false;
+    }
+
+    // Entries are shared with the disk writer, so refresh a copy
+    auto refreshed = std::make_shared<Entry>(*entry);
+    for (const char* name : REFRESHED_HEADERS) {
+        std::string_view value = notModified.headers.get(name);
+        if (!value.empty()) {
+            refreshed->headers.set(name, value);
+        }
+    }
+    refreshed->storedAt = nowSeconds();
+    refreshed->freshUntil = freshUntil(refreshed->headers, refreshed->storedAt);
+    insert(refreshed, true);
+    stats.notModified++;
+
+    response.statusCode = refreshed->statusCode;
+    response.body = refreshed->body;
+    response.headers = refreshed->headers;
+    response.fromCache = true;
+    return true;
+}
+
+void HttpCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    index.clear();
+    pendingWrites.clear();
+    stats.memoryBytes = 0;
+
+    if (!directory.empty()) {
+        if (DIR* dir = opendir(directory.c_str())) {
+            while (struct dirent* item = readdir(dir)) {
+                if (item->d_name[0] != '.') {
+                    unlink((directory + "/" + item->d_name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        stats.diskBytes = 0;
+    }
+}
+
+HttpCacheStats HttpCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::string HttpCache::pathFor(const std::string& key) const {
+    char name[24];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(HttpParser::fingerprint(key)));
+    return directory + "/" + name;
+}
+
+HttpCache::EntryPtr HttpCache::readFromDisk(const std::string& key) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = pathFor(key);
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string_view in(contents);
+
+    auto entry = std::make_shared<Entry>();
+    std::string magic;
+    int64_t statusCode = 0;
+    int64_t count = 0;
+    if (!readField(in, magic) || magic != FILE_MAGIC || !readField(in, entry->key) || entry->key != key ||
+        !readNumber(in, statusCode) || !readNumber(in, entry->storedAt) || !readNumber(in, entry->freshUntil)) {
+        return nullptr;
+    }
+    entry->statusCode = static_cast<int>(statusCode);
+
+    if (!readNumber(in, count)) {
+        return nullptr;
+    }
+    for (int64_t i = 0; i < count; ++i) {
+        std::string name, value;
+        if (!readField(in, name) || !readField(in, value)) {
+            return nullptr;
+        }
+        entry->vary.emplace_back(std::move(name), std::move(value));
+    }
+    if (!readNumber(in, count)) {
+        return nullptr;
+    }
+    for (int64_t i = 0; i < count; ++i) {
+        std::string name, value;
+        if (!readField(in, name) || !readField(in, value)) {
+            return nullptr;
+        }
+        entry->headers.add(name, value);
+    }
+    if (!readField(in, entry->body)) {
+        return nullptr;
+    }
+    return entry;
+}
+
+void HttpCache::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        writerWake.wait(lock, [this]() { return stopping || !pendingWrites.empty(); });
+        if (stopping) {
+            break;
+        }
+        EntryPtr entry = std::move(pendingWrites.front());
+        pendingWrites.pop_front();
+        bool overBudget = stats.diskBytes > maxDiskBytes;
+
+        lock.unlock();
+        writeToDisk(*entry);
+        if (overBudget) {
+            trimDisk();
+        }
+        lock.lock();
+    }
+}
+
+void HttpCache::writeToDisk(const Entry& entry) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (directory.empty()) {
+            return;
+        }
+        path = pathFor(entry.key);
+    }
+
+    std::string out;
+    out.reserve(entry.body.size() + entry.key.size() + 512);
+    writeField(out, FILE_MAGIC);
+    writeField(out, entry.key);
+    writeField(out, std::to_string(entry.statusCode));
+    writeField(out, std::to_string(entry.storedAt));
+    writeField(out, std::to_string(entry.freshUntil));
+    writeField(out, std::to_string(entry.vary.size()));
+    for (const auto& header : entry.vary) {
+        writeField(out, header.first);
+        writeField(out, header.second);
+    }
+    writeField(out, std::to_string(entry.headers.size()));
+    for (HttpHeaders::Field header : entry.headers) {
+        writeField(out, header.name);
+        writeField(out, header.value);
+    }
+    writeField(out, entry.body);
+
+    // Write then rename so a crash never leaves a torn entry behind
+    struct stat previous;
+    size_t replaced = stat(path.c_str(), &previous) == 0 ? static_cast<size_t>(previous.st_size) : 0;
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.data(), out.size())) {
+            LOGE("Failed to write cache entry %s", temporary.c_str());
+            unlink(temporary.c_str());
+            return;
+        }
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.diskBytes -= std::min(stats.diskBytes, replaced);
+    stats.diskBytes += out.size();
+}
+
+void HttpCache::removeOutdatedFiles(const std::string& path) {
+    std::string expected;
+    writeField(expected, FILE_MAGIC);
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    size_t removed = 0;
+    while (struct dirent* item = readdir(dir)) {
+        if (item->d_name[0] == '.') {
+            continue;
+        }
+        std::string file = path + "/" + item->d_name;
+        std::string header(expected.size(), '\0');
+        std::ifstream in(file, std::ios::binary);
+        if (!in.read(&header[0], header.size()) || header != expected) {
+            in.close();
+            removed += unlink(file.c_str()) == 0 ? 1 : 0;
+        }
+    }
+    closedir(dir);
+    if (removed > 0) {
+        LOGI("Removed %zu outdated HTTP cache files", removed);
+    }
+}
+
+void HttpCache::trimDisk() {
+    std::string path;
+    size_t budget;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = directory;
+        budget = maxDiskBytes;
+    }
+    if (path.empty()) {
+        return;
+    }
+
+    struct FileInfo {
+        std::string name;
+        time_t modified;
+        size_t size;
+    };
+    std::vector<FileInfo> files;
+    size_t total = 0;
+    if (DIR* dir = opendir(path.c_str())) {
+        while (struct dirent* item = readdir(dir)) {
+            if (item->d_name[0] == '.') {
+                continue;
+            }
+            std::string file = path + "/" + item->d_name;
+            struct stat info;
+            if (stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+                files.push_back(FileInfo{file, info.st_mtime, static_cast<size_t>(info.st_size)});
+                total += info.st_size;
+            }
+        }
+        closedir(dir);
+    }
+
+    // Oldest first, down to three quarters of the budget to avoid trimming on every write
+    if (total > budget) {
+        std::sort(files.begin(), files.end(),
+                  [](const FileInfo& a, const FileInfo& b) { return a.modified < b.modified; });
+        for (const FileInfo& file : files) {
+            if (total <= budget / 4 * 3) {
+                break;
+            }
+            if (unlink(file.name.c_str()) == 0) {
+                total -= file.size;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.diskBytes = total;
+}
+
+} // namespace localify
@@ -1,13 +1,11 @@
 #include "http_client.h"
 #include "app_config.h"
+#include "dns_resolver.h"
+#include "http_cache.h"
+#include "io_engine.h"
+#include "tls_context.h"
 #include <android/log.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <netdb.h>
-#include <unistd.h>
 #include <sstream>
-#include <thread>
-#include <regex>
 #include <iomanip>
 
 #define LOG_TAG "LocalifyHTTP"
@@ -18,11 +16,18 @@ namespace localify {
 
 std::unique_ptr<HttpClient> HttpClient::instance = nullptr;
 
-HttpClient::HttpClient() : userAgent("Localify-Android-CPP/1.0"), defaultTimeoutSeconds(30) {
+HttpClient::HttpClient()
+    : userAgent("Localify-Android-CPP/1.0"), defaultTimeoutSeconds(30), connectTimeoutSeconds(10),
+      firstByteTimeoutSeconds(0), cache(new HttpCache()), cacheEnabled(true) {
+    socketTransport = std::make_shared<IOEngine>(connectionPool);
+    transport = socketTransport;
     LOGI("HttpClient initialized");
 }
 
 HttpClient::~HttpClient() {
+    // Stop the event loop before the pool it returns connections to goes away
+    transport.reset();
+    socketTransport.reset();
     LOGI("HttpClient destroyed");
 }
 
@@ -33,55 +38,45 @@ HttpClient& HttpClient::getInstance() {
     return *instance;
 }
 
-HttpResponse HttpClient::get(const std::string& url, const std::map<std::string, std::string>& headers) {
+HttpResponse HttpClient::get(const std::string& url, const HttpHeaders& headers) {
     HttpRequest request(url, "GET");
-    for (const auto& header : headers) {
-        request.setHeader(header.first, header.second);
-    }
+    request.headers = headers;
     return performRequest(request);
 }
 
-HttpResponse HttpClient::post(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse HttpClient::post(const std::string& url, const std::string& body, const HttpHeaders& headers) {
     HttpRequest request(url, "POST");
     request.body = body;
-    for (const auto& header : headers) {
-        request.setHeader(header.first, header.second);
-    }
-    if (!body.empty() && headers.find("Content-Type") == headers.end()) {
+    request.headers = headers;
+    if (!body.empty() && !headers.has("Content-Type")) {
         request.setContentType("application/json");
     }
     return performRequest(request);
 }
 
-HttpResponse HttpClient::put(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse HttpClient::put(const std::string& url, const std::string& body, const HttpHeaders& headers) {
     HttpRequest request(url, "PUT");
     request.body = body;
-    for (const auto& header : headers) {
-        request.setHeader(header.first, header.second);
-    }
-    if (!body.empty() && headers.find("Content-Type") == headers.end()) {
+    request.headers = headers;
+    if (!body.empty() && !headers.has("Content-Type")) {
         request.setContentType("application/json");
     }
     return performRequest(request);
 }
 
-HttpResponse HttpClient::patch(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers) {
+HttpResponse HttpClient::patch(const std::string& url, const std::string& body, const HttpHeaders& headers) {
     HttpRequest request(url, "PATCH");
     request.body = body;
-    for (const auto& header : headers) {
-        request.setHeader(header.first, header.second);
-    }
-    if (!body.empty() && headers.find("Content-Type") == headers.end()) {
+    request.headers = headers;
+    if (!body.empty() && !headers.has("Content-Type")) {
         request.setContentType("application/json");
     }
     return performRequest(request);
 }
 
-HttpResponse HttpClient::delete_(const std::string& url, const std::map<std::string, std::string>& headers) {
+HttpResponse HttpClient::delete_(const std::string& url, const HttpHeaders& headers) {
     HttpRequest request(url, "DELETE");
-    for (const auto& header : headers) {
-        request.setHeader(header.first, header.second);
-    }
+    request.headers = headers;
     return performRequest(request);
 }
 
@@ -89,22 +84,24 @@ HttpResponse HttpClient::request(const HttpRequest& request) {
     return performRequest(request);
 }
 
-std::future<HttpResponse> HttpClient::getAsync(const std::string& url, const std::map<std::string, std::string>& headers) {
-    return std::async(std::launch::async, [this, url, headers]() {
-        return get(url, headers);
-    });
+std::future<HttpResponse> HttpClient::getAsync(const std::string& url, const HttpHeaders& headers) {
+    HttpRequest request(url, "GET");
+    request.headers = headers;
+    return dispatch(request);
 }
 
-std::future<HttpResponse> HttpClient::postAsync(const std::string& url, const std::string& body, const std::map<std::string, std::string>& headers) {
-    return std::async(std::launch::async, [this, url, body, headers]() {
-        return post(url, body, headers);
-    });
+std::future<HttpResponse> HttpClient::postAsync(const std::string& url, const std::string& body, const HttpHeaders& headers) {
+    HttpRequest request(url, "POST");
+    request.body = body;
+    request.headers = headers;
+    if (!body.empty() && !headers.has("Content-Type")) {
+        request.setContentType("application/json");
+    }
+    return dispatch(request);
 }
 
 std::future<HttpResponse> HttpClient::requestAsync(const HttpRequest& request) {
-    return std::async(std::launch::async, [this, request]() {
-        return performRequest(request);
-    });
+    return dispatch(request);
 }
 
 void HttpClient::setUserAgent(const std::string& userAgent) {
@@ -115,156 +112,291 @@ void HttpClient::setDefaultTimeout(int seconds) {
     defaultTimeoutSeconds = seconds;
 }
 
+void HttpClient::setConnectTimeout(int seconds) {
+    connectTimeoutSeconds = seconds;
+}
+
+void HttpClient::setFirstByteTimeout(int seconds) {
+    firstByteTimeoutSeconds = seconds;
+}
+
+ConnectionPoolStats HttpClient::getConnectionPoolStats() const {
+    return connectionPool.getStats();
+}
+
+void HttpClient::closeIdleConnections() {
+    connectionPool.clear();
+}
+
+TlsStats HttpClient::getTlsStats() const {
+    return TlsContext::getInstance().getStats();
+}
+
+void HttpClient::setTransport(std::shared_ptr<HttpTransport> transport) {
+    std::lock_guard<std::mutex> lock(transportMutex);
+    this->transport = transport ? std::move(transport) : socketTransport;
+}
+
+std::shared_ptr<HttpTransport> HttpClient::getTransport() const {
+    std::lock_guard<std::mutex> lock(transportMutex);
+    return transport;
+}
+
+void HttpClient::setCacheEnabled(bool enabled) {
+    cacheEnabled = enabled;
+}
+
+void HttpClient::setCacheDirectory(const std::string& directory) {
+    cache->setDiskDirectory(directory);
+}
+
+HttpCacheStats HttpClient::getCacheStats() const {
+    return cache->getStats();
+}
+
+void HttpClient::clearCache() {
+    cache->clear();
+}
+
+void HttpClient::setHostConcurrency(size_t maxPerHost, size_t maxBackgroundPerHost) {
+    scheduler.setLimits(maxPerHost, maxBackgroundPerHost);
+}
+
+RequestSchedulerStats HttpClient::getSchedulerStats() const {
+    return scheduler.getStats();
+}
+
+void HttpClient::prefetchDNS(const std::string& url) {
+    ParsedUrl parsed;
+    if (HttpParser::parseUrl(url, parsed)) {
+        DNSResolver::getInstance().prefetch(std::string(parsed.host));
+    }
+}
+
 HttpResponse HttpClient::performRequest(const HttpRequest& request) {
-    HttpResponse response;
-    
+    return dispatch(request).get();
+}
+
+bool HttpClient::prepareJob(const HttpRequest& request, IOJob& job, HttpResponse& response) {
     LOGI("Performing %s request to: %s", request.method.c_str(), request.url.c_str());
     
-    // Parse URL to extract host, port, and path
-    std::regex urlRegex(R"(^https?://([^:/]+)(?::(\d+))?(/.*)?$)");
-    std::smatch matches;
+    if (request.cancellation && request.cancellation->isCancelled()) {
+        response.error = "Request cancelled";
+        response.errorCode = HttpError::CANCELLED;
+        return false;
+    }
     
-    if (!std::regex_match(request.url, matches, urlRegex)) {
+    // Parse URL to extract host, port, and path
+    ParsedUrl parsed;
+    if (!HttpParser::parseUrl(request.url, parsed)) {
         response.error = "Invalid URL format";
+        response.errorCode = HttpError::INVALID_URL;
         LOGE("Invalid URL: %s", request.url.c_str());
-        return response;
+        return false;
     }
     
-    std::string host = matches[1].str();
-    int port = matches[2].matched ? std::stoi(matches[2].str()) : (request.url.find("https://") == 0 ? 443 : 80);
-    std::string path = matches[3].matched ? matches[3].str() : "/";
-    bool isHttps = request.url.find("https://") == 0;
-    
-    LOGI("Connecting to %s:%d%s (HTTPS: %s)", host.c_str(), port, path.c_str(), isHttps ? "yes" : "no");
-    
-    // For HTTPS, we'd need to implement SSL/TLS support
-    // For now, we'll simulate the response for development
-    if (isHttps) {
-        // Simulate API responses for development
-        response.statusCode = 200;
-        
-        if (request.url.find("/v1/auth/guest") != std::string::npos) {
-            response.body = R"({"token":"guest_token_123","refreshToken":"refresh_token_456","expiresIn":3600})";
-        } else if (request.url.find("/v1/@me") != std::string::npos) {
-            response.body = R"({"id":"user123","name":"Guest User","anonymousUser":true,"emailConnected":false,"spotifyConnected":false,"appleConnected":false,"emailVerified":false,"emailOptIn":false,"isAdmin":false,"isTeamMember":false,"playlistUseSeedSongs":false,"playlistGeneration":false})";
-        } else if (request.url.find("/v1/search") != std::string::npos) {
-            response.body = R"({"artists":[{"id":"artist1","name":"Arctic Monkeys","popularity":85}],"events":[{"id":"event1","name":"Concert Tonight","venueName":"The Fillmore"}],"venues":[{"id":"venue1","name":"The Fillmore","city":"San Francisco"}],"cities":[{"id":"city1","name":"San Francisco","country":"USA"}]})";
-        } else {
-            response.body = R"({"message":"API endpoint not implemented in development mode"})";
-        }
-        
-        LOGI("Simulated HTTPS response (development mode)");
-        return response;
+    std::string host(parsed.host);
+    int port = parsed.port;
+    bool isHttps = parsed.isHttps;
+    
+    LOGI("Connecting to %s:%d%.*s (HTTPS: %s)", host.c_str(), port,
+         static_cast<int>(parsed.path.size()), parsed.path.data(), isHttps ? "yes" : "no");
+    
+    // Build HTTP request into a single pre-sized buffer
+    std::string requestData;
+    requestData.reserve(256 + request.url.size() + request.body.size());
+    requestData.append(request.method).append(" ");
+    requestData.append(parsed.path.data(), parsed.path.size());
+    requestData.append(parsed.query.data(), parsed.query.size());
+    requestData.append(" HTTP/1.1\r\n");
+    requestData.append("Host: ");
+    if (host.find(':') != std::string::npos) {
+        requestData.append("[").append(host).append("]");
+    } else {
+        requestData.append(host);
     }
-    
-    // For HTTP (development/testing), implement basic socket connection
-    struct hostent* server = gethostbyname(host.c_str());
-    if (!server) {
-        response.error = "Host not found: " + host;
-        LOGE("Host not found: %s", host.c_str());
-        return response;
+    if (port != (isHttps ? 443 : 80)) {
+        requestData.append(":").append(std::to_string(port));
     }
+    requestData.append("\r\n");
+    requestData.append("User-Agent: ").append(userAgent).append("\r\n");
+    requestData.append("Connection: keep-alive\r\n");
     
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        response.error = "Failed to create socket";
-        LOGE("Failed to create socket");
-        return response;
+    // Bodies are decoded transparently by the response parser
+    if (!request.headers.has("Accept-Encoding")) {
+        requestData.append("Accept-Encoding: gzip, deflate\r\n");
     }
     
-    struct sockaddr_in serverAddr;
-    memset(&serverAddr, 0, sizeof(serverAddr));
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_port = htons(port);
-    memcpy(&serverAddr.sin_addr.s_addr, server->h_addr, server->h_length);
-    
-    if (connect(sockfd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-        response.error = "Failed to connect to server";
-        LOGE("Failed to connect to %s:%d", host.c_str(), port);
-        close(sockfd);
-        return response;
-    }
-    
-    // Build HTTP request
-    std::ostringstream requestStream;
-    requestStream << request.method << " " << path << " HTTP/1.1\r\n";
-    requestStream << "Host: " << host << "\r\n";
-    requestStream << "User-Agent: " << userAgent << "\r\n";
-    requestStream << "Connection: close\r\n";
-    
     // Add custom headers
-    for (const auto& header : request.headers) {
-        requestStream << header.first << ": " << header.second << "\r\n";
-    }
+    appendHeaders(requestData, request.headers);
     
     // Add content length if body exists
     if (!request.body.empty()) {
-        requestStream << "Content-Length: " << request.body.length() << "\r\n";
+        requestData.append("Content-Length: ").append(std::to_string(request.body.length())).append("\r\n");
     }
     
-    requestStream << "\r\n";
+    requestData.append("\r\n");
     
     // Add body if exists
-    if (!request.body.empty()) {
-        requestStream << request.body;
+    requestData.append(request.body);
+    
+    job.url = request.url;
+    job.host = host;
+    job.port = port;
+    job.secure = isHttps;
+    job.method = request.method;
+    job.requestData = std::move(requestData);
+    
+    // Request values win over client defaults; a phase never outlives the total
+    int total = request.timeoutSeconds > 0 ? request.timeoutSeconds : defaultTimeoutSeconds;
+    int connect = request.connectTimeoutSeconds > 0 ? request.connectTimeoutSeconds : connectTimeoutSeconds;
+    int firstByte = request.firstByteTimeoutSeconds > 0 ? request.firstByteTimeoutSeconds : firstByteTimeoutSeconds;
+    job.totalTimeout = std::chrono::seconds(total);
+    job.connectTimeout = std::chrono::seconds(connect > 0 && connect < total ? connect : total);
+    job.firstByteTimeout = std::chrono::seconds(firstByte > 0 && firstByte < total ? firstByte : total);
+    job.cancellation = request.cancellation;
+    return true;
+}
+
+std::future<HttpResponse> HttpClient::dispatch(const HttpRequest& original) {
+    auto promise = std::make_shared<std::promise<HttpResponse>>();
+    std::future<HttpResponse> future = promise->get_future();
+    
+    // A fresh cache hit never touches the network; a stale one goes out as a
+    // conditional request
+    bool cacheable = cacheEnabled && original.method == "GET";
+    HttpRequest conditional;
+    HttpCache::Lookup lookup = HttpCache::Lookup::MISS;
+    if (cacheable) {
+        HttpResponse cached;
+        conditional = original;
+        lookup = cache->lookup(conditional, cached);
+        if (lookup == HttpCache::Lookup::FRESH) {
+            LOGI("HTTP response from cache: %d (%zu bytes)", cached.statusCode, cached.body.length());
+            promise->set_value(std::move(cached));
+            return future;
+        }
     }
     
-    std::string requestStr = requestStream.str();
-    LOGI("Sending HTTP request (%zu bytes)", requestStr.length());
-    
-    // Send request
-    if (send(sockfd, requestStr.c_str(), requestStr.length(), 0) < 0) {
-        response.error = "Failed to send request";
-        LOGE("Failed to send request");
-        close(sockfd);
-        return response;
+    IOJob job;
+    HttpResponse immediate;
+    if (!prepareJob(cacheable ? conditional : original, job, immediate)) {
+        promise->set_value(std::move(immediate));
+        return future;
     }
     
-    // Read response
-    std::string responseStr;
-    char buffer[4096];
-    ssize_t bytesRead;
-    
-    while ((bytesRead = recv(sockfd, buffer, sizeof(buffer) - 1, 0)) > 0) {
-        buffer[bytesRead] = '\0';
-        responseStr += buffer;
+    // Kept for resending should the 304 arrive after the entry was evicted
+    std::shared_ptr<HttpRequest> unconditional;
+    if (lookup == HttpCache::Lookup::STALE) {
+        unconditional = std::make_shared<HttpRequest>(original);
     }
     
-    close(sockfd);
-    
-    if (responseStr.empty()) {
-        response.error = "Empty response from server";
-        LOGE("Empty response from server");
-        return response;
-    }
+    // Hand the exchange to the event loop; no thread is parked on this request
+    job.onComplete = [this, promise, conditional, unconditional, lookup, cacheable](HttpResponse result) {
+        if (lookup == HttpCache::Lookup::STALE && result.error.empty() && result.statusCode == 304) {
+            HttpResponse full;
+            if (!cache->revalidated(conditional, result, full)) {
+                LOGI("HTTP cache entry evicted during revalidation, resending %s", unconditional->url.c_str());
+                resend(*unconditional, promise);
+                return;
+            }
+            full.timing = result.timing;
+            result = std::move(full);
+            LOGI("HTTP response revalidated: %d (%zu bytes)", result.statusCode, result.body.length());
+        } else if (result.error.empty()) {
+            LOGI("HTTP response received: %d (%zu bytes, %zu copied, %lld ms)", result.statusCode,
+                 result.body.length(), result.bytesCopied,
+                 static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(result.timing.total).count()));
+            if (cacheable) {
+                cache->store(conditional, result);
+            }
+        }
+        promise->set_value(std::move(result));
+    };
+    submitScheduled(std::move(job), original.priority);
     
-    // Parse HTTP response
-    size_t headerEnd = responseStr.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
-        response.error = "Invalid HTTP response format";
-        LOGE("Invalid HTTP response format");
-        return response;
+    return future;
+}
+
+void HttpClient::resend(const HttpRequest& request, std::shared_ptr<std::promise<HttpResponse>> promise) {
+    IOJob job;
+    HttpResponse immediate;
+    if (!prepareJob(request, job, immediate)) {
+        promise->set_value(std::move(immediate));
+        return;
     }
-    
-    std::string headerSection = responseStr.substr(0, headerEnd);
-    response.body = responseStr.substr(headerEnd + 4);
-    
-    // Parse status line
-    size_t firstLine = headerSection.find("\r\n");
-    std::string statusLine = headerSection.substr(0, firstLine);
-    
-    std::regex statusRegex(R"(HTTP/\d\.\d (\d+) .*)");
-    std::smatch statusMatches;
-    if (std::regex_match(statusLine, statusMatches, statusRegex)) {
-        response.statusCode = std::stoi(statusMatches[1].str());
+    // Bypasses lookup, which could find the entry on disk and go stale again
+    job.onComplete = [this, promise, request](HttpResponse result) {
+        if (result.error.empty()) {
+            cache->store(request, result);
+        }
+        promise->set_value(std::move(result));
+    };
+    submitScheduled(std::move(job), request.priority);
+}
+
+void HttpClient::stream(const HttpRequest& request, HeadersCallback onHeaders,
+                        ChunkCallback onChunk, CompleteCallback onComplete) {
+    IOJob job;
+    HttpResponse immediate;
+    if (!prepareJob(request, job, immediate)) {
+        // Replay an immediate response through the same callbacks
+        bool accepted = immediate.error.empty() && (!onHeaders || onHeaders(immediate));
+        if (accepted && onChunk && !immediate.body.empty()) {
+            onChunk(immediate.body.data(), immediate.body.size());
+        }
+        immediate.body.clear();
+        if (onComplete) {
+            onComplete(immediate);
+        }
+        return;
     }
     
-    // Parse headers
-    response.headers = parseHeaders(headerSection);
-    
-    LOGI("HTTP response received: %d (%zu bytes)", response.statusCode, response.body.length());
-    
-    return response;
+    job.onHead = std::move(onHeaders);
+    job.onBody = onChunk ? std::move(onChunk) : ChunkCallback([](const char*, size_t) { return true; });
+    job.onComplete = [onComplete](HttpResponse result) {
+        if (result.error.empty()) {
+            LOGI("HTTP response streamed: %d", result.statusCode);
+        }
+        if (onComplete) {
+            onComplete(result);
+        }
+    };
+    submitScheduled(std::move(job), request.priority);
+}
+
+void HttpClient::submitScheduled(IOJob job, std::shared_ptr<PriorityToken> priority) {
+    std::string host = job.host + ":" + std::to_string(job.port);
+    std::shared_ptr<CancellationToken> cancellation = job.cancellation;
+    auto queued = std::make_shared<IOJob>(std::move(job));
+    
+    scheduler.submit(host, std::move(priority), std::move(cancellation),
+        [this, queued](uint64_t ticket) {
+            // The slot is given back before the caller sees the response, so
+            // the next request in line is already on its way
+            IOJob job = std::move(*queued);
+            auto onComplete = std::move(job.onComplete);
+            job.onComplete = [this, ticket, onComplete](HttpResponse response) {
+                scheduler.finished(ticket);
+                onComplete(std::move(response));
+            };
+            std::shared_ptr<HttpTransport> target = getTransport();
+            if (!target) {
+                // Started by a slot freed while the client shuts down
+                HttpResponse response;
+                response.error = "HttpClient is shutting down";
+                response.errorCode = HttpError::SHUTTING_DOWN;
+                job.onComplete(std::move(response));
+                return;
+            }
+            target->submit(std::move(job));
+        },
+        [queued]() {
+            HttpResponse response;
+            response.error = "Request cancelled";
+            response.errorCode = HttpError::CANCELLED;
+            queued->onComplete(std::move(response));
+        });
 }
 
 std::string HttpClient::urlEncode(const std::string& value) {
@@ -301,39 +433,11 @@ std::string HttpClient::urlDecode(const std::string& value) {
     return decoded;
 }
 
-std::map<std::string, std::string> HttpClient::parseHeaders(const std::string& headerString) {
-    std::map<std::string, std::string> headers;
-    std::istringstream stream(headerString);
-    std::string line;
-    
-    // Skip status line
-    std::getline(stream, line);
-    
-    while (std::getline(stream, line) && !line.empty() && line != "\r") {
-        size_t colonPos = line.find(':');
-        if (colonPos != std::string::npos) {
-            std::string key = line.substr(0, colonPos);
-            std::string value = line.substr(colonPos + 1);
-            
-            // Trim whitespace
-            key.erase(0, key.find_first_not_of(" \t\r\n"));
-            key.erase(key.find_last_not_of(" \t\r\n") + 1);
-            value.erase(0, value.find_first_not_of(" \t\r\n"));
-            value.erase(value.find_last_not_of(" \t\r\n") + 1);
-            
-            headers[key] = value;
-        }
-    }
-    
-    return headers;
-}
-
-std::string HttpClient::buildHeaderString(const std::map<std::string, std::string>& headers) {
-    std::ostringstream stream;
-    for (const auto& header : headers) {
-        stream << header.first << ": " << header.second << "\r\n";
+void HttpClient::appendHeaders(std::string& out, const HttpHeaders& headers) {
+    for (HttpHeaders::Field header : headers) {
+        out.append(header.name.data(), header.name.size()).append(": ");
+        out.append(header.value.data(), header.value.size()).append("\r\n");
     }
-    return stream.str();
 }
 
 } // namespace localify
@@ -0,0 +1,182 @@
+#include "http_decoder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace localify {
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+const size_t MIN_INFLATE_WINDOW = 16384;
+
+} // namespace
+
+ChunkedDecoder::ChunkedDecoder() : state(State::SIZE), remaining(0), sizeDigits(0) {}
+
+ChunkedDecoder::Result ChunkedDecoder::decode(const char* data, size_t length, size_t& consumed,
+                                              const Sink& sink) {
+    size_t i = 0;
+    while (i < length) {
+        char c = data[i];
+        switch (state) {
+            case State::SIZE: {
+                int value = hexValue(c);
+                if (value >= 0) {
+                    // More than 15 hex digits would overflow size_t on 64-bit targets
+                    if (++sizeDigits > 15) return Result::ERROR;
+                    remaining = remaining * 16 + value;
+                } else if (sizeDigits > 0 && (c == ';' || c == ' ' || c == '\t')) {
+                    state = State::EXTENSION;
+                } else if (sizeDigits > 0 && c == '\r') {
+                    state = State::SIZE_LF;
+                } else {
+                    return Result::ERROR;
+                }
+                ++i;
+                break;
+            }
+            case State::EXTENSION:
+                if (c == '\r') state = State::SIZE_LF;
+                ++i;
+                break;
+            case State::SIZE_LF:
+                if (c != '\n') return Result::ERROR;
+                state = remaining == 0 ? State::TRAILER_START : State::DATA;
+                ++i;
+                break;
+            case State::DATA: {
+                size_t count = std::min(remaining, length - i);
+                if (!sink(data + i, count)) return Result::ERROR;
+                remaining -= count;
+                i += count;
+                if (remaining == 0) state = State::DATA_CR;
+                break;
+            }
+            case State::DATA_CR:
+                if (c != '\r') return Result::ERROR;
+                state = State::DATA_LF;
+                ++i;
+                break;
+            case State::DATA_LF:
+                if (c != '\n') return Result::ERROR;
+                state = State::SIZE;
+                sizeDigits = 0;
+                ++i;
+                break;
+            case State::TRAILER_START:
+                state = c == '\r' ? State::FINAL_LF : State::TRAILER;
+                ++i;
+                break;
+            case State::TRAILER:
+                if (c == '\r') state = State::TRAILER_LF;
+                ++i;
+                break;
+            case State::TRAILER_LF:
+                if (c != '\n') return Result::ERROR;
+                state = State::TRAILER_START;
+                ++i;
+                break;
+            case State::FINAL_LF:
+                if (c != '\n') return Result::ERROR;
+                state = State::DONE;
+                ++i;
+                consumed = i;
+                return Result::DONE;
+            case State::DONE:
+                consumed = i;
+                return Result::DONE;
+        }
+    }
+    consumed = i;
+    return state == State::DONE ? Result::DONE : Result::NEED_MORE;
+}
+
+InflateDecoder::InflateDecoder(Format format, size_t maxOutput)
+    : format(format), maxOutput(maxOutput), initialized(false), finished(false) {
+    memset(&stream, 0, sizeof(stream));
+}
+
+InflateDecoder::~InflateDecoder() {
+    if (initialized) {
+        inflateEnd(&stream);
+    }
+}
+
+bool InflateDecoder::initialize(const char* data, size_t length) {
+    int windowBits = 15 + 16;   // gzip wrapper
+    if (format == Format::DEFLATE) {
+        // "deflate" should be zlib-wrapped, but some servers send a raw stream
+        bool zlibHeader = length >= 2 &&
+            (static_cast<unsigned char>(data[0]) & 0x0F) == 8 &&
+            ((static_cast<unsigned char>(data[0]) << 8) | static_cast<unsigned char>(data[1])) % 31 == 0;
+        windowBits = zlibHeader ? 15 : -15;
+    }
+    if (inflateInit2(&stream, windowBits) != Z_OK) {
+        error = "Failed to initialize decompressor";
+        return false;
+    }
+    initialized = true;
+    return true;
+}
+
+bool InflateDecoder::decode(const char* data, size_t length, std::string& output, const Flush& flush) {
+    if (finished || length == 0) {
+        return true;
+    }
+    if (!initialized) {
+        // Telling zlib from raw deflate takes two bytes; hold a lone first one
+        if (format == Format::DEFLATE && header.size() + length < 2) {
+            header.append(data, length);
+            return true;
+        }
+        if (!header.empty()) {
+            std::string joined = header + std::string(data, length);
+            header.clear();
+            return decode(joined.data(), joined.size(), output, flush);
+        }
+        if (!initialize(data, length)) {
+            return false;
+        }
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(length);
+
+    while (stream.avail_in > 0 && !finished) {
+        // Inflate straight into the output string's spare capacity
+        size_t used = output.size();
+        size_t window = std::max(MIN_INFLATE_WINDOW, static_cast<size_t>(stream.avail_in) * 4);
+        output.resize(used + window);
+        stream.next_out = reinterpret_cast<Bytef*>(&output[used]);
+        stream.avail_out = static_cast<uInt>(window);
+
+        int status = inflate(&stream, Z_NO_FLUSH);
+        output.resize(used + window - stream.avail_out);
+
+        if (status == Z_STREAM_END) {
+            finished = true;
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            error = stream.msg ? std::string("Decompression failed: ") + stream.msg : "Decompression failed";
+            return false;
+        }
+        if (flush && !output.empty()) {
+            if (!flush(output)) {
+                error = "Decompression aborted";
+                return false;
+            }
+            output.clear();
+        } else if (output.size() > maxOutput) {
+            error = "Decompressed body too large";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace localify
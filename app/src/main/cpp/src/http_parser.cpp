@@ -0,0 +1,273 @@
+#include "http_parser.h"
+#include <cstring>
+#include <ctime>
+
+namespace localify {
+
+namespace {
+
+inline char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+bool isTokenSeparator(char c) {
+    return c == ',' || c == ' ' || c == '\t' || c == ';';
+}
+
+} // namespace
+
+HttpHeaders::HttpHeaders(std::initializer_list<std::pair<std::string_view, std::string_view>> fields) {
+    for (const auto& field : fields) {
+        set(field.first, field.second);
+    }
+}
+
+bool HttpHeaders::equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (toLower(a[i]) != toLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpHeaders::containsToken(std::string_view value, std::string_view token) {
+    size_t pos = 0;
+    while (pos < value.size()) {
+        while (pos < value.size() && isTokenSeparator(value[pos])) {
+            ++pos;
+        }
+        size_t start = pos;
+        while (pos < value.size() && !isTokenSeparator(value[pos])) {
+            ++pos;
+        }
+        if (pos > start && equalsIgnoreCase(value.substr(start, pos - start), token)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int HttpHeaders::find(std::string_view name) const {
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        if (equalsIgnoreCase(std::string_view(storage.data() + entry.nameOffset, entry.nameLength), name)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void HttpHeaders::set(std::string_view name, std::string_view value) {
+    remove(name);
+    add(name, value);
+}
+
+void HttpHeaders::add(std::string_view name, std::string_view value) {
+    Entry entry;
+    entry.nameOffset = static_cast<uint32_t>(storage.size());
+    entry.nameLength = static_cast<uint32_t>(name.size());
+    storage.append(name.data(), name.size());
+    entry.valueOffset = static_cast<uint32_t>(storage.size());
+    entry.valueLength = static_cast<uint32_t>(value.size());
+    storage.append(value.data(), value.size());
+    entries.push_back(entry);
+}
+
+bool HttpHeaders::remove(std::string_view name) {
+    bool removed = false;
+    int index;
+    while ((index = find(name)) >= 0) {
+        // The bytes stay in storage until clear(); header lists are short-lived
+        entries.erase(entries.begin() + index);
+        removed = true;
+    }
+    return removed;
+}
+
+std::string_view HttpHeaders::get(std::string_view name) const {
+    int index = find(name);
+    if (index < 0) {
+        return std::string_view();
+    }
+    return at(index).value;
+}
+
+bool HttpHeaders::has(std::string_view name) const {
+    return find(name) >= 0;
+}
+
+HttpHeaders::Field HttpHeaders::at(size_t index) const {
+    const Entry& entry = entries[index];
+    return Field{std::string_view(storage.data() + entry.nameOffset, entry.nameLength),
+                 std::string_view(storage.data() + entry.valueOffset, entry.valueLength)};
+}
+
+void HttpHeaders::clear() {
+    storage.clear();
+    entries.clear();
+}
+
+void HttpHeaders::reserve(size_t fields, size_t bytes) {
+    entries.reserve(fields);
+    storage.reserve(bytes);
+}
+
+std::string_view HttpParser::trim(std::string_view value) {
+    size_t start = value.find_first_not_of(" \t\r\n");
+    if (start == std::string_view::npos) {
+        return std::string_view();
+    }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(start, end - start + 1);
+}
+
+int64_t HttpParser::parseHttpDate(std::string_view value) {
+    // strptime needs a terminated string; dates are short
+    char text[64];
+    if (value.size() >= sizeof(text)) {
+        return -1;
+    }
+    memcpy(text, value.data(), value.size());
+    text[value.size()] = '\0';
+
+    struct tm parsed;
+    memset(&parsed, 0, sizeof(parsed));
+    if (strptime(text, "%a, %d %b %Y %H:%M:%S", &parsed) == nullptr) {
+        return -1;
+    }
+    return static_cast<int64_t>(timegm(&parsed));
+}
+
+uint64_t HttpParser::fingerprint(std::string_view value) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : value) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool HttpParser::parseUrl(std::string_view url, ParsedUrl& result) {
+    size_t schemeEnd = url.find("://");
+    if (schemeEnd == std::string_view::npos) {
+        return false;
+    }
+    result.scheme = url.substr(0, schemeEnd);
+    if (HttpHeaders::equalsIgnoreCase(result.scheme, "https")) {
+        result.isHttps = true;
+    } else if (HttpHeaders::equalsIgnoreCase(result.scheme, "http")) {
+        result.isHttps = false;
+    } else {
+        return false;
+    }
+
+    size_t authorityStart = schemeEnd + 3;
+    size_t authorityEnd = url.find_first_of("/?#", authorityStart);
+    if (authorityEnd == std::string_view::npos) {
+        authorityEnd = url.size();
+    }
+    std::string_view authority = url.substr(authorityStart, authorityEnd - authorityStart);
+    if (authority.empty() || authority.find('@') != std::string_view::npos) {
+        return false;
+    }
+
+    // Host, with IPv6 literals in brackets: "[::1]:8080"
+    std::string_view portText;
+    if (authority.front() == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string_view::npos) {
+            return false;
+        }
+        result.host = authority.substr(1, close - 1);
+        std::string_view rest = authority.substr(close + 1);
+        if (!rest.empty()) {
+            if (rest.front() != ':') {
+                return false;
+            }
+            portText = rest.substr(1);
+        }
+    } else {
+        size_t colon = authority.find(':');
+        result.host = authority.substr(0, colon);
+        if (colon != std::string_view::npos) {
+            portText = authority.substr(colon + 1);
+        }
+    }
+    if (result.host.empty()) {
+        return false;
+    }
+
+    if (portText.empty()) {
+        result.port = result.isHttps ? 443 : 80;
+    } else {
+        int port = 0;
+        for (char c : portText) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            port = port * 10 + (c - '0');
+            if (port > 65535) {
+                return false;
+            }
+        }
+        result.port = port;
+    }
+
+    // Path and query go on the request line; a fragment never leaves the client
+    std::string_view path = url.substr(authorityEnd);
+    size_t fragment = path.find('#');
+    if (fragment != std::string_view::npos) {
+        path = path.substr(0, fragment);
+    }
+    size_t queryStart = path.find('?');
+    result.query = queryStart == std::string_view::npos ? std::string_view() : path.substr(queryStart);
+    path = path.substr(0, queryStart);
+    result.path = path.empty() ? std::string_view("/") : path;
+    return true;
+}
+
+bool HttpParser::parseStatusLine(std::string_view line, int& statusCode, int& minorVersion) {
+    // HTTP/1.x SSS[ reason]
+    if (line.size() < 12 || line.compare(0, 7, "HTTP/1.") != 0 || line[8] != ' ') {
+        return false;
+    }
+    if (line[7] < '0' || line[7] > '9') {
+        return false;
+    }
+    minorVersion = line[7] - '0';
+
+    int code = 0;
+    for (size_t i = 9; i < 12; ++i) {
+        if (line[i] < '0' || line[i] > '9') {
+            return false;
+        }
+        code = code * 10 + (line[i] - '0');
+    }
+    if (line.size() > 12 && line[12] != ' ') {
+        return false;
+    }
+    statusCode = code;
+    return true;
+}
+
+void HttpParser::parseHeaderLines(std::string_view block, HttpHeaders& headers) {
+    size_t pos = 0;
+    while (pos < block.size()) {
+        size_t next = block.find("\r\n", pos);
+        std::string_view line = block.substr(pos, next == std::string_view::npos ? std::string_view::npos : next - pos);
+        pos = next == std::string_view::npos ? block.size() : next + 2;
+
+        // Lines without a name are ignored, as most clients do
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0) {
+            continue;
+        }
+        headers.add(trim(line.substr(0, colon)), trim(line.substr(colon + 1)));
+    }
+}
+
+} // namespace localify
@@ -0,0 +1,402 @@
+#include "http_response_parser.h"
+#include "buffer_pool.h"
+#include "http_decoder.h"
+#include "http_parser.h"
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <string_view>
+
+namespace localify {
+
+namespace {
+
+const size_t HEADER_BUFFER_SIZE = 4096;
+const size_t MAX_HEADER_SIZE = 64 * 1024;
+const size_t MIN_RECV_WINDOW = 16384;
+const size_t MAX_DECODED_SIZE = 64 * 1024 * 1024;
+
+// Value of "name=<digits>" inside a Keep-Alive header, or 0
+int keepAliveParameter(std::string_view value, std::string_view name) {
+    size_t pos = value.find(name);
+    if (pos == std::string_view::npos || pos + name.size() >= value.size() ||
+        value[pos + name.size()] != '=') {
+        return 0;
+    }
+    const char* begin = value.data() + pos + name.size() + 1;
+    int result = 0;
+    std::from_chars(begin, value.data() + value.size(), result);
+    return result;
+}
+
+} // namespace
+
+HttpResponseParser::HttpResponseParser(const std::string& method)
+    : method(method), headerBuffer(BufferPool::getInstance().acquire(HEADER_BUFFER_SIZE)),
+      headerFilled(0), headerEnd(std::string::npos), bodyFilled(0), streaming(false), aborted(false), framing(Framing::NONE),
+      contentLength(0), rawReceived(0), overflow(false), complete(false),
+      keepAlive(false), keepAliveTimeout(0), keepAliveMax(0), bytesCopied(0) {
+    headerBuffer.resize(headerBuffer.capacity());
+}
+
+HttpResponseParser::~HttpResponseParser() {
+    if (headerBuffer.capacity() > 0) {
+        BufferPool::getInstance().release(std::move(headerBuffer));
+    }
+    if (scratch.capacity() > 0) {
+        BufferPool::getInstance().release(std::move(scratch));
+    }
+}
+
+void HttpResponseParser::setStreamHandlers(HeadHandler onHead, BodySink onBody) {
+    headHandler = std::move(onHead);
+    bodySink = std::move(onBody);
+}
+
+HttpResponseParser::Window HttpResponseParser::prepare() {
+    if (headerEnd == std::string::npos) {
+        if (headerFilled == headerBuffer.size()) {
+            if (headerBuffer.size() >= MAX_HEADER_SIZE) {
+                error = "Response headers too large";
+                return Window{nullptr, 0};
+            }
+            headerBuffer.resize(std::min(headerBuffer.size() * 2, MAX_HEADER_SIZE));
+        }
+        return Window{&headerBuffer[headerFilled], headerBuffer.size() - headerFilled};
+    }
+
+    // Never read past a declared length, so the next response stays on the socket
+    if (isDecoding()) {
+        size_t window = scratch.size();
+        if (framing == Framing::CONTENT_LENGTH) {
+            window = std::min(window, contentLength - rawReceived);
+        }
+        return Window{&scratch[0], window};
+    }
+    if (framing == Framing::CONTENT_LENGTH) {
+        return Window{&body[0] + bodyFilled, contentLength - bodyFilled};
+    }
+
+    growBody(MIN_RECV_WINDOW / 4);
+    return Window{&body[0] + bodyFilled, body.size() - bodyFilled};
+}
+
+HttpResponseParser::Status HttpResponseParser::commit(size_t length) {
+    if (complete) {
+        // Bytes past the end of the message mean the connection is out of sync
+        keepAlive = false;
+        return Status::COMPLETE;
+    }
+
+    if (headerEnd == std::string::npos) {
+        size_t searchFrom = headerFilled >= 3 ? headerFilled - 3 : 0;
+        headerFilled += length;
+
+        std::string_view received(headerBuffer.data(), headerFilled);
+        headerEnd = received.find("\r\n\r\n", searchFrom);
+        if (headerEnd == std::string::npos) {
+            return Status::NEED_MORE;
+        }
+        Status status = parseHeaderSection();
+        if (status != Status::NEED_MORE) {
+            return status;
+        }
+        return checkBody();
+    }
+
+    if (isDecoding()) {
+        Status status = decodeRaw(scratch.data(), length);
+        if (status == Status::ERROR) {
+            return status;
+        }
+    } else {
+        bodyFilled += length;
+    }
+    return checkBody();
+}
+
+HttpResponseParser::Status HttpResponseParser::feed(const char* data, size_t length) {
+    Status status = Status::NEED_MORE;
+    while (length > 0) {
+        Window window = prepare();
+        if (window.size == 0) {
+            return complete ? Status::COMPLETE : Status::ERROR;
+        }
+        size_t count = std::min(window.size, length);
+        memcpy(window.data, data, count);
+        bytesCopied += count;
+        data += count;
+        length -= count;
+        status = commit(count);
+        if (status != Status::NEED_MORE) {
+            if (length > 0) {
+                keepAlive = false;
+            }
+            return status;
+        }
+    }
+    return status;
+}
+
+HttpResponseParser::Status HttpResponseParser::finish() {
+    if (complete) {
+        return Status::COMPLETE;
+    }
+    if (headerEnd == std::string::npos) {
+        error = headerFilled == 0 ? "Empty response from server" : "Invalid HTTP response format";
+        return Status::ERROR;
+    }
+    if (framing == Framing::UNTIL_CLOSE) {
+        keepAlive = false;
+        return markComplete();
+    }
+    error = "Connection closed mid-response";
+    return Status::ERROR;
+}
+
+HttpResponseParser::Status HttpResponseParser::parseHeaderSection() {
+    std::string_view section(headerBuffer.data(), headerEnd);
+
+    size_t lineEnd = section.find("\r\n");
+    int minorVersion = 0;
+    if (!HttpParser::parseStatusLine(section.substr(0, lineEnd), response.statusCode, minorVersion)) {
+        error = "Invalid HTTP status line";
+        return Status::ERROR;
+    }
+
+    // Header names and values are copied once, into the flat header storage
+    std::string_view lines = lineEnd == std::string_view::npos ? std::string_view() : section.substr(lineEnd + 2);
+    response.headers.reserve(16, lines.size());
+    HttpParser::parseHeaderLines(lines, response.headers);
+
+    // Decide whether the connection may be reused after this response
+    std::string_view connectionHeader = response.headers.get("Connection");
+    keepAlive = minorVersion >= 1
+        ? !HttpHeaders::containsToken(connectionHeader, "close")
+        : HttpHeaders::containsToken(connectionHeader, "keep-alive");
+
+    // Parses "timeout=5, max=100"
+    std::string_view keepAliveHeader = response.headers.get("Keep-Alive");
+    keepAliveTimeout = keepAliveParameter(keepAliveHeader, "timeout");
+    keepAliveMax = keepAliveParameter(keepAliveHeader, "max");
+
+    // Determine message framing (RFC 7230 section 3.3.3)
+    std::string_view contentLengthHeader = response.headers.get("Content-Length");
+    if (method == "HEAD" || response.statusCode == 204 || response.statusCode == 304 ||
+        (response.statusCode >= 100 && response.statusCode < 200)) {
+        framing = Framing::NONE;
+    } else if (HttpHeaders::containsToken(response.headers.get("Transfer-Encoding"), "chunked")) {
+        framing = Framing::CHUNKED;
+    } else if (!contentLengthHeader.empty()) {
+        unsigned long long length = 0;
+        auto parsed = std::from_chars(contentLengthHeader.data(),
+                                      contentLengthHeader.data() + contentLengthHeader.size(), length);
+        if (parsed.ec != std::errc()) {
+            error = "Invalid Content-Length";
+            return Status::ERROR;
+        }
+        framing = Framing::CONTENT_LENGTH;
+        // Saturate rather than wrap where size_t is 32 bits
+        contentLength = static_cast<size_t>(std::min<unsigned long long>(length, std::numeric_limits<size_t>::max()));
+    } else {
+        framing = Framing::UNTIL_CLOSE;
+    }
+
+    if (headHandler && !headHandler(response)) {
+        error = "Cancelled by response handler";
+        aborted = true;
+        return Status::ERROR;
+    }
+    streaming = bodySink && framing != Framing::NONE;
+
+    // A buffered body is allocated up front at its declared length, so a
+    // bogus header must not get to size it
+    if (!streaming && framing == Framing::CONTENT_LENGTH && contentLength > MAX_DECODED_SIZE) {
+        error = "Content-Length exceeds maximum body size";
+        return Status::ERROR;
+    }
+
+    // Encoded bodies (chunked and/or compressed) are received into a scratch
+    // window and decoded into body storage as they arrive
+    std::string_view contentEncoding = response.headers.get("Content-Encoding");
+    if (framing != Framing::NONE) {
+        if (HttpHeaders::containsToken(contentEncoding, "gzip")) {
+            inflater.reset(new InflateDecoder(InflateDecoder::Format::GZIP, MAX_DECODED_SIZE));
+        } else if (HttpHeaders::containsToken(contentEncoding, "deflate")) {
+            inflater.reset(new InflateDecoder(InflateDecoder::Format::DEFLATE, MAX_DECODED_SIZE));
+        }
+        if (framing == Framing::CHUNKED) {
+            chunkedDecoder.reset(new ChunkedDecoder());
+        }
+    }
+
+    size_t bodyStart = headerEnd + 4;
+    size_t tail = headerFilled - bodyStart;
+    Status status = Status::NEED_MORE;
+
+    if (isDecoding()) {
+        scratch = BufferPool::getInstance().acquire(MIN_RECV_WINDOW);
+        scratch.resize(scratch.capacity());
+        body.reserve(inflater && contentLength > 0 && !streaming
+                         ? std::min(contentLength, MAX_DECODED_SIZE / 4) * 4
+                         : MIN_RECV_WINDOW);
+        if (tail > 0) {
+            status = decodeRaw(headerBuffer.data() + bodyStart, tail);
+        }
+    } else {
+        // Move whatever body bytes arrived with the headers into body storage;
+        // this is the only copy on the receive path when Content-Length is known
+        size_t initial = tail;
+        if (framing == Framing::NONE) {
+            initial = 0;
+        } else if (framing == Framing::CONTENT_LENGTH) {
+            initial = std::min(tail, contentLength);
+            body.resize(contentLength);
+        } else {
+            body.resize(std::max(tail, MIN_RECV_WINDOW));
+        }
+        if (tail > initial) {
+            overflow = true;
+        }
+        if (initial > 0) {
+            memcpy(&body[0], headerBuffer.data() + bodyStart, initial);
+            bytesCopied += initial;
+        }
+        bodyFilled = initial;
+    }
+
+    // Header bytes are no longer needed; let the next request reuse the buffer
+    BufferPool::getInstance().release(std::move(headerBuffer));
+    headerBuffer = std::string();
+
+    return status;
+}
+
+void HttpResponseParser::growBody(size_t minFree) {
+    if (body.size() - bodyFilled >= minFree) {
+        return;
+    }
+    // Growing reallocates and copies what has been received so far
+    if (body.capacity() < bodyFilled + minFree) {
+        bytesCopied += bodyFilled;
+    }
+    body.resize(std::max(body.size() * 2, bodyFilled + MIN_RECV_WINDOW));
+}
+
+HttpResponseParser::Status HttpResponseParser::decodeRaw(const char* data, size_t length) {
+    if (framing == Framing::CONTENT_LENGTH) {
+        size_t usable = std::min(length, contentLength - rawReceived);
+        if (usable < length) {
+            overflow = true;
+        }
+        length = usable;
+    }
+    rawReceived += length;
+
+    auto sink = [this](const char* payload, size_t count) {
+        if (inflater) {
+            InflateDecoder::Flush flush;
+            if (streaming) {
+                // Hand out each inflated window and reuse its storage
+                flush = [this](std::string& output) { return emit(output.data(), output.size()); };
+            }
+            if (!inflater->decode(payload, count, body, flush)) {
+                if (error.empty()) {
+                    error = inflater->getError();
+                }
+                return false;
+            }
+        } else if (streaming) {
+            return emit(payload, count);
+        } else {
+            body.append(payload, count);
+            bytesCopied += count;
+        }
+        bodyFilled = body.size();
+        return true;
+    };
+
+    if (chunkedDecoder) {
+        size_t consumed = 0;
+        ChunkedDecoder::Result result = chunkedDecoder->decode(data, length, consumed, sink);
+        if (result == ChunkedDecoder::Result::ERROR) {
+            if (error.empty()) {
+                error = "Invalid chunked encoding";
+            }
+            return Status::ERROR;
+        }
+        if (consumed < length) {
+            overflow = true;
+        }
+    } else if (!sink(data, length)) {
+        return Status::ERROR;
+    }
+    return Status::NEED_MORE;
+}
+
+bool HttpResponseParser::emit(const char* data, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+    if (!bodySink(data, length)) {
+        error = "Cancelled by body handler";
+        aborted = true;
+        return false;
+    }
+    return true;
+}
+
+HttpResponseParser::Status HttpResponseParser::checkBody() {
+    switch (framing) {
+        case Framing::NONE:
+            break;
+        case Framing::CONTENT_LENGTH:
+            if ((isDecoding() ? rawReceived : bodyFilled) < contentLength) {
+                return Status::NEED_MORE;
+            }
+            break;
+        case Framing::CHUNKED:
+            if (!chunkedDecoder->isDone()) {
+                return Status::NEED_MORE;
+            }
+            break;
+        case Framing::UNTIL_CLOSE:
+            return Status::NEED_MORE;
+    }
+
+    return markComplete();
+}
+
+HttpResponseParser::Status HttpResponseParser::markComplete() {
+    if (inflater && !inflater->isFinished()) {
+        error = "Truncated compressed body";
+        return Status::ERROR;
+    }
+    complete = true;
+    if (overflow) {
+        keepAlive = false;
+    }
+    return Status::COMPLETE;
+}
+
+bool HttpResponseParser::isKeepAlive() const {
+    return complete && keepAlive;
+}
+
+HttpResponse HttpResponseParser::takeResponse() {
+    if (complete) {
+        body.resize(bodyFilled);
+        response.body = std::move(body);
+        if (chunkedDecoder || inflater) {
+            // The body handed out is the decoded representation
+            for (const char* name : {"Content-Encoding", "Transfer-Encoding", "Content-Length"}) {
+                response.headers.remove(name);
+            }
+        }
+    }
+    response.bytesCopied = bytesCopied;
+    return std::move(response);
+}
+
+} // namespace localify
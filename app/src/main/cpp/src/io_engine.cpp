@@ -0,0 +1,847 @@
+#include "io_engine.h"
+#include "http_response_parser.h"
+#include "tls_context.h"
+#include <android/log.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#define LOG_TAG "LocalifyIO"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+namespace {
+const int MAX_EVENTS = 64;
+
+// RFC 8305 section 5 recommends 250 ms between connection attempts
+const std::chrono::milliseconds CONNECTION_ATTEMPT_DELAY(250);
+}
+
+IOEngine::Transfer::Transfer()
+    : id(0), state(State::RESOLVING), nextAddress(0), bytesSent(0), retried(false), tag(0), watchedEvents(0),
+      totalDeadline(Clock::time_point::max()), phaseDeadline(Clock::time_point::max()),
+      nextAttemptAt(Clock::time_point::max()), timerArmed(false), cancelSubscription(0) {}
+
+IOEngine::Transfer::~Transfer() = default;
+
+IOEngine::TaskQueue::TaskQueue() : wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), closed(false) {}
+
+IOEngine::TaskQueue::~TaskQueue() {
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+}
+
+bool IOEngine::TaskQueue::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) {
+            return false;
+        }
+        tasks.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+    return true;
+}
+
+IOEngine::IOEngine(ConnectionPool& pool)
+    : pool(pool), epollFd(epoll_create1(EPOLL_CLOEXEC)),
+      taskQueue(std::make_shared<TaskQueue>()), running(true), nextTransferId(1), nextTag(1) {
+    if (epollFd < 0 || taskQueue->wakeFd < 0) {
+        LOGE("Failed to create epoll instance: %s", strerror(errno));
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = 0;     // tag 0 marks the wake-up eventfd
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, taskQueue->wakeFd, &event);
+
+    loopThread = std::thread(&IOEngine::run, this);
+    LOGI("IOEngine started");
+}
+
+IOEngine::~IOEngine() {
+    running = false;
+    taskQueue->post([]() {});
+    if (loopThread.joinable()) {
+        loopThread.join();
+    }
+    close(epollFd);
+    LOGI("IOEngine stopped");
+}
+
+void IOEngine::submit(IOJob job) {
+    if (job.secure && !TlsContext::isAvailable()) {
+        HttpResponse response;
+        response.error = "HTTPS is not supported: built without TLS";
+        response.errorCode = HttpError::NETWORK;
+        job.onComplete(std::move(response));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.submitted++;
+    }
+
+    auto transfer = std::make_shared<std::unique_ptr<Transfer>>(new Transfer());
+    (*transfer)->job = std::move(job);
+    (*transfer)->submittedAt = Clock::now();
+
+    bool posted = taskQueue->post([this, transfer]() {
+        Transfer* raw = transfer->get();
+        transfers[raw] = std::move(*transfer);
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.active = transfers.size();
+            if (stats.active > stats.peakActive) {
+                stats.peakActive = stats.active;
+            }
+        }
+
+        raw->id = nextTransferId++;
+        if (raw->job.totalTimeout.count() > 0) {
+            raw->totalDeadline = Clock::now() + raw->job.totalTimeout;
+            rearmTimer(raw);
+        }
+
+        // The token may fire on any thread; the teardown itself runs here. The
+        // id guards against the address being reused by a later transfer.
+        if (raw->job.cancellation) {
+            uint64_t id = raw->id;
+            std::weak_ptr<TaskQueue> queue = taskQueue;
+            raw->cancelSubscription = raw->job.cancellation->subscribe([this, queue, raw, id]() {
+                if (auto target = queue.lock()) {
+                    target->post([this, raw, id]() {
+                        if (transfers.count(raw) && raw->id == id) {
+                            fail(raw, HttpError::CANCELLED, "Request cancelled");
+                        }
+                    });
+                }
+            });
+        }
+        start(raw);
+    });
+
+    if (!posted) {
+        HttpResponse response;
+        response.error = "HttpClient is shutting down";
+        response.errorCode = HttpError::SHUTTING_DOWN;
+        (*transfer)->job.onComplete(std::move(response));
+    }
+}
+
+IOEngineStats IOEngine::getStats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+void IOEngine::run() {
+    struct epoll_event events[MAX_EVENTS];
+
+    while (running) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, nextTimeoutMs());
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            LOGE("epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+
+        // Each tag is looked up before use: an earlier event in the batch
+        // may have torn its source down
+        for (int i = 0; i < count; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == 0) {
+                uint64_t value;
+                while (read(taskQueue->wakeFd, &value, sizeof(value)) > 0) {}
+                drainTasks();
+                continue;
+            }
+            auto transfer = watchedTransfers.find(tag);
+            if (transfer != watchedTransfers.end()) {
+                handleEvent(transfer->second, events[i].events);
+                continue;
+            }
+            auto attempt = pendingConnects.find(tag);
+            if (attempt != pendingConnects.end()) {
+                onAttemptReady(attempt->second, events[i].events);
+            }
+        }
+        expireTimers();
+    }
+
+    // Refuse new work, then fail whatever is still in flight
+    {
+        std::lock_guard<std::mutex> lock(taskQueue->mutex);
+        taskQueue->closed = true;
+    }
+    drainTasks();
+    while (!transfers.empty()) {
+        fail(transfers.begin()->first, HttpError::SHUTTING_DOWN, "HttpClient is shutting down");
+    }
+}
+
+void IOEngine::drainTasks() {
+    std::vector<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> lock(taskQueue->mutex);
+        pending.swap(taskQueue->tasks);
+    }
+    for (auto& task : pending) {
+        task();
+    }
+}
+
+void IOEngine::start(Transfer* transfer) {
+    const IOJob& job = transfer->job;
+
+    if (!transfer->retried) {
+        PooledConnection connection = pool.acquire(job.host, job.port);
+        if (connection.isValid() && (connection.tls != nullptr) != job.secure) {
+            // Same host and port, other scheme: not a connection this request can use
+            pool.release(connection, false);
+            connection = PooledConnection();
+        }
+        if (connection.isValid()) {
+            transfer->connection = connection;
+            transfer->timing.reusedConnection = true;
+            transfer->phaseStartedAt = Clock::now();
+            beginExchange(transfer);
+            return;
+        }
+    }
+
+    // DNS and the handshake share the connect budget
+    setPhaseDeadline(transfer, job.connectTimeout);
+    transfer->timing.reusedConnection = false;
+    transfer->phaseStartedAt = Clock::now();
+
+    if (DNSResolver::getInstance().resolveCached(job.host, job.port, transfer->resolved)) {
+        markPhase(transfer, &HttpTiming::resolve);
+        transfer->nextAddress = 0;
+        connectNext(transfer);
+        return;
+    }
+
+    // Resolve off the loop thread; every transfer for this host waits on one lookup
+    transfer->state = State::RESOLVING;
+    std::vector<Transfer*>& waiting = awaitingDNS[job.host];
+    waiting.push_back(transfer);
+    if (waiting.size() > 1) {
+        return;
+    }
+
+    std::string host = job.host;
+    std::weak_ptr<TaskQueue> queue = taskQueue;
+    std::thread([this, host, queue]() {
+        DNSResult result = DNSResolver::getInstance().resolve(host, 0);
+        if (auto target = queue.lock()) {
+            target->post([this, host, result]() { onResolved(host, result); });
+        }
+    }).detach();
+}
+
+void IOEngine::onResolved(const std::string& host, const DNSResult& result) {
+    auto it = awaitingDNS.find(host);
+    if (it == awaitingDNS.end()) {
+        return;
+    }
+    std::vector<Transfer*> waiting = std::move(it->second);
+    awaitingDNS.erase(it);
+
+    for (Transfer* transfer : waiting) {
+        if (!transfers.count(transfer)) {
+            continue;
+        }
+        // Use the answer handed back rather than the cache, which a clear()
+        // or a short TTL may already have emptied; connectNext() reports a
+        // failed lookup
+        transfer->resolved = result;
+        DNSResolver::applyPort(transfer->resolved, transfer->job.port);
+        markPhase(transfer, &HttpTiming::resolve);
+        transfer->nextAddress = 0;
+        connectNext(transfer);
+    }
+}
+
+void IOEngine::connectNext(Transfer* transfer) {
+    if (!transfer->resolved.isSuccess()) {
+        fail(transfer, HttpError::NETWORK, transfer->resolved.error);
+        return;
+    }
+    if (transfer->nextAddress == 0 && transfer->attempts.empty()) {
+        orderAddresses(transfer);
+    }
+    transfer->state = State::CONNECTING;
+
+    const std::vector<ResolvedAddress>& addresses = transfer->resolved.addresses;
+    while (transfer->nextAddress < addresses.size()) {
+        size_t index = transfer->nextAddress++;
+        const ResolvedAddress& address = addresses[index];
+
+        int fd = socket(address.family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            continue;
+        }
+
+        int result = connect(fd, reinterpret_cast<const struct sockaddr*>(&address.address), address.length);
+        if (result < 0 && errno != EINPROGRESS) {
+            close(fd);
+            continue;
+        }
+
+        std::unique_ptr<ConnectAttempt> attempt(new ConnectAttempt{transfer, fd, address.family, index, 0});
+        ConnectAttempt* raw = attempt.get();
+        transfer->attempts.push_back(std::move(attempt));
+        if (result == 0) {
+            winRace(raw);
+            return;
+        }
+
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLOUT;
+        event.data.u64 = nextTag;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0) {
+            raw->tag = nextTag++;
+            pendingConnects[raw->tag] = raw;
+        }
+
+        // Give this attempt a head start before racing the next address
+        transfer->nextAttemptAt = transfer->nextAddress < addresses.size()
+                                      ? Clock::now() + CONNECTION_ATTEMPT_DELAY
+                                      : Clock::time_point::max();
+        rearmTimer(transfer);
+        return;
+    }
+
+    transfer->nextAttemptAt = Clock::time_point::max();
+    rearmTimer(transfer);
+    if (transfer->attempts.empty()) {
+        LOGE("Failed to connect to %s:%d", transfer->job.host.c_str(), transfer->job.port);
+        fail(transfer, HttpError::NETWORK, "Failed to connect to server");
+    }
+}
+
+void IOEngine::orderAddresses(Transfer* transfer) {
+    std::vector<ResolvedAddress>& addresses = transfer->resolved.addresses;
+    if (addresses.size() < 2) {
+        return;
+    }
+
+    // getaddrinfo's order (RFC 6724) decides the first family unless this
+    // host has a winner on record
+    int first = addresses.front().family;
+    auto remembered = preferredFamily.find(transfer->job.host);
+    if (remembered != preferredFamily.end()) {
+        first = remembered->second;
+    }
+
+    std::vector<ResolvedAddress> preferred;
+    std::vector<ResolvedAddress> other;
+    for (const ResolvedAddress& address : addresses) {
+        (address.family == first ? preferred : other).push_back(address);
+    }
+    addresses.clear();
+    for (size_t i = 0; i < preferred.size() || i < other.size(); ++i) {
+        if (i < preferred.size()) {
+            addresses.push_back(preferred[i]);
+        }
+        if (i < other.size()) {
+            addresses.push_back(other[i]);
+        }
+    }
+}
+
+void IOEngine::onAttemptReady(ConnectAttempt* attempt, uint32_t events) {
+    int socketError = 0;
+    socklen_t length = sizeof(socketError);
+    getsockopt(attempt->fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+
+    // Only a writable socket with no error and no hang-up has connected
+    bool failed = socketError != 0 || (events & (EPOLLERR | EPOLLHUP)) != 0;
+    if (!failed) {
+        if (events & EPOLLOUT) {
+            winRace(attempt);
+        }
+        return;
+    }
+
+    // A refused attempt hands over to the next address without waiting
+    Transfer* transfer = attempt->transfer;
+    LOGI("Connection attempt to %s:%d failed: %s", transfer->job.host.c_str(), transfer->job.port,
+         socketError != 0 ? strerror(socketError) : "hang-up");
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, attempt->fd, nullptr);
+    close(attempt->fd);
+    pendingConnects.erase(attempt->tag);
+    auto& attempts = transfer->attempts;
+    attempts.erase(std::find_if(attempts.begin(), attempts.end(),
+                                [attempt](const std::unique_ptr<ConnectAttempt>& entry) { return entry.get() == attempt; }));
+    connectNext(transfer);
+}
+
+void IOEngine::winRace(ConnectAttempt* attempt) {
+    Transfer* transfer = attempt->transfer;
+    int fd = attempt->fd;
+    if (attempt->addressIndex > 0) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.connectFallbacks++;
+    }
+    preferredFamily[transfer->job.host] = attempt->family;
+
+    // Keep the winner's socket, drop everyone else's
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    attempt->fd = -1;
+    closeAttempts(transfer);
+    // The stagger timer must not outlive the race: the handshake runs under
+    // the connect deadline alone
+    transfer->nextAttemptAt = Clock::time_point::max();
+    rearmTimer(transfer);
+
+    // Small request/response exchanges on a persistent socket must not wait on Nagle
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    transfer->connection = pool.registerNew(fd, transfer->job.host, transfer->job.port);
+    markPhase(transfer, &HttpTiming::connect);
+    if (transfer->job.secure) {
+        startHandshake(transfer);
+    } else {
+        beginExchange(transfer);
+    }
+}
+
+void IOEngine::closeAttempts(Transfer* transfer) {
+    for (const auto& attempt : transfer->attempts) {
+        if (attempt->fd >= 0) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, attempt->fd, nullptr);
+            close(attempt->fd);
+        }
+        pendingConnects.erase(attempt->tag);
+    }
+    transfer->attempts.clear();
+}
+
+void IOEngine::startHandshake(Transfer* transfer) {
+    std::unique_ptr<TlsStream> tls = TlsContext::getInstance().connect(
+        transfer->connection.fd, transfer->job.host, transfer->job.port);
+    if (!tls) {
+        fail(transfer, HttpError::NETWORK, "Failed to set up TLS");
+        return;
+    }
+    transfer->connection.tls = std::move(tls);
+    transfer->state = State::HANDSHAKING;
+    continueHandshake(transfer);
+}
+
+void IOEngine::continueHandshake(Transfer* transfer) {
+    TlsStream& tls = *transfer->connection.tls;
+    switch (tls.handshake()) {
+        case TlsStatus::OK:
+            markPhase(transfer, &HttpTiming::tls);
+            transfer->timing.resumedSession = tls.isResumed();
+            beginExchange(transfer);
+            break;
+        case TlsStatus::WANT_READ:
+            watch(transfer, EPOLLIN);
+            break;
+        case TlsStatus::WANT_WRITE:
+            watch(transfer, EPOLLOUT);
+            break;
+        case TlsStatus::CLOSED:
+        case TlsStatus::ERROR:
+            LOGE("TLS handshake with %s failed: %s", transfer->job.host.c_str(), tls.getError().c_str());
+            fail(transfer, HttpError::NETWORK, "TLS handshake failed: " + tls.getError());
+            break;
+    }
+}
+
+void IOEngine::beginExchange(Transfer* transfer) {
+    clearPhaseDeadline(transfer);
+    transfer->state = State::SENDING;
+    transfer->bytesSent = 0;
+    transfer->parser.reset(new HttpResponseParser(transfer->job.method));
+    if (transfer->job.onHead || transfer->job.onBody) {
+        transfer->parser->setStreamHandlers(transfer->job.onHead, transfer->job.onBody);
+    }
+    onWritable(transfer);
+}
+
+void IOEngine::handleEvent(Transfer* transfer, uint32_t events) {
+    // While receiving, recv() reports an error after whatever arrived before
+    // it; earlier on there is nothing to drain, so fail with the cause now
+    if ((events & EPOLLERR) && transfer->state != State::RECEIVING) {
+        int socketError = 0;
+        socklen_t length = sizeof(socketError);
+        getsockopt(transfer->connection.fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+        if (!retryIfStale(transfer)) {
+            fail(transfer, HttpError::NETWORK,
+                 std::string("Connection failed: ") + strerror(socketError != 0 ? socketError : EIO));
+        }
+        return;
+    }
+
+    switch (transfer->state) {
+        case State::HANDSHAKING:
+            continueHandshake(transfer);
+            break;
+        case State::SENDING:
+            onWritable(transfer);
+            break;
+        case State::RECEIVING:
+            onReadable(transfer);
+            break;
+        case State::RESOLVING:
+        case State::CONNECTING:     // attempts carry their own events
+            break;
+    }
+}
+
+void IOEngine::onWritable(Transfer* transfer) {
+    const std::string& data = transfer->job.requestData;
+
+    while (transfer->bytesSent < data.size()) {
+        if (TlsStream* tls = transfer->connection.tls.get()) {
+            size_t written = 0;
+            TlsStatus status = tls->write(data.data() + transfer->bytesSent,
+                                          data.size() - transfer->bytesSent, written);
+            if (status == TlsStatus::OK) {
+                transfer->bytesSent += written;
+                continue;
+            }
+            if (status == TlsStatus::WANT_READ || status == TlsStatus::WANT_WRITE) {
+                watch(transfer, status == TlsStatus::WANT_READ ? EPOLLIN : EPOLLOUT);
+                return;
+            }
+            if (!retryIfStale(transfer)) {
+                fail(transfer, HttpError::NETWORK, "Failed to send request");
+            }
+            return;
+        }
+
+        ssize_t sent = send(transfer->connection.fd, data.data() + transfer->bytesSent,
+                            data.size() - transfer->bytesSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(transfer, EPOLLOUT);
+                return;
+            }
+            if (!retryIfStale(transfer)) {
+                fail(transfer, HttpError::NETWORK, "Failed to send request");
+            }
+            return;
+        }
+        transfer->bytesSent += sent;
+    }
+
+    markPhase(transfer, &HttpTiming::send);
+    transfer->timing.bytesSent = transfer->bytesSent;
+    transfer->state = State::RECEIVING;
+    setPhaseDeadline(transfer, transfer->job.firstByteTimeout);
+    watch(transfer, EPOLLIN);
+}
+
+void IOEngine::onReadable(Transfer* transfer) {
+    HttpResponseParser& parser = *transfer->parser;
+
+    while (true) {
+        // Receive straight into the parser's storage; no intermediate buffer
+        HttpResponseParser::Window window = parser.prepare();
+        if (window.size == 0) {
+            failParse(transfer);
+            return;
+        }
+        ssize_t bytesRead;
+        if (TlsStream* tls = transfer->connection.tls.get()) {
+            size_t decrypted = 0;
+            TlsStatus status = tls->read(window.data, window.size, decrypted);
+            if (status == TlsStatus::WANT_READ) {
+                watch(transfer, EPOLLIN);
+                return;
+            }
+            if (status == TlsStatus::WANT_WRITE) {
+                // TLS itself needs to write (a key update) before reading on
+                watch(transfer, EPOLLIN | EPOLLOUT);
+                return;
+            }
+            if (status == TlsStatus::ERROR) {
+                fail(transfer, HttpError::NETWORK, "TLS error: " + tls->getError());
+                return;
+            }
+            bytesRead = static_cast<ssize_t>(decrypted);   // zero when CLOSED
+        } else {
+            bytesRead = recv(transfer->connection.fd, window.data, window.size, 0);
+        }
+
+        if (bytesRead > 0) {
+            if (transfer->phaseDeadline != Clock::time_point::max()) {
+                clearPhaseDeadline(transfer);
+            }
+            if (transfer->timing.bytesReceived == 0) {
+                markPhase(transfer, &HttpTiming::firstByte);
+            }
+            transfer->timing.bytesReceived += bytesRead;
+            HttpResponseParser::Status status = parser.commit(bytesRead);
+            if (status == HttpResponseParser::Status::COMPLETE) {
+                complete(transfer, parser.isKeepAlive());
+                return;
+            }
+            if (status == HttpResponseParser::Status::ERROR) {
+                failParse(transfer);
+                return;
+            }
+            continue;
+        }
+
+        if (bytesRead < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+        }
+
+        // Peer closed (or reset) the connection
+        if (retryIfStale(transfer)) {
+            return;
+        }
+        if (parser.finish() == HttpResponseParser::Status::COMPLETE) {
+            complete(transfer, false);
+        } else {
+            fail(transfer, HttpError::NETWORK, parser.getError());
+        }
+        return;
+    }
+}
+
+void IOEngine::watch(Transfer* transfer, uint32_t events) {
+    if (transfer->tag != 0 && transfer->watchedEvents == events) {
+        return;
+    }
+    // A socket keeps its tag while it stays registered
+    uint64_t tag = transfer->tag != 0 ? transfer->tag : nextTag;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = tag;
+
+    int op = transfer->tag != 0 ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(epollFd, op, transfer->connection.fd, &event) == 0) {
+        if (transfer->tag == 0) {
+            transfer->tag = nextTag++;
+            watchedTransfers[transfer->tag] = transfer;
+        }
+        transfer->watchedEvents = events;
+    } else {
+        LOGE("epoll_ctl failed: %s", strerror(errno));
+    }
+}
+
+void IOEngine::unwatch(Transfer* transfer) {
+    if (transfer->tag != 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, transfer->connection.fd, nullptr);
+        watchedTransfers.erase(transfer->tag);
+        transfer->tag = 0;
+    }
+}
+
+void IOEngine::setPhaseDeadline(Transfer* transfer, std::chrono::milliseconds timeout) {
+    transfer->phaseDeadline = timeout.count() > 0 ? Clock::now() + timeout : Clock::time_point::max();
+    rearmTimer(transfer);
+}
+
+void IOEngine::clearPhaseDeadline(Transfer* transfer) {
+    transfer->phaseDeadline = Clock::time_point::max();
+    rearmTimer(transfer);
+}
+
+void IOEngine::markPhase(Transfer* transfer, std::chrono::microseconds HttpTiming::*field) {
+    Clock::time_point now = Clock::now();
+    transfer->timing.*field = std::chrono::duration_cast<std::chrono::microseconds>(now - transfer->phaseStartedAt);
+    transfer->phaseStartedAt = now;
+}
+
+void IOEngine::finishTiming(Transfer* transfer, HttpResponse& response) {
+    transfer->timing.total = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - transfer->submittedAt);
+    response.timing = transfer->timing;
+}
+
+void IOEngine::rearmTimer(Transfer* transfer) {
+    if (transfer->timerArmed) {
+        timers.erase(transfer->timer);
+        transfer->timerArmed = false;
+    }
+    Clock::time_point deadline = std::min({transfer->phaseDeadline, transfer->totalDeadline, transfer->nextAttemptAt});
+    if (deadline != Clock::time_point::max()) {
+        transfer->timer = timers.emplace(deadline, transfer);
+        transfer->timerArmed = true;
+    }
+}
+
+int IOEngine::nextTimeoutMs() const {
+    if (timers.empty()) {
+        return -1;
+    }
+    auto remaining = timers.begin()->first - Clock::now();
+    if (remaining <= Clock::duration::zero()) {
+        return 0;
+    }
+    // Round up so the loop never wakes just before the deadline
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+}
+
+void IOEngine::expireTimers() {
+    Clock::time_point now = Clock::now();
+    while (!timers.empty() && timers.begin()->first <= now) {
+        onTimeout(timers.begin()->second);
+    }
+}
+
+void IOEngine::onTimeout(Transfer* transfer) {
+    Clock::time_point now = Clock::now();
+    if (now < transfer->totalDeadline && now < transfer->phaseDeadline && now >= transfer->nextAttemptAt) {
+        // Not a deadline: the previous attempt's head start is over
+        connectNext(transfer);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.timedOut++;
+    }
+    if (now >= transfer->totalDeadline) {
+        fail(transfer, HttpError::TIMED_OUT, "Request timed out");
+        return;
+    }
+
+    switch (transfer->state) {
+        case State::RESOLVING:
+            fail(transfer, HttpError::TIMED_OUT, "DNS lookup timed out");
+            break;
+        case State::CONNECTING:
+            // The connect budget covers the whole race
+            LOGE("Connection to %s:%d timed out", transfer->job.host.c_str(), transfer->job.port);
+            fail(transfer, HttpError::TIMED_OUT, "Connection timed out");
+            break;
+        case State::HANDSHAKING:
+            fail(transfer, HttpError::TIMED_OUT, "TLS handshake timed out");
+            break;
+        case State::SENDING:
+        case State::RECEIVING:
+            fail(transfer, HttpError::TIMED_OUT, "Timed out waiting for response");
+            break;
+    }
+}
+
+bool IOEngine::retryIfStale(Transfer* transfer) {
+    if (!transfer->connection.reused || transfer->retried ||
+        (transfer->parser && transfer->parser->hasReceivedData())) {
+        return false;
+    }
+
+    LOGI("Pooled connection to %s:%d was closed by peer, retrying",
+         transfer->job.host.c_str(), transfer->job.port);
+    unwatch(transfer);
+    pool.release(transfer->connection, false);
+    transfer->connection = PooledConnection();
+    transfer->parser.reset();
+    transfer->retried = true;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.staleRetries++;
+    }
+    start(transfer);
+    return true;
+}
+
+void IOEngine::complete(Transfer* transfer, bool reusable) {
+    unwatch(transfer);
+
+    HttpResponseParser& parser = *transfer->parser;
+    if (parser.getKeepAliveTimeout() > 0) {
+        transfer->connection.keepAliveTimeout = std::chrono::seconds(parser.getKeepAliveTimeout());
+    }
+    if (parser.getKeepAliveMax() > 0) {
+        transfer->connection.maxRequests = transfer->connection.requestsServed + parser.getKeepAliveMax();
+    }
+    pool.release(transfer->connection, reusable);
+    transfer->connection = PooledConnection();
+
+    HttpResponse response = parser.takeResponse();
+    markPhase(transfer, &HttpTiming::transfer);
+    finishTiming(transfer, response);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.completed++;
+    }
+    report(transfer, std::move(response));
+}
+
+void IOEngine::failParse(Transfer* transfer) {
+    HttpResponseParser& parser = *transfer->parser;
+    fail(transfer, parser.isAborted() ? HttpError::CANCELLED : HttpError::PROTOCOL, parser.getError());
+}
+
+void IOEngine::fail(Transfer* transfer, HttpError code, const std::string& error) {
+    unwatch(transfer);
+    if (transfer->connection.isValid()) {
+        pool.release(transfer->connection, false);
+        transfer->connection = PooledConnection();
+    }
+
+    LOGE("Request to %s failed: %s", transfer->job.host.c_str(), error.c_str());
+    HttpResponse response;
+    response.error = error;
+    response.errorCode = code;
+    finishTiming(transfer, response);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.failed++;
+        if (code == HttpError::CANCELLED) {
+            stats.cancelled++;
+        }
+    }
+    report(transfer, std::move(response));
+}
+
+void IOEngine::report(Transfer* transfer, HttpResponse response) {
+    // The transfer goes first: once the caller has its response it may
+    // tear down anything the transfer would still touch, down to the
+    // process-wide buffer pool at exit
+    auto onComplete = std::move(transfer->job.onComplete);
+    destroy(transfer);
+    onComplete(std::move(response));
+}
+
+void IOEngine::destroy(Transfer* transfer) {
+    if (transfer->state == State::RESOLVING) {
+        auto it = awaitingDNS.find(transfer->job.host);
+        if (it != awaitingDNS.end()) {
+            std::vector<Transfer*>& waiting = it->second;
+            waiting.erase(std::remove(waiting.begin(), waiting.end(), transfer), waiting.end());
+        }
+    }
+    if (transfer->timerArmed) {
+        timers.erase(transfer->timer);
+        transfer->timerArmed = false;
+    }
+    closeAttempts(transfer);
+    unwatch(transfer);
+    if (transfer->job.cancellation) {
+        transfer->job.cancellation->unsubscribe(transfer->cancelSubscription);
+    }
+    transfers.erase(transfer);
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.active = transfers.size();
+}
+
+} // namespace localify
@@ -1,6 +1,6 @@
 #include "jni_bridge.h"
 #include "api_service.h"
-#include "json_parser.h"
+#include "model_schema.h"
 #include <android/log.h>
 
 #define LOG_TAG "LocalifyJNI"
@@ -23,75 +23,22 @@ jstring string_to_jstring(JNIEnv *env, const std::string& str) {
     return env->NewStringUTF(str.c_str());
 }
 
-// Convert C++ AuthResponse to JSON string
-std::string authResponseToJson(const AuthResponse& auth) {
-    return "{\"token\":\"" + auth.token + 
-           "\",\"refreshToken\":\"" + auth.refreshToken + 
-           "\",\"expiresIn\":" + std::to_string(auth.expiresIn) + "}";
+// Hands the scratch writer's buffer straight to the JVM, with no copy
+template<typename T>
+jstring json_to_jstring(JNIEnv *env, const T& value) {
+    JSONWriter& writer = JSONWriter::scratch();
+    writer.setEscapeSupplementary(true);
+    writeJSON(writer, value);
+    return env->NewStringUTF(writer.str().c_str());
 }
 
-// Convert C++ UserDetails to JSON string
-std::string userDetailsToJson(const UserDetails& user) {
-    std::string json = "{";
-    json += "\"id\":\"" + user.id + "\",";
-    json += "\"name\":\"" + user.name + "\",";
-    
-    if (user.email.has_value()) {
-        json += "\"email\":\"" + user.email.value() + "\",";
-    } else {
-        json += "\"email\":null,";
-    }
-    
-    json += "\"anonymousUser\":" + std::string(user.anonymousUser ? "true" : "false") + ",";
-    json += "\"emailConnected\":" + std::string(user.emailConnected ? "true" : "false") + ",";
-    json += "\"spotifyConnected\":" + std::string(user.spotifyConnected ? "true" : "false");
-    json += "}";
-    
-    return json;
-}
-
-// Convert C++ SearchResponse to JSON string
-std::string searchResponseToJson(const SearchResponse& search) {
-    std::string json = "{";
-    
-    // Artists array
-    json += "\"artists\":[";
-    for (size_t i = 0; i < search.artists.size(); ++i) {
-        if (i > 0) json += ",";
-        const auto& artist = search.artists[i];
-        json += "{\"id\":\"" + artist.id + "\",\"name\":\"" + artist.name + "\",\"popularity\":" + std::to_string(artist.popularity) + "}";
-    }
-    json += "],";
-    
-    // Events array
-    json += "\"events\":[";
-    for (size_t i = 0; i < search.events.size(); ++i) {
-        if (i > 0) json += ",";
-        const auto& event = search.events[i];
-        json += "{\"id\":\"" + event.id + "\",\"name\":\"" + event.name + "\",\"venueName\":\"" + event.venueName + "\"}";
-    }
-    json += "],";
-    
-    // Venues array
-    json += "\"venues\":[";
-    for (size_t i = 0; i < search.venues.size(); ++i) {
-        if (i > 0) json += ",";
-        const auto& venue = search.venues[i];
-        json += "{\"id\":\"" + venue.id + "\",\"name\":\"" + venue.name + "\",\"city\":\"" + venue.city + "\"}";
-    }
-    json += "],";
-    
-    // Cities array
-    json += "\"cities\":[";
-    for (size_t i = 0; i < search.cities.size(); ++i) {
-        if (i > 0) json += ",";
-        const auto& city = search.cities[i];
-        json += "{\"id\":\"" + city.id + "\",\"name\":\"" + city.name + "\",\"country\":\"" + city.country + "\"}";
-    }
-    json += "]";
-    
-    json += "}";
-    return json;
+jstring error_to_jstring(JNIEnv *env, const char* message) {
+    JSONWriter& writer = JSONWriter::scratch();
+    writer.setEscapeSupplementary(true);
+    writer.beginObject();
+    writer.field("error", message);
+    writer.endObject();
+    return env->NewStringUTF(writer.str().c_str());
 }
 
 extern "C" {
@@ -102,13 +49,11 @@ Java_com_localify_android_LocalifyNative_createGuestUser(JNIEnv *env, jobject th
         LOGI("Creating guest user");
         auto future = APIService::getInstance().createGuestUser();
         AuthResponse auth = future.get();
-        std::string jsonResult = authResponseToJson(auth);
         LOGI("Guest user created successfully");
-        return string_to_jstring(env, jsonResult);
+        return json_to_jstring(env, auth);
     } catch (const std::exception& e) {
         LOGE("Error creating guest user: %s", e.what());
-        std::string errorJson = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        return string_to_jstring(env, errorJson);
+        return error_to_jstring(env, e.what());
     }
 }
 
@@ -122,13 +67,11 @@ Java_com_localify_android_LocalifyNative_exchangeToken(JNIEnv *env, jobject thiz
         LOGI("Exchanging token");
         auto future = APIService::getInstance().exchangeToken(tokenStr, secretStr);
         AuthResponse auth = future.get();
-        std::string jsonResult = authResponseToJson(auth);
         LOGI("Token exchanged successfully");
-        return string_to_jstring(env, jsonResult);
+        return json_to_jstring(env, auth);
     } catch (const std::exception& e) {
         LOGE("Error exchanging token: %s", e.what());
-        std::string errorJson = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        return string_to_jstring(env, errorJson);
+        return error_to_jstring(env, e.what());
     }
 }
 
@@ -138,13 +81,11 @@ Java_com_localify_android_LocalifyNative_refreshAuth(JNIEnv *env, jobject thiz,
         LOGI("Refreshing auth token");
         auto future = APIService::getInstance().refreshAuth(force == JNI_TRUE);
         AuthResponse auth = future.get();
-        std::string jsonResult = authResponseToJson(auth);
         LOGI("Auth token refreshed successfully");
-        return string_to_jstring(env, jsonResult);
+        return json_to_jstring(env, auth);
     } catch (const std::exception& e) {
         LOGE("Error refreshing auth: %s", e.what());
-        std::string errorJson = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        return string_to_jstring(env, errorJson);
+        return error_to_jstring(env, e.what());
     }
 }
 
@@ -154,13 +95,11 @@ Java_com_localify_android_LocalifyNative_fetchUserDetails(JNIEnv *env, jobject t
         LOGI("Fetching user details");
         auto future = APIService::getInstance().fetchUserDetails();
         UserDetails user = future.get();
-        std::string jsonResult = userDetailsToJson(user);
         LOGI("User details fetched successfully");
-        return string_to_jstring(env, jsonResult);
+        return json_to_jstring(env, user);
     } catch (const std::exception& e) {
         LOGE("Error fetching user details: %s", e.what());
-        std::string errorJson = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        return string_to_jstring(env, errorJson);
+        return error_to_jstring(env, e.what());
     }
 }
 
@@ -193,13 +132,11 @@ Java_com_localify_android_LocalifyNative_fetchSearch(JNIEnv *env, jobject thiz,
         LOGI("Performing search for: %s", textStr.c_str());
         auto future = APIService::getInstance().fetchSearch(textStr, autoSearch);
         SearchResponse search = future.get();
-        std::string jsonResult = searchResponseToJson(search);
         LOGI("Search completed successfully");
-        return string_to_jstring(env, jsonResult);
+        return json_to_jstring(env, search);
     } catch (const std::exception& e) {
         LOGE("Error performing search: %s", e.what());
-        std::string errorJson = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        return string_to_jstring(env, errorJson);
+        return error_to_jstring(env, e.what());
     }
 }
 
@@ -213,22 +150,11 @@ Java_com_localify_android_LocalifyNative_fetchSearchArtists(JNIEnv *env, jobject
         LOGI("Searching artists for: %s", textStr.c_str());
         auto future = APIService::getInstance().fetchSearchArtists(textStr, limitInt);
         std::vector<ArtistResponse> artists = future.get();
-        
-        // Convert to JSON array
-        std::string json = "[";
-        for (size_t i = 0; i < artists.size(); ++i) {
-            if (i > 0) json += ",";
-            const auto& artist = artists[i];
-            json += "{\"id\":\"" + artist.id + "\",\"name\":\"" + artist.name + "\",\"popularity\":" + std::to_string(artist.popularity) + "}";
-        }
-        json += "]";
-        
         LOGI("Artist search completed successfully");
-        return string_to_jstring(env, json);
+        return json_to_jstring(env, artists);
     } catch (const std::exception& e) {
         LOGE("Error searching artists: %s", e.what());
-        std::string errorJson = "{\"error\":\"" + std::string(e.what()) + "\"}";
-        return string_to_jstring(env, errorJson);
+        return error_to_jstring(env, e.what());
     }
 }
 
@@ -1,7 +1,11 @@
 #include "json_parser.h"
-#include <sstream>
-#include <regex>
+#include "json_tape.h"
+#include "model_schema.h"
+#include "model_views.h"
+#include "worker_pool.h"
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <android/log.h>
 
 #define LOG_TAG "LocalifyJSON"
@@ -10,318 +14,357 @@
 
 namespace localify {
 
-// Helper function to extract string value from JSON
-std::string JSONParser::extractStringValue(const std::string& json, const std::string& key) {
-    std::regex pattern("\"" + key + "\"\\s*:\\s*\"([^\"]*?)\"");
-    std::smatch match;
-    if (std::regex_search(json, match, pattern)) {
-        return unescapeJsonString(match[1].str());
-    }
-    return "";
-}
+namespace {
 
-int JSONParser::extractIntValue(const std::string& json, const std::string& key) {
-    std::regex pattern("\"" + key + "\"\\s*:\\s*([0-9]+)");
-    std::smatch match;
-    if (std::regex_search(json, match, pattern)) {
-        return std::stoi(match[1].str());
+// Tokenizes json into the calling thread's scratch tape (see
+// JSONTape::scratch); a value read from it is only good until the next
+// document is parsed on the same thread.
+JSONTape* tokenize(std::string_view json, const char* what) {
+    JSONTape& tape = JSONTape::scratch();
+    if (!tape.parse(json)) {
+        LOGE("Malformed %s JSON: %s", what, tape.getError().c_str());
+        return nullptr;
     }
-    return 0;
+    return &tape;
 }
 
-double JSONParser::extractDoubleValue(const std::string& json, const std::string& key) {
-    std::regex pattern("\"" + key + "\"\\s*:\\s*([0-9]+\\.?[0-9]*)");
-    std::smatch match;
-    if (std::regex_search(json, match, pattern)) {
-        return std::stod(match[1].str());
-    }
-    return 0.0;
+// Decodes a whole document through T's JSONSchema, or returns defaults if
+// it is malformed
+template<typename T>
+T parseWith(const std::string& json, const char* what) {
+    JSONTape* tape = tokenize(json, what);
+    return tape != nullptr ? fromJSON<T>(tape->root()) : T{};
 }
 
-bool JSONParser::extractBoolValue(const std::string& json, const std::string& key) {
-    std::regex pattern("\"" + key + "\"\\s*:\\s*(true|false)");
-    std::smatch match;
-    if (std::regex_search(json, match, pattern)) {
-        return match[1].str() == "true";
+// Copies the body into arena and decodes it there; the scratch tape is only
+// needed while decoding, so nothing outside the arena refers to the result
+template<typename T>
+T parseInArena(std::string_view json, Arena& arena, const char* what) {
+    std::string_view body = arena.copy(json);
+    JSONTape* tape = tokenize(body, what);
+    T out{};
+    if (tape != nullptr) {
+        readJSON(tape->root(), out, arena);
     }
-    return false;
+    return out;
 }
 
-std::optional<std::string> JSONParser::extractOptionalStringValue(const std::string& json, const std::string& key) {
-    std::regex pattern("\"" + key + "\"\\s*:\\s*(\"([^\"]*?)\"|null)");
-    std::smatch match;
-    if (std::regex_search(json, match, pattern)) {
-        if (match[1].str() == "null") {
-            return std::nullopt;
-        }
-        return unescapeJsonString(match[2].str());
-    }
-    return std::nullopt;
-}
+// Elements per parallel task; enough to amortise claiming one
+const size_t ELEMENTS_PER_TASK = 32;
 
-std::optional<int> JSONParser::extractOptionalIntValue(const std::string& json, const std::string& key) {
-    std::regex pattern("\"" + key + "\"\\s*:\\s*(([0-9]+)|null)");
-    std::smatch match;
-    if (std::regex_search(json, match, pattern)) {
-        if (match[1].str() == "null") {
-            return std::nullopt;
-        }
-        return std::stoi(match[2].str());
-    }
-    return std::nullopt;
-}
+std::atomic<size_t> parallelDecodeThreshold(256 * 1024);
 
-std::string JSONParser::findJsonArray(const std::string& json, const std::string& key) {
-    std::regex pattern("\"" + key + "\"\\s*:\\s*(\\[.*?\\])");
-    std::smatch match;
-    if (std::regex_search(json, match, pattern)) {
-        return match[1].str();
+// Decodes a top-level array, splitting its elements across WorkerPool when
+// the document is big enough. The tape is tokenized once on this thread;
+// workers only read it, and each fills its own slice of the result, so the
+// order is kept without a merge step.
+template<typename T>
+std::vector<T> parseArray(const std::string& json, const char* what) {
+    JSONTape* tape = tokenize(json, what);
+    if (tape == nullptr) {
+        return std::vector<T>();
     }
-    return "[]";
-}
-
-std::vector<std::string> JSONParser::splitJsonArray(const std::string& jsonArray) {
-    std::vector<std::string> result;
-    if (jsonArray.length() < 2) return result;
-    
-    std::string content = jsonArray.substr(1, jsonArray.length() - 2); // Remove [ and ]
-    if (content.empty()) return result;
-    
-    // Simple JSON object splitting (assumes objects don't contain nested arrays)
-    int braceCount = 0;
-    int start = 0;
-    bool inString = false;
-    bool escaped = false;
-    
-    for (size_t i = 0; i < content.length(); ++i) {
-        char c = content[i];
-        
-        if (!inString) {
-            if (c == '{') braceCount++;
-            else if (c == '}') braceCount--;
-            else if (c == '"') inString = true;
-            else if (c == ',' && braceCount == 0) {
-                result.push_back(trim(content.substr(start, i - start)));
-                start = i + 1;
-            }
-        } else {
-            if (!escaped) {
-                if (c == '"') inString = false;
-                else if (c == '\\') escaped = true;
-            } else {
-                escaped = false;
-            }
-        }
+    JSONValue root = tape->root();
+    size_t threshold = parallelDecodeThreshold.load();
+    WorkerPool* pool = nullptr;
+    if (threshold > 0 && json.size() >= threshold && root.size() > ELEMENTS_PER_TASK) {
+        pool = &WorkerPool::getInstance();
     }
-    
-    if (start < content.length()) {
-        result.push_back(trim(content.substr(start)));
+    if (pool == nullptr || pool->getThreadCount() < 2) {
+        return fromJSON<std::vector<T>>(root);
     }
-    
-    return result;
-}
-
-std::string JSONParser::trim(const std::string& str) {
-    size_t start = str.find_first_not_of(" \t\n\r");
-    if (start == std::string::npos) return "";
-    size_t end = str.find_last_not_of(" \t\n\r");
-    return str.substr(start, end - start + 1);
-}
-
-std::string JSONParser::unescapeJsonString(const std::string& str) {
-    std::string result = str;
-    std::regex escapePattern("\\\\([\"\\\\/bfnrt])");
-    result = std::regex_replace(result, escapePattern, "$1");
-    return result;
-}
-
-std::string JSONParser::escapeJsonString(const std::string& str) {
-    std::string result;
-    for (char c : str) {
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\b': result += "\\b"; break;
-            case '\f': result += "\\f"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default: result += c; break;
+
+    std::vector<JSONValue> elements;
+    elements.reserve(root.size());
+    root.forEachElement([&elements](JSONValue element) {
+        elements.push_back(element);
+    });
+    std::vector<T> items(elements.size());
+    size_t tasks = (elements.size() + ELEMENTS_PER_TASK - 1) / ELEMENTS_PER_TASK;
+    pool->parallelFor(tasks, [&elements, &items](size_t task) {
+        size_t end = std::min(elements.size(), (task + 1) * ELEMENTS_PER_TASK);
+        for (size_t i = task * ELEMENTS_PER_TASK; i < end; ++i) {
+            readJSON(elements[i], items[i]);
         }
-    }
-    return result;
+    });
+    return items;
+}
+
+} // namespace
+
+void JSONParser::setParallelDecodeThreshold(size_t bytes) {
+    parallelDecodeThreshold = bytes;
+}
+
+size_t JSONParser::getParallelDecodeThreshold() {
+    return parallelDecodeThreshold.load();
 }
 
-// Parse AuthResponse
 AuthResponse JSONParser::parseAuthResponse(const std::string& json) {
-    AuthResponse auth;
-    auth.token = extractStringValue(json, "token");
-    auth.refreshToken = extractStringValue(json, "refreshToken");
-    auth.expiresIn = extractIntValue(json, "expiresIn");
-    return auth;
+    return parseWith<AuthResponse>(json, "auth");
 }
 
-// Parse UserDetails
 UserDetails JSONParser::parseUserDetails(const std::string& json) {
-    UserDetails user;
-    user.id = extractStringValue(json, "id");
-    user.name = extractStringValue(json, "name");
-    user.email = extractOptionalStringValue(json, "email");
-    user.appleId = extractOptionalStringValue(json, "appleId");
-    user.spotifyId = extractOptionalStringValue(json, "spotifyId");
-    user.accountCreationDate = extractIntValue(json, "accountCreationDate");
-    user.profileImage = extractOptionalStringValue(json, "profileImage");
-    user.spotifyProfileImage = extractOptionalStringValue(json, "spotifyProfileImage");
-    user.playlistLocalSongsPerSeed = extractOptionalIntValue(json, "playlistLocalSongsPerSeed");
-    user.anonymousUser = extractBoolValue(json, "anonymousUser");
-    user.emailConnected = extractBoolValue(json, "emailConnected");
-    user.appleConnected = extractBoolValue(json, "appleConnected");
-    user.spotifyConnected = extractBoolValue(json, "spotifyConnected");
-    user.emailVerified = extractBoolValue(json, "emailVerified");
-    user.emailOptIn = extractBoolValue(json, "emailOptIn");
-    user.isAdmin = extractBoolValue(json, "isAdmin");
-    user.isTeamMember = extractBoolValue(json, "isTeamMember");
-    user.playlistUseSeedSongs = extractBoolValue(json, "playlistUseSeedSongs");
-    user.playlistGeneration = extractBoolValue(json, "playlistGeneration");
-    return user;
-}
-
-// Parse ArtistResponse
+    return parseWith<UserDetails>(json, "user");
+}
+
 ArtistResponse JSONParser::parseArtistResponse(const std::string& json) {
-    ArtistResponse artist;
-    artist.id = extractStringValue(json, "id");
-    artist.name = extractStringValue(json, "name");
-    artist.imageUrl = extractOptionalStringValue(json, "imageUrl");
-    artist.spotifyId = extractOptionalStringValue(json, "spotifyId");
-    artist.popularity = extractIntValue(json, "popularity");
-    artist.isFavorite = extractBoolValue(json, "isFavorite");
-    
-    // Parse genres array
-    std::string genresArray = findJsonArray(json, "genres");
-    std::vector<std::string> genreObjects = splitJsonArray(genresArray);
-    for (const std::string& genreStr : genreObjects) {
-        // Remove quotes if it's a simple string
-        std::string genre = genreStr;
-        if (genre.front() == '"' && genre.back() == '"') {
-            genre = genre.substr(1, genre.length() - 2);
-        }
-        artist.genres.push_back(genre);
-    }
-    
-    return artist;
+    return parseWith<ArtistResponse>(json, "artist");
 }
 
-// Parse EventResponse
 EventResponse JSONParser::parseEventResponse(const std::string& json) {
-    EventResponse event;
-    event.id = extractStringValue(json, "id");
-    event.name = extractStringValue(json, "name");
-    event.description = extractStringValue(json, "description");
-    event.startDate = extractStringValue(json, "startDate");
-    event.endDate = extractStringValue(json, "endDate");
-    event.imageUrl = extractOptionalStringValue(json, "imageUrl");
-    event.venueId = extractStringValue(json, "venueId");
-    event.venueName = extractStringValue(json, "venueName");
-    event.isFavorite = extractBoolValue(json, "isFavorite");
-    event.latitude = extractDoubleValue(json, "latitude");
-    event.longitude = extractDoubleValue(json, "longitude");
-    
-    // Parse artists array
-    std::string artistsArray = findJsonArray(json, "artists");
-    std::vector<std::string> artistObjects = splitJsonArray(artistsArray);
-    for (const std::string& artistJson : artistObjects) {
-        event.artists.push_back(parseArtistResponse(artistJson));
-    }
-    
-    return event;
+    return parseWith<EventResponse>(json, "event");
 }
 
-// Parse VenueResponse
 VenueResponse JSONParser::parseVenueResponse(const std::string& json) {
-    VenueResponse venue;
-    venue.id = extractStringValue(json, "id");
-    venue.name = extractStringValue(json, "name");
-    venue.address = extractStringValue(json, "address");
-    venue.city = extractStringValue(json, "city");
-    venue.state = extractStringValue(json, "state");
-    venue.country = extractStringValue(json, "country");
-    venue.latitude = extractDoubleValue(json, "latitude");
-    venue.longitude = extractDoubleValue(json, "longitude");
-    venue.imageUrl = extractOptionalStringValue(json, "imageUrl");
-    venue.isFavorite = extractBoolValue(json, "isFavorite");
-    return venue;
-}
-
-// Parse CityResponse
+    return parseWith<VenueResponse>(json, "venue");
+}
+
 CityResponse JSONParser::parseCityResponse(const std::string& json) {
-    CityResponse city;
-    city.id = extractStringValue(json, "id");
-    city.name = extractStringValue(json, "name");
-    city.state = extractStringValue(json, "state");
-    city.country = extractStringValue(json, "country");
-    city.latitude = extractDoubleValue(json, "latitude");
-    city.longitude = extractDoubleValue(json, "longitude");
-    return city;
+    return parseWith<CityResponse>(json, "city");
+}
+
+UserCity JSONParser::parseUserCity(const std::string& json) {
+    return parseWith<UserCity>(json, "user city");
 }
 
-// Parse SearchResponse
 SearchResponse JSONParser::parseSearchResponse(const std::string& json) {
-    SearchResponse search;
-    
-    // Parse artists array
-    std::string artistsArray = findJsonArray(json, "artists");
-    search.artists = parseArtistArray(artistsArray);
-    
-    // Parse events array
-    std::string eventsArray = findJsonArray(json, "events");
-    search.events = parseEventArray(eventsArray);
-    
-    // Parse venues array
-    std::string venuesArray = findJsonArray(json, "venues");
-    search.venues = parseVenueArray(venuesArray);
-    
-    // Parse cities array
-    std::string citiesArray = findJsonArray(json, "cities");
-    search.cities = parseCityArray(citiesArray);
-    
-    return search;
+    return parseWith<SearchResponse>(json, "search");
+}
+
+std::shared_ptr<LazySearchResponse> JSONParser::parseSearchResponseLazy(std::string json) {
+    return std::make_shared<LazySearchResponse>(std::move(json));
+}
+
+ErrorResponse JSONParser::parseErrorResponse(const std::string& json) {
+    return parseWith<ErrorResponse>(json, "error");
 }
 
-// Parse arrays
 std::vector<ArtistResponse> JSONParser::parseArtistArray(const std::string& json) {
-    std::vector<ArtistResponse> artists;
-    std::vector<std::string> artistObjects = splitJsonArray(json);
-    for (const std::string& artistJson : artistObjects) {
-        artists.push_back(parseArtistResponse(artistJson));
-    }
-    return artists;
+    return parseArray<ArtistResponse>(json, "artist array");
 }
 
 std::vector<EventResponse> JSONParser::parseEventArray(const std::string& json) {
-    std::vector<EventResponse> events;
-    std::vector<std::string> eventObjects = splitJsonArray(json);
-    for (const std::string& eventJson : eventObjects) {
-        events.push_back(parseEventResponse(eventJson));
-    }
-    return events;
+    return parseArray<EventResponse>(json, "event array");
 }
 
 std::vector<VenueResponse> JSONParser::parseVenueArray(const std::string& json) {
-    std::vector<VenueResponse> venues;
-    std::vector<std::string> venueObjects = splitJsonArray(json);
-    for (const std::string& venueJson : venueObjects) {
-        venues.push_back(parseVenueResponse(venueJson));
-    }
-    return venues;
+    return parseArray<VenueResponse>(json, "venue array");
 }
 
 std::vector<CityResponse> JSONParser::parseCityArray(const std::string& json) {
-    std::vector<CityResponse> cities;
-    std::vector<std::string> cityObjects = splitJsonArray(json);
-    for (const std::string& cityJson : cityObjects) {
-        cities.push_back(parseCityResponse(cityJson));
+    return parseArray<CityResponse>(json, "city array");
+}
+
+std::vector<UserCity> JSONParser::parseUserCityArray(const std::string& json) {
+    return parseArray<UserCity>(json, "user city array");
+}
+
+std::vector<std::string> JSONParser::parseStringArray(const std::string& json) {
+    return parseArray<std::string>(json, "string array");
+}
+
+ArenaSpan<ArtistView> JSONParser::parseArtistArray(std::string_view json, Arena& arena) {
+    return parseInArena<ArenaSpan<ArtistView>>(json, arena, "artist array");
+}
+
+ArenaSpan<EventView> JSONParser::parseEventArray(std::string_view json, Arena& arena) {
+    return parseInArena<ArenaSpan<EventView>>(json, arena, "event array");
+}
+
+ArenaSpan<VenueView> JSONParser::parseVenueArray(std::string_view json, Arena& arena) {
+    return parseInArena<ArenaSpan<VenueView>>(json, arena, "venue array");
+}
+
+ArenaSpan<CityView> JSONParser::parseCityArray(std::string_view json, Arena& arena) {
+    return parseInArena<ArenaSpan<CityView>>(json, arena, "city array");
+}
+
+SearchView JSONParser::parseSearchResponse(std::string_view json, Arena& arena) {
+    return parseInArena<SearchView>(json, arena, "search");
+}
+
+std::string JSONParser::serializeUserDetails(const UserDetails& user) {
+    return toJSON(user);
+}
+
+std::string JSONParser::serializeUserCity(const UserCity& userCity) {
+    return toJSON(userCity);
+}
+
+std::string JSONParser::serializeStringArray(const std::vector<std::string>& strings) {
+    return toJSON(strings);
+}
+
+LazySearchResponse::LazySearchResponse() {}
+
+LazySearchResponse::LazySearchResponse(std::string json) : body(std::move(json)) {
+    if (!tape.parse(body)) {
+        LOGE("Malformed search JSON: %s", tape.getError().c_str());
+        return;
+    }
+    // One pass over the top level finds all four categories
+    tape.root().forEachMember([this](std::string_view key, JSONValue value) {
+        if (key == "artists") {
+            artistsValue = value;
+        } else if (key == "events") {
+            eventsValue = value;
+        } else if (key == "venues") {
+            venuesValue = value;
+        } else if (key == "cities") {
+            citiesValue = value;
+        }
+    });
+}
+
+template<typename T>
+const std::vector<T>& LazySearchResponse::decode(std::once_flag& once, std::vector<T>& cache,
+                                                 JSONValue value) const {
+    std::call_once(once, [&cache, value]() {
+        readJSON(value, cache);
+    });
+    return cache;
+}
+
+const std::vector<ArtistResponse>& LazySearchResponse::artists() const {
+    return decode(artistsOnce, artistsCache, artistsValue);
+}
+
+const std::vector<EventResponse>& LazySearchResponse::events() const {
+    return decode(eventsOnce, eventsCache, eventsValue);
+}
+
+const std::vector<VenueResponse>& LazySearchResponse::venues() const {
+    return decode(venuesOnce, venuesCache, venuesValue);
+}
+
+const std::vector<CityResponse>& LazySearchResponse::cities() const {
+    return decode(citiesOnce, citiesCache, citiesValue);
+}
+
+SearchResponse LazySearchResponse::toSearchResponse() const {
+    SearchResponse search;
+    search.artists = artists();
+    search.events = events();
+    search.venues = venues();
+    search.cities = cities();
+    return search;
+}
+
+JSONArrayStream::JSONArrayStream(ElementHandler onElement)
+    : onElement(std::move(onElement)), state(State::BEFORE_ARRAY), depth(0), elementCount(0) {}
+
+void JSONArrayStream::flushElement() {
+    // Scalars end at the delimiter, so they may carry trailing whitespace
+    size_t end = element.find_last_not_of(" \t\r\n");
+    element.resize(end == std::string::npos ? 0 : end + 1);
+    ++elementCount;
+    onElement(std::move(element));
+    element = std::string();
+    state = State::AFTER_ELEMENT;
+}
+
+bool JSONArrayStream::feed(const char* data, size_t length) {
+    if (state == State::DONE || state == State::MALFORMED) {
+        return state == State::DONE;
+    }
+    structurals.clear();
+    indexer.index(data, length, 0, structurals);
+
+    size_t next = 0;            // first structural not yet visited
+    size_t segmentStart = 0;
+    size_t i = 0;
+    while (i < length) {
+        switch (state) {
+            case State::BEFORE_ARRAY:
+                if (data[i] == '[') {
+                    state = State::BEFORE_ELEMENT;
+                } else if (!isspace(static_cast<unsigned char>(data[i]))) {
+                    state = State::MALFORMED;
+                    return false;
+                }
+                ++i;
+                break;
+
+            case State::BEFORE_ELEMENT:
+                if (isspace(static_cast<unsigned char>(data[i]))) {
+                    ++i;
+                } else if (data[i] == ']' && elementCount == 0) {
+                    state = State::DONE;
+                    return true;
+                } else if (data[i] == ',' || data[i] == ']' || data[i] == '}') {
+                    state = State::MALFORMED;
+                    return false;
+                } else {
+                    state = State::IN_ELEMENT;
+                    segmentStart = i;
+                    depth = 0;
+                }
+                break;
+
+            case State::AFTER_ELEMENT:
+                if (data[i] == ']') {
+                    state = State::DONE;
+                    return true;
+                }
+                if (data[i] == ',') {
+                    state = State::BEFORE_ELEMENT;
+                } else if (!isspace(static_cast<unsigned char>(data[i]))) {
+                    state = State::MALFORMED;
+                    return false;
+                }
+                ++i;
+                break;
+
+            case State::IN_ELEMENT: {
+                // Jump straight to the next bracket or comma outside a string
+                while (next < structurals.size() && structurals[next] < i) {
+                    ++next;
+                }
+                if (next == structurals.size()) {
+                    i = length;
+                    break;
+                }
+                size_t at = structurals[next++];
+                char c = data[at];
+                i = at + 1;
+                if (c == '{' || c == '[') {
+                    ++depth;
+                } else if (c == '}' || c == ']') {
+                    if (depth == 0) {
+                        // End of the array after a scalar element
+                        if (c == '}') {
+                            state = State::MALFORMED;
+                            return false;
+                        }
+                        element.append(data + segmentStart, at - segmentStart);
+                        flushElement();
+                        state = State::DONE;
+                        return true;
+                    }
+                    if (--depth == 0) {
+                        element.append(data + segmentStart, at + 1 - segmentStart);
+                        flushElement();
+                    }
+                } else if (c == ',' && depth == 0) {
+                    element.append(data + segmentStart, at - segmentStart);
+                    flushElement();
+                    state = State::BEFORE_ELEMENT;
+                }
+                break;
+            }
+
+            case State::DONE:
+            case State::MALFORMED:
+                return state == State::DONE;
+        }
+    }
+
+    // Keep the partial element for the next piece
+    if (state == State::IN_ELEMENT) {
+        element.append(data + segmentStart, length - segmentStart);
     }
-    return cities;
+    return true;
 }
 
 } // namespace localify
@@ -0,0 +1,225 @@
+#include "json_scan.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOCALIFY_SCAN_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define LOCALIFY_SCAN_NEON 1
+#endif
+
+namespace localify {
+
+namespace {
+
+const size_t BLOCK = 64;
+
+// One bit per byte of a 64-byte block
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;        // { } [ ] , :
+};
+
+[[maybe_unused]] BlockMasks classifyPortable(const char* block) {
+    BlockMasks masks = {0, 0, 0};
+    for (size_t i = 0; i < BLOCK; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+            case '"': masks.quote |= bit; break;
+            case '\\': masks.backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ',': case ':': masks.op |= bit; break;
+            default: break;
+        }
+    }
+    return masks;
+}
+
+#if LOCALIFY_SCAN_X86
+
+// '[' and ']' differ from '{' and '}' only in bit 5, so setting it folds
+// the four brackets into two comparisons
+
+__attribute__((target("sse2")))
+BlockMasks classifySse2(const char* block) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i colon = _mm_set1_epi8(':');
+
+    BlockMasks masks = {0, 0, 0};
+    for (size_t i = 0; i < BLOCK; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        __m128i folded = _mm_or_si128(bytes, caseBit);
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, colon)));
+        masks.quote |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)))) << i;
+        masks.backslash |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash)))) << i;
+        masks.op |= uint64_t(uint32_t(_mm_movemask_epi8(op))) << i;
+    }
+    return masks;
+}
+
+__attribute__((target("avx2")))
+BlockMasks classifyAvx2(const char* block) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i colon = _mm256_set1_epi8(':');
+
+    BlockMasks masks = {0, 0, 0};
+    for (size_t i = 0; i < BLOCK; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        __m256i folded = _mm256_or_si256(bytes, caseBit);
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, comma), _mm256_cmpeq_epi8(bytes, colon)));
+        masks.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote)))) << i;
+        masks.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, backslash)))) << i;
+        masks.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << i;
+    }
+    return masks;
+}
+
+#elif LOCALIFY_SCAN_NEON
+
+// NEON has no movemask: weight each lane's match by its bit, then three
+// rounds of pairwise adds pack four 16-byte comparisons into 64 bits
+inline uint64_t movemask64(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) {
+    const uint8x16_t weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, weights), vandq_u8(m1, weights));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, weights), vandq_u8(m3, weights));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+BlockMasks classifyNeon(const char* block) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(block);
+    uint8x16_t in[4] = {vld1q_u8(bytes), vld1q_u8(bytes + 16), vld1q_u8(bytes + 32), vld1q_u8(bytes + 48)};
+    uint8x16_t quote[4], backslash[4], op[4];
+    for (int i = 0; i < 4; ++i) {
+        uint8x16_t folded = vorrq_u8(in[i], vdupq_n_u8(0x20));
+        quote[i] = vceqq_u8(in[i], vdupq_n_u8('"'));
+        backslash[i] = vceqq_u8(in[i], vdupq_n_u8('\\'));
+        op[i] = vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+                         vorrq_u8(vceqq_u8(in[i], vdupq_n_u8(',')), vceqq_u8(in[i], vdupq_n_u8(':'))));
+    }
+    BlockMasks masks;
+    masks.quote = movemask64(quote[0], quote[1], quote[2], quote[3]);
+    masks.backslash = movemask64(backslash[0], backslash[1], backslash[2], backslash[3]);
+    masks.op = movemask64(op[0], op[1], op[2], op[3]);
+    return masks;
+}
+
+#endif
+
+using Classifier = BlockMasks (*)(const char*);
+
+struct Implementation {
+    Classifier classify;
+    const char* name;
+};
+
+Implementation selectImplementation() {
+#if LOCALIFY_SCAN_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return {classifyAvx2, "avx2"};
+    }
+    return {classifySse2, "sse2"};
+#elif LOCALIFY_SCAN_NEON
+    return {classifyNeon, "neon"};
+#else
+    return {classifyPortable, "portable"};
+#endif
+}
+
+const Implementation& active() {
+    static const Implementation selected = selectImplementation();
+    return selected;
+}
+
+// Bytes preceded by an odd run of backslashes. carry says whether the
+// previous block ended in one and is updated for the next block.
+inline uint64_t findEscaped(uint64_t backslash, uint64_t& carry) {
+    const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+    backslash &= ~carry;
+    uint64_t followsEscape = (backslash << 1) | carry;
+    uint64_t oddSequenceStarts = backslash & ~EVEN_BITS & ~followsEscape;
+    uint64_t sequencesStartingOnEvenBits;
+    carry = __builtin_add_overflow(oddSequenceStarts, backslash, &sequencesStartingOnEvenBits) ? 1 : 0;
+    uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (EVEN_BITS ^ invertMask) & followsEscape;
+}
+
+// Bit i becomes the parity of bits 0..i: set from an opening quote up to,
+// but not including, its closing quote
+inline uint64_t prefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+} // namespace
+
+void JSONStructuralIndexer::reset() {
+    previousEscaped = 0;
+    previousInString = 0;
+}
+
+const char* JSONStructuralIndexer::implementation() {
+    return active().name;
+}
+
+uint64_t JSONStructuralIndexer::indexBlock(const char* block, uint32_t base, std::vector<uint32_t>& positions) {
+    BlockMasks masks = active().classify(block);
+    uint64_t escaped = findEscaped(masks.backslash, previousEscaped);
+    uint64_t quotes = masks.quote & ~escaped;
+    uint64_t inString = prefixXor(quotes) ^ previousInString;
+    previousInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+    uint64_t structural = (masks.op & ~inString) | quotes;
+
+    size_t count = static_cast<size_t>(__builtin_popcountll(structural));
+    size_t at = positions.size();
+    positions.resize(at + count);
+    uint32_t* out = positions.data() + at;
+    while (structural != 0) {
+        *out++ = base + static_cast<uint32_t>(__builtin_ctzll(structural));
+        structural &= structural - 1;
+    }
+    return escaped;
+}
+
+void JSONStructuralIndexer::index(const char* data, size_t length, uint32_t base, std::vector<uint32_t>& positions) {
+    size_t offset = 0;
+    for (; offset + BLOCK <= length; offset += BLOCK) {
+        indexBlock(data + offset, base + static_cast<uint32_t>(offset), positions);
+    }
+    if (offset == length) {
+        return;
+    }
+
+    // Pad the tail with spaces, which are never structural. Escape state
+    // for the next piece comes from the first padding byte: it is escaped
+    // exactly when the real input ends in an odd run of backslashes.
+    size_t tail = length - offset;
+    char block[BLOCK];
+    memset(block, ' ', BLOCK);
+    memcpy(block, data + offset, tail);
+    uint64_t escaped = indexBlock(block, base + static_cast<uint32_t>(offset), positions);
+    previousEscaped = (escaped >> tail) & 1;
+}
+
+} // namespace localify
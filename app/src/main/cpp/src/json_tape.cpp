@@ -0,0 +1,469 @@
+#include "json_tape.h"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace localify {
+
+namespace {
+
+inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Tapes bigger than this are freed when their thread next asks for its
+// scratch tape instead of staying allocated until the thread exits
+const size_t SCRATCH_RETAINED_CAPACITY = 1024 * 1024;
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// End of the number starting at i, or i if none starts there. RFC 8259:
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+size_t scanNumber(const char* data, size_t size, size_t i) {
+    size_t start = i;
+    if (i < size && data[i] == '-') {
+        ++i;
+    }
+    if (i < size && data[i] == '0') {
+        ++i;
+    } else if (i < size && isDigit(data[i])) {
+        while (i < size && isDigit(data[i])) {
+            ++i;
+        }
+    } else {
+        return start;
+    }
+    if (i < size && data[i] == '.') {
+        if (++i == size || !isDigit(data[i])) {
+            return start;
+        }
+        while (i < size && isDigit(data[i])) {
+            ++i;
+        }
+    }
+    if (i < size && (data[i] == 'e' || data[i] == 'E')) {
+        if (++i < size && (data[i] == '+' || data[i] == '-')) {
+            ++i;
+        }
+        if (i == size || !isDigit(data[i])) {
+            return start;
+        }
+        while (i < size && isDigit(data[i])) {
+            ++i;
+        }
+    }
+    return i;
+}
+
+// RFC 8259 requires U+0000 through U+001F to be escaped inside strings.
+// Branch-free so the compiler can check a whole string a vector at a time.
+bool hasControlCharacter(const char* text, size_t length) {
+    unsigned char found = 0;
+    for (size_t k = 0; k < length; ++k) {
+        found |= static_cast<unsigned char>(text[k]) < 0x20;
+    }
+    return found != 0;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(std::string_view raw, size_t at, uint32_t& value) {
+    if (at + 4 > raw.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = at; i < at + 4; ++i) {
+        int digit = hexValue(raw[i]);
+        if (digit < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+// Returns the byte after the last one written
+char* writeUtf8(char* out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        *out++ = static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    return out;
+}
+
+} // namespace
+
+JSONTape& JSONTape::scratch() {
+    static thread_local JSONTape tape;
+    if (tape.tokens.capacity() * sizeof(JSONToken) > SCRATCH_RETAINED_CAPACITY) {
+        std::vector<JSONToken>().swap(tape.tokens);
+    }
+    return tape;
+}
+
+size_t JSONTape::getRetainedBytes() const {
+    return tokens.capacity() * sizeof(JSONToken) + open.capacity() * sizeof(uint32_t);
+}
+
+bool JSONTape::fail(const char* message, size_t position) {
+    error = std::string(message) + " at offset " + std::to_string(position);
+    tokens.clear();
+    return false;
+}
+
+bool JSONTape::parse(std::string_view json) {
+    source = json;
+    tokens.clear();
+    open.clear();
+    error.clear();
+    if (json.size() >= std::numeric_limits<uint32_t>::max()) {
+        return fail("Document too large", 0);
+    }
+
+    // What the grammar allows next
+    enum class Expect { VALUE, VALUE_OR_CLOSE, KEY, KEY_OR_CLOSE, COLON, COMMA_OR_CLOSE, END };
+    Expect expect = Expect::VALUE;
+
+    const char* data = json.data();
+    size_t size = json.size();
+    size_t i = 0;
+
+    // A value just finished: the enclosing container wants a separator
+    auto afterValue = [&]() {
+        expect = open.empty() ? Expect::END : Expect::COMMA_OR_CLOSE;
+    };
+    auto push = [&](JSONType type, bool escaped, size_t offset, size_t length) {
+        JSONToken token;
+        token.type = type;
+        token.escaped = escaped;
+        token.offset = static_cast<uint32_t>(offset);
+        token.length = static_cast<uint32_t>(length);
+        token.next = static_cast<uint32_t>(tokens.size() + 1);
+        tokens.push_back(token);
+    };
+    auto close = [&]() {
+        tokens[open.back()].next = static_cast<uint32_t>(tokens.size());
+        open.pop_back();
+        ++i;
+        afterValue();
+    };
+    // Scans the string starting at the quote at i; leaves i past the closing
+    // quote, or returns what is wrong with it
+    auto scanString = [&]() -> const char* {
+        size_t start = i + 1;
+        size_t j = start;
+        bool escaped = false;
+        while (true) {
+            const void* stop = memchr(data + j, '"', size - j);
+            if (stop == nullptr) {
+                return "Unterminated string";
+            }
+            size_t quote = static_cast<const char*>(stop) - data;
+            // A quote preceded by an odd run of backslashes is escaped
+            size_t backslashes = 0;
+            while (quote - backslashes > start && data[quote - backslashes - 1] == '\\') {
+                ++backslashes;
+            }
+            if (backslashes > 0) {
+                escaped = true;
+            }
+            if (backslashes % 2 == 0) {
+                if (!escaped && memchr(data + start, '\\', quote - start) != nullptr) {
+                    escaped = true;
+                }
+                if (hasControlCharacter(data + start, quote - start)) {
+                    return "Unescaped control character in string";
+                }
+                push(JSONType::STRING, escaped, start, quote - start);
+                i = quote + 1;
+                return nullptr;
+            }
+            j = quote + 1;
+        }
+    };
+
+    while (true) {
+        while (i < size && isWhitespace(data[i])) {
+            ++i;
+        }
+        if (i == size) {
+            break;
+        }
+        char c = data[i];
+
+        switch (expect) {
+            case Expect::KEY_OR_CLOSE:
+                if (c == '}') {
+                    close();
+                    break;
+                }
+                // fall through
+            case Expect::KEY:
+                if (c != '"') {
+                    return fail("Expected object key", i);
+                }
+                tokens[open.back()].length++;
+                if (const char* problem = scanString()) {
+                    return fail(problem, i);
+                }
+                expect = Expect::COLON;
+                break;
+
+            case Expect::COLON:
+                if (c != ':') {
+                    return fail("Expected ':'", i);
+                }
+                ++i;
+                expect = Expect::VALUE;
+                break;
+
+            case Expect::COMMA_OR_CLOSE: {
+                bool inObject = tokens[open.back()].type == JSONType::OBJECT;
+                if (c == ',') {
+                    ++i;
+                    expect = inObject ? Expect::KEY : Expect::VALUE;
+                } else if (c == (inObject ? '}' : ']')) {
+                    close();
+                } else {
+                    return fail("Expected ',' or closing bracket", i);
+                }
+                break;
+            }
+
+            case Expect::VALUE_OR_CLOSE:
+                if (c == ']') {
+                    close();
+                    break;
+                }
+                // fall through
+            case Expect::VALUE:
+                if (!open.empty() && tokens[open.back()].type == JSONType::ARRAY) {
+                    tokens[open.back()].length++;
+                }
+                if (c == '{' || c == '[') {
+                    open.push_back(static_cast<uint32_t>(tokens.size()));
+                    push(c == '{' ? JSONType::OBJECT : JSONType::ARRAY, false, i, 0);
+                    ++i;
+                    expect = c == '{' ? Expect::KEY_OR_CLOSE : Expect::VALUE_OR_CLOSE;
+                } else if (c == '"') {
+                    if (const char* problem = scanString()) {
+                        return fail(problem, i);
+                    }
+                    afterValue();
+                } else if (c == '-' || isDigit(c)) {
+                    // Whatever follows the number must fit the grammar, so
+                    // "1-2" fails on the '-' as "1 2" would on the '2'
+                    size_t end = scanNumber(data, size, i);
+                    if (end == i) {
+                        return fail("Malformed number", i);
+                    }
+                    push(JSONType::NUMBER, false, i, end - i);
+                    i = end;
+                    afterValue();
+                } else if (json.compare(i, 4, "true") == 0) {
+                    push(JSONType::TRUE, false, i, 4);
+                    i += 4;
+                    afterValue();
+                } else if (json.compare(i, 5, "false") == 0) {
+                    push(JSONType::FALSE, false, i, 5);
+                    i += 5;
+                    afterValue();
+                } else if (json.compare(i, 4, "null") == 0) {
+                    push(JSONType::NUL, false, i, 4);
+                    i += 4;
+                    afterValue();
+                } else {
+                    return fail("Unexpected character", i);
+                }
+                break;
+
+            case Expect::END:
+                return fail("Unexpected data after document", i);
+        }
+    }
+
+    if (expect != Expect::END) {
+        return fail("Unexpected end of document", size);
+    }
+    return true;
+}
+
+std::string JSONTape::unescape(std::string_view raw) {
+    std::string out(raw.size(), '\0');
+    out.resize(unescape(raw, &out[0]));
+    return out;
+}
+
+size_t JSONTape::unescape(std::string_view raw, char* out) {
+    char* start = out;
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\' || i + 1 == raw.size()) {
+            *out++ = c;
+            continue;
+        }
+        char escape = raw[++i];
+        switch (escape) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t codePoint;
+                if (!readHex4(raw, i + 1, codePoint)) {
+                    *out++ = escape;
+                    break;
+                }
+                i += 4;
+                // Characters outside the BMP arrive as a surrogate pair
+                uint32_t low;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 2 < raw.size() &&
+                    raw[i + 1] == '\\' && raw[i + 2] == 'u' && readHex4(raw, i + 3, low) &&
+                    low >= 0xDC00 && low <= 0xDFFF) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                out = writeUtf8(out, codePoint);
+                break;
+            }
+            default:
+                *out++ = escape;   // \" \\ \/ and anything unknown
+                break;
+        }
+    }
+    return static_cast<size_t>(out - start);
+}
+
+size_t JSONValue::size() const {
+    if (!isValid() || (type() != JSONType::OBJECT && type() != JSONType::ARRAY)) {
+        return 0;
+    }
+    return token().length;
+}
+
+std::string_view JSONValue::raw() const {
+    if (!isValid()) {
+        return std::string_view();
+    }
+    const JSONToken& value = token();
+    return tape->source.substr(value.offset, value.length);
+}
+
+std::string JSONValue::asString() const {
+    if (!isString()) {
+        return std::string();
+    }
+    return token().escaped ? JSONTape::unescape(raw()) : std::string(raw());
+}
+
+std::string_view JSONValue::asStringView(std::string& scratch) const {
+    if (!isString()) {
+        return std::string_view();
+    }
+    if (!token().escaped) {
+        return raw();
+    }
+    scratch = JSONTape::unescape(raw());
+    return scratch;
+}
+
+std::optional<std::string> JSONValue::asOptionalString() const {
+    if (!isString()) {
+        return std::nullopt;
+    }
+    return asString();
+}
+
+namespace {
+template<typename T>
+T parseInteger(std::string_view text, T fallback) {
+    T value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() ? value : fallback;
+}
+}
+
+int JSONValue::asInt(int fallback) const {
+    if (!isValid() || type() != JSONType::NUMBER) {
+        return fallback;
+    }
+    return parseInteger(raw(), fallback);
+}
+
+int64_t JSONValue::asInt64(int64_t fallback) const {
+    if (!isValid() || type() != JSONType::NUMBER) {
+        return fallback;
+    }
+    return parseInteger(raw(), fallback);
+}
+
+std::optional<int> JSONValue::asOptionalInt() const {
+    if (!isValid() || type() != JSONType::NUMBER) {
+        return std::nullopt;
+    }
+    return asInt();
+}
+
+double JSONValue::asDouble(double fallback) const {
+    if (!isValid() || type() != JSONType::NUMBER) {
+        return fallback;
+    }
+    // strtod needs a terminator; number lexemes are short
+    std::string_view text = raw();
+    char buffer[64];
+    if (text.size() >= sizeof(buffer)) {
+        return fallback;
+    }
+    memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+    char* end = nullptr;
+    double value = strtod(buffer, &end);
+    // Lexemes like 1e999 overflow to infinity, which JSON cannot carry back
+    return end == buffer || !std::isfinite(value) ? fallback : value;
+}
+
+bool JSONValue::asBool(bool fallback) const {
+    if (!isValid()) {
+        return fallback;
+    }
+    if (type() == JSONType::TRUE) {
+        return true;
+    }
+    if (type() == JSONType::FALSE) {
+        return false;
+    }
+    return fallback;
+}
+
+JSONValue JSONValue::operator[](std::string_view key) const {
+    JSONValue found;
+    forEachMember([&found, key](std::string_view name, JSONValue value) {
+        if (!found.isValid() && name == key) {
+            found = value;
+        }
+    });
+    return found;
+}
+
+} // namespace localify
@@ -0,0 +1,215 @@
+#include "json_writer.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Floating-point to_chars arrived in libc++ 14 (NDK r25) and libstdc++ 11
+#if defined(__cpp_lib_to_chars) || (defined(_LIBCPP_VERSION) && _LIBCPP_VERSION >= 14000)
+#define LOCALIFY_HAS_FLOAT_TO_CHARS 1
+#endif
+
+namespace localify {
+
+namespace {
+// A thread's scratch writer gives back anything larger once it is reused,
+// so one big response does not pin memory for the life of the thread
+const size_t SCRATCH_RETAINED_CAPACITY = 1024 * 1024;
+
+const char HEX[] = "0123456789abcdef";
+
+void appendUnicodeEscape(std::string& out, uint32_t unit) {
+    char escape[6] = {'\\', 'u', HEX[(unit >> 12) & 0xF], HEX[(unit >> 8) & 0xF],
+                      HEX[(unit >> 4) & 0xF], HEX[unit & 0xF]};
+    out.append(escape, sizeof(escape));
+}
+
+// Length of the well-formed UTF-8 sequence whose lead byte (0x80 or above)
+// is text[i], or 0 if it is malformed: a stray continuation byte, an
+// overlong form, an encoded surrogate, a code point past U+10FFFF or a
+// truncated sequence. Then malformedLength is the number of bytes one
+// replacement character stands for, the lead plus any continuation bytes
+// that still fit it.
+size_t sequenceLength(std::string_view text, size_t i, size_t& malformedLength) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t length;
+    // Allowed range of the first continuation byte; the rest are 80..BF
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        malformedLength = 1;
+        return 0;
+    }
+    for (size_t k = 1; k < length; ++k) {
+        unsigned char c = i + k < text.size() ? static_cast<unsigned char>(text[i + k]) : 0;
+        if (c < low || c > high) {
+            malformedLength = k;
+            return 0;
+        }
+        low = 0x80;
+        high = 0xBF;
+    }
+    return length;
+}
+}
+
+JSONWriter::JSONWriter(size_t capacity) : needsComma(false), escapeSupplementary(false) {
+    buffer.reserve(capacity);
+}
+
+void JSONWriter::clear() {
+    buffer.clear();
+    needsComma = false;
+}
+
+JSONWriter& JSONWriter::scratch() {
+    static thread_local JSONWriter writer;
+    if (writer.buffer.capacity() > SCRATCH_RETAINED_CAPACITY) {
+        std::string().swap(writer.buffer);
+    }
+    writer.clear();
+    writer.escapeSupplementary = false;
+    return writer;
+}
+
+void JSONWriter::beginObject() {
+    separate();
+    buffer += '{';
+}
+
+void JSONWriter::endObject() {
+    buffer += '}';
+    needsComma = true;
+}
+
+void JSONWriter::beginArray() {
+    separate();
+    buffer += '[';
+}
+
+void JSONWriter::endArray() {
+    buffer += ']';
+    needsComma = true;
+}
+
+void JSONWriter::key(std::string_view name) {
+    separate();
+    appendString(name);
+    buffer += ':';
+}
+
+void JSONWriter::value(std::string_view text) {
+    separate();
+    appendString(text);
+    needsComma = true;
+}
+
+void JSONWriter::value(bool flag) {
+    separate();
+    buffer += flag ? "true" : "false";
+    needsComma = true;
+}
+
+void JSONWriter::null() {
+    separate();
+    buffer += "null";
+    needsComma = true;
+}
+
+void JSONWriter::appendInteger(long long number) {
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    buffer.append(digits, result.ptr - digits);
+    needsComma = true;
+}
+
+void JSONWriter::value(double number) {
+    if (!std::isfinite(number)) {
+        null();
+        return;
+    }
+    separate();
+    char digits[32];
+#if LOCALIFY_HAS_FLOAT_TO_CHARS
+    // Shortest text that reads back to the same double
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    buffer.append(digits, result.ptr - digits);
+#else
+    // 15 digits keeps coordinates like 40.7 tidy; fall back to 17 when
+    // that would not read back to the same double
+    int length = snprintf(digits, sizeof(digits), "%.15g", number);
+    if (strtod(digits, nullptr) != number) {
+        length = snprintf(digits, sizeof(digits), "%.17g", number);
+    }
+    buffer.append(digits, static_cast<size_t>(length));
+#endif
+    needsComma = true;
+}
+
+void JSONWriter::appendString(std::string_view text) {
+    buffer += '"';
+    // Text for Java has every non-ASCII sequence checked; otherwise bytes
+    // from 0x80 up pass through untouched
+    unsigned limit = escapeSupplementary ? 0x80 : 0x100;
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\' && c < limit) {
+            continue;
+        }
+        size_t length = 0;
+        size_t malformedLength = 1;
+        if (c >= limit) {
+            length = sequenceLength(text, i, malformedLength);
+            // Two- and three-byte sequences are the same in modified UTF-8
+            if (length == 2 || length == 3) {
+                i += length - 1;
+                continue;
+            }
+        }
+        // Copy the plain run before this byte in one go
+        buffer.append(text.data() + runStart, i - runStart);
+        switch (c) {
+            case '"': buffer += "\\\""; break;
+            case '\\': buffer += "\\\\"; break;
+            case '\b': buffer += "\\b"; break;
+            case '\f': buffer += "\\f"; break;
+            case '\n': buffer += "\\n"; break;
+            case '\r': buffer += "\\r"; break;
+            case '\t': buffer += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    appendUnicodeEscape(buffer, c);
+                } else if (length == 4) {
+                    uint32_t codePoint = (uint32_t(c & 0x07) << 18) | (uint32_t(text[i + 1] & 0x3F) << 12) |
+                                         (uint32_t(text[i + 2] & 0x3F) << 6) | uint32_t(text[i + 3] & 0x3F);
+                    codePoint -= 0x10000;
+                    appendUnicodeEscape(buffer, 0xD800 + (codePoint >> 10));
+                    appendUnicodeEscape(buffer, 0xDC00 + (codePoint & 0x3FF));
+                    i += 3;
+                } else {
+                    // Malformed; Java would reject the raw bytes, so send
+                    // one replacement character for them
+                    appendUnicodeEscape(buffer, 0xFFFD);
+                    i += malformedLength - 1;
+                }
+                break;
+        }
+        runStart = i + 1;
+    }
+    buffer.append(text.data() + runStart, text.size() - runStart);
+    buffer += '"';
+}
+
+} // namespace localify
@@ -23,26 +23,22 @@ void MapScreen::initialize() {
     centerY = screenHeight / 2.0f;
     
     // Create back button
-    backButton = std::make_unique<Button>(
+    backButton = addComponent(std::make_unique<Button>(
         Rect(20.0f, 20.0f, 80.0f, 50.0f),
         "Back"
-    );
+    ));
     backButton->setBackgroundColor(Color::Gray());
     backButton->setTextColor(Color::White());
     backButton->setOnClick([this]() { onBack(); });
     
     // Create confirm button
-    confirmButton = std::make_unique<Button>(
+    confirmButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth - 120.0f, 20.0f, 100.0f, 50.0f),
         "Confirm"
-    );
+    ));
     confirmButton->setBackgroundColor(Color::LocalifyPink());
     confirmButton->setTextColor(Color::White());
     confirmButton->setOnClick([this]() { onConfirm(); });
-    
-    // Add components
-    addComponent(std::move(backButton));
-    addComponent(std::move(confirmButton));
 }
 
 void MapScreen::draw() {
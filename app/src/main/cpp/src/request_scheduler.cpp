@@ -0,0 +1,290 @@
+#include "request_scheduler.h"
+#include <android/log.h>
+#include <algorithm>
+#include <vector>
+
+#define LOG_TAG "LocalifyScheduler"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+std::shared_ptr<PriorityToken> PriorityToken::create(RequestPriority priority) {
+    return std::shared_ptr<PriorityToken>(new PriorityToken(priority));
+}
+
+void PriorityToken::set(RequestPriority value) {
+    change(value, false);
+}
+
+void PriorityToken::raise(RequestPriority value) {
+    change(value, true);
+}
+
+void PriorityToken::change(RequestPriority value, bool raiseOnly) {
+    std::vector<Callback> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        RequestPriority current = priority.load();
+        if (current == value || (raiseOnly && current > value)) {
+            return;
+        }
+        priority.store(value);
+        for (auto& entry : callbacks) {
+            pending.push_back(entry.second);
+        }
+    }
+    for (auto& callback : pending) {
+        callback();
+    }
+}
+
+uint64_t PriorityToken::subscribe(Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t id = nextId++;
+    callbacks[id] = std::move(callback);
+    return id;
+}
+
+void PriorityToken::unsubscribe(uint64_t id) {
+    if (id == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    callbacks.erase(id);
+}
+
+RequestScheduler::RequestScheduler(size_t maxPerHost, size_t maxBackgroundPerHost)
+    : maxPerHost(1), maxBackgroundPerHost(1), nextId(1) {
+    setLimits(maxPerHost, maxBackgroundPerHost);
+}
+
+RequestPriority RequestScheduler::priorityOf(const Pending& pending) {
+    return pending.priority ? pending.priority->get() : RequestPriority::NORMAL;
+}
+
+void RequestScheduler::submit(const std::string& host, std::shared_ptr<PriorityToken> priority,
+                              std::shared_ptr<CancellationToken> cancellation,
+                              StartFunction start, std::function<void()> cancelled) {
+    auto pending = std::make_shared<Pending>();
+    pending->host = host;
+    pending->priority = std::move(priority);
+    pending->cancellation = std::move(cancellation);
+    pending->start = std::move(start);
+    pending->cancelled = std::move(cancelled);
+    pending->prioritySubscription = 0;
+    pending->cancelSubscription = 0;
+    pending->queued = true;
+
+    std::list<PendingPtr> ready;
+    bool waiting;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending->id = nextId++;
+        hosts[host].waiting.push_back(pending);
+        stats.waiting++;
+        takeRunnableLocked(host, ready);
+        waiting = pending->queued;
+        if (waiting) {
+            stats.delayed++;
+            stats.peakWaiting = std::max(stats.peakWaiting, stats.waiting);
+        }
+    }
+    launch(ready);
+    if (!waiting) {
+        return;
+    }
+
+    // Only queued requests need to hear about priority changes and
+    // cancellation; either may fire before subscribe() returns
+    uint64_t id = pending->id;
+    uint64_t prioritySubscription = 0;
+    uint64_t cancelSubscription = 0;
+    if (pending->priority) {
+        prioritySubscription = pending->priority->subscribe([this, host, id]() { onPriorityChanged(host, id); });
+    }
+    if (pending->cancellation) {
+        cancelSubscription = pending->cancellation->subscribe([this, host, id]() { onCancelled(host, id); });
+    }
+
+    bool stillQueued;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stillQueued = pending->queued;
+        if (stillQueued) {
+            pending->prioritySubscription = prioritySubscription;
+            pending->cancelSubscription = cancelSubscription;
+        }
+    }
+    if (!stillQueued) {
+        if (pending->priority) {
+            pending->priority->unsubscribe(prioritySubscription);
+        }
+        if (pending->cancellation) {
+            pending->cancellation->unsubscribe(cancelSubscription);
+        }
+    }
+}
+
+void RequestScheduler::takeRunnableLocked(const std::string& host, std::list<PendingPtr>& ready) {
+    auto it = hosts.find(host);
+    if (it == hosts.end()) {
+        return;
+    }
+    HostState& state = it->second;
+
+    while (state.active < maxPerHost && !state.waiting.empty()) {
+        // Highest priority that may start; the list is in submission order,
+        // so the first one found wins ties
+        auto best = state.waiting.end();
+        RequestPriority bestPriority = RequestPriority::BACKGROUND;
+        for (auto candidate = state.waiting.begin(); candidate != state.waiting.end(); ++candidate) {
+            RequestPriority priority = priorityOf(**candidate);
+            if (priority == RequestPriority::BACKGROUND && state.activeBackground >= maxBackgroundPerHost) {
+                continue;
+            }
+            if (best == state.waiting.end() || priority > bestPriority) {
+                best = candidate;
+                bestPriority = priority;
+            }
+        }
+        if (best == state.waiting.end()) {
+            break;
+        }
+
+        PendingPtr pending = *best;
+        state.waiting.erase(best);
+        pending->queued = false;
+
+        bool background = bestPriority == RequestPriority::BACKGROUND;
+        state.active++;
+        if (background) {
+            state.activeBackground++;
+        }
+        running[pending->id] = Running{host, background};
+        stats.dispatched++;
+        stats.waiting--;
+        ready.push_back(pending);
+    }
+}
+
+void RequestScheduler::launch(std::list<PendingPtr>& ready) {
+    for (PendingPtr& pending : ready) {
+        uint64_t prioritySubscription;
+        uint64_t cancelSubscription;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            prioritySubscription = pending->prioritySubscription;
+            cancelSubscription = pending->cancelSubscription;
+            pending->prioritySubscription = 0;
+            pending->cancelSubscription = 0;
+        }
+        if (pending->priority) {
+            pending->priority->unsubscribe(prioritySubscription);
+        }
+        if (pending->cancellation) {
+            pending->cancellation->unsubscribe(cancelSubscription);
+        }
+        pending->start(pending->id);
+    }
+}
+
+void RequestScheduler::finished(uint64_t ticket) {
+    std::list<PendingPtr> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = running.find(ticket);
+        if (it == running.end()) {
+            return;
+        }
+        std::string host = it->second.host;
+        HostState& state = hosts[host];
+        state.active--;
+        if (it->second.background) {
+            state.activeBackground--;
+        }
+        running.erase(it);
+
+        takeRunnableLocked(host, ready);
+        if (state.active == 0 && state.waiting.empty()) {
+            hosts.erase(host);
+        }
+    }
+    launch(ready);
+}
+
+void RequestScheduler::onPriorityChanged(const std::string& host, uint64_t id) {
+    std::list<PendingPtr> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = hosts.find(host);
+        if (it == hosts.end()) {
+            return;
+        }
+        std::list<PendingPtr>& waiting = it->second.waiting;
+        bool found = std::any_of(waiting.begin(), waiting.end(),
+                                 [id](const PendingPtr& pending) { return pending->id == id; });
+        if (!found) {
+            return;
+        }
+        // Ordering is read at dispatch time; a change can only matter now if
+        // it lifts a request out of the capped background class
+        stats.reprioritised++;
+        takeRunnableLocked(host, ready);
+    }
+    launch(ready);
+}
+
+void RequestScheduler::onCancelled(const std::string& host, uint64_t id) {
+    PendingPtr cancelled;
+    uint64_t prioritySubscription;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = hosts.find(host);
+        if (it == hosts.end()) {
+            return;
+        }
+        HostState& state = it->second;
+        auto entry = std::find_if(state.waiting.begin(), state.waiting.end(),
+                                  [id](const PendingPtr& pending) { return pending->id == id; });
+        if (entry == state.waiting.end()) {
+            return;
+        }
+        cancelled = *entry;
+        state.waiting.erase(entry);
+        cancelled->queued = false;
+        prioritySubscription = cancelled->prioritySubscription;
+        cancelled->prioritySubscription = 0;
+        stats.waiting--;
+        stats.cancelledWhileQueued++;
+        if (state.active == 0 && state.waiting.empty()) {
+            hosts.erase(it);
+        }
+    }
+
+    // The cancellation subscription has fired; only the priority one remains
+    if (cancelled->priority) {
+        cancelled->priority->unsubscribe(prioritySubscription);
+    }
+    LOGI("Dropped queued request for %s: cancelled", host.c_str());
+    cancelled->cancelled();
+}
+
+void RequestScheduler::setLimits(size_t maxPerHost, size_t maxBackgroundPerHost) {
+    std::list<PendingPtr> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->maxPerHost = std::max<size_t>(maxPerHost, 1);
+        this->maxBackgroundPerHost = std::min(std::max<size_t>(maxBackgroundPerHost, 1), this->maxPerHost);
+        for (auto& entry : hosts) {
+            takeRunnableLocked(entry.first, ready);
+        }
+    }
+    launch(ready);
+}
+
+RequestSchedulerStats RequestScheduler::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+} // namespace localify
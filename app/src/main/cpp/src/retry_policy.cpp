@@ -0,0 +1,55 @@
+#include "retry_policy.h"
+#include <random>
+#include <charconv>
+#include <algorithm>
+#include <ctime>
+
+namespace localify {
+
+bool RetryPolicy::isIdempotent(const std::string& method) {
+    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" || method == "OPTIONS";
+}
+
+bool RetryPolicy::isRetryable(const HttpResponse& response) {
+    switch (response.errorCode) {
+        case HttpError::NETWORK:
+        case HttpError::TIMED_OUT:
+            return true;
+        case HttpError::NONE:
+            break;
+        default:
+            return false;
+    }
+    int status = response.statusCode;
+    return status == 408 || status == 429 || status == 502 || status == 503 || status == 504;
+}
+
+std::chrono::milliseconds RetryPolicy::retryAfter(const HttpResponse& response) {
+    std::string_view value = HttpParser::trim(response.headers.get("Retry-After"));
+    if (value.empty()) {
+        return std::chrono::milliseconds(-1);
+    }
+
+    int64_t seconds = 0;
+    auto parsed = std::from_chars(value.data(), value.data() + value.size(), seconds);
+    if (parsed.ec == std::errc() && parsed.ptr == value.data() + value.size()) {
+        return std::chrono::seconds(std::max<int64_t>(0, seconds));
+    }
+
+    int64_t at = HttpParser::parseHttpDate(value);
+    if (at < 0) {
+        return std::chrono::milliseconds(-1);
+    }
+    return std::chrono::seconds(std::max<int64_t>(0, at - static_cast<int64_t>(time(nullptr))));
+}
+
+std::chrono::milliseconds RetryPolicy::backoff(int attempt) const {
+    thread_local std::mt19937 random(std::random_device{}());
+
+    int64_t ceiling = baseDelay.count() << std::min(attempt - 1, 20);
+    ceiling = std::min<int64_t>(ceiling, maxDelay.count());
+    std::uniform_int_distribution<int64_t> jitter(0, std::max<int64_t>(0, ceiling));
+    return std::chrono::milliseconds(jitter(random));
+}
+
+} // namespace localify
@@ -1,7 +1,10 @@
 #include "screens.h"
 #include "api_service.h"
 #include "json_parser.h"
+#include "http_client.h"
+#include "app_config.h"
 #include <android/log.h>
+#include <thread>
 
 #define LOG_TAG "LocalifyScreens"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -15,6 +18,9 @@ LoginScreen::LoginScreen() : Screen("Welcome to Localify") {}
 void LoginScreen::initialize() {
     LOGI("Initializing Login Screen");
     
+    // Resolve the API host while the user is still looking at the login options
+    HttpClient::getInstance().prefetchDNS(AppConfig::API_BASE_URL);
+    
     // Clear existing components
     components.clear();
     
@@ -22,36 +28,31 @@ void LoginScreen::initialize() {
     float screenHeight = g_app->getHeight();
     
     // Create guest login button
-    guestLoginButton = std::make_unique<Button>(
+    guestLoginButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth * 0.1f, screenHeight * 0.4f, screenWidth * 0.8f, 60.0f),
         "Continue as Guest"
-    );
+    ));
     guestLoginButton->setBackgroundColor(Color::LocalifyPink());
     guestLoginButton->setTextColor(Color::White());
     guestLoginButton->setOnClick([this]() { onGuestLogin(); });
     
     // Create Apple login button
-    appleLoginButton = std::make_unique<Button>(
+    appleLoginButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth * 0.1f, screenHeight * 0.5f, screenWidth * 0.8f, 60.0f),
         "Sign in with Apple"
-    );
+    ));
     appleLoginButton->setBackgroundColor(Color::Black());
     appleLoginButton->setTextColor(Color::White());
     appleLoginButton->setOnClick([this]() { onAppleLogin(); });
     
     // Create Spotify login button
-    spotifyLoginButton = std::make_unique<Button>(
+    spotifyLoginButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth * 0.1f, screenHeight * 0.6f, screenWidth * 0.8f, 60.0f),
         "Connect with Spotify"
-    );
+    ));
     spotifyLoginButton->setBackgroundColor(Color(0.11f, 0.73f, 0.33f, 1.0f)); // Spotify green
     spotifyLoginButton->setTextColor(Color::White());
     spotifyLoginButton->setOnClick([this]() { onSpotifyLogin(); });
-    
-    // Add components to screen
-    addComponent(std::move(guestLoginButton));
-    addComponent(std::move(appleLoginButton));
-    addComponent(std::move(spotifyLoginButton));
 }
 
 void LoginScreen::onGuestLogin() {
@@ -91,35 +92,30 @@ void HomeScreen::initialize() {
     float screenHeight = g_app->getHeight();
     
     // Create refresh button
-    refreshButton = std::make_unique<Button>(
+    refreshButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth - 120.0f, 20.0f, 100.0f, 50.0f),
         "Refresh"
-    );
+    ));
     refreshButton->setBackgroundColor(Color::LocalifyPink());
     refreshButton->setTextColor(Color::White());
     refreshButton->setOnClick([this]() { onRefresh(); });
     
     // Create map button
-    mapButton = std::make_unique<Button>(
+    mapButton = addComponent(std::make_unique<Button>(
         Rect(20.0f, 20.0f, 100.0f, 50.0f),
         "Map"
-    );
+    ));
     mapButton->setBackgroundColor(Color::Gray());
     mapButton->setTextColor(Color::White());
     mapButton->setOnClick([this]() { onMapView(); });
     
     // Create recommendations list
-    recommendationsList = std::make_unique<ListView>(
+    recommendationsList = addComponent(std::make_unique<ListView>(
         Rect(0.0f, 80.0f, screenWidth, screenHeight - 160.0f), // Leave space for bottom nav
         80.0f
-    );
+    ));
     recommendationsList->setOnItemClick([this](int index) { onItemSelected(index); });
     
-    // Add components
-    addComponent(std::move(refreshButton));
-    addComponent(std::move(mapButton));
-    addComponent(std::move(recommendationsList));
-    
     // Load initial recommendations
     loadRecommendations();
 }
@@ -158,9 +154,30 @@ void HomeScreen::onItemSelected(int index) {
     // TODO: Navigate to event detail view
 }
 
+namespace {
+
+// Hands a load the screen no longer wants to a thread of its own: destroying
+// a std::async future blocks until the work finishes, which must not happen
+// on the UI thread. Cancel the load first so the thread ends promptly.
+template<typename T>
+void abandon(std::future<T>& pending) {
+    if (pending.valid()) {
+        std::thread([abandoned = std::move(pending)]() { abandoned.wait(); }).detach();
+    }
+}
+
+} // namespace
+
 // SearchScreen implementation
 SearchScreen::SearchScreen() : Screen("Search"), selectedTab(0) {}
 
+SearchScreen::~SearchScreen() {
+    if (searchCancellation) {
+        searchCancellation->cancel();
+    }
+    abandon(pendingSearch);
+}
+
 void SearchScreen::initialize() {
     LOGI("Initializing Search Screen");
     
@@ -170,66 +187,84 @@ void SearchScreen::initialize() {
     float screenHeight = g_app->getHeight();
     
     // Create search bar
-    searchBar = std::make_unique<SearchBar>(
+    searchBar = addComponent(std::make_unique<SearchBar>(
         Rect(20.0f, 20.0f, screenWidth - 40.0f, 50.0f),
         "Search artists, events, venues..."
-    );
+    ));
     searchBar->setOnTextChanged([this](const std::string& query) { onSearch(query); });
     
     // Create tab buttons
     float tabWidth = screenWidth / 3.0f;
     
-    artistsTab = std::make_unique<Button>(
+    artistsTab = addComponent(std::make_unique<Button>(
         Rect(0.0f, 80.0f, tabWidth, 50.0f),
         "Artists"
-    );
+    ));
     artistsTab->setOnClick([this]() { onTabSelected(0); });
     
-    eventsTab = std::make_unique<Button>(
+    eventsTab = addComponent(std::make_unique<Button>(
         Rect(tabWidth, 80.0f, tabWidth, 50.0f),
         "Events"
-    );
+    ));
     eventsTab->setOnClick([this]() { onTabSelected(1); });
     
-    venuesTab = std::make_unique<Button>(
+    venuesTab = addComponent(std::make_unique<Button>(
         Rect(tabWidth * 2, 80.0f, tabWidth, 50.0f),
         "Venues"
-    );
+    ));
     venuesTab->setOnClick([this]() { onTabSelected(2); });
     
     // Create results list
-    resultsList = std::make_unique<ListView>(
+    resultsList = addComponent(std::make_unique<ListView>(
         Rect(0.0f, 140.0f, screenWidth, screenHeight - 220.0f),
         70.0f
-    );
+    ));
     resultsList->setOnItemClick([this](int index) { onResultSelected(index); });
     
-    // Add components
-    addComponent(std::move(searchBar));
-    addComponent(std::move(artistsTab));
-    addComponent(std::move(eventsTab));
-    addComponent(std::move(venuesTab));
-    addComponent(std::move(resultsList));
-    
     // Set initial tab selection
     onTabSelected(0);
 }
 
+void SearchScreen::update(float deltaTime) {
+    Screen::update(deltaTime);
+    
+    if (!pendingSearch.valid() || pendingSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    try {
+        std::shared_ptr<LazySearchResponse> results = pendingSearch.get();
+        if (searchCancellation && !searchCancellation->isCancelled()) {
+            currentResults = std::move(results);
+            updateResultsList();
+        }
+    } catch (const APIException& e) {
+        if (e.getError() != APIError::CANCELLED) {
+            LOGE("Search failed: %s", e.what());
+        }
+    } catch (const std::exception& e) {
+        LOGE("Search failed: %s", e.what());
+    }
+    searchCancellation.reset();
+}
+
 void SearchScreen::onSearch(const std::string& query) {
     LOGI("Searching for: %s", query.c_str());
     
+    // A newer query supersedes whatever is still in flight
+    if (searchCancellation) {
+        searchCancellation->cancel();
+        searchCancellation.reset();
+    }
+    abandon(pendingSearch);
+    
     if (query.empty()) {
         resultsList->clearItems();
         return;
     }
     
-    try {
-        auto future = APIService::getInstance().fetchSearch(query, false);
-        currentResults = future.get();
-        updateResultsList();
-    } catch (const std::exception& e) {
-        LOGE("Search failed: %s", e.what());
-    }
+    // Runs in the background; update() shows the results once they arrive
+    searchCancellation = CancellationToken::create();
+    pendingSearch = APIService::getInstance().fetchSearchLazy(query, false, searchCancellation);
 }
 
 void SearchScreen::onTabSelected(int tab) {
@@ -250,21 +285,25 @@ void SearchScreen::onResultSelected(int index) {
 
 void SearchScreen::updateResultsList() {
     std::vector<std::string> items;
+    if (!currentResults) {
+        resultsList->setItems(items);
+        return;
+    }
     
     switch (selectedTab) {
         case 0: // Artists
-            for (const auto& artist : currentResults.artists) {
-                items.push_back("🎤 " + artist.name);
+            for (const auto& artist : currentResults->artists()) {
+                items.push_back("🎤 " + artist.name.str());
             }
             break;
         case 1: // Events
-            for (const auto& event : currentResults.events) {
-                items.push_back("🎵 " + event.name + " at " + event.venueName);
+            for (const auto& event : currentResults->events()) {
+                items.push_back("🎵 " + event.name + " at " + event.venueName.str());
             }
             break;
         case 2: // Venues
-            for (const auto& venue : currentResults.venues) {
-                items.push_back("🏛️ " + venue.name + " - " + venue.city);
+            for (const auto& venue : currentResults->venues()) {
+                items.push_back("🏛️ " + venue.name + " - " + venue.city.str());
             }
             break;
     }
@@ -273,7 +312,35 @@ void SearchScreen::updateResultsList() {
 }
 
 // FavoritesScreen implementation
-FavoritesScreen::FavoritesScreen() : Screen("Favorites"), selectedTab(0) {}
+namespace {
+
+// Moves a finished load's result into place without blocking the UI thread
+template<typename T>
+bool takeIfReady(std::future<T>& pending, T& out, const char* what) {
+    if (!pending.valid() || pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+    try {
+        out = pending.get();
+    } catch (const std::exception& e) {
+        LOGE("Failed to load favorite %s: %s", what, e.what());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+FavoritesScreen::FavoritesScreen()
+    : Screen("Favorites"), selectedTab(0), loadPriority(PriorityToken::create(RequestPriority::BACKGROUND)),
+      loadCancellation(CancellationToken::create()) {}
+
+FavoritesScreen::~FavoritesScreen() {
+    loadCancellation->cancel();
+    abandon(pendingArtists);
+    abandon(pendingEvents);
+    abandon(pendingVenues);
+}
 
 void FavoritesScreen::initialize() {
     LOGI("Initializing Favorites Screen");
@@ -286,66 +353,73 @@ void FavoritesScreen::initialize() {
     // Create tab buttons
     float tabWidth = screenWidth / 3.0f;
     
-    artistsTab = std::make_unique<Button>(
+    artistsTab = addComponent(std::make_unique<Button>(
         Rect(0.0f, 20.0f, tabWidth, 50.0f),
         "Artists"
-    );
+    ));
     artistsTab->setOnClick([this]() { onTabSelected(0); });
     
-    eventsTab = std::make_unique<Button>(
+    eventsTab = addComponent(std::make_unique<Button>(
         Rect(tabWidth, 20.0f, tabWidth, 50.0f),
         "Events"
-    );
+    ));
     eventsTab->setOnClick([this]() { onTabSelected(1); });
     
-    venuesTab = std::make_unique<Button>(
+    venuesTab = addComponent(std::make_unique<Button>(
         Rect(tabWidth * 2, 20.0f, tabWidth, 50.0f),
         "Venues"
-    );
+    ));
     venuesTab->setOnClick([this]() { onTabSelected(2); });
     
     // Create favorites list
-    favoritesList = std::make_unique<ListView>(
+    favoritesList = addComponent(std::make_unique<ListView>(
         Rect(0.0f, 80.0f, screenWidth, screenHeight - 160.0f),
         70.0f
-    );
+    ));
     favoritesList->setOnItemClick([this](int index) { onFavoriteSelected(index); });
     
-    // Add components
-    addComponent(std::move(artistsTab));
-    addComponent(std::move(eventsTab));
-    addComponent(std::move(venuesTab));
-    addComponent(std::move(favoritesList));
-    
-    // Set initial tab and load favorites
+    // Set initial tab; favorites normally arrive through prefetch() already
     onTabSelected(0);
     loadFavorites();
 }
 
 void FavoritesScreen::update(float deltaTime) {
     Screen::update(deltaTime);
+    
+    bool changed = takeIfReady(pendingArtists, favoriteArtists, "artists");
+    changed = takeIfReady(pendingEvents, favoriteEvents, "events") || changed;
+    changed = takeIfReady(pendingVenues, favoriteVenues, "venues") || changed;
+    if (changed) {
+        updateFavoritesList();
+    }
+}
+
+void FavoritesScreen::onShow() {
+    // Loads still queued go ahead of background work while the user waits
+    loadPriority->set(RequestPriority::USER_VISIBLE);
+}
+
+void FavoritesScreen::onHide() {
+    loadPriority->set(RequestPriority::BACKGROUND);
+}
+
+void FavoritesScreen::prefetch() {
+    // Not shown yet, so loadPriority is still BACKGROUND
+    loadFavorites();
 }
 
 void FavoritesScreen::loadFavorites() {
+    if (pendingArtists.valid() || pendingEvents.valid() || pendingVenues.valid()) {
+        return;
+    }
     LOGI("Loading favorites");
     
-    try {
-        // Load favorite artists
-        auto artistsFuture = APIService::getInstance().fetchFavoriteArtists();
-        favoriteArtists = artistsFuture.get();
-        
-        // Load favorite events  
-        auto eventsFuture = APIService::getInstance().fetchFavoriteEvents();
-        favoriteEvents = eventsFuture.get();
-        
-        // Load favorite venues
-        auto venuesFuture = APIService::getInstance().fetchFavoriteVenues();
-        favoriteVenues = venuesFuture.get();
-        
-        updateFavoritesList();
-    } catch (const std::exception& e) {
-        LOGE("Failed to load favorites: %s", e.what());
-    }
+    // From prefetch() these start out as background work and onShow() raises
+    // whatever is still queued; from initialize() the screen is about to be
+    // shown and they are raised straight away
+    pendingArtists = APIService::getInstance().fetchFavoriteArtists(0, 20, loadPriority, loadCancellation);
+    pendingEvents = APIService::getInstance().fetchFavoriteEvents(0, 20, true, loadPriority, loadCancellation);
+    pendingVenues = APIService::getInstance().fetchFavoriteVenues(0, 20, loadPriority, loadCancellation);
 }
 
 void FavoritesScreen::onTabSelected(int tab) {
@@ -370,17 +444,17 @@ void FavoritesScreen::updateFavoritesList() {
     switch (selectedTab) {
         case 0: // Artists
             for (const auto& artist : favoriteArtists) {
-                items.push_back("⭐ " + artist.name);
+                items.push_back("⭐ " + artist.name.str());
             }
             break;
         case 1: // Events
             for (const auto& event : favoriteEvents) {
-                items.push_back("⭐ " + event.name + " at " + event.venueName);
+                items.push_back("⭐ " + event.name + " at " + event.venueName.str());
             }
             break;
         case 2: // Venues
             for (const auto& venue : favoriteVenues) {
-                items.push_back("⭐ " + venue.name + " - " + venue.city);
+                items.push_back("⭐ " + venue.name + " - " + venue.city.str());
             }
             break;
     }
@@ -404,44 +478,38 @@ void ProfileScreen::initialize() {
     float screenHeight = g_app->getHeight();
     
     // Create profile buttons
-    connectEmailButton = std::make_unique<Button>(
+    connectEmailButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth * 0.1f, screenHeight * 0.3f, screenWidth * 0.8f, 60.0f),
         "Connect Email"
-    );
+    ));
     connectEmailButton->setBackgroundColor(Color::LocalifyPink());
     connectEmailButton->setTextColor(Color::White());
     connectEmailButton->setOnClick([this]() { onConnectEmail(); });
     
-    connectSpotifyButton = std::make_unique<Button>(
+    connectSpotifyButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth * 0.1f, screenHeight * 0.4f, screenWidth * 0.8f, 60.0f),
         "Connect Spotify"
-    );
+    ));
     connectSpotifyButton->setBackgroundColor(Color(0.11f, 0.73f, 0.33f, 1.0f)); // Spotify green
     connectSpotifyButton->setTextColor(Color::White());
     connectSpotifyButton->setOnClick([this]() { onConnectSpotify(); });
     
-    logoutButton = std::make_unique<Button>(
+    logoutButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth * 0.1f, screenHeight * 0.6f, screenWidth * 0.8f, 60.0f),
         "Logout"
-    );
+    ));
     logoutButton->setBackgroundColor(Color::Gray());
     logoutButton->setTextColor(Color::White());
     logoutButton->setOnClick([this]() { onLogout(); });
     
-    deleteAccountButton = std::make_unique<Button>(
+    deleteAccountButton = addComponent(std::make_unique<Button>(
         Rect(screenWidth * 0.1f, screenHeight * 0.7f, screenWidth * 0.8f, 60.0f),
         "Delete Account"
-    );
+    ));
     deleteAccountButton->setBackgroundColor(Color(0.8f, 0.2f, 0.2f, 1.0f)); // Red
     deleteAccountButton->setTextColor(Color::White());
     deleteAccountButton->setOnClick([this]() { onDeleteAccount(); });
     
-    // Add components
-    addComponent(std::move(connectEmailButton));
-    addComponent(std::move(connectSpotifyButton));
-    addComponent(std::move(logoutButton));
-    addComponent(std::move(deleteAccountButton));
-    
     loadUserProfile();
 }
 
@@ -0,0 +1,170 @@
+#include "string_pool.h"
+#include <cstring>
+#include <new>
+
+namespace localify {
+
+InternedString::InternedString(std::string_view text)
+    : InternedString(StringPool::getInstance().intern(text)) {}
+
+InternedString& InternedString::operator=(const InternedString& other) {
+    if (entry != other.entry) {
+        release();
+        entry = other.entry;
+        retain();
+    }
+    return *this;
+}
+
+InternedString& InternedString::operator=(InternedString&& other) noexcept {
+    if (this != &other) {
+        release();
+        entry = other.entry;
+        other.entry = nullptr;
+    }
+    return *this;
+}
+
+void InternedString::release() {
+    if (entry == nullptr) {
+        return;
+    }
+    // Pooled entries stay behind at zero, where intern() can revive them,
+    // until the pool sweeps them out. Once the last reference is dropped a
+    // sweep may free a pooled entry at any moment, so read the (immutable)
+    // flag before letting go.
+    bool pooled = entry->pooled;
+    if (entry->references.fetch_sub(1, std::memory_order_acq_rel) == 1 && !pooled) {
+        StringPool::destroy(entry);
+    }
+    entry = nullptr;
+}
+
+std::unique_ptr<StringPool> StringPool::instance = nullptr;
+
+StringPool& StringPool::getInstance() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        instance = std::unique_ptr<StringPool>(new StringPool());
+    });
+    return *instance;
+}
+
+StringPool::~StringPool() {
+    // Entries still referenced are left to leak: their handles may outlive
+    // the pool during static destruction
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (Entry* entry : shard.table) {
+            if (entry && entry->references.load(std::memory_order_acquire) == 0) {
+                destroy(entry);
+            }
+        }
+    }
+}
+
+StringPool::Entry* StringPool::allocate(std::string_view text, uint32_t hash, bool pooled) {
+    void* memory = ::operator new(sizeof(Entry) + text.size());
+    Entry* entry = new (memory) Entry;
+    entry->references.store(1, std::memory_order_relaxed);
+    entry->length = static_cast<uint32_t>(text.size());
+    entry->hash = hash;
+    entry->pooled = pooled;
+    memcpy(entry->text, text.data(), text.size());
+    entry->text[text.size()] = '\0';
+    return entry;
+}
+
+void StringPool::destroy(Entry* entry) {
+    entry->~Entry();
+    ::operator delete(entry);
+}
+
+void StringPool::rebuild(Shard& shard) {
+    std::vector<Entry*> live;
+    live.reserve(shard.count);
+    for (Entry* entry : shard.table) {
+        if (!entry) {
+            continue;
+        }
+        // Only intern() revives an entry, and it holds this shard's mutex
+        if (entry->references.load(std::memory_order_acquire) == 0) {
+            shard.bytes -= entry->length;
+            destroy(entry);
+        } else {
+            live.push_back(entry);
+        }
+    }
+
+    // At most half full afterwards, so the next rebuild is far off
+    size_t size = MIN_TABLE_SIZE;
+    while (size < live.size() * 2) {
+        size *= 2;
+    }
+    shard.table.assign(size, nullptr);
+    size_t mask = size - 1;
+    for (Entry* entry : live) {
+        size_t slot = entry->hash & mask;
+        while (shard.table[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        shard.table[slot] = entry;
+    }
+    shard.count = live.size();
+}
+
+InternedString StringPool::intern(std::string_view text) {
+    if (text.empty()) {
+        return InternedString();
+    }
+    size_t fullHash = std::hash<std::string_view>()(text);
+    uint32_t hash = static_cast<uint32_t>(fullHash);
+    if (text.size() > MAX_POOLED_LENGTH) {
+        return InternedString(allocate(text, hash, false));
+    }
+
+    // Top bits pick the shard, low bits the slot
+    Shard& shard = shards[(fullHash >> (sizeof(size_t) * 8 - 4)) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.lookups++;
+    if (shard.table.empty()) {
+        shard.table.assign(MIN_TABLE_SIZE, nullptr);
+    }
+
+    size_t mask = shard.table.size() - 1;
+    size_t slot = hash & mask;
+    while (Entry* entry = shard.table[slot]) {
+        if (entry->hash == hash && entry->length == text.size() &&
+            memcmp(entry->text, text.data(), text.size()) == 0) {
+            entry->references.fetch_add(1, std::memory_order_relaxed);
+            shard.hits++;
+            shard.savedBytes += text.size();
+            return InternedString(entry);
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    Entry* entry = allocate(text, hash, true);
+    shard.bytes += text.size();
+    shard.table[slot] = entry;
+    shard.count++;
+    if (shard.count * 4 > shard.table.size() * 3) {
+        rebuild(shard);
+    }
+    return InternedString(entry);
+}
+
+StringPoolStats StringPool::getStats() const {
+    StringPoolStats stats;
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.lookups += shard.lookups;
+        stats.hits += shard.hits;
+        stats.savedBytes += shard.savedBytes;
+        stats.entries += shard.count;
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+} // namespace localify
@@ -0,0 +1,353 @@
+#include "tls_context.h"
+#include <android/log.h>
+
+#ifdef LOCALIFY_HAS_TLS
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+#endif
+
+#define LOG_TAG "LocalifyTLS"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+std::unique_ptr<TlsContext> TlsContext::instance = nullptr;
+
+TlsContext& TlsContext::getInstance() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        instance = std::unique_ptr<TlsContext>(new TlsContext());
+    });
+    return *instance;
+}
+
+TlsStats TlsContext::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void TlsContext::recordHandshake(bool resumed, std::chrono::microseconds elapsed, bool failed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (failed) {
+        stats.failedHandshakes++;
+    } else if (resumed) {
+        stats.resumedHandshakes++;
+        stats.resumedHandshakeTime += elapsed;
+    } else {
+        stats.fullHandshakes++;
+        stats.fullHandshakeTime += elapsed;
+    }
+}
+
+#ifdef LOCALIFY_HAS_TLS
+
+namespace {
+#ifdef __ANDROID__
+// Where Android keeps its CA certificates, already in OpenSSL's hashed layout
+const char* ANDROID_CA_DIRECTORY = "/system/etc/security/cacerts";
+#endif
+
+const unsigned char ALPN_HTTP11[] = {8, 'h', 't', 't', 'p', '/', '1', '.', '1'};
+
+std::string lastError() {
+    unsigned long code = ERR_get_error();
+    ERR_clear_error();
+    if (code == 0) {
+        return "unknown error";
+    }
+    char buffer[256];
+    ERR_error_string_n(code, buffer, sizeof(buffer));
+    return buffer;
+}
+}
+
+bool TlsContext::isAvailable() {
+    return true;
+}
+
+TlsContext::TlsContext() : context(SSL_CTX_new(TLS_client_method())) {
+    if (context == nullptr) {
+        LOGE("Failed to create TLS context: %s", lastError().c_str());
+        return;
+    }
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_options(context, SSL_OP_NO_RENEGOTIATION);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+    // OpenSSL 3 otherwise fails a read that meets EOF without close_notify and
+    // drops the session; servers routinely end close-delimited bodies that way
+    SSL_CTX_set_options(context, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+    SSL_CTX_set_verify(context, SSL_VERIFY_PEER, nullptr);
+#ifdef __ANDROID__
+    SSL_CTX_load_verify_locations(context, nullptr, ANDROID_CA_DIRECTORY);
+#else
+    SSL_CTX_set_default_verify_paths(context);
+#endif
+    SSL_CTX_set_alpn_protos(context, ALPN_HTTP11, sizeof(ALPN_HTTP11));
+
+    // Sessions live in our per-host cache, not OpenSSL's id-keyed server-style one
+    SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(context, &TlsContext::onNewSession);
+    LOGI("TLS context initialized");
+}
+
+TlsContext::~TlsContext() {
+    clearSessions();
+    if (context != nullptr) {
+        SSL_CTX_free(context);
+    }
+}
+
+bool TlsContext::addTrustedCertificates(const std::string& pemPath) {
+    if (context == nullptr || SSL_CTX_load_verify_locations(context, pemPath.c_str(), nullptr) != 1) {
+        LOGE("Failed to load certificates from %s: %s", pemPath.c_str(), lastError().c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<TlsStream> TlsContext::connect(int fd, const std::string& host, int port) {
+    if (context == nullptr) {
+        return nullptr;
+    }
+    SSL* ssl = SSL_new(context);
+    if (ssl == nullptr) {
+        LOGE("Failed to create TLS connection: %s", lastError().c_str());
+        return nullptr;
+    }
+
+    std::string key = host + ":" + std::to_string(port);
+    std::unique_ptr<TlsStream> stream(new TlsStream(ssl, key));
+    SSL_set_app_data(ssl, stream.get());
+    SSL_set_fd(ssl, fd);
+    SSL_set_connect_state(ssl);
+    SSL_set_tlsext_host_name(ssl, host.c_str());
+    SSL_set_hostflags(ssl, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS);
+    SSL_set1_host(ssl, host.c_str());
+
+    SSL_SESSION* session = takeSession(key);
+    if (session != nullptr) {
+        SSL_set_session(ssl, session);
+        SSL_SESSION_free(session);
+    }
+    return stream;
+}
+
+int TlsContext::onNewSession(SSL* ssl, SSL_SESSION* session) {
+    TlsStream* stream = static_cast<TlsStream*>(SSL_get_app_data(ssl));
+    if (stream == nullptr || !SSL_SESSION_is_resumable(session)) {
+        return 0;
+    }
+    getInstance().storeSession(stream->sessionKey, session);
+    return 1;   // the cache now owns the reference
+}
+
+void TlsContext::storeSession(const std::string& key, SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::deque<SSL_SESSION*>& cached = sessions[key];
+    cached.push_back(session);
+    if (cached.size() > MAX_SESSIONS_PER_HOST) {
+        SSL_SESSION_free(cached.front());
+        cached.pop_front();
+    }
+    stats.sessionsCached++;
+}
+
+SSL_SESSION* TlsContext::takeSession(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sessions.find(key);
+    if (it == sessions.end() || it->second.empty()) {
+        return nullptr;
+    }
+
+    // TLS 1.3 tickets are single use; a TLS 1.2 session may serve every
+    // connection until the server stops accepting it
+    SSL_SESSION* session = it->second.back();
+    if (SSL_SESSION_get_protocol_version(session) >= TLS1_3_VERSION) {
+        it->second.pop_back();
+    } else {
+        SSL_SESSION_up_ref(session);
+    }
+    return session;
+}
+
+void TlsContext::clearSessions() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : sessions) {
+        for (SSL_SESSION* session : entry.second) {
+            SSL_SESSION_free(session);
+        }
+    }
+    sessions.clear();
+}
+
+TlsStream::TlsStream(SSL* ssl, const std::string& sessionKey)
+    : ssl(ssl), sessionKey(sessionKey), handshakeStarted(std::chrono::steady_clock::now()),
+      handshakeDone(false) {}
+
+TlsStream::~TlsStream() {
+    // Mark the session cleanly finished without writing a close_notify;
+    // OpenSSL refuses to resume sessions from connections freed mid-stream
+    SSL_set_app_data(ssl, nullptr);
+    if (handshakeDone) {
+        SSL_set_quiet_shutdown(ssl, 1);
+        SSL_shutdown(ssl);
+    }
+    SSL_free(ssl);
+}
+
+bool TlsStream::isResumed() const {
+    return SSL_session_reused(ssl) == 1;
+}
+
+TlsStatus TlsStream::translate(int result) {
+    int code = SSL_get_error(ssl, result);
+    switch (code) {
+        case SSL_ERROR_WANT_READ:
+            return TlsStatus::WANT_READ;
+        case SSL_ERROR_WANT_WRITE:
+            return TlsStatus::WANT_WRITE;
+        case SSL_ERROR_ZERO_RETURN:
+            return TlsStatus::CLOSED;
+        case SSL_ERROR_SYSCALL:
+            // EOF or reset without a close_notify; HTTP framing decides whether that is fine
+            ERR_clear_error();
+            return TlsStatus::CLOSED;
+#ifdef SSL_R_UNEXPECTED_EOF_WHILE_READING
+        case SSL_ERROR_SSL:
+            // The same, as OpenSSL 3 reports it without SSL_OP_IGNORE_UNEXPECTED_EOF
+            if (ERR_GET_REASON(ERR_peek_error()) == SSL_R_UNEXPECTED_EOF_WHILE_READING) {
+                ERR_clear_error();
+                return TlsStatus::CLOSED;
+            }
+            error = lastError();
+            return TlsStatus::ERROR;
+#endif
+        default:
+            error = lastError();
+            return TlsStatus::ERROR;
+    }
+}
+
+TlsStatus TlsStream::handshake() {
+    int result = SSL_do_handshake(ssl);
+    if (result == 1) {
+        handshakeDone = true;
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - handshakeStarted);
+        TlsContext::getInstance().recordHandshake(isResumed(), elapsed, false);
+        return TlsStatus::OK;
+    }
+
+    TlsStatus status = translate(result);
+    if (status == TlsStatus::CLOSED || status == TlsStatus::ERROR) {
+        long verify = SSL_get_verify_result(ssl);
+        if (verify != X509_V_OK) {
+            error = std::string("certificate verification failed: ") + X509_verify_cert_error_string(verify);
+        } else if (error.empty()) {
+            error = "connection closed during handshake";
+        }
+        TlsContext::getInstance().recordHandshake(false, std::chrono::microseconds(0), true);
+        return TlsStatus::ERROR;
+    }
+    return status;
+}
+
+TlsStatus TlsStream::read(char* buffer, size_t size, size_t& bytesRead) {
+    bytesRead = 0;
+    int result = SSL_read(ssl, buffer, static_cast<int>(size));
+    if (result > 0) {
+        bytesRead = static_cast<size_t>(result);
+        return TlsStatus::OK;
+    }
+    return translate(result);
+}
+
+TlsStatus TlsStream::write(const char* data, size_t size, size_t& bytesWritten) {
+    bytesWritten = 0;
+    int result = SSL_write(ssl, data, static_cast<int>(size));
+    if (result > 0) {
+        bytesWritten = static_cast<size_t>(result);
+        return TlsStatus::OK;
+    }
+    return translate(result);
+}
+
+bool TlsStream::drainIdle() {
+    // Peeking processes handshake records without consuming any response data
+    char probe;
+    int result = SSL_peek(ssl, &probe, 1);
+    if (result > 0) {
+        return false;
+    }
+    return translate(result) == TlsStatus::WANT_READ;
+}
+
+#else // !LOCALIFY_HAS_TLS
+
+bool TlsContext::isAvailable() {
+    return false;
+}
+
+TlsContext::TlsContext() : context(nullptr) {
+    LOGI("Built without TLS support");
+}
+
+TlsContext::~TlsContext() = default;
+
+bool TlsContext::addTrustedCertificates(const std::string&) {
+    return false;
+}
+
+std::unique_ptr<TlsStream> TlsContext::connect(int, const std::string&, int) {
+    return nullptr;
+}
+
+int TlsContext::onNewSession(ssl_st*, ssl_session_st*) {
+    return 0;
+}
+
+void TlsContext::storeSession(const std::string&, ssl_session_st*) {}
+
+ssl_session_st* TlsContext::takeSession(const std::string&) {
+    return nullptr;
+}
+
+void TlsContext::clearSessions() {}
+
+TlsStream::TlsStream(ssl_st* ssl, const std::string& sessionKey)
+    : ssl(ssl), sessionKey(sessionKey), handshakeDone(false) {}
+
+TlsStream::~TlsStream() = default;
+
+bool TlsStream::isResumed() const {
+    return false;
+}
+
+TlsStatus TlsStream::translate(int) {
+    return TlsStatus::ERROR;
+}
+
+TlsStatus TlsStream::handshake() {
+    return TlsStatus::ERROR;
+}
+
+TlsStatus TlsStream::read(char*, size_t, size_t& bytesRead) {
+    bytesRead = 0;
+    return TlsStatus::ERROR;
+}
+
+TlsStatus TlsStream::write(const char*, size_t, size_t& bytesWritten) {
+    bytesWritten = 0;
+    return TlsStatus::ERROR;
+}
+
+bool TlsStream::drainIdle() {
+    return false;
+}
+
+#endif // LOCALIFY_HAS_TLS
+
+} // namespace localify
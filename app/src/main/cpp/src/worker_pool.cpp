@@ -0,0 +1,144 @@
+#include "worker_pool.h"
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "LocalifyWorkers"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace localify {
+
+namespace {
+// Phones pair a few fast cores with slow ones; past four threads the slow
+// cores only add stragglers
+const size_t DEFAULT_MAX_THREADS = 4;
+}
+
+std::unique_ptr<WorkerPool> WorkerPool::instance = nullptr;
+
+WorkerPool& WorkerPool::getInstance() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        instance = std::unique_ptr<WorkerPool>(new WorkerPool());
+    });
+    return *instance;
+}
+
+WorkerPool::WorkerPool() : stopping(false) {
+    size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    startWorkers(std::min(cores, DEFAULT_MAX_THREADS) - 1);
+}
+
+WorkerPool::~WorkerPool() {
+    stopWorkers();
+}
+
+void WorkerPool::startWorkers(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+    for (size_t i = 0; i < count; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+    LOGI("Worker pool running %zu threads", count + 1);
+}
+
+void WorkerPool::stopWorkers() {
+    std::vector<std::thread> stopped;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        stopped.swap(workers);
+    }
+    wake.notify_all();
+    for (std::thread& worker : stopped) {
+        worker.join();
+    }
+}
+
+size_t WorkerPool::getThreadCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return workers.size() + 1;
+}
+
+void WorkerPool::setThreadCount(size_t threads) {
+    // Batches already queued are finished by their callers
+    stopWorkers();
+    startWorkers(std::max<size_t>(threads, 1) - 1);
+}
+
+void WorkerPool::runBatch(Batch& batch) {
+    size_t index;
+    while ((index = batch.next.fetch_add(1)) < batch.count) {
+        try {
+            (*batch.task)(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            if (!batch.error) {
+                batch.error = std::current_exception();
+            }
+        }
+        if (batch.finished.fetch_add(1) + 1 == batch.count) {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            batch.done.notify_all();
+        }
+    }
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !batches.empty(); });
+        if (stopping) {
+            return;
+        }
+        BatchPtr batch = batches.front();
+        if (batch->next.load() >= batch->count) {
+            // Every index is claimed; the rest is up to whoever holds them
+            batches.pop_front();
+            continue;
+        }
+        lock.unlock();
+        runBatch(*batch);
+        lock.lock();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->task = &task;
+    batch->count = count;
+    batch->next = 0;
+    batch->finished = 0;
+
+    bool queued = false;
+    if (count > 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!workers.empty()) {
+            batches.push_back(batch);
+            queued = true;
+        }
+    }
+    if (queued) {
+        wake.notify_all();
+    }
+
+    runBatch(*batch);
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&batch]() { return batch->finished.load() == batch->count; });
+    }
+    if (queued) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find(batches.begin(), batches.end(), batch);
+        if (it != batches.end()) {
+            batches.erase(it);
+        }
+    }
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+} // namespace localify
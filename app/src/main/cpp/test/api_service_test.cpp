@@ -0,0 +1,450 @@
+// APIService over a ReplayTransport: cancelling a load must end it promptly,
+// so screens can drop loads they no longer want without waiting on them.
+// Then against a loopback server: identical concurrent GETs go out once and
+// share the result or failure, joining at a higher priority raises the
+// shared request, retries honour Retry-After within
+// RetryPolicy::maxRetryAfter, and an unhealthy host opens the breaker.
+// Request timing: every phase is measured, endpoints aggregate across ids,
+// and fresh cache hits are left out.
+
+#include "test_support.h"
+#include "api_service.h"
+#include "fixture_transport.h"
+#include "dns_resolver.h"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+// A JSON array of count artists, roughly 60 bytes each
+std::string artistArray(int count) {
+    std::string body = "[";
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            body += ",";
+        }
+        body += R"({"id":"artist-)" + std::to_string(i) + R"(","name":"Artist number )" + std::to_string(i) + "\"}";
+    }
+    return body + "]";
+}
+
+const std::string USER = R"({"id":"user123","name":"Guest User","anonymousUser":true})";
+
+// Answers requests with the scripted responses in order, then with
+// fallback, and records what reaches it. While held, requests wait at the
+// server until release().
+class ScriptedAPI {
+public:
+    ScriptedAPI(std::deque<std::string> script, std::string fallback)
+        : script(std::move(script)), fallback(std::move(fallback)), requests(0),
+          server([this](int fd) { serve(fd); }) {
+        CHECK(server.isListening());
+        HttpClient& client = HttpClient::getInstance();
+        client.setTransport(nullptr);
+        client.setTransport(std::make_shared<RedirectTransport>(client.getTransport(), server));
+        client.setCacheEnabled(false);
+    }
+
+    ~ScriptedAPI() {
+        release();
+        HttpClient::getInstance().setTransport(nullptr);
+    }
+
+    size_t getRequestCount() const { return requests.load(); }
+
+    void hold() {
+        std::lock_guard<std::mutex> lock(mutex);
+        held = true;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            held = false;
+        }
+        released.notify_all();
+    }
+
+    // How many requests so far had a target containing part
+    size_t countPaths(const std::string& part) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::count_if(paths.begin(), paths.end(),
+                             [&part](const std::string& path) { return path.find(part) != std::string::npos; });
+    }
+
+private:
+    void serve(int fd) {
+        std::string request;
+        while (readRequest(fd, request)) {
+            std::string answer;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                requests++;
+                size_t target = request.find(' ') + 1;
+                paths.push_back(request.substr(target, request.find(' ', target) - target));
+                released.wait(lock, [this]() { return !held; });
+                if (script.empty()) {
+                    answer = fallback;
+                } else {
+                    answer = script.front();
+                    script.pop_front();
+                }
+            }
+            if (!writeAll(fd, answer)) {
+                return;
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::deque<std::string> script;
+    std::string fallback;
+    std::atomic<size_t> requests;
+    std::vector<std::string> paths;
+    bool held = false;
+    std::condition_variable released;
+    LoopbackServer server;
+};
+
+// Fetches the signed-in user, expecting the request to fail
+APIException fetchUserFailure() {
+    try {
+        APIService::getInstance().fetchUserDetails().get();
+    } catch (const APIException& e) {
+        return e;
+    }
+    fail(__FILE__, __LINE__, "fetchUserDetails() throws", "it succeeded");
+}
+
+void testFavoritesLoadCompletes() {
+    auto replay = std::make_shared<ReplayTransport>();
+    replay->setDefaultResponse(200, artistArray(50));
+    HttpClient::getInstance().setTransport(replay);
+    HttpClient::getInstance().setCacheEnabled(false);
+
+    auto cancellation = CancellationToken::create();
+    std::vector<ArtistResponse> artists =
+        APIService::getInstance().fetchFavoriteArtists(0, 50, nullptr, cancellation).get();
+    CHECK(artists.size() == 50);
+    CHECK(artists[49].id == "artist-49");
+
+    HttpClient::getInstance().setTransport(nullptr);
+}
+
+void testCancelledFavoritesLoadEndsEarly() {
+    // About 64 KB streamed at 160 KB/s: 16 KB chunks every 100 ms
+    auto replay = std::make_shared<ReplayTransport>(std::chrono::milliseconds(0), 160 * 1024);
+    std::string body = artistArray(1100);
+    replay->setDefaultResponse(200, body);
+    HttpClient::getInstance().setTransport(replay);
+    HttpClient::getInstance().setCacheEnabled(false);
+
+    auto cancellation = CancellationToken::create();
+    auto start = std::chrono::steady_clock::now();
+    auto artists = APIService::getInstance().fetchFavoriteArtists(0, 1100, nullptr, cancellation);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    cancellation->cancel();
+
+    CHECK(artists.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+    CHECK_MSG(elapsedMs(start) < 1000.0 * body.size() / (160 * 1024), std::to_string(elapsedMs(start)) + " ms");
+    try {
+        artists.get();
+        CHECK(!"cancelled load returned results");
+    } catch (const APIException& e) {
+        CHECK_MSG(e.getError() == APIError::CANCELLED, e.what());
+    }
+
+    HttpClient::getInstance().setTransport(nullptr);
+}
+
+const int CALLERS = 8;
+
+void testConcurrentGetsShareOneRequest() {
+    ScriptedAPI api({}, response(200, USER));
+    APIService& service = APIService::getInstance();
+    SingleFlightStats before = service.getCoalescingStats();
+
+    // Held at the server until every caller has joined the first
+    api.hold();
+    std::vector<std::future<UserDetails>> callers;
+    for (int i = 0; i < CALLERS; ++i) {
+        callers.push_back(service.fetchUserDetails());
+    }
+    CHECK(waitUntil([&]() { return service.getCoalescingStats().saved == before.saved + CALLERS - 1; }));
+    api.release();
+
+    for (auto& caller : callers) {
+        CHECK(caller.get().id == "user123");
+    }
+    CHECK_MSG(api.getRequestCount() == 1, std::to_string(api.getRequestCount()) + " requests");
+    SingleFlightStats after = service.getCoalescingStats();
+    CHECK(after.started == before.started + 1);
+    CHECK(after.saved == before.saved + CALLERS - 1);
+
+    // Nothing is cached: the next call goes out again
+    CHECK(service.fetchUserDetails().get().id == "user123");
+    CHECK(api.getRequestCount() == 2);
+}
+
+void testFailureReachesEveryCaller() {
+    ScriptedAPI api({}, response(404, "gone"));
+    APIService& service = APIService::getInstance();
+    SingleFlightStats before = service.getCoalescingStats();
+
+    api.hold();
+    std::vector<std::future<UserDetails>> callers;
+    for (int i = 0; i < CALLERS; ++i) {
+        callers.push_back(service.fetchUserDetails());
+    }
+    CHECK(waitUntil([&]() { return service.getCoalescingStats().saved == before.saved + CALLERS - 1; }));
+    api.release();
+
+    for (auto& caller : callers) {
+        try {
+            caller.get();
+            CHECK(!"a joined caller missed the failure");
+        } catch (const APIException& e) {
+            CHECK_MSG(e.getError() == APIError::CLIENT_4XX_ERROR, e.what());
+        }
+    }
+    CHECK(api.getRequestCount() == 1);
+}
+
+void testJoiningRaisesTheSharedRequest() {
+    // One background request per host, so a second background load waits
+    // in the scheduler until something raises it
+    HttpClient& client = HttpClient::getInstance();
+    client.setHostConcurrency(4, 1);
+    ScriptedAPI api({}, response(200, "[]"));
+    APIService& service = APIService::getInstance();
+    api.hold();
+
+    auto venues = service.fetchFavoriteVenues(0, 20);
+    CHECK(waitUntil([&]() { return api.countPaths("/venues/") == 1; }));
+    size_t waiting = client.getSchedulerStats().waiting;
+    auto background = service.fetchFavoriteArtists(0, 20);
+    CHECK(waitUntil([&]() { return client.getSchedulerStats().waiting == waiting + 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(api.countPaths("/artists/") == 0);
+
+    // The user opens favorites: the same load, wanted now
+    SingleFlightStats before = service.getCoalescingStats();
+    auto visible = service.fetchFavoriteArtists(0, 20, PriorityToken::create(RequestPriority::USER_VISIBLE));
+    CHECK(waitUntil([&]() { return api.countPaths("/artists/") == 1; }));
+    CHECK(service.getCoalescingStats().saved == before.saved + 1);
+    CHECK(client.getSchedulerStats().waiting == waiting);
+
+    // Only that request was raised; other background work still queues
+    auto events = service.fetchFavoriteEvents(0, 20, true);
+    CHECK(waitUntil([&]() { return client.getSchedulerStats().waiting == waiting + 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(api.countPaths("/events/") == 0);
+
+    api.release();
+    CHECK(background.get().empty());
+    CHECK(visible.get().empty());
+    CHECK(venues.get().empty());
+    CHECK(events.get().empty());
+    CHECK(api.getRequestCount() == 3);
+    client.setHostConcurrency(6, 4);
+}
+
+using std::chrono::milliseconds;
+
+void testTimingPhasesAreFilledIn() {
+    // Resolving takes 20 ms; the server waits 50 ms before answering and
+    // 30 ms between the two halves of the response
+    DNSResolver& resolver = DNSResolver::getInstance();
+    resolver.clear();
+    resolver.setLookupFunction([](const std::string&) {
+        std::this_thread::sleep_for(milliseconds(20));
+        ResolvedAddress address;
+        auto* in4 = reinterpret_cast<struct sockaddr_in*>(&address.address);
+        in4->sin_family = AF_INET;
+        inet_pton(AF_INET, "127.0.0.1", &in4->sin_addr);
+        address.length = sizeof(*in4);
+        address.family = AF_INET;
+        DNSResult result;
+        result.addresses.push_back(address);
+        return result;
+    });
+    const std::string full = response(200, std::string(4096, 'x'));
+    std::atomic<size_t> requestSize(0);
+    LoopbackServer server([&full, &requestSize](int fd) {
+        std::string request;
+        while (readRequest(fd, request)) {
+            requestSize = request.size();
+            std::this_thread::sleep_for(milliseconds(50));
+            writeAll(fd, std::string_view(full).substr(0, full.size() / 2));
+            std::this_thread::sleep_for(milliseconds(30));
+            writeAll(fd, std::string_view(full).substr(full.size() / 2));
+        }
+    });
+    CHECK(server.isListening());
+    HttpClient& client = HttpClient::getInstance();
+    client.setTransport(nullptr);
+    client.setCacheEnabled(false);
+    std::string url = "http://timing.test:" + std::to_string(server.getPort()) + "/timing";
+
+    HttpResponse first = client.get(url);
+    CHECK_MSG(first.error.empty(), first.error);
+    const HttpTiming& timing = first.timing;
+    CHECK(!timing.reusedConnection);
+    CHECK_MSG(timing.resolve >= milliseconds(20), std::to_string(timing.resolve.count()) + " us");
+    CHECK(timing.connect.count() > 0);
+    CHECK_MSG(timing.firstByte >= milliseconds(50), std::to_string(timing.firstByte.count()) + " us");
+    CHECK_MSG(timing.transfer >= milliseconds(30), std::to_string(timing.transfer.count()) + " us");
+    CHECK(timing.tls.count() == 0);
+    CHECK(timing.total >= timing.resolve + timing.connect + timing.send + timing.firstByte + timing.transfer);
+    CHECK(timing.bytesSent == requestSize.load());
+    CHECK(timing.bytesReceived == full.size());
+
+    // A reused connection skips resolving and connecting
+    HttpResponse second = client.get(url);
+    CHECK(second.timing.reusedConnection);
+    CHECK(second.timing.resolve.count() == 0);
+    CHECK(second.timing.connect.count() == 0);
+    CHECK(second.timing.firstByte >= milliseconds(50));
+
+    client.closeIdleConnections();
+    resolver.setLookupFunction(nullptr);
+    resolver.clear();
+}
+
+size_t endpointRequests(const std::string& key) {
+    auto timings = APIService::getInstance().getEndpointTimings();
+    auto entry = timings.find(key);
+    return entry == timings.end() ? 0 : entry->second.requests;
+}
+
+void testIdsCollapseIntoOneEndpoint() {
+    ScriptedAPI api({}, response(200, "[]"));
+    const std::string key = "GET /v1/cities/{id}/events";
+    size_t before = endpointRequests(key);
+
+    for (const char* city : {"42", "43", "c0ffee-7"}) {
+        APIService::getInstance().fetchEventsForCities(city, 0, 20).get();
+    }
+    CHECK(api.getRequestCount() == 3);
+    CHECK(endpointRequests(key) == before + 3);
+    for (const auto& entry : APIService::getInstance().getEndpointTimings()) {
+        CHECK_MSG(entry.first.find("42") == std::string::npos && entry.first.find("c0ffee") == std::string::npos &&
+                  entry.first.find('?') == std::string::npos, entry.first);
+    }
+    EndpointTiming timing = APIService::getInstance().getEndpointTimings()[key];
+    CHECK(timing.sum.total.count() > 0);
+    CHECK(timing.slowest.count() > 0);
+}
+
+void testCacheHitsAreNotTimed() {
+    ScriptedAPI api({}, response(200, USER, "Cache-Control: max-age=60\r\n"));
+    HttpClient& client = HttpClient::getInstance();
+    client.clearCache();
+    client.setCacheEnabled(true);
+    size_t before = endpointRequests("GET /v1/@me");
+
+    // The second answer comes from the cache, never touching the network
+    CHECK(APIService::getInstance().fetchUserDetails().get().id == "user123");
+    CHECK(APIService::getInstance().fetchUserDetails().get().id == "user123");
+    CHECK(api.getRequestCount() == 1);
+    CHECK(endpointRequests("GET /v1/@me") == before + 1);
+
+    client.clearCache();
+    client.setCacheEnabled(false);
+}
+
+void testRetryAfterIsHonoured() {
+    ScriptedAPI api({response(503, "", "Retry-After: 1\r\n")}, response(200, USER));
+    RetryStats before = APIService::getInstance().getRetryStats();
+
+    auto start = std::chrono::steady_clock::now();
+    UserDetails user = APIService::getInstance().fetchUserDetails().get();
+    CHECK(user.id == "user123");
+    CHECK(api.getRequestCount() == 2);
+    CHECK_MSG(elapsedMs(start) >= 1000, std::to_string(elapsedMs(start)) + " ms");
+
+    RetryStats after = APIService::getInstance().getRetryStats();
+    CHECK(after.retries == before.retries + 1);
+    CHECK(after.retryAfterHonoured == before.retryAfterHonoured + 1);
+    CHECK(after.recovered == before.recovered + 1);
+    CHECK(after.exhausted == before.exhausted);
+}
+
+void testLongRetryAfterGivesUp() {
+    // A minute is past maxRetryAfter: fail now rather than hold the caller
+    ScriptedAPI api({}, response(503, "", "Retry-After: 60\r\n"));
+    RetryStats before = APIService::getInstance().getRetryStats();
+
+    auto start = std::chrono::steady_clock::now();
+    APIException failure = fetchUserFailure();
+    CHECK_MSG(failure.getError() == APIError::SERVER_5XX_ERROR, failure.what());
+    CHECK(api.getRequestCount() == 1);
+    CHECK_MSG(elapsedMs(start) < 1000, std::to_string(elapsedMs(start)) + " ms");
+
+    RetryStats after = APIService::getInstance().getRetryStats();
+    CHECK(after.retries == before.retries);
+    CHECK(after.retryAfterHonoured == before.retryAfterHonoured);
+    CHECK(after.exhausted == before.exhausted + 1);
+
+    // A success resets the host's failure count for the next test
+    ScriptedAPI healthy({}, response(200, USER));
+    APIService::getInstance().fetchUserDetails().get();
+}
+
+void testRepeatedFailuresOpenTheBreaker() {
+    // Runs last: the breaker stays open for the API host afterwards
+    ScriptedAPI api({}, response(503, ""));
+    APIService& service = APIService::getInstance();
+    RetryStats before = service.getRetryStats();
+    CircuitBreakerStats breakerBefore = service.getCircuitBreakerStats();
+
+    // Each call makes up to three attempts; the breaker opens on the fifth
+    // consecutive failure and ends the second call's retries early
+    size_t calls = 0;
+    while (service.getCircuitBreakerStats().opened == breakerBefore.opened && calls < 5) {
+        APIException failure = fetchUserFailure();
+        CHECK_MSG(failure.getError() == APIError::SERVER_5XX_ERROR, failure.what());
+        calls++;
+    }
+    CHECK(service.getCircuitBreakerStats().opened == breakerBefore.opened + 1);
+    CHECK(calls == 2);
+    CHECK(api.getRequestCount() == 5);
+
+    RetryStats after = service.getRetryStats();
+    CHECK(after.retries == before.retries + 3);
+    CHECK(after.exhausted == before.exhausted + 2);
+    CHECK(after.recovered == before.recovered);
+    CHECK(after.retryAfterHonoured == before.retryAfterHonoured);
+
+    // Open: the next call fails fast without reaching the server
+    APIException rejected = fetchUserFailure();
+    CHECK_MSG(std::string(rejected.what()).find("Circuit open") != std::string::npos, rejected.what());
+    CHECK(api.getRequestCount() == 5);
+    CHECK(service.getCircuitBreakerStats().rejected == breakerBefore.rejected + 1);
+    CHECK(service.getRetryStats().retries == after.retries);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"favorites load completes", testFavoritesLoadCompletes},
+        {"cancelled favorites load ends early", testCancelledFavoritesLoadEndsEarly},
+        {"concurrent GETs share one request", testConcurrentGetsShareOneRequest},
+        {"failure reaches every caller", testFailureReachesEveryCaller},
+        {"joining raises the shared request", testJoiningRaisesTheSharedRequest},
+        {"timing phases are filled in", testTimingPhasesAreFilledIn},
+        {"ids collapse into one endpoint", testIdsCollapseIntoOneEndpoint},
+        {"cache hits are not timed", testCacheHitsAreNotTimed},
+        {"retry-after is honoured", testRetryAfterIsHonoured},
+        {"long retry-after gives up", testLongRetryAfterGivesUp},
+        {"repeated failures open the breaker", testRepeatedFailuresOpenTheBreaker},
+    });
+}
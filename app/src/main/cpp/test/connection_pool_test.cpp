@@ -0,0 +1,247 @@
+// ConnectionPool on real loopback sockets: the per-host and global idle caps
+// in release(), idle expiry by the pool's and the server's keep-alive window,
+// and dead sockets skipped by acquire(). Then the I/O engine retrying a
+// request whose pooled socket the server closed under it, and only then.
+
+#include "test_support.h"
+#include "connection_pool.h"
+#include "io_engine.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <future>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+int connectTo(const LoopbackServer& server) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    CHECK(fd >= 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(server.getPort()));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    CHECK(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    return fd;
+}
+
+// Holds each connection open until the client closes it, counting closes
+struct IdleServer {
+    std::atomic<size_t> closed{0};
+    LoopbackServer server{[this](int fd) {
+        char c;
+        while (read(fd, &c, 1) > 0) {
+        }
+        closed++;
+    }};
+};
+
+// A socket to server, registered with and released straight into pool
+int pooled(ConnectionPool& pool, const IdleServer& idle, const std::string& host) {
+    int fd = connectTo(idle.server);
+    pool.release(pool.registerNew(fd, host, 80), true);
+    return fd;
+}
+
+void testReleaseCapsIdlePerHost() {
+    IdleServer idle;
+    CHECK(idle.server.isListening());
+    ConnectionPool pool(2, 16);
+
+    // The third release for a host closes that host's oldest
+    int first = pooled(pool, idle, "a.example");
+    int second = pooled(pool, idle, "a.example");
+    int third = pooled(pool, idle, "a.example");
+    (void)first;
+    ConnectionPoolStats stats = pool.getStats();
+    CHECK(stats.idleConnections == 2 && stats.connectionsOpened == 3 && stats.connectionsEvicted == 1);
+    CHECK(waitUntil([&]() { return idle.closed == 1; }));
+
+    // Other hosts have caps of their own
+    int other = pooled(pool, idle, "b.example");
+    CHECK(pool.getStats().idleConnections == 3);
+
+    // Most recently used comes back first
+    PooledConnection connection = pool.acquire("a.example", 80);
+    CHECK(connection.fd == third && connection.reused);
+    PooledConnection older = pool.acquire("a.example", 80);
+    CHECK(older.fd == second);
+    CHECK(!pool.acquire("a.example", 80).isValid());
+    CHECK(pool.acquire("b.example", 80).fd == other);
+    CHECK(!pool.acquire("a.example", 443).isValid());
+    CHECK(pool.getStats().connectionsReused == 3);
+
+    // Not reusable, or used up by Keep-Alive: max, means closed
+    pool.release(connection, false);
+    older.maxRequests = older.requestsServed + 1;
+    pool.release(older, true);
+    CHECK(waitUntil([&]() { return idle.closed == 3; }));
+    CHECK(pool.getStats().idleConnections == 0);
+}
+
+void testReleaseCapsIdleTotal() {
+    IdleServer idle;
+    ConnectionPool pool(2, 3);
+
+    // At the global cap the oldest idle socket of any host is closed
+    int a1 = pooled(pool, idle, "a.example");
+    int a2 = pooled(pool, idle, "a.example");
+    int b1 = pooled(pool, idle, "b.example");
+    (void)a1;
+    int b2 = pooled(pool, idle, "b.example");
+    ConnectionPoolStats stats = pool.getStats();
+    CHECK(stats.idleConnections == 3 && stats.connectionsEvicted == 1);
+    CHECK(waitUntil([&]() { return idle.closed == 1; }));
+
+    CHECK(pool.acquire("a.example", 80).fd == a2);
+    CHECK(!pool.acquire("a.example", 80).isValid());
+    PooledConnection b = pool.acquire("b.example", 80);
+    CHECK(b.fd == b2);
+    CHECK(pool.acquire("b.example", 80).fd == b1);
+
+    // Both caps at once: the host's own oldest goes, and nothing else
+    ConnectionPool tight(1, 1);
+    int c1 = pooled(tight, idle, "c.example");
+    (void)c1;
+    int c2 = pooled(tight, idle, "c.example");
+    CHECK(tight.getStats().idleConnections == 1 && tight.getStats().connectionsEvicted == 1);
+    CHECK(tight.acquire("c.example", 80).fd == c2);
+
+    close(a2);
+    close(b2);
+    close(b1);
+    close(c2);
+    CHECK(waitUntil([&]() { return idle.closed == 6; }));
+}
+
+void testIdleConnectionsExpire() {
+    IdleServer idle;
+    // The pool's own window, and a server's shorter Keep-Alive: timeout
+    ConnectionPool shortLived(4, 16, std::chrono::seconds(1));
+    pooled(shortLived, idle, "a.example");
+    ConnectionPool longLived(4, 16, std::chrono::seconds(30));
+    PooledConnection advertised = longLived.registerNew(connectTo(idle.server), "b.example", 80);
+    advertised.keepAliveTimeout = std::chrono::seconds(1);
+    longLived.release(advertised, true);
+    int kept = pooled(longLived, idle, "b.example");
+
+    // Fresh ones come back
+    PooledConnection fresh = shortLived.acquire("a.example", 80);
+    CHECK(fresh.isValid());
+    shortLived.release(fresh, true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    CHECK(!shortLived.acquire("a.example", 80).isValid());
+    CHECK(shortLived.getStats().connectionsEvicted == 1);
+    longLived.evictStale();
+    CHECK(longLived.getStats().idleConnections == 1 && longLived.getStats().connectionsEvicted == 1);
+    CHECK(longLived.acquire("b.example", 80).fd == kept);
+    CHECK(waitUntil([&]() { return idle.closed == 2; }));
+    close(kept);
+}
+
+void testDeadIdleConnectionIsSkipped() {
+    IdleServer idle;
+    LoopbackServer hangUp([](int) {});
+    ConnectionPool pool;
+    int live = pooled(pool, idle, "a.example");
+    PooledConnection dead = pool.registerNew(connectTo(hangUp), "a.example", 80);
+    CHECK(waitUntil([&]() { return hangUp.getConnectionCount() == 1; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    pool.release(dead, true);
+
+    // The newer one was closed by its server, so the older is handed out
+    CHECK(pool.acquire("a.example", 80).fd == live);
+    CHECK(pool.getStats().connectionsEvicted == 1);
+    close(live);
+}
+
+HttpResponse exchange(IOEngine& engine, const LoopbackServer& server, const std::string& path) {
+    IOJob job;
+    job.url = server.url(path);
+    job.host = server.getAddress();
+    job.port = server.getPort();
+    job.method = "GET";
+    job.requestData = "GET " + path + " HTTP/1.1\r\nHost: " + server.getAddress() + "\r\n\r\n";
+    job.totalTimeout = std::chrono::milliseconds(5000);
+    auto done = std::make_shared<std::promise<HttpResponse>>();
+    std::future<HttpResponse> result = done->get_future();
+    job.onComplete = [done](HttpResponse response) { done->set_value(std::move(response)); };
+    engine.submit(std::move(job));
+    return result.get();
+}
+
+// The first connection answers one request, then reads the next and
+// replies with partial (nothing if empty) before closing; later connections
+// answer every request
+LoopbackServer::Handler closesAfterFirst(const std::string& partial) {
+    auto connections = std::make_shared<std::atomic<int>>(0);
+    return [connections, partial](int fd) {
+        std::string request;
+        if (connections->fetch_add(1) == 0) {
+            if (readRequest(fd, request) && writeAll(fd, response(200, "first")) && readRequest(fd, request)) {
+                writeAll(fd, partial);
+            }
+            return;
+        }
+        while (readRequest(fd, request) && writeAll(fd, response(200, "again"))) {
+        }
+    };
+}
+
+void testStalePooledSocketIsRetried() {
+    LoopbackServer server(closesAfterFirst(""));
+    ConnectionPool pool;
+    IOEngine engine(pool);
+
+    HttpResponse first = exchange(engine, server, "/one");
+    CHECK_MSG(first.statusCode == 200 && first.body == "first", first.error);
+    CHECK(pool.getStats().idleConnections == 1);
+
+    // The pooled socket looks alive, then closes on the request: one retry,
+    // on a fresh connection
+    HttpResponse second = exchange(engine, server, "/two");
+    CHECK_MSG(second.statusCode == 200 && second.body == "again", second.error);
+    CHECK(engine.getStats().staleRetries == 1);
+    CHECK(server.getConnectionCount() == 2);
+    ConnectionPoolStats stats = pool.getStats();
+    CHECK(stats.connectionsReused == 1 && stats.connectionsOpened == 2 && stats.idleConnections == 1);
+}
+
+void testOnlyUnansweredReuseIsRetried() {
+    // Part of a response arrived, so the request may have been acted on
+    LoopbackServer partial(closesAfterFirst("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc"));
+    ConnectionPool pool;
+    IOEngine engine(pool);
+    CHECK(exchange(engine, partial, "/one").statusCode == 200);
+    HttpResponse cut = exchange(engine, partial, "/two");
+    CHECK(cut.errorCode == HttpError::NETWORK);
+    CHECK(engine.getStats().staleRetries == 0);
+    CHECK(partial.getConnectionCount() == 1);
+
+    // A fresh connection closing is the server's answer, not staleness
+    LoopbackServer hangUp([](int fd) {
+        std::string request;
+        readRequest(fd, request);
+    });
+    HttpResponse refused = exchange(engine, hangUp, "/");
+    CHECK(refused.errorCode == HttpError::NETWORK);
+    CHECK(engine.getStats().staleRetries == 0);
+    CHECK(hangUp.getConnectionCount() == 1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"release caps idle per host", testReleaseCapsIdlePerHost},
+        {"release caps idle total", testReleaseCapsIdleTotal},
+        {"idle connections expire", testIdleConnectionsExpire},
+        {"dead idle connection is skipped", testDeadIdleConnectionIsSkipped},
+        {"stale pooled socket is retried", testStalePooledSocketIsRetried},
+        {"only unanswered reuse is retried", testOnlyUnansweredReuseIsRetried},
+    });
+}
@@ -0,0 +1,175 @@
+// DNSResolver's cache and lookup merging, with a scripted lookup function in
+// place of getaddrinfo that counts how often it is asked.
+
+#include "test_support.h"
+#include "dns_resolver.h"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+// Answers every host with 127.0.0.1, or with an error for hosts under
+// ".invalid", after delay
+struct CountingLookup {
+    std::atomic<int> calls{0};
+    std::chrono::milliseconds delay{0};
+
+    DNSResolver::LookupFunction function() {
+        return [this](const std::string& host) {
+            calls++;
+            std::this_thread::sleep_for(delay);
+            DNSResult result;
+            if (host.size() >= 8 && host.compare(host.size() - 8, 8, ".invalid") == 0) {
+                result.error = "Host not found: " + host;
+                return result;
+            }
+            ResolvedAddress address;
+            auto* in4 = reinterpret_cast<struct sockaddr_in*>(&address.address);
+            in4->sin_family = AF_INET;
+            inet_pton(AF_INET, "127.0.0.1", &in4->sin_addr);
+            address.length = sizeof(*in4);
+            address.family = AF_INET;
+            result.addresses.push_back(address);
+            return result;
+        };
+    }
+};
+
+// Installs lookup and restores getaddrinfo and the default TTLs afterwards
+struct ResolverFixture {
+    DNSResolver& resolver = DNSResolver::getInstance();
+
+    explicit ResolverFixture(CountingLookup& lookup) {
+        resolver.clear();
+        resolver.setLookupFunction(lookup.function());
+    }
+    ~ResolverFixture() {
+        resolver.setLookupFunction(nullptr);
+        resolver.setTTL(std::chrono::seconds(60), std::chrono::seconds(10));
+        resolver.clear();
+    }
+};
+
+int portOf(const DNSResult& result) {
+    return ntohs(reinterpret_cast<const struct sockaddr_in*>(&result.addresses.at(0).address)->sin_port);
+}
+
+void testConcurrentLookupsAreMerged() {
+    CountingLookup lookup;
+    lookup.delay = std::chrono::milliseconds(100);
+    ResolverFixture fixture(lookup);
+    DNSResolverStats before = fixture.resolver.getStats();
+
+    // Every thread asks while the first lookup is still in flight
+    const int THREADS = 16;
+    std::vector<std::thread> threads;
+    std::vector<int> ports(THREADS, 0);
+    for (int i = 0; i < THREADS; ++i) {
+        threads.emplace_back([&fixture, &ports, i]() {
+            DNSResult result = fixture.resolver.resolve("api.coalesce.test", 8000 + i);
+            ports[i] = result.isSuccess() ? portOf(result) : -1;
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    CHECK(lookup.calls == 1);
+    DNSResolverStats after = fixture.resolver.getStats();
+    CHECK(after.lookups - before.lookups == 1);
+    // A thread the scheduler starts late may find the answer already cached
+    size_t coalesced = after.coalesced - before.coalesced;
+    CHECK(coalesced > 0);
+    CHECK(coalesced + after.cacheHits - before.cacheHits == THREADS - 1);
+    // The shared answer carries each caller's own port
+    for (int i = 0; i < THREADS; ++i) {
+        CHECK(ports[i] == 8000 + i);
+    }
+}
+
+void testFreshAnswersAreCacheHits() {
+    CountingLookup lookup;
+    ResolverFixture fixture(lookup);
+    DNSResolverStats before = fixture.resolver.getStats();
+
+    CHECK(fixture.resolver.resolve("api.cache.test", 443).isSuccess());
+    for (int i = 0; i < 9; ++i) {
+        CHECK(portOf(fixture.resolver.resolve("api.cache.test", 443)) == 443);
+    }
+    DNSResult cached;
+    CHECK(fixture.resolver.resolveCached("api.cache.test", 80, cached));
+    CHECK(portOf(cached) == 80);
+    CHECK(!fixture.resolver.resolveCached("other.cache.test", 80, cached));
+
+    CHECK(lookup.calls == 1);
+    DNSResolverStats after = fixture.resolver.getStats();
+    CHECK(after.misses - before.misses == 1);
+    CHECK(after.cacheHits - before.cacheHits == 10);
+}
+
+void testNegativeAnswersAreCached() {
+    CountingLookup lookup;
+    ResolverFixture fixture(lookup);
+    DNSResolverStats before = fixture.resolver.getStats();
+
+    for (int i = 0; i < 3; ++i) {
+        DNSResult result = fixture.resolver.resolve("missing.invalid", 443);
+        CHECK(!result.isSuccess());
+        CHECK(!result.error.empty());
+    }
+    CHECK(lookup.calls == 1);
+    CHECK(fixture.resolver.getStats().negativeHits - before.negativeHits == 2);
+}
+
+void testExpiredAnswersAreLookedUpAgain() {
+    CountingLookup lookup;
+    ResolverFixture fixture(lookup);
+    fixture.resolver.setTTL(std::chrono::seconds(1), std::chrono::seconds(1));
+
+    CHECK(fixture.resolver.resolve("api.expiry.test", 443).isSuccess());
+    CHECK(!fixture.resolver.resolve("gone.invalid", 443).isSuccess());
+    CHECK(fixture.resolver.resolve("api.expiry.test", 443).isSuccess());
+    CHECK(lookup.calls == 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    DNSResult cached;
+    CHECK(!fixture.resolver.resolveCached("api.expiry.test", 443, cached));
+    CHECK(fixture.resolver.resolve("api.expiry.test", 443).isSuccess());
+    CHECK(!fixture.resolver.resolve("gone.invalid", 443).isSuccess());
+    CHECK(lookup.calls == 4);
+}
+
+void testPrefetchWarmsTheCache() {
+    CountingLookup lookup;
+    lookup.delay = std::chrono::milliseconds(50);
+    ResolverFixture fixture(lookup);
+
+    fixture.resolver.prefetch("api.prefetch.test");
+    DNSResult cached;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!fixture.resolver.resolveCached("api.prefetch.test", 443, cached) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(cached.isSuccess());
+    CHECK(fixture.resolver.resolve("api.prefetch.test", 443).isSuccess());
+    CHECK(lookup.calls == 1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"concurrent lookups are merged", testConcurrentLookupsAreMerged},
+        {"fresh answers are cache hits", testFreshAnswersAreCacheHits},
+        {"negative answers are cached", testNegativeAnswersAreCached},
+        {"expired answers are looked up again", testExpiredAnswersAreLookedUpAgain},
+        {"prefetch warms the cache", testPrefetchWarmsTheCache},
+    });
+}
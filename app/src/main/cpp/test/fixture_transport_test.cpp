@@ -0,0 +1,96 @@
+// ReplayTransport's handling of cancellation: a cancelled request finishes
+// as soon as its token fires, whatever step of its delivery is next.
+
+#include "test_support.h"
+#include "fixture_transport.h"
+#include "cancellation.h"
+#include <future>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+IOJob makeJob(std::shared_ptr<CancellationToken> cancellation, std::promise<HttpResponse>& done) {
+    IOJob job;
+    job.url = "https://api.example/v1/slow";
+    job.host = "api.example";
+    job.port = 443;
+    job.secure = true;
+    job.method = "GET";
+    job.totalTimeout = std::chrono::milliseconds(0);
+    job.connectTimeout = std::chrono::milliseconds(0);
+    job.firstByteTimeout = std::chrono::milliseconds(0);
+    job.cancellation = std::move(cancellation);
+    job.onComplete = [&done](HttpResponse response) { done.set_value(std::move(response)); };
+    return job;
+}
+
+// Cancels after delayMs and returns how long the request then took to end
+double cancelAfter(ReplayTransport& transport, int delayMs) {
+    auto cancellation = CancellationToken::create();
+    std::promise<HttpResponse> done;
+    std::future<HttpResponse> result = done.get_future();
+    transport.submit(makeJob(cancellation, done));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    auto cancelledAt = std::chrono::steady_clock::now();
+    cancellation->cancel();
+    CHECK(result.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    double elapsed = elapsedMs(cancelledAt);
+    HttpResponse response = result.get();
+    CHECK_MSG(response.errorCode == HttpError::CANCELLED, response.error);
+    return elapsed;
+}
+
+void testCancelDuringLatency() {
+    ReplayTransport transport(std::chrono::seconds(10));
+    transport.setDefaultResponse(200, "{}");
+    double elapsed = cancelAfter(transport, 20);
+    CHECK_MSG(elapsed < 100, std::to_string(elapsed) + " ms");
+}
+
+void testCancelDuringBody() {
+    // 64 KB at 16 KB/s: a chunk is due only once a second
+    ReplayTransport transport(std::chrono::milliseconds(0), 16 * 1024);
+    transport.setDefaultResponse(200, std::string(64 * 1024, 'x'));
+    double elapsed = cancelAfter(transport, 50);
+    CHECK_MSG(elapsed < 100, std::to_string(elapsed) + " ms");
+}
+
+void testCancelledBeforeSubmit() {
+    ReplayTransport transport(std::chrono::seconds(10));
+    transport.setDefaultResponse(200, "{}");
+    auto cancellation = CancellationToken::create();
+    cancellation->cancel();
+    std::promise<HttpResponse> done;
+    std::future<HttpResponse> result = done.get_future();
+    transport.submit(makeJob(cancellation, done));
+    CHECK(result.wait_for(std::chrono::milliseconds(100)) == std::future_status::ready);
+    CHECK(result.get().errorCode == HttpError::CANCELLED);
+}
+
+void testCancelAfterTransportDestroyed() {
+    auto cancellation = CancellationToken::create();
+    std::promise<HttpResponse> done;
+    std::future<HttpResponse> result = done.get_future();
+    {
+        ReplayTransport transport(std::chrono::seconds(10));
+        transport.setDefaultResponse(200, "{}");
+        transport.submit(makeJob(cancellation, done));
+    }
+    CHECK(result.get().errorCode == HttpError::SHUTTING_DOWN);
+    // Must not reach the destroyed transport
+    cancellation->cancel();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"cancel during latency", testCancelDuringLatency},
+        {"cancel during body", testCancelDuringBody},
+        {"cancelled before submit", testCancelledBeforeSubmit},
+        {"cancel after transport destroyed", testCancelAfterTransportDestroyed},
+    });
+}
@@ -0,0 +1,162 @@
+// Happy Eyeballs in the I/O engine: a host resolves to ::1 and 127.0.0.1 on
+// the same port, with the IPv6 side stalled, refused or serving, through a
+// scripted DNSResolver lookup.
+
+#include "test_support.h"
+#include "http_client.h"
+#include "dns_resolver.h"
+#include "io_engine.h"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <memory>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+// IOEngine's CONNECTION_ATTEMPT_DELAY
+const double ATTEMPT_DELAY_MS = 250;
+
+ResolvedAddress loopback(int family) {
+    ResolvedAddress address;
+    if (family == AF_INET6) {
+        auto* in6 = reinterpret_cast<struct sockaddr_in6*>(&address.address);
+        in6->sin6_family = AF_INET6;
+        in6->sin6_addr = in6addr_loopback;
+        address.length = sizeof(*in6);
+    } else {
+        auto* in4 = reinterpret_cast<struct sockaddr_in*>(&address.address);
+        in4->sin_family = AF_INET;
+        in4->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.length = sizeof(*in4);
+    }
+    address.family = family;
+    return address;
+}
+
+// Resolves every host to ::1 then 127.0.0.1, the order getaddrinfo gives
+// on an IPv6-preferring network
+struct DualStackFixture {
+    DualStackFixture() {
+        DNSResolver& resolver = DNSResolver::getInstance();
+        resolver.clear();
+        resolver.setLookupFunction([](const std::string&) {
+            DNSResult result;
+            result.addresses.push_back(loopback(AF_INET6));
+            result.addresses.push_back(loopback(AF_INET));
+            return result;
+        });
+        HttpClient::getInstance().setCacheEnabled(false);
+        HttpClient::getInstance().closeIdleConnections();
+    }
+    ~DualStackFixture() {
+        DNSResolver::getInstance().setLookupFunction(nullptr);
+        DNSResolver::getInstance().clear();
+        HttpClient::getInstance().closeIdleConnections();
+    }
+};
+
+// An IPv4 server, and a stalled IPv6 listener on the same port when
+// stallIPv6 is set
+struct DualStackServer {
+    std::unique_ptr<LoopbackServer> ipv4;
+    std::unique_ptr<StalledListener> ipv6;
+
+    explicit DualStackServer(bool stallIPv6) {
+        // The IPv4 port may already be taken on ::1; try a few
+        for (int i = 0; i < 20; ++i) {
+            ipv4.reset(new LoopbackServer(serveForever(response(200, "ipv4"))));
+            CHECK(ipv4->isListening());
+            if (!stallIPv6) {
+                return;
+            }
+            ipv6.reset(new StalledListener("::1", ipv4->getPort()));
+            if (ipv6->isListening()) {
+                return;
+            }
+        }
+        CHECK(!"no port free on both 127.0.0.1 and ::1");
+    }
+
+    std::string url(const std::string& host, const std::string& path) const {
+        return "http://" + host + ":" + std::to_string(ipv4->getPort()) + path;
+    }
+};
+
+size_t connectFallbacks() {
+    auto engine = std::dynamic_pointer_cast<IOEngine>(HttpClient::getInstance().getTransport());
+    CHECK(engine != nullptr);
+    return engine->getStats().connectFallbacks;
+}
+
+double connectMs(const HttpResponse& response) {
+    return std::chrono::duration<double, std::milli>(response.timing.connect).count();
+}
+
+void testBlackholedIPv6FallsBackToIPv4() {
+    DualStackFixture fixture;
+    DualStackServer server(true);
+    size_t fallbacks = connectFallbacks();
+
+    auto start = std::chrono::steady_clock::now();
+    HttpResponse response = HttpClient::getInstance().get(server.url("blackhole.test", "/"));
+    double elapsed = elapsedMs(start);
+    CHECK_MSG(response.statusCode == 200, response.error);
+    CHECK(response.body == "ipv4");
+    // IPv4 starts once the IPv6 attempt has had its head start, and wins
+    // well before any connect timeout
+    CHECK_MSG(connectMs(response) >= ATTEMPT_DELAY_MS - 10, std::to_string(connectMs(response)) + " ms");
+    CHECK_MSG(elapsed < ATTEMPT_DELAY_MS + 500, std::to_string(elapsed) + " ms");
+    CHECK(connectFallbacks() == fallbacks + 1);
+    printf("     fallback connect %.1f ms, request %.1f ms\n", connectMs(response), elapsed);
+}
+
+void testWinningFamilyIsRemembered() {
+    DualStackFixture fixture;
+    DualStackServer server(true);
+    HttpClient& client = HttpClient::getInstance();
+    CHECK(client.get(server.url("remember.test", "/")).statusCode == 200);
+    size_t fallbacks = connectFallbacks();
+
+    // The next new connection tries IPv4 first and skips the wait
+    client.closeIdleConnections();
+    HttpResponse response = client.get(server.url("remember.test", "/"));
+    CHECK_MSG(response.statusCode == 200, response.error);
+    CHECK(!response.timing.reusedConnection);
+    CHECK_MSG(connectMs(response) < ATTEMPT_DELAY_MS / 2, std::to_string(connectMs(response)) + " ms");
+    CHECK(connectFallbacks() == fallbacks);
+}
+
+void testRefusedIPv6FallsBackAtOnce() {
+    // Nothing listens on ::1, so its attempt fails fast and IPv4 need not
+    // wait out the delay
+    DualStackFixture fixture;
+    DualStackServer server(false);
+    HttpResponse response = HttpClient::getInstance().get(server.url("refused.test", "/"));
+    CHECK_MSG(response.statusCode == 200, response.error);
+    CHECK_MSG(connectMs(response) < ATTEMPT_DELAY_MS / 2, std::to_string(connectMs(response)) + " ms");
+}
+
+void testReachableIPv6Wins() {
+    DualStackFixture fixture;
+    LoopbackServer ipv6(serveForever(response(200, "ipv6")), "::1");
+    CHECK(ipv6.isListening());
+    size_t fallbacks = connectFallbacks();
+    HttpResponse response =
+        HttpClient::getInstance().get("http://reachable.test:" + std::to_string(ipv6.getPort()) + "/");
+    CHECK_MSG(response.statusCode == 200, response.error);
+    CHECK(response.body == "ipv6");
+    CHECK(connectFallbacks() == fallbacks);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"blackholed IPv6 falls back to IPv4", testBlackholedIPv6FallsBackToIPv4},
+        {"winning family is remembered", testWinningFamilyIsRemembered},
+        {"refused IPv6 falls back at once", testRefusedIPv6FallsBackAtOnce},
+        {"reachable IPv6 wins", testReachableIPv6Wins},
+    });
+}
@@ -0,0 +1,205 @@
+// HttpCache on its own and behind HttpClient: what reaches the disk, how the
+// disk tier is accounted, and a 304 that arrives after its entry is gone.
+
+#include "test_support.h"
+#include "http_cache.h"
+#include "http_client.h"
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+const char* const TOKEN = "secret-bearer-token-0123456789";
+
+// A fresh, empty directory under /tmp
+std::string makeDirectory() {
+    char path[] = "/tmp/localify-cache-test-XXXXXX";
+    CHECK(mkdtemp(path) != nullptr);
+    return path;
+}
+
+std::vector<std::string> readFiles(const std::string& directory) {
+    std::vector<std::string> contents;
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* item = readdir(dir)) {
+            if (item->d_name[0] != '.') {
+                std::ifstream file(directory + "/" + item->d_name, std::ios::binary);
+                contents.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+        }
+        closedir(dir);
+    }
+    return contents;
+}
+
+void removeDirectory(const std::string& directory) {
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* item = readdir(dir)) {
+            if (item->d_name[0] != '.') {
+                unlink((directory + "/" + item->d_name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(directory.c_str());
+}
+
+HttpRequest authorizedGet(const std::string& url) {
+    HttpRequest request(url);
+    request.setAuthorization(TOKEN);
+    return request;
+}
+
+HttpResponse cacheableResponse(const std::string& body) {
+    HttpResponse response;
+    response.statusCode = 200;
+    response.body = body;
+    response.headers.set("Cache-Control", "max-age=60");
+    response.headers.set("ETag", "\"v1\"");
+    response.headers.set("Vary", "Authorization");
+    return response;
+}
+
+// Waits for the background writer until the disk tier holds at least bytes
+size_t waitForDiskBytes(const HttpCache& cache, size_t bytes) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (cache.getStats().diskBytes < bytes && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Give a miscounted write the chance to show up
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return cache.getStats().diskBytes;
+}
+
+void testDiskHoldsNoCredentials() {
+    std::string directory = makeDirectory();
+    {
+        HttpCache cache;
+        cache.setDiskDirectory(directory);
+        HttpRequest request = authorizedGet("https://api.example/v1/@me");
+        cache.store(request, cacheableResponse("{\"name\":\"me\"}"));
+        waitForDiskBytes(cache, 1);
+
+        std::vector<std::string> files = readFiles(directory);
+        CHECK(files.size() == 1);
+        CHECK(files[0].find(TOKEN) == std::string::npos);
+        CHECK(files[0].find("{\"name\":\"me\"}") != std::string::npos);
+    }
+
+    // Reloaded from disk for the same user only
+    HttpCache reloaded;
+    reloaded.setDiskDirectory(directory);
+    HttpRequest same = authorizedGet("https://api.example/v1/@me");
+    HttpResponse cached;
+    CHECK(reloaded.lookup(same, cached) == HttpCache::Lookup::FRESH);
+    CHECK(cached.body == "{\"name\":\"me\"}");
+    HttpRequest other("https://api.example/v1/@me");
+    other.setAuthorization("someone-else");
+    CHECK(reloaded.lookup(other, cached) == HttpCache::Lookup::MISS);
+    removeDirectory(directory);
+}
+
+void testOutdatedFilesRemoved() {
+    std::string directory = makeDirectory();
+    {
+        std::ofstream old(directory + "/0123456789abcdef", std::ios::binary);
+        old << "21\nLOCALIFY-HTTP-CACHE 1\n";
+    }
+    HttpCache cache;
+    cache.setDiskDirectory(directory);
+    CHECK(readFiles(directory).empty());
+    CHECK(cache.getStats().diskBytes == 0);
+    removeDirectory(directory);
+}
+
+void testOverwriteKeepsDiskBytes() {
+    std::string directory = makeDirectory();
+    HttpCache cache;
+    cache.setDiskDirectory(directory);
+
+    // Same-sized entries under two keys of the same length
+    HttpRequest first = authorizedGet("https://api.example/v1/a");
+    HttpRequest second = authorizedGet("https://api.example/v1/b");
+    cache.store(first, cacheableResponse("body"));
+    size_t one = waitForDiskBytes(cache, 1);
+    CHECK(one > 0);
+
+    cache.store(first, cacheableResponse("body"));
+    cache.store(second, cacheableResponse("body"));
+    size_t total = waitForDiskBytes(cache, 2 * one);
+    CHECK_MSG(total == 2 * one, std::to_string(total) + " bytes for two " + std::to_string(one) + " byte files");
+    removeDirectory(directory);
+}
+
+void testRevalidatedAfterEviction() {
+    HttpCache cache;
+    HttpRequest request = authorizedGet("https://api.example/v1/@me");
+    HttpResponse stored = cacheableResponse("cached");
+    stored.headers.set("Cache-Control", "no-cache");
+    cache.store(request, stored);
+
+    HttpRequest conditional = request;
+    HttpResponse cached;
+    CHECK(cache.lookup(conditional, cached) == HttpCache::Lookup::STALE);
+    CHECK(conditional.headers.get("If-None-Match") == "\"v1\"");
+
+    HttpResponse notModified;
+    notModified.statusCode = 304;
+    HttpResponse full;
+    CHECK(cache.revalidated(conditional, notModified, full));
+    CHECK(full.statusCode == 200 && full.body == "cached");
+
+    cache.clear();
+    CHECK(!cache.revalidated(conditional, notModified, full));
+}
+
+void testClientResendsWhenEntryEvicted() {
+    // The server empties the client's cache before answering the conditional
+    // request, as an eviction racing the 304 would
+    std::atomic<int> requests(0);
+    std::atomic<int> conditionals(0);
+    LoopbackServer server([&requests, &conditionals](int fd) {
+        std::string request;
+        while (readRequest(fd, request)) {
+            requests++;
+            if (request.find("If-None-Match") != std::string::npos) {
+                conditionals++;
+                HttpClient::getInstance().clearCache();
+                writeAll(fd, "HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\n\r\n");
+            } else {
+                writeAll(fd, response(200, "full body", "ETag: \"v1\"\r\nCache-Control: no-cache\r\n"));
+            }
+        }
+    });
+    CHECK(server.isListening());
+
+    HttpClient& client = HttpClient::getInstance();
+    client.setCacheEnabled(true);
+    client.clearCache();
+    HttpResponse first = client.get(server.url("/profile"));
+    CHECK_MSG(first.statusCode == 200, first.error);
+
+    HttpResponse second = client.get(server.url("/profile"));
+    CHECK_MSG(second.statusCode == 200, second.error + " status " + std::to_string(second.statusCode));
+    CHECK(second.body == "full body");
+    CHECK(conditionals == 1);
+    CHECK(requests == 3);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"disk holds no credentials", testDiskHoldsNoCredentials},
+        {"outdated files removed", testOutdatedFilesRemoved},
+        {"overwrite keeps disk bytes", testOverwriteKeepsDiskBytes},
+        {"revalidated after eviction", testRevalidatedAfterEviction},
+        {"client resends when entry evicted", testClientResendsWhenEntryEvicted},
+    });
+}
@@ -0,0 +1,467 @@
+// Chunked and gzip/deflate bodies: ChunkedDecoder and HttpResponseParser fed
+// fixtures split at every byte boundary, and HttpClient against a loopback
+// server serving the same fixtures. Bodies with embedded NULs received
+// straight into the parser's windows, with the bytes it copies counted.
+// Streamed JSON arrays: JSONArrayStream behind the parser at every split,
+// malformed tails, and HttpClient::stream stopped early.
+
+#include "test_support.h"
+#include "http_client.h"
+#include "http_decoder.h"
+#include "http_response_parser.h"
+#include "json_parser.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+std::string event(int i) {
+    return "{\"id\":\"event-" + std::to_string(i) + "\",\"venueName\":\"The Fillmore\",\"city\":\"San Francisco\","
+           "\"state\":\"CA\",\"country\":\"US\",\"genres\":[\"indie\",\"rock\"]}";
+}
+
+// Repetitive, like the API's event feeds, so it compresses well
+std::string eventFeed(int events) {
+    std::string json = "[";
+    for (int i = 0; i < events; ++i) {
+        json += i > 0 ? "," : "";
+        json += event(i);
+    }
+    return json + "]";
+}
+
+std::string compress(const std::string& data, InflateDecoder::Format format) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    int windowBits = format == InflateDecoder::Format::GZIP ? 15 + 16 : 15;
+    CHECK(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    CHECK(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+// data in chunks of the given sizes, cycling, with an extension and a trailer
+std::string chunked(const std::string& data, std::initializer_list<size_t> sizes) {
+    std::string out;
+    size_t at = 0;
+    for (size_t i = 0; at < data.size(); ++i) {
+        size_t size = std::min(*(sizes.begin() + i % sizes.size()), data.size() - at);
+        char line[32];
+        snprintf(line, sizeof(line), i == 1 ? "%zx;name=value\r\n" : "%zX\r\n", size);
+        out += line;
+        out.append(data, at, size);
+        out += "\r\n";
+        at += size;
+    }
+    return out + "0\r\nX-Trailer: done\r\n\r\n";
+}
+
+std::string chunkedResponse(const std::string& body, const std::string& extraHeaders = std::string()) {
+    return "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n" + extraHeaders + "\r\n" +
+           chunked(body, {1, 7, 300, 16, 4096});
+}
+
+// Feeds message in two pieces split at split, or byte by byte if split is 0
+HttpResponseParser::Status parse(const std::string& message, size_t split, HttpResponse& response,
+                                 std::string& error) {
+    HttpResponseParser parser("GET");
+    HttpResponseParser::Status status = HttpResponseParser::Status::NEED_MORE;
+    if (split == 0) {
+        for (size_t i = 0; i < message.size() && status == HttpResponseParser::Status::NEED_MORE; ++i) {
+            status = parser.feed(&message[i], 1);
+        }
+    } else {
+        status = parser.feed(message.data(), split);
+        if (status == HttpResponseParser::Status::NEED_MORE) {
+            status = parser.feed(message.data() + split, message.size() - split);
+        }
+    }
+    if (status == HttpResponseParser::Status::NEED_MORE) {
+        status = parser.finish();
+    }
+    error = parser.getError();
+    if (status == HttpResponseParser::Status::COMPLETE) {
+        response = parser.takeResponse();
+    }
+    return status;
+}
+
+// Every split point, plus byte-at-a-time, must decode to body
+void checkEverySplit(const std::string& message, const std::string& body) {
+    for (size_t split = 0; split < message.size(); ++split) {
+        HttpResponse response;
+        std::string error;
+        CHECK_MSG(parse(message, split, response, error) == HttpResponseParser::Status::COMPLETE,
+                  "split at " + std::to_string(split) + ": " + error);
+        CHECK_MSG(response.body == body, "split at " + std::to_string(split));
+    }
+}
+
+void testChunkedDecoderSplitBoundaries() {
+    const std::string payload = "hello, chunked world";
+    const std::string encoded = chunked(payload, {3, 5}) + "HTTP/1.1 next";
+    const size_t messageLength = encoded.size() - strlen("HTTP/1.1 next");
+    for (size_t split = 0; split <= encoded.size(); ++split) {
+        ChunkedDecoder decoder;
+        std::string out;
+        auto sink = [&out](const char* data, size_t length) {
+            out.append(data, length);
+            return true;
+        };
+        size_t first = 0;
+        size_t second = 0;
+        auto result = decoder.decode(encoded.data(), split, first, sink);
+        if (result == ChunkedDecoder::Result::NEED_MORE) {
+            CHECK(first == split);
+            result = decoder.decode(encoded.data() + split, encoded.size() - split, second, sink);
+        }
+        CHECK_MSG(result == ChunkedDecoder::Result::DONE, "split at " + std::to_string(split));
+        CHECK(out == payload);
+        // The next pipelined response is left for the caller
+        CHECK(first + second == messageLength);
+    }
+}
+
+void testChunkedDecoderRejectsMalformedInput() {
+    for (const char* bad : {"zz\r\nabc\r\n", "3\r\nabcX\r\n", "FFFFFFFFFFFFFFFFFF\r\n"}) {
+        ChunkedDecoder decoder;
+        size_t consumed = 0;
+        auto result = decoder.decode(bad, strlen(bad), consumed, [](const char*, size_t) { return true; });
+        CHECK_MSG(result == ChunkedDecoder::Result::ERROR, bad);
+    }
+}
+
+void testChunkedResponse() {
+    std::string body = eventFeed(20);
+    checkEverySplit(chunkedResponse(body), body);
+}
+
+void testGzipResponse() {
+    std::string body = eventFeed(50);
+    std::string gzip = compress(body, InflateDecoder::Format::GZIP);
+    CHECK(gzip.size() * 4 < body.size());
+    checkEverySplit("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " + std::to_string(gzip.size()) +
+                    "\r\n\r\n" + gzip, body);
+    checkEverySplit(chunkedResponse(gzip, "Content-Encoding: gzip\r\n"), body);
+}
+
+void testDeflateResponse() {
+    // "deflate" means zlib-wrapped, but servers also send raw deflate
+    std::string body = eventFeed(50);
+    std::string zlib = compress(body, InflateDecoder::Format::DEFLATE);
+    checkEverySplit(chunkedResponse(zlib, "Content-Encoding: deflate\r\n"), body);
+    std::string raw = zlib.substr(2, zlib.size() - 6);
+    checkEverySplit("HTTP/1.1 200 OK\r\nContent-Encoding: deflate\r\nContent-Length: " + std::to_string(raw.size()) +
+                    "\r\n\r\n" + raw, body);
+}
+
+void testTruncatedGzipTrailer() {
+    std::string body = eventFeed(50);
+    std::string gzip = compress(body, InflateDecoder::Format::GZIP);
+    // Drop the CRC32/ISIZE trailer: every payload byte is there, but the
+    // stream never ends
+    std::string truncated = gzip.substr(0, gzip.size() - 8);
+    for (const std::string& message : {
+             "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " + std::to_string(truncated.size()) +
+                 "\r\n\r\n" + truncated,
+             chunkedResponse(truncated, "Content-Encoding: gzip\r\n"),
+             "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nConnection: close\r\n\r\n" + truncated}) {
+        HttpResponse response;
+        std::string error;
+        CHECK(parse(message, 0, response, error) == HttpResponseParser::Status::ERROR);
+        CHECK_MSG(error == "Truncated compressed body", error);
+    }
+
+    // A corrupt trailer fails the CRC check instead
+    std::string corrupt = gzip;
+    corrupt[corrupt.size() - 6] ^= 0xFF;
+    HttpResponse response;
+    std::string error;
+    CHECK(parse("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " + std::to_string(corrupt.size()) +
+                "\r\n\r\n" + corrupt, 0, response, error) == HttpResponseParser::Status::ERROR);
+}
+
+void testClientNegotiatesEncoding() {
+    std::string body = eventFeed(200);
+    std::string gzip = compress(body, InflateDecoder::Format::GZIP);
+    std::string acceptEncoding;
+    std::mutex mutex;
+    LoopbackServer server([&](int fd) {
+        std::string request;
+        while (readRequest(fd, request)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::string lower = request;
+                std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                size_t field = lower.find("\r\naccept-encoding:");
+                acceptEncoding = field == std::string::npos
+                    ? std::string() : lower.substr(field + 18, lower.find("\r\n", field + 2) - field - 18);
+            }
+            if (!writeAll(fd, chunkedResponse(gzip, "Content-Encoding: gzip\r\n"))) {
+                return;
+            }
+        }
+    });
+    CHECK(server.isListening());
+
+    HttpClient& client = HttpClient::getInstance();
+    client.setCacheEnabled(false);
+    HttpResponse response = client.get(server.url("/events"));
+    CHECK_MSG(response.statusCode == 200, response.error);
+    CHECK(response.body == body);
+    CHECK(response.timing.bytesReceived < body.size() / 4);
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK_MSG(acceptEncoding.find("gzip") != std::string::npos, acceptEncoding);
+    CHECK_MSG(acceptEncoding.find("deflate") != std::string::npos, acceptEncoding);
+}
+
+// Receives message the way the transport does, straight into the parser's
+// windows: first bytes in the first read, then at most window bytes a read
+HttpResponseParser::Status receive(HttpResponseParser& parser, const std::string& message, size_t first,
+                                   size_t window) {
+    HttpResponseParser::Status status = HttpResponseParser::Status::NEED_MORE;
+    for (size_t at = 0; at < message.size() && status == HttpResponseParser::Status::NEED_MORE;) {
+        HttpResponseParser::Window space = parser.prepare();
+        CHECK(space.size > 0);
+        size_t count = std::min({space.size, at == 0 ? first : window, message.size() - at});
+        // Stands in for recv(), so not a copy the parser should count
+        memcpy(space.data, message.data() + at, count);
+        at += count;
+        status = parser.commit(count);
+    }
+    return status == HttpResponseParser::Status::NEED_MORE ? parser.finish() : status;
+}
+
+void testBinaryBodyReceivedInPlace() {
+    // NULs at both ends and on every side of every 7-byte window
+    std::string body(1, '\0');
+    for (int i = 0; i < 100; ++i) {
+        body += i % 3 == 0 ? '\0' : static_cast<char>(i % 2 == 0 ? 'a' + i % 26 : 0x80 + i);
+    }
+    body += '\0';
+    const std::string SIZED = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: " +
+                              std::to_string(body.size()) + "\r\n\r\n";
+    const std::string UNSIZED = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n";
+
+    // Only the body bytes that share a read with the headers are copied
+    for (const std::string* head : {&SIZED, &UNSIZED}) {
+        for (size_t tail = 0; tail <= body.size(); ++tail) {
+            std::string where = (head == &SIZED ? "sized, " : "unsized, ") + std::to_string(tail) + " with headers";
+            HttpResponseParser parser("GET");
+            CHECK_MSG(receive(parser, *head + body, head->size() + tail, 7) == HttpResponseParser::Status::COMPLETE,
+                      where + ": " + parser.getError());
+            CHECK_MSG(parser.isKeepAlive() == (head == &SIZED), where);
+            HttpResponse response = parser.takeResponse();
+            CHECK_MSG(response.body.size() == body.size(), where + ": " + std::to_string(response.body.size()));
+            CHECK_MSG(response.body == body, where);
+            CHECK_MSG(response.bytesCopied == tail, where + ": " + std::to_string(response.bytesCopied));
+        }
+    }
+
+    // Chunked bodies are decoded out of a scratch window, once per byte
+    std::string message = chunkedResponse(body);
+    for (size_t first : {message.find("\r\n\r\n") + 4, message.size()}) {
+        HttpResponseParser parser("GET");
+        CHECK(receive(parser, message, first, 7) == HttpResponseParser::Status::COMPLETE);
+        HttpResponse response = parser.takeResponse();
+        CHECK(response.body == body);
+        CHECK_MSG(response.bytesCopied == body.size(), std::to_string(response.bytesCopied));
+    }
+}
+
+struct Streamed {
+    HttpResponseParser::Status status;
+    std::vector<std::string> elements;
+    std::vector<size_t> deliveredAt;    // bytes of the message fed when each element arrived
+    bool complete;
+};
+
+// Streams message's body into a JSONArrayStream as HttpClient::stream
+// would, in two pieces split at split, or byte by byte if split is 0
+Streamed streamArray(const std::string& message, size_t split) {
+    Streamed streamed;
+    size_t fed = 0;
+    JSONArrayStream array([&streamed, &fed](std::string element) {
+        streamed.elements.push_back(std::move(element));
+        streamed.deliveredAt.push_back(fed);
+    });
+    HttpResponseParser parser("GET");
+    parser.setStreamHandlers([](const HttpResponse& head) { return head.statusCode == 200; },
+                             [&array](const char* data, size_t length) { return array.feed(data, length); });
+    streamed.status = HttpResponseParser::Status::NEED_MORE;
+    for (size_t start = 0; start < message.size() && streamed.status == HttpResponseParser::Status::NEED_MORE;) {
+        fed = split == 0 ? start + 1 : (start < split ? split : message.size());
+        streamed.status = parser.feed(message.data() + start, fed - start);
+        start = fed;
+    }
+    streamed.complete = array.isComplete();
+    return streamed;
+}
+
+void testArrayStreamEverySplit() {
+    const size_t EVENTS = 30;
+    std::string message = chunkedResponse(compress(eventFeed(EVENTS), InflateDecoder::Format::GZIP),
+                                          "Content-Encoding: gzip\r\n");
+    for (size_t split = 0; split < message.size(); ++split) {
+        std::string where = "split at " + std::to_string(split);
+        Streamed streamed = streamArray(message, split);
+        CHECK_MSG(streamed.status == HttpResponseParser::Status::COMPLETE, where);
+        CHECK_MSG(streamed.complete, where);
+        CHECK_MSG(streamed.elements.size() == EVENTS, where);
+        for (size_t i = 0; i < EVENTS; ++i) {
+            CHECK_MSG(streamed.elements[i] == event(static_cast<int>(i)), where + ", element " + std::to_string(i));
+        }
+    }
+
+    // Byte by byte, each element is handed out once its last byte has been
+    // inflated, not when the response ends
+    Streamed streamed = streamArray(message, 0);
+    CHECK(streamed.deliveredAt.back() < message.size());
+    CHECK(std::is_sorted(streamed.deliveredAt.begin(), streamed.deliveredAt.end()));
+    size_t distinct = std::unique(streamed.deliveredAt.begin(), streamed.deliveredAt.end()) - streamed.deliveredAt.begin();
+    CHECK_MSG(distinct > EVENTS / 2, std::to_string(distinct) + " distinct delivery points");
+}
+
+struct ArrayCase {
+    const char* json;
+    std::vector<std::string> elements;      // handed out before the input ends or goes wrong
+    bool complete;
+    bool malformed;
+};
+
+void testArrayStreamMalformedTail() {
+    const ArrayCase CASES[] = {
+        {R"([ 1 , "a,]}" , {"c":[1,2]} , [] ])", {"1", R"("a,]}")", R"({"c":[1,2]})", "[]"}, true, false},
+        {" [ ] ", {}, true, false},
+        {R"([{"a":1},{"b":2}}])", {R"({"a":1})", R"({"b":2})"}, false, true},
+        {R"([{"a":1},{"b":2},])", {R"({"a":1})", R"({"b":2})"}, false, true},
+        {R"([{"a":1},,{"b":2}])", {R"({"a":1})"}, false, true},
+        {R"([{"a":1} {"b":2}])", {R"({"a":1})"}, false, true},
+        {R"([,1])", {}, false, true},
+        {R"([1})", {}, false, true},
+        {R"({"a":1})", {}, false, true},
+        // Cut off: everything before the cut, but never complete
+        {R"([{"a":1},{"b":)", {R"({"a":1})"}, false, false},
+    };
+    for (const ArrayCase& c : CASES) {
+        std::string json = c.json;
+        for (size_t split = 0; split <= json.size(); ++split) {
+            std::string where = json + " split at " + std::to_string(split);
+            std::vector<std::string> elements;
+            JSONArrayStream array([&elements](std::string element) { elements.push_back(std::move(element)); });
+            bool accepted = array.feed(json.data(), split);
+            accepted = array.feed(json.data() + split, json.size() - split) && accepted;
+            CHECK_MSG(elements == c.elements, where);
+            CHECK_MSG(array.isComplete() == c.complete, where);
+            CHECK_MSG(array.isMalformed() == c.malformed, where);
+            CHECK_MSG(accepted == !c.malformed, where);
+            CHECK(array.getElementCount() == c.elements.size());
+        }
+    }
+}
+
+struct StreamResult {
+    std::vector<std::string> elements;
+    HttpResponse response;
+    double elapsedMs;
+};
+
+// Streams url through HttpClient into a JSONArrayStream; onElement returns
+// false to stop the transfer
+StreamResult streamURL(const std::string& url, const std::function<bool(size_t elements)>& onElement) {
+    StreamResult result;
+    JSONArrayStream array([&result](std::string element) { result.elements.push_back(std::move(element)); });
+    std::promise<HttpResponse> done;
+    auto start = std::chrono::steady_clock::now();
+    HttpRequest request;
+    request.url = url;
+    request.method = "GET";
+    HttpClient::getInstance().stream(request,
+        [](const HttpResponse& head) { return head.statusCode == 200; },
+        [&array, &result, &onElement](const char* data, size_t length) {
+            return array.feed(data, length) && onElement(result.elements.size());
+        },
+        [&done](const HttpResponse& response) { done.set_value(response); });
+    result.response = done.get_future().get();
+    result.elapsedMs = elapsedMs(start);
+    return result;
+}
+
+void testStreamStopsEarly() {
+    // One event per chunk, 5 ms apart: two seconds to send them all
+    const int EVENTS = 400;
+    std::atomic<bool> closed(false);
+    LoopbackServer server([&closed](int fd) {
+        std::string request;
+        if (!readRequest(fd, request) || !writeAll(fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n")) {
+            return;
+        }
+        for (int i = 0; i < EVENTS; ++i) {
+            std::string piece = (i == 0 ? "[" : ",") + event(i) + (i == EVENTS - 1 ? "]" : "");
+            char size[16];
+            snprintf(size, sizeof(size), "%zx\r\n", piece.size());
+            if (!writeAll(fd, size + piece + "\r\n")) {
+                closed = true;
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        writeAll(fd, "0\r\n\r\n");
+    });
+    CHECK(server.isListening());
+
+    StreamResult result = streamURL(server.url("/events"), [](size_t elements) { return elements < 10; });
+    CHECK_MSG(result.response.errorCode == HttpError::CANCELLED, result.response.error);
+    CHECK(result.response.body.empty());
+    CHECK_MSG(result.elements.size() >= 10 && result.elements.size() < 20, std::to_string(result.elements.size()));
+    for (size_t i = 0; i < result.elements.size(); ++i) {
+        CHECK(result.elements[i] == event(static_cast<int>(i)));
+    }
+    CHECK_MSG(result.elapsedMs < 1000, std::to_string(result.elapsedMs) + " ms");
+    // The connection is dropped rather than drained for reuse
+    CHECK(waitUntil([&closed]() { return closed.load(); }));
+}
+
+void testStreamMalformedTailAborts() {
+    // Five good events, then a trailing comma, gzip-encoded and chunked
+    std::string body = eventFeed(5);
+    body.insert(body.size() - 1, ",");
+    std::string full = chunkedResponse(compress(body, InflateDecoder::Format::GZIP), "Content-Encoding: gzip\r\n");
+    LoopbackServer server(serveForever(full));
+    CHECK(server.isListening());
+
+    StreamResult result = streamURL(server.url("/events"), [](size_t) { return true; });
+    CHECK_MSG(result.response.errorCode == HttpError::CANCELLED, result.response.error);
+    CHECK(result.elements.size() == 5);
+    CHECK(result.elements.back() == event(4));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"chunked decoder split boundaries", testChunkedDecoderSplitBoundaries},
+        {"chunked decoder rejects malformed input", testChunkedDecoderRejectsMalformedInput},
+        {"chunked response", testChunkedResponse},
+        {"gzip response", testGzipResponse},
+        {"deflate response", testDeflateResponse},
+        {"truncated gzip trailer", testTruncatedGzipTrailer},
+        {"client negotiates encoding", testClientNegotiatesEncoding},
+        {"binary body received in place", testBinaryBodyReceivedInPlace},
+        {"array stream every split", testArrayStreamEverySplit},
+        {"array stream malformed tail", testArrayStreamMalformedTail},
+        {"stream stops early", testStreamStopsEarly},
+        {"stream malformed tail aborts", testStreamMalformedTailAborts},
+    });
+}
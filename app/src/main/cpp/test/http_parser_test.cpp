@@ -0,0 +1,202 @@
+// HttpParser's URL and status-line parsing, and HttpHeaders' case-insensitive
+// lookup when a header appears more than once.
+
+#include "test_support.h"
+#include "http_parser.h"
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+struct UrlCase {
+    const char* url;
+    const char* host;
+    int port;
+    const char* path;
+    const char* query;
+    bool isHttps;
+};
+
+const UrlCase GOOD_URLS[] = {
+    {"http://example.com", "example.com", 80, "/", "", false},
+    {"https://example.com", "example.com", 443, "/", "", true},
+    {"HTTPS://Example.com/Path", "Example.com", 443, "/Path", "", true},
+    {"https://api.example.com:8443/v1/events?city=1&page=2#top", "api.example.com", 8443, "/v1/events",
+     "?city=1&page=2", true},
+    {"http://localhost:1/", "localhost", 1, "/", "", false},
+    {"http://localhost:65535/x", "localhost", 65535, "/x", "", false},
+    {"http://host:/x", "host", 80, "/x", "", false},
+    {"https://[::1]:8080/p", "::1", 8080, "/p", "", true},
+    {"http://[2001:db8::1]/", "2001:db8::1", 80, "/", "", false},
+    {"https://[fe80::1%25wlan0]", "fe80::1%25wlan0", 443, "/", "", true},
+    {"https://example.com?q=a%20b", "example.com", 443, "/", "?q=a%20b", true},
+    {"https://example.com:444?q", "example.com", 444, "/", "?q", true},
+    {"https://[::1]?q=1", "::1", 443, "/", "?q=1", true},
+    {"https://example.com/?", "example.com", 443, "/", "?", true},
+    {"https://example.com#only-fragment", "example.com", 443, "/", "", true},
+    {"https://example.com/a?b=c?d#e?f", "example.com", 443, "/a", "?b=c?d", true},
+};
+
+const char* const BAD_URLS[] = {
+    "",
+    "example.com/path",
+    "ftp://example.com/",
+    "http:/example.com",
+    "http://",
+    "http:///path",
+    "http://:8080/",
+    "http://host:8a/",
+    "http://host:-1/",
+    "http://host:65536/",
+    "http://host:99999999999/",
+    "http://user@host/",
+    "http://[::1/",
+    "http://[::1]8080/",
+    "http://[]/",
+    "http://::1/",
+};
+
+void testParseUrl() {
+    for (const UrlCase& c : GOOD_URLS) {
+        ParsedUrl parsed;
+        CHECK_MSG(HttpParser::parseUrl(c.url, parsed), c.url);
+        CHECK_MSG(parsed.host == c.host, std::string(c.url) + " host " + std::string(parsed.host));
+        CHECK_MSG(parsed.port == c.port, std::string(c.url) + " port " + std::to_string(parsed.port));
+        CHECK_MSG(parsed.path == c.path, std::string(c.url) + " path " + std::string(parsed.path));
+        CHECK_MSG(parsed.query == c.query, std::string(c.url) + " query " + std::string(parsed.query));
+        CHECK_MSG(parsed.isHttps == c.isHttps, c.url);
+    }
+    for (const char* url : BAD_URLS) {
+        ParsedUrl parsed;
+        CHECK_MSG(!HttpParser::parseUrl(url, parsed), url);
+    }
+
+    // Every part is a view into the caller's string
+    std::string url = "https://[::1]:8443/v1?x=1";
+    ParsedUrl parsed;
+    CHECK(HttpParser::parseUrl(url, parsed));
+    CHECK(parsed.scheme.data() == url.data());
+    CHECK(parsed.host.data() == url.data() + 9);
+    CHECK(parsed.query.data() + parsed.query.size() == url.data() + url.size());
+}
+
+struct StatusCase {
+    const char* line;
+    int statusCode;
+    int minorVersion;
+};
+
+const StatusCase GOOD_STATUS_LINES[] = {
+    {"HTTP/1.1 200 OK", 200, 1},
+    {"HTTP/1.0 404 Not Found", 404, 0},
+    {"HTTP/1.1 204", 204, 1},
+    {"HTTP/1.1 301 ", 301, 1},
+    {"HTTP/1.1 503 Service Unavailable Right Now", 503, 1},
+    {"HTTP/1.1 999 Unknown", 999, 1},
+    {"HTTP/1.9 100 Continue", 100, 9},
+};
+
+const char* const BAD_STATUS_LINES[] = {
+    "",
+    "HTTP/1.1",
+    "HTTP/1.1 ",
+    "HTTP/1.1 20",
+    "HTTP/1.1 20 OK",
+    "HTTP/1.1 2000 OK",
+    "HTTP/1.1 200OK",
+    "HTTP/1.1 2x0 OK",
+    "HTTP/1.1  200 OK",
+    "HTTP/1.x 200 OK",
+    "HTTP/1.12 200 OK",
+    "HTTP/1 200 OK",
+    "HTTP/2 200 OK",
+    "HTTP/2.0 200 OK",
+    "HTTP/0.9 200 OK",
+    "http/1.1 200 OK",
+    "HTTPS/1.1 200 OK",
+    " HTTP/1.1 200 OK",
+};
+
+void testParseStatusLine() {
+    for (const StatusCase& c : GOOD_STATUS_LINES) {
+        int statusCode = 0;
+        int minorVersion = -1;
+        CHECK_MSG(HttpParser::parseStatusLine(c.line, statusCode, minorVersion), c.line);
+        CHECK_MSG(statusCode == c.statusCode && minorVersion == c.minorVersion, c.line);
+    }
+    for (const char* line : BAD_STATUS_LINES) {
+        int statusCode = -1;
+        int minorVersion = -1;
+        CHECK_MSG(!HttpParser::parseStatusLine(line, statusCode, minorVersion), line);
+        // A rejected line leaves the previous status alone
+        CHECK_MSG(statusCode == -1, line);
+    }
+}
+
+void testRepeatedHeadersLookUpIgnoringCase() {
+    HttpHeaders headers;
+    HttpParser::parseHeaderLines("Set-Cookie: a=1\r\n"
+                                 "Content-Type:  application/json \r\n"
+                                 "not a header\r\n"
+                                 ": no name\r\n"
+                                 "set-cookie: b=2\r\n"
+                                 "SET-COOKIE:c=3\r\n"
+                                 "X-Empty:",
+                                 headers);
+    CHECK(headers.size() == 5);
+
+    // Lookup returns the first of the repeats, whatever the case on either side
+    for (const char* name : {"Set-Cookie", "set-cookie", "SET-COOKIE", "sEt-CoOkIe"}) {
+        CHECK_MSG(headers.get(name) == "a=1", name);
+        CHECK_MSG(headers.has(name), name);
+    }
+    CHECK(headers.get("content-type") == "application/json");
+    CHECK(headers.has("x-empty") && headers.get("X-EMPTY").empty());
+    CHECK(!headers.has("Set-Cookie2") && !headers.has("Set-Cooki") && headers.get("Cookie").empty());
+
+    // Iteration keeps every repeat in arrival order, with its own spelling
+    std::vector<std::string> cookies;
+    for (HttpHeaders::Field field : headers) {
+        if (HttpHeaders::equalsIgnoreCase(field.name, "set-cookie")) {
+            cookies.push_back(std::string(field.name) + "=" + std::string(field.value));
+        }
+    }
+    CHECK(cookies == std::vector<std::string>({"Set-Cookie=a=1", "set-cookie=b=2", "SET-COOKIE=c=3"}));
+
+    // set() replaces every repeat; remove() takes them all
+    HttpHeaders copy = headers;
+    copy.set("SET-cookie", "d=4");
+    CHECK(copy.size() == 3);
+    CHECK(copy.get("Set-Cookie") == "d=4");
+    CHECK(copy.at(2).name == "SET-cookie");
+    CHECK(headers.remove("set-COOKIE"));
+    CHECK(!headers.remove("Set-Cookie"));
+    CHECK(headers.size() == 2 && !headers.has("set-cookie"));
+    CHECK(headers.get("Content-Type") == "application/json");
+
+    // The list form applies set(), so the last of a repeated name wins
+    HttpHeaders listed{{"Accept", "text/html"}, {"ACCEPT", "application/json"}};
+    CHECK(listed.size() == 1 && listed.get("accept") == "application/json");
+}
+
+void testHeaderTokens() {
+    CHECK(HttpHeaders::equalsIgnoreCase("Cache-Control", "cache-CONTROL"));
+    CHECK(!HttpHeaders::equalsIgnoreCase("Cache-Control", "Cache-Contro"));
+    CHECK(!HttpHeaders::equalsIgnoreCase("a-b", "a_b"));
+    CHECK(HttpHeaders::containsToken("no-cache, No-Store", "no-store"));
+    CHECK(HttpHeaders::containsToken("max-age=0;must-revalidate", "MUST-REVALIDATE"));
+    CHECK(!HttpHeaders::containsToken("no-storex, private", "no-store"));
+    CHECK(!HttpHeaders::containsToken("", "gzip"));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"parse url", testParseUrl},
+        {"parse status line", testParseStatusLine},
+        {"repeated headers look up ignoring case", testRepeatedHeadersLookUpIgnoringCase},
+        {"header tokens", testHeaderTokens},
+    });
+}
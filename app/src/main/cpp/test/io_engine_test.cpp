@@ -0,0 +1,210 @@
+// Loopback stress test for the I/O engine: 500 requests in flight at once
+// against a server that holds each one for a moment. It reports the client's
+// peak thread count and latency percentiles for the engine, and for the
+// thread-per-request shape that getAsync used to have.
+//
+// The server runs in a child process forked before the client starts any
+// threads, so /proc/self/task counts only the client's threads.
+
+#include "test_support.h"
+#include "http_client.h"
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <future>
+#include <vector>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+const size_t REQUESTS = 500;
+const auto SERVER_DELAY = std::chrono::milliseconds(50);
+
+pid_t serverPid = -1;
+int serverPort = 0;
+
+// Forks the server; the child serves until the parent closes the pipe
+bool startServer() {
+    int ready[2];
+    int stop[2];
+    if (pipe(ready) != 0 || pipe(stop) != 0) {
+        return false;
+    }
+    serverPid = fork();
+    if (serverPid == 0) {
+        close(ready[0]);
+        close(stop[1]);
+        LoopbackServer server([](int fd) {
+            std::string request;
+            while (readRequest(fd, request)) {
+                std::this_thread::sleep_for(SERVER_DELAY);
+                if (!writeAll(fd, response(200, "stress"))) {
+                    return;
+                }
+            }
+        });
+        int port = server.isListening() ? server.getPort() : 0;
+        ssize_t written = write(ready[1], &port, sizeof(port));
+        char byte;
+        while (written == sizeof(port) && read(stop[0], &byte, 1) > 0) {
+        }
+        _exit(0);
+    }
+    close(ready[1]);
+    close(stop[0]);
+    // The write end stays open for the life of the test; the child sees EOF
+    // when this process exits, however it exits
+    bool ok = read(ready[0], &serverPort, sizeof(serverPort)) == sizeof(serverPort) && serverPort != 0;
+    close(ready[0]);
+    return serverPid > 0 && ok;
+}
+
+void stopServer() {
+    if (serverPid > 0) {
+        kill(serverPid, SIGTERM);
+        waitpid(serverPid, nullptr, 0);
+    }
+}
+
+size_t threadCount() {
+    size_t count = 0;
+    DIR* tasks = opendir("/proc/self/task");
+    if (tasks == nullptr) {
+        return 0;
+    }
+    while (struct dirent* entry = readdir(tasks)) {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(tasks);
+    return count;
+}
+
+// Samples the thread count until stopped; the sampler itself is excluded
+class ThreadSampler {
+public:
+    ThreadSampler() : peak(0), stopping(false), thread([this]() {
+        while (!stopping) {
+            peak = std::max(peak.load(), threadCount() - 1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }) {}
+
+    size_t stop() {
+        stopping = true;
+        thread.join();
+        return peak;
+    }
+
+private:
+    std::atomic<size_t> peak;
+    std::atomic<bool> stopping;
+    std::thread thread;
+};
+
+struct StressResult {
+    size_t peakThreads;
+    size_t failures;
+    double p50Ms;
+    double p99Ms;
+    double wallMs;
+};
+
+double percentile(std::vector<double>& values, double fraction) {
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(values.size() * fraction));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Issues REQUESTS requests at once through issue() and waits for them all
+template<typename Issue>
+StressResult stress(const char* name, Issue issue) {
+    HttpClient& client = HttpClient::getInstance();
+    client.closeIdleConnections();
+    std::string url = "http://127.0.0.1:" + std::to_string(serverPort) + "/stress";
+
+    ThreadSampler sampler;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<HttpResponse>> futures;
+    futures.reserve(REQUESTS);
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        futures.push_back(issue(client, url));
+    }
+
+    StressResult result = {0, 0, 0, 0, 0};
+    std::vector<double> latencies;
+    for (auto& future : futures) {
+        HttpResponse response = future.get();
+        if (response.statusCode != 200 || response.body != "stress") {
+            result.failures++;
+            continue;
+        }
+        latencies.push_back(std::chrono::duration<double, std::milli>(response.timing.total).count());
+    }
+    result.wallMs = elapsedMs(start);
+    result.peakThreads = sampler.stop();
+    if (!latencies.empty()) {
+        result.p50Ms = percentile(latencies, 0.50);
+        result.p99Ms = percentile(latencies, 0.99);
+    }
+    printf("     %-20s threads %4zu   p50 %7.1f ms   p99 %7.1f ms   wall %7.1f ms   failures %zu\n", name,
+           result.peakThreads, result.p50Ms, result.p99Ms, result.wallMs, result.failures);
+    return result;
+}
+
+struct StressFixture {
+    StressFixture() {
+        HttpClient& client = HttpClient::getInstance();
+        client.setCacheEnabled(false);
+        client.setHostConcurrency(REQUESTS, REQUESTS);
+    }
+    ~StressFixture() {
+        HttpClient& client = HttpClient::getInstance();
+        client.setHostConcurrency(6, 4);
+        client.closeIdleConnections();
+    }
+};
+
+void testEngineDrivesConcurrentRequests() {
+    StressFixture fixture;
+    size_t idleThreads = threadCount();
+    StressResult result = stress("event loop", [](HttpClient& client, const std::string& url) {
+        return client.getAsync(url);
+    });
+    CHECK(result.failures == 0);
+    // The engine adds its loop thread, not one thread per request
+    CHECK_MSG(result.peakThreads < idleThreads + 16,
+              std::to_string(result.peakThreads) + " threads, " + std::to_string(idleThreads) + " idle");
+    // Every request was in flight at once, so the batch takes about one
+    // server delay rather than many
+    CHECK_MSG(result.p99Ms < 2000, std::to_string(result.p99Ms));
+}
+
+void testThreadPerRequestBaseline() {
+    // What getAsync did before the engine: a blocking request on its own thread
+    StressFixture fixture;
+    StressResult result = stress("thread per request", [](HttpClient& client, const std::string& url) {
+        return std::async(std::launch::async, [&client, url]() { return client.get(url); });
+    });
+    CHECK(result.failures == 0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!startServer()) {
+        fprintf(stderr, "could not start the loopback server\n");
+        return 1;
+    }
+    int status = run(argc, argv, {
+        {"engine drives 500 concurrent requests", testEngineDrivesConcurrentRequests},
+        {"thread per request baseline", testThreadPerRequestBaseline},
+    });
+    stopServer();
+    return status;
+}
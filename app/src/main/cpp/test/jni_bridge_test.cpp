@@ -0,0 +1,135 @@
+// jni_bridge.cpp against the host <jni.h> stand-in: results decoded from
+// an API response with malformed UTF-8 must reach NewStringUTF as valid
+// modified UTF-8, with U+FFFD for every bad sequence.
+
+#include "test_support.h"
+#include "jni_bridge.h"
+#include "api_service.h"
+#include "fixture_transport.h"
+#include <deque>
+#include <memory>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+struct HostString : _jstring {
+    std::string bytes;
+};
+
+// Plays the JVM: NewStringUTF fails the test on anything CheckJNI would
+// abort on, and on raw surrogates or overlong forms besides C0 80, which
+// no valid JSON text from the bridge contains
+class FakeJVM : public JNIEnv {
+public:
+    jstring NewStringUTF(const char* bytes) override {
+        std::string text(bytes);
+        checkModifiedUTF8(text);
+        return make(text);
+    }
+    const char* GetStringUTFChars(jstring string, jboolean* isCopy) override {
+        if (isCopy != nullptr) {
+            *isCopy = JNI_FALSE;
+        }
+        return static_cast<HostString*>(string)->bytes.c_str();
+    }
+    void ReleaseStringUTFChars(jstring, const char*) override {}
+
+    jstring make(const std::string& text) {
+        strings.emplace_back();
+        strings.back().bytes = text;
+        return &strings.back();
+    }
+
+    static const std::string& bytesOf(jstring string) { return static_cast<HostString*>(string)->bytes; }
+
+private:
+    static void checkModifiedUTF8(const std::string& text) {
+        for (size_t i = 0; i < text.size();) {
+            unsigned char lead = static_cast<unsigned char>(text[i]);
+            size_t length = lead < 0x80 ? 1 : (lead & 0xE0) == 0xC0 ? 2 : (lead & 0xF0) == 0xE0 ? 3 : 0;
+            CHECK_MSG(length > 0, "bad lead byte at " + std::to_string(i) + " in " + text);
+            CHECK_MSG(i + length <= text.size(), "truncated sequence in " + text);
+            uint32_t codePoint = length == 1 ? lead : lead & (length == 2 ? 0x1F : 0x0F);
+            for (size_t k = 1; k < length; ++k) {
+                unsigned char c = static_cast<unsigned char>(text[i + k]);
+                CHECK_MSG((c & 0xC0) == 0x80, "missing continuation byte in " + text);
+                codePoint = (codePoint << 6) | (c & 0x3F);
+            }
+            CHECK_MSG(length < 2 || codePoint >= (length == 2 ? 0x80u : 0x800u), "overlong form in " + text);
+            CHECK_MSG(codePoint < 0xD800 || codePoint > 0xDFFF, "raw surrogate in " + text);
+            i += length;
+        }
+    }
+
+    std::deque<HostString> strings;
+};
+
+struct Case {
+    const char* name;
+    const char* expected;
+};
+
+// Names as the API might send them, and as they must reach Java
+const Case CASES[] = {
+    {"plain", "plain"},
+    {"caf\xC3\xA9 \xE2\x82\xAC", "caf\xC3\xA9 \xE2\x82\xAC"},
+    {"emoji \xF0\x9F\x98\x80", "emoji \\ud83d\\ude00"},
+    {"stray \x80\xBF", "stray \\ufffd\\ufffd"},
+    {"overlong \xC0\xAF \xE0\x80\xAF", "overlong \\ufffd\\ufffd \\ufffd\\ufffd\\ufffd"},
+    {"surrogate \xED\xA0\x80", "surrogate \\ufffd\\ufffd\\ufffd"},
+    {"truncated \xE2\x82 \xF0\x9F\x98", "truncated \\ufffd \\ufffd"},
+    {"too high \xF4\x90\x80\x80 \xF5", "too high \\ufffd\\ufffd\\ufffd\\ufffd \\ufffd"},
+    {"at end \xC3", "at end \\ufffd"},
+};
+
+void testMalformedUTF8IsReplaced() {
+    std::string body = "[";
+    for (const Case& c : CASES) {
+        body += (body.size() > 1 ? ",{\"id\":\"" : "{\"id\":\"") + std::string(c.name) + "\",\"name\":\"" + c.name +
+                "\",\"genres\":[\"" + c.name + "\"]}";
+    }
+    body += "]";
+    auto replay = std::make_shared<ReplayTransport>();
+    replay->setDefaultResponse(200, body);
+    HttpClient::getInstance().setTransport(replay);
+    HttpClient::getInstance().setCacheEnabled(false);
+
+    FakeJVM jvm;
+    jstring result = Java_com_localify_android_LocalifyNative_fetchSearchArtists(&jvm, nullptr,
+                                                                                  jvm.make("utf-8"), 20);
+    const std::string& json = FakeJVM::bytesOf(result);
+    CHECK_MSG(json.find("\"error\"") == std::string::npos, json);
+    for (const Case& c : CASES) {
+        std::string expected = "\"" + std::string(c.expected) + "\"";
+        CHECK_MSG(json.find("{\"id\":" + expected + ",\"name\":" + expected) != std::string::npos, c.expected);
+        CHECK_MSG(json.find("\"genres\":[" + expected + "]") != std::string::npos, c.expected);
+    }
+
+    HttpClient::getInstance().setTransport(nullptr);
+}
+
+void testFailureReachesJava() {
+    // The error object goes through the same checks
+    auto replay = std::make_shared<ReplayTransport>();
+    replay->setDefaultResponse(404, "no such \xFF artist");
+    HttpClient::getInstance().setTransport(replay);
+    HttpClient::getInstance().setCacheEnabled(false);
+
+    FakeJVM jvm;
+    jstring result = Java_com_localify_android_LocalifyNative_fetchSearchArtists(&jvm, nullptr,
+                                                                                  jvm.make("broken"), 20);
+    CHECK_MSG(FakeJVM::bytesOf(result).find("{\"error\":") == 0, FakeJVM::bytesOf(result));
+
+    HttpClient::getInstance().setTransport(nullptr);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"malformed UTF-8 is replaced", testMalformedUTF8IsReplaced},
+        {"failure reaches Java", testFailureReachesJava},
+    });
+}
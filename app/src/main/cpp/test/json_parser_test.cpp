@@ -0,0 +1,260 @@
+// JSONTape's validation of numbers and strings against RFC 8259, every
+// JSONParser::parse* entry point read back field by field, and the
+// per-thread scratch tape letting go of a large document's storage.
+
+#include "test_support.h"
+#include "json_parser.h"
+#include "json_tape.h"
+#include "model_schema.h"
+#include <cmath>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+bool near(double a, double b) {
+    return std::fabs(a - b) < 1e-9;
+}
+
+void testTapeRejectsMalformedNumbers() {
+    for (const char* bad : {"1-2", "--1", "-", "-a", "1e", "1e+", "1E-", "1ee2", "1.", ".5", "01", "-01", "1.e5",
+                            "+1", "0x10", "[1-2]", "[1,-]", "{\"a\":1e}", "{\"a\":2.}"}) {
+        JSONTape tape;
+        CHECK_MSG(!tape.parse(bad), bad);
+        CHECK(!tape.root().isValid());
+    }
+    for (const char* good : {"0", "-0", "7", "-12", "1.5", "0.25e-3", "1E+10", "6e2", " 42 ", "[1,-2,3.0]",
+                             "{\"a\":-0.5e1}"}) {
+        JSONTape tape;
+        CHECK_MSG(tape.parse(good), std::string(good) + ": " + tape.getError());
+    }
+
+    JSONTape tape;
+    CHECK(tape.parse("[-12,0.25e-3,1E+10,0]"));
+    std::vector<double> values;
+    tape.root().forEachElement([&values](JSONValue value) { values.push_back(value.asDouble(-1)); });
+    CHECK(values.size() == 4);
+    CHECK(near(values[0], -12) && near(values[1], 0.00025) && near(values[2], 1e10) && near(values[3], 0));
+}
+
+void testTapeRejectsRawControlCharacters() {
+    const std::string BAD[] = {
+        "\"tab\there\"",
+        "\"line\nbreak\"",
+        "\"\x01\"",
+        "\"\x1f\"",
+        "{\"key\nname\":1}",
+        std::string("[\"ok\",\"nul") + '\0' + "\"]",
+    };
+    for (const std::string& bad : BAD) {
+        JSONTape tape;
+        CHECK_MSG(!tape.parse(bad), bad);
+        CHECK_MSG(tape.getError().find("control character") != std::string::npos, tape.getError());
+    }
+
+    // Escaped, they are fine, as are DEL and UTF-8
+    JSONTape tape;
+    CHECK(tape.parse("[\"tab\\there\",\"\x7f\",\"caf\xC3\xA9\"]"));
+    std::vector<std::string> strings;
+    tape.root().forEachElement([&strings](JSONValue value) { strings.push_back(value.asString()); });
+    CHECK(strings == std::vector<std::string>({"tab\there", "\x7f", "caf\xC3\xA9"}));
+}
+
+void testParseUserDetails() {
+    UserDetails user = JSONParser::parseUserDetails(R"({
+        "id":"u1","name":"Ada \"The Countess\"","email":"ada@example.com","appleId":null,"spotifyId":"sp1",
+        "accountCreationDate":1700000000123,"profileImage":"https://img.example.com/u1.png",
+        "playlistLocalSongsPerSeed":3,"anonymousUser":false,"emailConnected":true,"appleConnected":false,
+        "spotifyConnected":true,"emailVerified":true,"emailOptIn":false,"isAdmin":false,"isTeamMember":true,
+        "playlistUseSeedSongs":true,"playlistGeneration":false,"unknown":{"nested":[1,{"deeper":null}]}})");
+    CHECK(user.id == "u1");
+    CHECK(user.name == "Ada \"The Countess\"");
+    CHECK(user.email == std::optional<std::string>("ada@example.com"));
+    CHECK(!user.appleId.has_value());
+    CHECK(user.spotifyId == std::optional<std::string>("sp1"));
+    CHECK(user.accountCreationDate == 1700000000123);
+    CHECK(user.profileImage == std::optional<std::string>("https://img.example.com/u1.png"));
+    CHECK(!user.spotifyProfileImage.has_value());
+    CHECK(user.playlistLocalSongsPerSeed == std::optional<int>(3));
+    CHECK(!user.anonymousUser && user.emailConnected && !user.appleConnected && user.spotifyConnected);
+    CHECK(user.emailVerified && !user.emailOptIn && !user.isAdmin && user.isTeamMember);
+    CHECK(user.playlistUseSeedSongs && !user.playlistGeneration);
+
+    // Past 32 bits both ways, on every ABI
+    JSONWriter writer;
+    writeJSON(writer, user);
+    CHECK_MSG(writer.str().find("\"accountCreationDate\":1700000000123,") != std::string::npos, writer.str());
+    CHECK(JSONParser::parseUserDetails(writer.str()).accountCreationDate == 1700000000123);
+    UserDetails negative = JSONParser::parseUserDetails(R"({"accountCreationDate":-4102444800000})");
+    CHECK(negative.accountCreationDate == -4102444800000);
+}
+
+const char* const ARTIST = R"({"id":"a1","name":"Café Tacvba","imageUrl":"https://img.example.com/a1.jpg",
+    "genres":["rock","latin\/alt"],"popularity":87,"isFavorite":true})";
+const char* const EVENT = R"({"id":"e1","name":"Late Show","description":"Doors at 8\nShow at 9",
+    "startDate":"2026-05-01T20:00:00Z","endDate":"2026-05-01T23:00:00Z","imageUrl":null,"venueId":"v1",
+    "venueName":"The Fillmore","artists":[{"id":"a1","name":"First"},{"id":"a2","name":"Second","popularity":5}],
+    "isFavorite":false,"latitude":37.784,"longitude":-122.433})";
+const char* const VENUE = R"({"id":"v1","name":"The Fillmore","address":"1805 Geary Blvd","city":"San Francisco",
+    "state":"CA","country":"US","latitude":37.784,"longitude":-122.433,"isFavorite":true})";
+const char* const CITY = R"({"id":"c1","name":"San Francisco","state":"CA","country":"US",
+    "latitude":37.7749,"longitude":-122.4194})";
+
+void checkArtist(const ArtistResponse& artist) {
+    CHECK(artist.id == "a1");
+    CHECK(artist.name == "Caf\xC3\xA9 Tacvba");
+    CHECK(artist.imageUrl.has_value() && *artist.imageUrl == "https://img.example.com/a1.jpg");
+    CHECK(!artist.spotifyId.has_value());
+    CHECK(artist.genres.size() == 2 && artist.genres[0] == "rock" && artist.genres[1] == "latin/alt");
+    CHECK(artist.popularity == 87);
+    CHECK(artist.isFavorite);
+}
+
+void checkEvent(const EventResponse& event) {
+    CHECK(event.id == "e1");
+    CHECK(event.name == "Late Show");
+    CHECK(event.description == "Doors at 8\nShow at 9");
+    CHECK(event.startDate == "2026-05-01T20:00:00Z");
+    CHECK(event.endDate == "2026-05-01T23:00:00Z");
+    CHECK(!event.imageUrl.has_value());
+    CHECK(event.venueId == "v1");
+    CHECK(event.venueName == "The Fillmore");
+    CHECK(event.artists.size() == 2);
+    CHECK(event.artists[0].id == "a1" && event.artists[0].name == "First");
+    CHECK(event.artists[1].id == "a2" && event.artists[1].popularity == 5);
+    CHECK(!event.isFavorite);
+    CHECK(near(event.latitude, 37.784) && near(event.longitude, -122.433));
+}
+
+void checkVenue(const VenueResponse& venue) {
+    CHECK(venue.id == "v1");
+    CHECK(venue.name == "The Fillmore");
+    CHECK(venue.address == "1805 Geary Blvd");
+    CHECK(venue.city == "San Francisco" && venue.state == "CA" && venue.country == "US");
+    CHECK(near(venue.latitude, 37.784) && near(venue.longitude, -122.433));
+    CHECK(!venue.imageUrl.has_value());
+    CHECK(venue.isFavorite);
+}
+
+void checkCity(const CityResponse& city) {
+    CHECK(city.id == "c1");
+    CHECK(city.name == "San Francisco");
+    CHECK(city.state == "CA" && city.country == "US");
+    CHECK(near(city.latitude, 37.7749) && near(city.longitude, -122.4194));
+}
+
+void testParseModels() {
+    checkArtist(JSONParser::parseArtistResponse(ARTIST));
+    checkEvent(JSONParser::parseEventResponse(EVENT));
+    checkVenue(JSONParser::parseVenueResponse(VENUE));
+    checkCity(JSONParser::parseCityResponse(CITY));
+
+    AuthResponse auth = JSONParser::parseAuthResponse(R"({"token":"t.k.n","refreshToken":"r1","expiresIn":3600})");
+    CHECK(auth.token == "t.k.n" && auth.refreshToken == "r1" && auth.expiresIn == 3600);
+
+    UserCity userCity = JSONParser::parseUserCity(
+        R"({"id":"uc1","cityId":"c1","cityName":"San Francisco","radius":25.5,"selected":true})");
+    CHECK(userCity.id == "uc1" && userCity.cityId == "c1" && userCity.cityName == "San Francisco");
+    CHECK(near(userCity.radius, 25.5) && userCity.selected);
+
+    ErrorResponse error = JSONParser::parseErrorResponse(R"({"status":404,"error":"Not Found","message":null,
+        "path":"/v1/artists/9","timestamp":"2026-05-01T20:00:00Z","requestId":"req-1"})");
+    CHECK(error.status == 404 && error.error == "Not Found" && !error.message.has_value());
+    CHECK(error.path == "/v1/artists/9" && error.timestamp == "2026-05-01T20:00:00Z" && error.requestId == "req-1");
+}
+
+void testParseArraysAndSearch() {
+    auto wrap = [](const char* element) { return "[" + std::string(element) + "," + element + "]"; };
+    std::vector<ArtistResponse> artists = JSONParser::parseArtistArray(wrap(ARTIST));
+    CHECK(artists.size() == 2);
+    checkArtist(artists[1]);
+    std::vector<EventResponse> events = JSONParser::parseEventArray(wrap(EVENT));
+    CHECK(events.size() == 2);
+    checkEvent(events[1]);
+    std::vector<VenueResponse> venues = JSONParser::parseVenueArray(wrap(VENUE));
+    CHECK(venues.size() == 2);
+    checkVenue(venues[1]);
+    std::vector<CityResponse> cities = JSONParser::parseCityArray(wrap(CITY));
+    CHECK(cities.size() == 2);
+    checkCity(cities[1]);
+    std::vector<UserCity> userCities = JSONParser::parseUserCityArray(R"([{"id":"uc1","radius":5},{"id":"uc2"}])");
+    CHECK(userCities.size() == 2 && userCities[0].id == "uc1" && near(userCities[0].radius, 5));
+    CHECK(userCities[1].id == "uc2");
+    CHECK(JSONParser::parseStringArray(R"(["a","b\"c","é😀"])") ==
+          std::vector<std::string>({"a", "b\"c", "\xC3\xA9\xF0\x9F\x98\x80"}));
+
+    std::string search = std::string(R"({"artists":[)") + ARTIST + R"(],"events":[)" + EVENT + R"(],"venues":[)" +
+                         VENUE + R"(],"cities":[)" + CITY + "]}";
+    SearchResponse eager = JSONParser::parseSearchResponse(search);
+    CHECK(eager.artists.size() == 1 && eager.events.size() == 1 && eager.venues.size() == 1 && eager.cities.size() == 1);
+    checkArtist(eager.artists[0]);
+    checkEvent(eager.events[0]);
+    checkVenue(eager.venues[0]);
+    checkCity(eager.cities[0]);
+
+    std::shared_ptr<LazySearchResponse> lazy = JSONParser::parseSearchResponseLazy(search);
+    CHECK(lazy->events().size() == 1);
+    checkEvent(lazy->events()[0]);
+    checkArtist(lazy->artists().at(0));
+    checkVenue(lazy->venues().at(0));
+    checkCity(lazy->cities().at(0));
+}
+
+void testMalformedDocumentsGiveDefaults() {
+    CHECK(JSONParser::parseUserDetails(R"({"id":"u1","accountCreationDate":1-2})").id.empty());
+    CHECK(JSONParser::parseArtistResponse("{\"id\":\"a1\",\"name\":\"raw\nnewline\"}").id.empty());
+    CHECK(JSONParser::parseArtistArray(R"([{"id":"a1"},{"id":"a2","popularity":1e}])").empty());
+    CHECK(JSONParser::parseStringArray(R"(["a",--1])").empty());
+    CHECK(JSONParser::parseSearchResponseLazy(R"({"artists":[{"id":"a1","popularity":01}]})")->artists().empty());
+
+    // Well-formed but of the wrong type: that field alone falls back
+    ArtistResponse artist = JSONParser::parseArtistResponse(
+        R"({"id":"a1","name":7,"genres":"rock","popularity":"high","isFavorite":1})");
+    CHECK(artist.id == "a1");
+    CHECK(artist.name.empty());
+    CHECK(artist.genres.empty());
+    CHECK(artist.popularity == 0);
+    CHECK(!artist.isFavorite);
+}
+
+std::string stringArray(size_t count) {
+    std::string json = "[";
+    for (size_t i = 0; i < count; ++i) {
+        json += i > 0 ? ",\"s\"" : "\"s\"";
+    }
+    return json + "]";
+}
+
+void testScratchTapeGivesBackLargeStorage() {
+    JSONTape& tape = JSONTape::scratch();
+    const size_t LIMIT = 1024 * 1024;
+
+    // A thousand tokens stay allocated for the next document
+    std::string small = stringArray(1000);
+    CHECK(JSONParser::parseStringArray(small).size() == 1000);
+    CHECK(tape.getRetainedBytes() >= 1000 * sizeof(JSONToken));
+    CHECK(JSONTape::scratch().getRetainedBytes() >= 1000 * sizeof(JSONToken));
+
+    // Half a million are held only until the thread's next document
+    std::string large = stringArray(500000);
+    CHECK(JSONParser::parseStringArray(large).size() == 500000);
+    CHECK(tape.getRetainedBytes() > LIMIT);
+    CHECK(&JSONTape::scratch() == &tape);
+    CHECK_MSG(tape.getRetainedBytes() < LIMIT, std::to_string(tape.getRetainedBytes()) + " bytes");
+    CHECK(JSONParser::parseStringArray(small).size() == 1000);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"tape rejects malformed numbers", testTapeRejectsMalformedNumbers},
+        {"tape rejects raw control characters", testTapeRejectsRawControlCharacters},
+        {"parse user details", testParseUserDetails},
+        {"parse models", testParseModels},
+        {"parse arrays and search", testParseArraysAndSearch},
+        {"malformed documents give defaults", testMalformedDocumentsGiveDefaults},
+        {"scratch tape gives back large storage", testScratchTapeGivesBackLargeStorage},
+    });
+}
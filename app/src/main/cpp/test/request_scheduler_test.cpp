@@ -0,0 +1,167 @@
+// Ordering in RequestScheduler, on its own and behind APIService: queued
+// background work (favorites) must yield to a user-visible search.
+
+#include "test_support.h"
+#include "api_service.h"
+#include "fixture_transport.h"
+#include "request_scheduler.h"
+#include "app_config.h"
+#include <thread>
+#include <vector>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+// Records the order tickets start in; finish() frees them by name
+struct StartLog {
+    std::mutex mutex;
+    std::vector<std::string> started;
+    std::map<std::string, uint64_t> tickets;
+
+    RequestScheduler::StartFunction starter(const std::string& name) {
+        return [this, name](uint64_t ticket) {
+            std::lock_guard<std::mutex> lock(mutex);
+            started.push_back(name);
+            tickets[name] = ticket;
+        };
+    }
+
+    void finish(RequestScheduler& scheduler, const std::string& name) {
+        uint64_t ticket;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ticket = tickets.at(name);
+        }
+        scheduler.finished(ticket);
+    }
+};
+
+void testBackgroundYieldsToUserVisible() {
+    RequestScheduler scheduler(1, 1);
+    StartLog log;
+    auto background = PriorityToken::create(RequestPriority::BACKGROUND);
+    auto visible = PriorityToken::create(RequestPriority::USER_VISIBLE);
+
+    scheduler.submit("api", background, nullptr, log.starter("favorite artists"), []() {});
+    scheduler.submit("api", background, nullptr, log.starter("favorite events"), []() {});
+    scheduler.submit("api", background, nullptr, log.starter("favorite venues"), []() {});
+    scheduler.submit("api", visible, nullptr, log.starter("search"), []() {});
+    CHECK(log.started == std::vector<std::string>{"favorite artists"});
+
+    // The search was submitted last but is next in line
+    log.finish(scheduler, "favorite artists");
+    CHECK(log.started.size() == 2 && log.started[1] == "search");
+    log.finish(scheduler, "search");
+    log.finish(scheduler, "favorite events");
+    log.finish(scheduler, "favorite venues");
+    CHECK((log.started == std::vector<std::string>{"favorite artists", "search", "favorite events", "favorite venues"}));
+}
+
+void testBackgroundLeavesSlotsForSearch() {
+    // Background work may not take every slot, so a search starts at once
+    RequestScheduler scheduler(2, 1);
+    StartLog log;
+    auto background = PriorityToken::create(RequestPriority::BACKGROUND);
+
+    scheduler.submit("api", background, nullptr, log.starter("favorite artists"), []() {});
+    scheduler.submit("api", background, nullptr, log.starter("favorite events"), []() {});
+    scheduler.submit("api", PriorityToken::create(RequestPriority::USER_VISIBLE), nullptr,
+                     log.starter("search"), []() {});
+    CHECK((log.started == std::vector<std::string>{"favorite artists", "search"}));
+}
+
+void testShowingRaisesQueuedFavorites() {
+    // Raising the screen's token reorders requests that are already queued
+    RequestScheduler scheduler(1, 1);
+    StartLog log;
+    auto favorites = PriorityToken::create(RequestPriority::BACKGROUND);
+
+    scheduler.submit("api", nullptr, nullptr, log.starter("blocker"), []() {});
+    scheduler.submit("api", favorites, nullptr, log.starter("favorite artists"), []() {});
+    scheduler.submit("api", nullptr, nullptr, log.starter("recommendations"), []() {});
+    favorites->set(RequestPriority::USER_VISIBLE);
+    log.finish(scheduler, "blocker");
+    CHECK(log.started.size() == 2 && log.started[1] == "favorite artists");
+    CHECK(scheduler.getStats().reprioritised == 1);
+}
+
+// Passes jobs on to inner, noting the order they reach the wire in
+class OrderTransport : public HttpTransport {
+public:
+    explicit OrderTransport(std::shared_ptr<HttpTransport> inner) : inner(std::move(inner)) {}
+
+    void submit(IOJob job) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            urls.push_back(job.url);
+        }
+        inner->submit(std::move(job));
+    }
+
+    std::vector<std::string> getUrls() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return urls;
+    }
+
+private:
+    std::shared_ptr<HttpTransport> inner;
+    std::mutex mutex;
+    std::vector<std::string> urls;
+};
+
+void testPrefetchedFavoritesYieldToSearch() {
+    // What FavoritesScreen::prefetch() and SearchScreen::onSearch() issue,
+    // over one connection slot to the API host
+    auto replay = std::make_shared<ReplayTransport>(std::chrono::milliseconds(50));
+    HttpFixture search;
+    search.method = "GET";
+    search.url = std::string(AppConfig::API_BASE_URL) + "/v1/search";
+    search.statusCode = 200;
+    search.body = R"({"artists":[],"events":[],"venues":[],"cities":[]})";
+    replay->addFixture(search);
+    replay->setDefaultResponse(200, "[]");
+    auto transport = std::make_shared<OrderTransport>(replay);
+
+    HttpClient& client = HttpClient::getInstance();
+    client.setTransport(transport);
+    client.setCacheEnabled(false);
+    client.setHostConcurrency(1, 1);
+
+    APIService& api = APIService::getInstance();
+    auto favoritesPriority = PriorityToken::create(RequestPriority::BACKGROUND);
+    auto artists = api.fetchFavoriteArtists(0, 20, favoritesPriority);
+    auto events = api.fetchFavoriteEvents(0, 20, true, favoritesPriority);
+    auto venues = api.fetchFavoriteVenues(0, 20, favoritesPriority);
+
+    // Wait for one favorites load to hold the slot and the others to queue
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (client.getSchedulerStats().waiting < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(client.getSchedulerStats().waiting == 2);
+
+    auto results = api.fetchSearch("fillmore", false, CancellationToken::create());
+    results.get();
+    artists.get();
+    events.get();
+    venues.get();
+
+    std::vector<std::string> urls = transport->getUrls();
+    CHECK(urls.size() == 4);
+    CHECK_MSG(urls[1].find("/v1/search") != std::string::npos, urls[1]);
+
+    client.setTransport(nullptr);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"background yields to user-visible", testBackgroundYieldsToUserVisible},
+        {"background leaves slots for search", testBackgroundLeavesSlotsForSearch},
+        {"showing raises queued favorites", testShowingRaisesQueuedFavorites},
+        {"prefetched favorites yield to search", testPrefetchedFavoritesYieldToSearch},
+    });
+}
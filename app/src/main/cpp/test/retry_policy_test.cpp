@@ -0,0 +1,202 @@
+// RetryPolicy's decisions and delays, and CircuitBreaker's state machine:
+// pure logic, driven directly with short cooldowns.
+
+#include "test_support.h"
+#include "retry_policy.h"
+#include "circuit_breaker.h"
+#include <ctime>
+#include <thread>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+HttpResponse failure(HttpError errorCode) {
+    HttpResponse response;
+    response.errorCode = errorCode;
+    return response;
+}
+
+HttpResponse status(int statusCode, const char* retryAfter = nullptr) {
+    HttpResponse response;
+    response.statusCode = statusCode;
+    if (retryAfter != nullptr) {
+        response.headers.set("Retry-After", retryAfter);
+    }
+    return response;
+}
+
+void testOnlyIdempotentMethodsRetry() {
+    for (const char* method : {"GET", "HEAD", "PUT", "DELETE", "OPTIONS"}) {
+        CHECK_MSG(RetryPolicy::isIdempotent(method), method);
+    }
+    for (const char* method : {"POST", "PATCH", "get", ""}) {
+        CHECK_MSG(!RetryPolicy::isIdempotent(method), method);
+    }
+}
+
+void testRetryableFailures() {
+    CHECK(RetryPolicy::isRetryable(failure(HttpError::NETWORK)));
+    CHECK(RetryPolicy::isRetryable(failure(HttpError::TIMED_OUT)));
+    for (HttpError error : {HttpError::INVALID_URL, HttpError::PROTOCOL, HttpError::CANCELLED,
+                            HttpError::SHUTTING_DOWN, HttpError::CIRCUIT_OPEN}) {
+        CHECK(!RetryPolicy::isRetryable(failure(error)));
+    }
+    for (int code : {408, 429, 502, 503, 504}) {
+        CHECK_MSG(RetryPolicy::isRetryable(status(code)), std::to_string(code));
+    }
+    for (int code : {200, 304, 400, 401, 404, 500, 501}) {
+        CHECK_MSG(!RetryPolicy::isRetryable(status(code)), std::to_string(code));
+    }
+}
+
+void testBackoffStaysWithinItsCeiling() {
+    RetryPolicy policy;
+    policy.baseDelay = std::chrono::milliseconds(100);
+    policy.maxDelay = std::chrono::milliseconds(1000);
+
+    const int SAMPLES = 4000;
+    for (int attempt = 1; attempt <= 6; ++attempt) {
+        int64_t ceiling = std::min<int64_t>(100 << (attempt - 1), 1000);
+        int64_t lowest = ceiling;
+        int64_t highest = 0;
+        double sum = 0;
+        for (int i = 0; i < SAMPLES; ++i) {
+            int64_t delay = policy.backoff(attempt).count();
+            CHECK_MSG(delay >= 0 && delay <= ceiling, std::to_string(delay) + " ms on attempt " + std::to_string(attempt));
+            lowest = std::min(lowest, delay);
+            highest = std::max(highest, delay);
+            sum += delay;
+        }
+        // Full jitter spreads delays over the whole range
+        CHECK(lowest < ceiling / 10);
+        CHECK(highest > ceiling * 9 / 10);
+        double mean = sum / SAMPLES;
+        CHECK_MSG(mean > ceiling * 0.4 && mean < ceiling * 0.6, std::to_string(mean));
+    }
+
+    // Far-out attempts clamp instead of overflowing
+    for (int attempt : {30, 64, 1000}) {
+        int64_t delay = policy.backoff(attempt).count();
+        CHECK(delay >= 0 && delay <= 1000);
+    }
+    policy.baseDelay = std::chrono::milliseconds(0);
+    CHECK(policy.backoff(3).count() == 0);
+}
+
+void testRetryAfter() {
+    CHECK(RetryPolicy::retryAfter(status(503)).count() == -1);
+    CHECK(RetryPolicy::retryAfter(status(503, "120")) == std::chrono::seconds(120));
+    CHECK(RetryPolicy::retryAfter(status(429, "  7 ")) == std::chrono::seconds(7));
+    CHECK(RetryPolicy::retryAfter(status(429, "0")).count() == 0);
+    CHECK(RetryPolicy::retryAfter(status(429, "soon")).count() == -1);
+    CHECK(RetryPolicy::retryAfter(status(429, "12s")).count() == -1);
+
+    // HTTP-date, relative to now
+    char date[64];
+    time_t later = time(nullptr) + 60;
+    struct tm utc;
+    gmtime_r(&later, &utc);
+    strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &utc);
+    auto delay = RetryPolicy::retryAfter(status(503, date));
+    CHECK_MSG(delay >= std::chrono::seconds(58) && delay <= std::chrono::seconds(60), date);
+    CHECK(RetryPolicy::retryAfter(status(503, "Sun, 06 Nov 1994 08:49:37 GMT")).count() == 0);
+}
+
+const auto COOLDOWN = std::chrono::milliseconds(100);
+
+void testBreakerOpensAfterConsecutiveFailures() {
+    CircuitBreaker breaker(3, COOLDOWN);
+    CHECK(breaker.allowRequest("api"));
+
+    // A success in between resets the count
+    breaker.recordFailure("api");
+    breaker.recordFailure("api");
+    breaker.recordSuccess("api");
+    breaker.recordFailure("api");
+    breaker.recordFailure("api");
+    CHECK(!breaker.isOpen("api"));
+    CHECK(breaker.allowRequest("api"));
+
+    breaker.recordFailure("api");
+    CHECK(breaker.isOpen("api"));
+    CHECK(!breaker.allowRequest("api"));
+    CHECK(!breaker.allowRequest("api"));
+    // Hosts are independent
+    CHECK(breaker.allowRequest("cdn"));
+
+    CircuitBreakerStats stats = breaker.getStats();
+    CHECK(stats.opened == 1);
+    CHECK(stats.rejected == 2);
+    CHECK(stats.probes == 0);
+}
+
+void testHalfOpenProbeSuccessCloses() {
+    CircuitBreaker breaker(1, COOLDOWN);
+    breaker.recordFailure("api");
+    CHECK(!breaker.allowRequest("api"));
+
+    std::this_thread::sleep_for(COOLDOWN + std::chrono::milliseconds(20));
+    CHECK(!breaker.isOpen("api"));
+    // Exactly one probe goes out; the rest fail fast until it reports
+    CHECK(breaker.allowRequest("api"));
+    CHECK(!breaker.allowRequest("api"));
+    CHECK(breaker.isOpen("api"));
+
+    breaker.recordSuccess("api");
+    CHECK(!breaker.isOpen("api"));
+    for (int i = 0; i < 5; ++i) {
+        CHECK(breaker.allowRequest("api"));
+    }
+    CHECK(breaker.getStats().probes == 1);
+}
+
+void testHalfOpenProbeFailureReopens() {
+    CircuitBreaker breaker(3, COOLDOWN);
+    for (int i = 0; i < 3; ++i) {
+        breaker.recordFailure("api");
+    }
+    std::this_thread::sleep_for(COOLDOWN + std::chrono::milliseconds(20));
+    CHECK(breaker.allowRequest("api"));
+
+    // One failed probe is enough, whatever the threshold
+    breaker.recordFailure("api");
+    CHECK(breaker.isOpen("api"));
+    CHECK(!breaker.allowRequest("api"));
+    CHECK(breaker.getStats().opened == 2);
+
+    std::this_thread::sleep_for(COOLDOWN + std::chrono::milliseconds(20));
+    CHECK(breaker.allowRequest("api"));
+    breaker.recordSuccess("api");
+    CHECK(breaker.allowRequest("api"));
+    CHECK(breaker.getStats().probes == 2);
+}
+
+void testAbandonedProbeExpires() {
+    // A probe that never reports back must not block the host for good
+    CircuitBreaker breaker(1, COOLDOWN);
+    breaker.recordFailure("api");
+    std::this_thread::sleep_for(COOLDOWN + std::chrono::milliseconds(20));
+    CHECK(breaker.allowRequest("api"));
+    CHECK(!breaker.allowRequest("api"));
+
+    std::this_thread::sleep_for(COOLDOWN + std::chrono::milliseconds(20));
+    CHECK(breaker.allowRequest("api"));
+    CHECK(breaker.getStats().probes == 2);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"only idempotent methods retry", testOnlyIdempotentMethodsRetry},
+        {"retryable failures", testRetryableFailures},
+        {"backoff stays within its ceiling", testBackoffStaysWithinItsCeiling},
+        {"retry-after", testRetryAfter},
+        {"breaker opens after consecutive failures", testBreakerOpensAfterConsecutiveFailures},
+        {"half-open probe success closes", testHalfOpenProbeSuccessCloses},
+        {"half-open probe failure reopens", testHalfOpenProbeFailureReopens},
+        {"abandoned probe expires", testAbandonedProbeExpires},
+    });
+}
@@ -0,0 +1,174 @@
+// LocalifyApp navigation, headless on the host UI stand-ins: every screen
+// exists and survives being left, nothing is prefetched before sign-in, and
+// the favorites prefetch runs as background work until the screen is shown.
+
+#include "test_support.h"
+#include "android_ui.h"
+#include "api_service.h"
+#include "dns_resolver.h"
+#include "fixture_transport.h"
+#include "http_transport.h"
+#include <memory>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+// Holds every job until the test answers it
+class HoldingTransport : public HttpTransport {
+public:
+    void submit(IOJob job) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size() + answered;
+    }
+
+    std::vector<std::string> urls() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> out;
+        for (const IOJob& job : jobs) {
+            out.push_back(job.url);
+        }
+        return out;
+    }
+
+    // Answers every held job with an empty JSON array
+    void answerAll() {
+        std::vector<IOJob> held;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            held.swap(jobs);
+            answered += held.size();
+        }
+        for (IOJob& job : held) {
+            HttpResponse response;
+            response.statusCode = 200;
+            if (job.onHead && !job.onHead(response)) {
+                response.errorCode = HttpError::CANCELLED;
+            } else if (job.onBody) {
+                job.onBody("[]", 2);
+            } else {
+                response.body = "[]";
+            }
+            job.onComplete(std::move(response));
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<IOJob> jobs;
+    size_t answered = 0;
+};
+
+// A headless app with every request going to a HoldingTransport
+struct AppFixture {
+    ANativeWindow window{1080, 1920};
+    std::shared_ptr<HoldingTransport> transport = std::make_shared<HoldingTransport>();
+
+    AppFixture() {
+        // The login screen warms DNS for the API host; keep that offline
+        DNSResolver::getInstance().setLookupFunction([](const std::string&) { return DNSResult(); });
+        APIService::getInstance().clearAuth();
+        g_app.reset(new LocalifyApp(nullptr));
+        g_app->setWindow(&window);
+        CHECK(g_app->initialize());
+        HttpClient::getInstance().setTransport(transport);
+        HttpClient::getInstance().setCacheEnabled(false);
+    }
+
+    ~AppFixture() {
+        transport->answerAll();
+        g_app.reset();
+        transport->answerAll();
+        HttpClient::getInstance().setTransport(nullptr);
+        HttpClient::getInstance().setHostConcurrency(6, 4);
+        APIService::getInstance().clearAuth();
+        DNSResolver::getInstance().setLookupFunction(nullptr);
+    }
+};
+
+bool allFavorites(const std::vector<std::string>& urls) {
+    for (const std::string& url : urls) {
+        if (url.find("/favorites") == std::string::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testEveryScreenIsReachable() {
+    AppFixture fixture;
+    // The profile screen waits on its request, so answer everything at once
+    auto replay = std::make_shared<ReplayTransport>();
+    replay->setDefaultResponse(200, "{}");
+    HttpClient::getInstance().setTransport(replay);
+    CHECK(g_app->currentScreenType == LocalifyApp::LOGIN_SCREEN);
+    for (LocalifyApp::ScreenType type : {LocalifyApp::HOME_SCREEN, LocalifyApp::SEARCH_SCREEN,
+                                         LocalifyApp::PROFILE_SCREEN, LocalifyApp::MAP_SCREEN,
+                                         LocalifyApp::HOME_SCREEN, LocalifyApp::LOGIN_SCREEN}) {
+        g_app->navigateToScreen(type);
+        CHECK(g_app->currentScreenType == type);
+        // Drawing and updating reach the screen now being shown
+        g_app->update(0.016f);
+        g_app->render();
+    }
+}
+
+void testNothingPrefetchedBeforeSignIn() {
+    AppFixture fixture;
+    g_app->navigateToScreen(LocalifyApp::HOME_SCREEN);
+    g_app->navigateToScreen(LocalifyApp::SEARCH_SCREEN);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK_MSG(fixture.transport->count() == 0, std::to_string(fixture.transport->count()) + " requests");
+}
+
+void testFavoritesPrefetchIsBackgroundUntilShown() {
+    AppFixture fixture;
+    // One background request per host at a time, so the rest of the
+    // prefetch waits in the scheduler where its priority shows
+    HttpClient& client = HttpClient::getInstance();
+    client.setHostConcurrency(4, 1);
+    APIService::getInstance().setAuthToken("signed-in");
+    RequestSchedulerStats before = client.getSchedulerStats();
+
+    g_app->navigateToScreen(LocalifyApp::HOME_SCREEN);
+    CHECK(waitUntil([&]() { return client.getSchedulerStats().waiting == before.waiting + 2; }));
+    CHECK(waitUntil([&]() { return fixture.transport->count() == 1; }));
+    CHECK(allFavorites(fixture.transport->urls()));
+    // Still background: navigating elsewhere leaves them queued
+    g_app->navigateToScreen(LocalifyApp::SEARCH_SCREEN);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(fixture.transport->count() == 1);
+    CHECK(client.getSchedulerStats().reprioritised == before.reprioritised);
+
+    // Showing the screen raises them, and the queued two go out at once
+    g_app->navigateToScreen(LocalifyApp::FAVORITES_SCREEN);
+    CHECK(waitUntil([&]() { return fixture.transport->count() == 3; }));
+    CHECK(allFavorites(fixture.transport->urls()));
+    // The first raise can dispatch both, so the second may not be counted
+    RequestSchedulerStats after = client.getSchedulerStats();
+    CHECK_MSG(after.reprioritised > before.reprioritised, std::to_string(after.reprioritised));
+    CHECK(after.waiting == before.waiting);
+
+    // Leaving and coming back reuses the loads instead of starting more
+    fixture.transport->answerAll();
+    g_app->navigateToScreen(LocalifyApp::HOME_SCREEN);
+    g_app->navigateToScreen(LocalifyApp::FAVORITES_SCREEN);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(fixture.transport->count() == 3);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"every screen is reachable", testEveryScreenIsReachable},
+        {"nothing prefetched before sign-in", testNothingPrefetchedBeforeSignIn},
+        {"favorites prefetch is background until shown", testFavoritesPrefetchIsBackgroundUntilShown},
+    });
+}
@@ -0,0 +1,277 @@
+#include "test_support.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <poll.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace localify {
+namespace test {
+
+void fail(const char* file, int line, const char* expression, const std::string& detail) {
+    fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    if (!detail.empty()) {
+        fprintf(stderr, "%s\n", detail.c_str());
+    }
+    fflush(stderr);
+    abort();
+}
+
+int run(int argc, char** argv, std::initializer_list<std::pair<const char*, TestFunction>> tests) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int ran = 0;
+    for (const auto& test : tests) {
+        if (filter != nullptr && strstr(test.first, filter) == nullptr) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        test.second();
+        printf("ok   %-48s %8.1f ms\n", test.first, elapsedMs(start));
+        fflush(stdout);
+        ++ran;
+    }
+    if (ran == 0) {
+        fprintf(stderr, "no test matches \"%s\"\n", filter != nullptr ? filter : "");
+        return 1;
+    }
+    return 0;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool waitUntil(const std::function<bool()>& condition, double timeoutMs) {
+    auto start = std::chrono::steady_clock::now();
+    while (!condition()) {
+        if (elapsedMs(start) > timeoutMs) {
+            return condition();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+bool readRequest(int fd, std::string& request) {
+    request.clear();
+    char buffer[4096];
+    size_t headerEnd = std::string::npos;
+    size_t bodyLength = 0;
+    while (true) {
+        if (headerEnd == std::string::npos) {
+            headerEnd = request.find("\r\n\r\n");
+            if (headerEnd != std::string::npos) {
+                headerEnd += 4;
+                std::string lower = request.substr(0, headerEnd);
+                std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                size_t field = lower.find("\r\ncontent-length:");
+                if (field != std::string::npos) {
+                    bodyLength = strtoul(lower.c_str() + field + 17, nullptr, 10);
+                }
+            }
+        }
+        if (headerEnd != std::string::npos && request.size() >= headerEnd + bodyLength) {
+            return true;
+        }
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        request.append(buffer, received);
+    }
+}
+
+bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data.remove_prefix(sent);
+    }
+    return true;
+}
+
+std::string response(int statusCode, const std::string& body, const std::string& extraHeaders) {
+    std::string out = "HTTP/1.1 " + std::to_string(statusCode) + " Test\r\n";
+    out += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    out += extraHeaders;
+    out += "\r\n";
+    out += body;
+    return out;
+}
+
+namespace {
+
+// Binds a listening socket to address:port (0 for any); returns the fd and
+// sets boundAddress to where it ended up, or returns -1
+int listenOn(const char* address, int port, int backlog, struct sockaddr_storage& boundAddress, socklen_t& length) {
+    bool ipv6 = strchr(address, ':') != nullptr;
+    memset(&boundAddress, 0, sizeof(boundAddress));
+    if (ipv6) {
+        auto* in6 = reinterpret_cast<struct sockaddr_in6*>(&boundAddress);
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(port);
+        inet_pton(AF_INET6, address, &in6->sin6_addr);
+        length = sizeof(*in6);
+    } else {
+        auto* in4 = reinterpret_cast<struct sockaddr_in*>(&boundAddress);
+        in4->sin_family = AF_INET;
+        in4->sin_port = htons(port);
+        inet_pton(AF_INET, address, &in4->sin_addr);
+        length = sizeof(*in4);
+    }
+
+    int fd = socket(ipv6 ? AF_INET6 : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr*>(&boundAddress), length) != 0 ||
+        listen(fd, backlog) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    getsockname(fd, reinterpret_cast<struct sockaddr*>(&boundAddress), &length);
+    return fd;
+}
+
+int portOf(const struct sockaddr_storage& address) {
+    return ntohs(address.ss_family == AF_INET6
+                     ? reinterpret_cast<const struct sockaddr_in6*>(&address)->sin6_port
+                     : reinterpret_cast<const struct sockaddr_in*>(&address)->sin_port);
+}
+
+} // namespace
+
+LoopbackServer::LoopbackServer(Handler handler, const char* address, int port)
+    : handler(std::move(handler)), address(address), listenFd(-1), port(0), stopping(false), connections(0) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    int fd = listenOn(address, port, 1024, storage, length);
+    if (fd < 0) {
+        return;
+    }
+    this->port = portOf(storage);
+    listenFd = fd;
+    acceptThread = std::thread(&LoopbackServer::acceptLoop, this);
+}
+
+LoopbackServer::~LoopbackServer() {
+    stopping = true;
+    if (listenFd >= 0) {
+        shutdown(listenFd, SHUT_RDWR);
+    }
+    if (acceptThread.joinable()) {
+        acceptThread.join();
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+    }
+
+    std::vector<std::thread> running;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int fd : openFds) {
+            shutdown(fd, SHUT_RDWR);
+        }
+        running.swap(workers);
+    }
+    for (std::thread& worker : running) {
+        worker.join();
+    }
+}
+
+std::string LoopbackServer::url(const std::string& path) const {
+    bool ipv6 = address.find(':') != std::string::npos;
+    return "http://" + (ipv6 ? "[" + address + "]" : address) + ":" + std::to_string(port) + path;
+}
+
+void LoopbackServer::acceptLoop() {
+    while (!stopping) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;
+        }
+        connections++;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            close(fd);
+            return;
+        }
+        openFds.push_back(fd);
+        workers.emplace_back([this, fd]() {
+            handler(fd);
+            std::lock_guard<std::mutex> lock(mutex);
+            openFds.erase(std::find(openFds.begin(), openFds.end(), fd));
+            close(fd);
+        });
+    }
+}
+
+StalledListener::StalledListener(const char* address, int port) : listenFd(-1), fillerFd(-1), port(0) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    listenFd = listenOn(address, port, 0, storage, length);
+    if (listenFd < 0) {
+        return;
+    }
+    this->port = portOf(storage);
+
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    connect(fd, reinterpret_cast<struct sockaddr*>(&storage), length);
+    struct pollfd connected = {fd, POLLOUT, 0};
+    if (poll(&connected, 1, 1000) != 1) {
+        close(fd);
+        return;
+    }
+    fillerFd = fd;
+}
+
+StalledListener::~StalledListener() {
+    if (fillerFd >= 0) {
+        close(fillerFd);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+    }
+}
+
+RedirectTransport::RedirectTransport(std::shared_ptr<HttpTransport> inner, const LoopbackServer& server)
+    : inner(std::move(inner)), address(server.getAddress()), base(server.url("")), port(server.getPort()) {}
+
+void RedirectTransport::submit(IOJob job) {
+    size_t authority = job.url.find("://");
+    size_t path = job.url.find('/', authority == std::string::npos ? 0 : authority + 3);
+    job.url = base + (path == std::string::npos ? "/" : job.url.substr(path));
+    job.host = address;
+    job.port = port;
+    job.secure = false;
+    inner->submit(std::move(job));
+}
+
+LoopbackServer::Handler serveForever(const std::string& fullResponse) {
+    return [fullResponse](int fd) {
+        std::string request;
+        while (readRequest(fd, request) && writeAll(fd, fullResponse)) {
+        }
+    };
+}
+
+} // namespace test
+} // namespace localify
@@ -0,0 +1,139 @@
+#ifndef LOCALIFY_TEST_SUPPORT_H
+#define LOCALIFY_TEST_SUPPORT_H
+
+// Minimal harness for the host networking tests: checks that abort the test
+// with a location, a runner, and loopback servers that tests script
+// connection by connection.
+
+#include "http_transport.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+namespace localify {
+namespace test {
+
+[[noreturn]] void fail(const char* file, int line, const char* expression, const std::string& detail);
+
+#define CHECK(condition) \
+    ((condition) ? (void)0 : ::localify::test::fail(__FILE__, __LINE__, #condition, std::string()))
+
+// As CHECK, with detail (a std::string) printed on failure
+#define CHECK_MSG(condition, detail) \
+    ((condition) ? (void)0 : ::localify::test::fail(__FILE__, __LINE__, #condition, (detail)))
+
+using TestFunction = void (*)();
+
+// Runs every test, or only those whose name contains argv[1]; returns the
+// process exit code
+int run(int argc, char** argv, std::initializer_list<std::pair<const char*, TestFunction>> tests);
+
+// Milliseconds since start
+double elapsedMs(std::chrono::steady_clock::time_point start);
+
+// Polls condition until it holds or timeoutMs passes; returns its last value
+bool waitUntil(const std::function<bool()>& condition, double timeoutMs = 2000);
+
+// Sockets
+
+// Reads one request (headers plus any Content-Length body); false on EOF or error
+bool readRequest(int fd, std::string& request);
+bool writeAll(int fd, std::string_view data);
+
+// A complete response with Content-Length framing
+std::string response(int statusCode, const std::string& body, const std::string& extraHeaders = std::string());
+
+// TCP server on an ephemeral loopback port. Every accepted connection runs
+// handler on its own thread and is closed when handler returns. Destruction
+// stops accepting, shuts down open connections so blocked handlers see EOF,
+// and joins them.
+class LoopbackServer {
+public:
+    using Handler = std::function<void(int fd)>;
+
+    // address is "127.0.0.1" or "::1"; port 0 picks a free one
+    explicit LoopbackServer(Handler handler, const char* address = "127.0.0.1", int port = 0);
+    ~LoopbackServer();
+
+    LoopbackServer(const LoopbackServer&) = delete;
+    LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+    bool isListening() const { return listenFd >= 0; }
+    const std::string& getAddress() const { return address; }
+    int getPort() const { return port; }
+    size_t getConnectionCount() const { return connections.load(); }
+
+    // "http://127.0.0.1:<port><path>", bracketed for IPv6
+    std::string url(const std::string& path) const;
+
+private:
+    void acceptLoop();
+
+    Handler handler;
+    std::string address;
+    int listenFd;
+    int port;
+    std::atomic<bool> stopping;
+    std::atomic<size_t> connections;
+    std::thread acceptThread;
+
+    std::mutex mutex;
+    std::vector<int> openFds;
+    std::vector<std::thread> workers;
+};
+
+// Listens with a backlog of zero and never accepts. One connection made up
+// front fills the queue, so the kernel drops later SYNs and their connects
+// hang until the client gives up.
+class StalledListener {
+public:
+    // address is "127.0.0.1" or "::1"; port 0 picks a free one
+    explicit StalledListener(const char* address = "127.0.0.1", int port = 0);
+    ~StalledListener();
+
+    StalledListener(const StalledListener&) = delete;
+    StalledListener& operator=(const StalledListener&) = delete;
+
+    // False if the port could not be bound
+    bool isListening() const { return fillerFd >= 0; }
+    int getPort() const { return port; }
+
+private:
+    int listenFd;
+    int fillerFd;
+    int port;
+};
+
+// Hands every job to inner aimed at server instead of the host its URL
+// names, so code with a fixed base URL (APIService) can be driven against
+// a loopback server over the real sockets
+class RedirectTransport : public HttpTransport {
+public:
+    RedirectTransport(std::shared_ptr<HttpTransport> inner, const LoopbackServer& server);
+
+    void submit(IOJob job) override;
+
+private:
+    std::shared_ptr<HttpTransport> inner;
+    std::string address;
+    std::string base;
+    int port;
+};
+
+// Serves every request on a connection with the same response until the
+// client closes it
+LoopbackServer::Handler serveForever(const std::string& fullResponse);
+
+} // namespace test
+} // namespace localify
+
+#endif // LOCALIFY_TEST_SUPPORT_H
@@ -0,0 +1,113 @@
+// Per-phase deadlines against loopback servers that stall: one whose accept
+// queue is full so connect never completes, one that accepts and never
+// answers, and one that answers a byte at a time forever.
+
+#include "test_support.h"
+#include "http_client.h"
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+HttpResponse timedRequest(const HttpRequest& request, double& elapsed) {
+    HttpClient& client = HttpClient::getInstance();
+    client.setCacheEnabled(false);
+    client.closeIdleConnections();
+    auto start = std::chrono::steady_clock::now();
+    HttpResponse response = client.request(request);
+    elapsed = elapsedMs(start);
+    return response;
+}
+
+void checkTimedOut(const HttpResponse& response, const char* error, double elapsed, double expectedMs) {
+    CHECK(response.statusCode == 0);
+    CHECK_MSG(response.errorCode == HttpError::TIMED_OUT, response.error);
+    CHECK_MSG(response.error == error, response.error);
+    CHECK_MSG(elapsed >= expectedMs - 50 && elapsed < expectedMs + 1000, std::to_string(elapsed) + " ms");
+}
+
+void testConnectTimeout() {
+    StalledListener listener;
+    CHECK(listener.isListening());
+    HttpRequest request("http://127.0.0.1:" + std::to_string(listener.getPort()) + "/connect");
+    request.connectTimeoutSeconds = 1;
+    request.timeoutSeconds = 10;
+    double elapsed;
+    HttpResponse response = timedRequest(request, elapsed);
+    checkTimedOut(response, "Connection timed out", elapsed, 1000);
+}
+
+void testFirstByteTimeout() {
+    // Accepts and reads the request, then waits for the client to give up
+    std::atomic<bool> sawClose(false);
+    LoopbackServer server([&](int fd) {
+        std::string request;
+        if (readRequest(fd, request) && !readRequest(fd, request)) {
+            sawClose = true;
+        }
+    });
+    CHECK(server.isListening());
+
+    HttpRequest request(server.url("/first-byte"));
+    request.firstByteTimeoutSeconds = 1;
+    request.timeoutSeconds = 10;
+    double elapsed;
+    HttpResponse response = timedRequest(request, elapsed);
+    checkTimedOut(response, "Timed out waiting for response", elapsed, 1000);
+
+    // The timed-out socket is closed, not left pinned
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!sawClose && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(sawClose);
+}
+
+void testFirstByteTimeoutFromClientDefault() {
+    LoopbackServer server([](int fd) {
+        std::string request;
+        while (readRequest(fd, request)) {
+        }
+    });
+    CHECK(server.isListening());
+
+    HttpClient::getInstance().setFirstByteTimeout(1);
+    double elapsed;
+    HttpResponse response = timedRequest(HttpRequest(server.url("/default")), elapsed);
+    HttpClient::getInstance().setFirstByteTimeout(0);
+    checkTimedOut(response, "Timed out waiting for response", elapsed, 1000);
+}
+
+void testTotalTimeout() {
+    // The first byte arrives at once and another every 100 ms, so no
+    // per-phase deadline fires; only the total one can end the request
+    LoopbackServer server([](int fd) {
+        std::string request;
+        if (!readRequest(fd, request) || !writeAll(fd, "HTTP/1.1 200 OK\r\nContent-Length: 100000\r\n\r\n")) {
+            return;
+        }
+        while (writeAll(fd, "x")) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
+    CHECK(server.isListening());
+
+    HttpRequest request(server.url("/trickle"));
+    request.firstByteTimeoutSeconds = 1;
+    request.timeoutSeconds = 2;
+    double elapsed;
+    HttpResponse response = timedRequest(request, elapsed);
+    checkTimedOut(response, "Request timed out", elapsed, 2000);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return run(argc, argv, {
+        {"connect timeout", testConnectTimeout},
+        {"first-byte timeout", testFirstByteTimeout},
+        {"first-byte timeout from client default", testFirstByteTimeoutFromClientDefault},
+        {"total timeout", testTotalTimeout},
+    });
+}
@@ -0,0 +1,241 @@
+// HTTPS through HttpClient against an in-process OpenSSL server holding a
+// self-signed certificate for "localhost", generated at startup and trusted
+// through TlsContext::addTrustedCertificates().
+
+#include "test_support.h"
+#include "http_client.h"
+#include "tls_context.h"
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <unistd.h>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace localify;
+using namespace localify::test;
+
+namespace {
+
+// Writes a fresh certificate and key for localhost to PEM files and returns
+// a server context serving them
+SSL_CTX* createServerContext(std::string& certificatePath) {
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* certificate = X509_new();
+    X509_set_version(certificate, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+    X509_gmtime_adj(X509_getm_notBefore(certificate), -60);
+    X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 60 * 60);
+    X509_set_pubkey(certificate, key);
+    X509_NAME* name = X509_get_subject_name(certificate);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(certificate, name);
+
+    X509V3_CTX extensions;
+    X509V3_set_ctx_nodb(&extensions);
+    X509V3_set_ctx(&extensions, certificate, certificate, nullptr, nullptr, 0);
+    const char* const EXTENSIONS[][2] = {
+        {"subjectAltName", "DNS:localhost"},
+        {"basicConstraints", "critical,CA:TRUE"},
+        {"keyUsage", "critical,digitalSignature,keyCertSign"},
+    };
+    for (const auto& entry : EXTENSIONS) {
+        X509_EXTENSION* extension = X509V3_EXT_conf(nullptr, &extensions, entry[0], entry[1]);
+        X509_add_ext(certificate, extension, -1);
+        X509_EXTENSION_free(extension);
+    }
+    X509_sign(certificate, key, EVP_sha256());
+
+    char path[] = "/tmp/localify-tls-test-XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    FILE* file = fdopen(fd, "w");
+    PEM_write_X509(file, certificate);
+    fclose(file);
+    certificatePath = path;
+
+    SSL_CTX* context = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_use_certificate(context, certificate);
+    SSL_CTX_use_PrivateKey(context, key);
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+    return context;
+}
+
+// One TLS connection on the server side
+class ServerConnection {
+public:
+    ServerConnection(SSL_CTX* context, int fd) : ssl(SSL_new(context)) {
+        SSL_set_fd(ssl, fd);
+        accepted = SSL_accept(ssl) == 1;
+    }
+    ~ServerConnection() { SSL_free(ssl); }
+
+    bool isAccepted() const { return accepted; }
+
+    bool readRequest(std::string& request) {
+        request.clear();
+        char buffer[4096];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            int received = SSL_read(ssl, buffer, sizeof(buffer));
+            if (received <= 0) {
+                return false;
+            }
+            request.append(buffer, received);
+        }
+        return true;
+    }
+
+    bool write(const std::string& data) {
+        return SSL_write(ssl, data.data(), static_cast<int>(data.size())) == static_cast<int>(data.size());
+    }
+
+    // Sends a TLS 1.3 NewSessionTicket outside the handshake, as servers do
+    // when they issue tickets lazily
+    void sendTicket() {
+        SSL_new_session_ticket(ssl);
+        SSL_do_handshake(ssl);
+    }
+
+    // Ends the connection without a close_notify alert
+    void abandon() { SSL_set_quiet_shutdown(ssl, 1); }
+
+private:
+    SSL* ssl;
+    bool accepted;
+};
+
+struct TlsFixture {
+    std::string certificatePath;    // initialized by createServerContext()
+    SSL_CTX* context;
+
+    TlsFixture() : context(createServerContext(certificatePath)) {
+        static bool trusted = false;
+        if (!trusted) {
+            CHECK(TlsContext::getInstance().addTrustedCertificates(certificatePath));
+            trusted = true;
+        }
+        TlsContext::getInstance().clearSessions();
+        HttpClient::getInstance().closeIdleConnections();
+        HttpClient::getInstance().setCacheEnabled(false);
+    }
+    ~TlsFixture() {
+        unlink(certificatePath.c_str());
+        SSL_CTX_free(context);
+    }
+};
+
+// Shared by every test: trust is only ever added, so one certificate is used
+TlsFixture& fixture() {
+    static TlsFixture* instance = new TlsFixture();
+    return *instance;
+}
+
+std::string httpsUrl(const LoopbackServer& server, const std::string& path) {
+    return "https://localhost:" + std::to_string(server.getPort()) + path;
+}
+
+void testCloseDelimitedBody() {
+    // No Content-Length: the body ends when the server closes, without a
+    // close_notify, as many servers and proxies do
+    SSL_CTX* context = fixture().context;
+    LoopbackServer server([context](int fd) {
+        ServerConnection connection(context, fd);
+        std::string request;
+        if (connection.isAccepted() && connection.readRequest(request)) {
+            connection.write("HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nclose-delimited body");
+            connection.abandon();
+        }
+    });
+    CHECK(server.isListening());
+
+    TlsContext::getInstance().clearSessions();
+    for (int i = 0; i < 2; ++i) {
+        HttpResponse response = HttpClient::getInstance().get(httpsUrl(server, "/close"));
+        CHECK_MSG(response.statusCode == 200, response.error);
+        CHECK(response.body == "close-delimited body");
+        // The unclean close must not cost the session: the reconnect resumes
+        CHECK(response.timing.resumedSession == (i == 1));
+    }
+}
+
+void testKeepAliveSurvivesLateTickets() {
+    // A ticket that arrives after the response sits unread on the idle
+    // socket; the pool must not mistake it for the peer closing
+    SSL_CTX* context = fixture().context;
+    LoopbackServer server([context](int fd) {
+        ServerConnection connection(context, fd);
+        std::string request;
+        while (connection.isAccepted() && connection.readRequest(request)) {
+            connection.write(response(200, "kept alive"));
+            connection.sendTicket();
+        }
+    });
+    CHECK(server.isListening());
+
+    for (int i = 0; i < 3; ++i) {
+        HttpResponse result = HttpClient::getInstance().get(httpsUrl(server, "/keep-alive"));
+        CHECK_MSG(result.statusCode == 200, result.error);
+        CHECK(result.body == "kept alive");
+        CHECK(result.timing.reusedConnection == (i > 0));
+        // Give the ticket time to land before the socket is checked out again
+        usleep(20 * 1000);
+    }
+    CHECK(server.getConnectionCount() == 1);
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void testHandshakeTiming() {
+    // Full handshakes with the session cache emptied before each connection,
+    // then resumed ones; reports the median TLS time of each
+    SSL_CTX* context = fixture().context;
+    LoopbackServer server([context](int fd) {
+        ServerConnection connection(context, fd);
+        std::string request;
+        while (connection.isAccepted() && connection.readRequest(request) &&
+               connection.write(response(200, "timed"))) {
+        }
+    });
+    CHECK(server.isListening());
+
+    HttpClient& client = HttpClient::getInstance();
+    const int HANDSHAKES = 20;
+    std::vector<double> full;
+    std::vector<double> resumed;
+    for (int i = 0; i < 2 * HANDSHAKES; ++i) {
+        bool resume = i >= HANDSHAKES;
+        if (!resume) {
+            TlsContext::getInstance().clearSessions();
+        }
+        client.closeIdleConnections();
+        HttpResponse result = client.get(httpsUrl(server, "/timing"));
+        CHECK_MSG(result.statusCode == 200, result.error);
+        CHECK(!result.timing.reusedConnection);
+        CHECK(result.timing.resumedSession == resume);
+        (resume ? resumed : full).push_back(std::chrono::duration<double, std::milli>(result.timing.tls).count());
+    }
+    printf("     TLS handshake median: full %.3f ms, resumed %.3f ms (%d each)\n", median(full), median(resumed),
+           HANDSHAKES);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // OpenSSL writes through write(), so a server still flushing a ticket or
+    // an alert after teardown shut its socket down would raise SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+    return run(argc, argv, {
+        {"close-delimited body", testCloseDelimitedBody},
+        {"keep-alive survives late tickets", testKeepAliveSurvivesLateTickets},
+        {"handshake timing", testHandshakeTiming},
+    });
+}